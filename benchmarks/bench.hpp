@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+// Runs `fn` `iterations` times and prints the mean wall time per run, plus
+// the throughput when the number of processed bytes is known.
+template <typename F>
+double measure(const char *name, int iterations, size_t bytes, F &&fn) {
+  fn(); // warm up
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    fn();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto seconds = std::chrono::duration<double>(end - start).count() /
+                 static_cast<double>(iterations);
+  if (bytes != 0) {
+    std::printf("%-40s %10.3f ms %10.1f MB/s\n", name, seconds * 1e3,
+                static_cast<double>(bytes) / seconds / 1e6);
+  } else {
+    std::printf("%-40s %10.3f ms\n", name, seconds * 1e3);
+  }
+  return seconds;
+}
+
+// keeps the optimizer from discarding benchmarked results
+template <typename T> void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// `M(N)` for N in 100..599, for stamping out many registered types
+#define SERIA_BENCH_REPEAT10(M, P)                                             \
+  M(P##0) M(P##1) M(P##2) M(P##3) M(P##4) M(P##5) M(P##6) M(P##7) M(P##8)      \
+  M(P##9)
+#define SERIA_BENCH_REPEAT100(M, P)                                            \
+  SERIA_BENCH_REPEAT10(M, P##0) SERIA_BENCH_REPEAT10(M, P##1)                  \
+  SERIA_BENCH_REPEAT10(M, P##2) SERIA_BENCH_REPEAT10(M, P##3)                  \
+  SERIA_BENCH_REPEAT10(M, P##4) SERIA_BENCH_REPEAT10(M, P##5)                  \
+  SERIA_BENCH_REPEAT10(M, P##6) SERIA_BENCH_REPEAT10(M, P##7)                  \
+  SERIA_BENCH_REPEAT10(M, P##8) SERIA_BENCH_REPEAT10(M, P##9)
+#define SERIA_BENCH_REPEAT500(M)                                               \
+  SERIA_BENCH_REPEAT100(M, 1) SERIA_BENCH_REPEAT100(M, 2)                      \
+  SERIA_BENCH_REPEAT100(M, 3) SERIA_BENCH_REPEAT100(M, 4)                      \
+  SERIA_BENCH_REPEAT100(M, 5)
@@ -0,0 +1,58 @@
+#include "bench.hpp"
+#include <seria/deserialize/cbor.hpp>
+#include <seria/serialize/cbor.hpp>
+
+struct Reading {
+  int32_t sensor = 0;
+  double timestamp = 0;
+  float temperature = 0;
+  bool ok = true;
+  std::string unit = "celsius";
+  std::vector<float> samples{};
+};
+
+namespace seria {
+
+template <> auto register_object<Reading>() {
+  return std::make_tuple(member("sensor", &Reading::sensor),
+                         member("timestamp", &Reading::timestamp),
+                         member("temperature", &Reading::temperature),
+                         member("ok", &Reading::ok),
+                         member("unit", &Reading::unit),
+                         member("samples", &Reading::samples));
+}
+
+} // namespace seria
+
+int main() {
+  std::vector<Reading> data(100000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i].sensor = static_cast<int32_t>(i % 64);
+    data[i].timestamp = static_cast<double>(i) * 0.01;
+    data[i].temperature = static_cast<float>(i % 40);
+    data[i].samples.assign(16, static_cast<float>(i));
+  }
+
+  auto encoded = seria::to_cbor(data);
+  std::printf("readings: %zu bytes\n", encoded.size());
+
+  measure("  cbor encode", 10, encoded.size(), [&] {
+    seria::cbor_writer writer;
+    seria::serialize(data, &writer);
+    do_not_optimize(writer.size());
+  });
+
+  std::vector<char> buffer(encoded.size());
+  measure("  cbor encode (fixed buffer)", 10, encoded.size(), [&] {
+    seria::cbor_writer writer(buffer.data(), buffer.size());
+    seria::serialize(data, &writer);
+    do_not_optimize(writer.size());
+  });
+
+  measure("  cbor decode", 10, encoded.size(), [&] {
+    std::vector<Reading> result;
+    seria::from_cbor(result, encoded.data(), encoded.size());
+    do_not_optimize(result.data());
+  });
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "bench.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <seria/chunked/rapidjson.hpp>
+#include <string>
+#ifdef SERIA_BENCH_MPACK
+#include <seria/chunked/mpack.hpp>
+#endif
+
+struct Reading {
+  uint32_t timestamp = 0;
+  int32_t sensor = 0;
+  double value = 0;
+  std::string unit;
+  std::vector<int32_t> flags;
+};
+
+struct Log {
+  std::string source;
+  std::vector<Reading> readings;
+};
+
+namespace seria {
+
+template <> auto register_object<Reading>() {
+  return std::make_tuple(member("timestamp", &Reading::timestamp),
+                         member("sensor", &Reading::sensor),
+                         member("value", &Reading::value),
+                         member("unit", &Reading::unit),
+                         member("flags", &Reading::flags));
+}
+
+template <> auto register_object<Log>() {
+  return std::make_tuple(member("source", &Log::source),
+                         member("readings", &Log::readings));
+}
+
+} // namespace seria
+
+using seconds = std::chrono::duration<double>;
+
+// Pulls the whole output in `chunk` byte pieces, printing the time to the
+// first one and to the end.
+template <typename Format>
+void pull(const char *name, const Log &log, size_t chunk) {
+  auto start = std::chrono::steady_clock::now();
+  seria::chunked_writer<Log, Format> writer(log, chunk);
+  size_t total = writer.next().size();
+  auto first = std::chrono::steady_clock::now();
+  while (!writer.done()) {
+    total += writer.next().size();
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::printf("%-28s %6zu KB chunks: first %8.3f ms, all %9.3f ms, "
+              "%zu bytes, %zu held\n",
+              name, chunk >> 10, seconds(first - start).count() * 1e3,
+              seconds(end - start).count() * 1e3, total, chunk);
+}
+
+// usage: bench_chunked [readings, 1000000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  Log log;
+  log.source = "station-1";
+  log.readings.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &reading = log.readings[i];
+    reading.timestamp = 1700000000u + static_cast<uint32_t>(i);
+    reading.sensor = static_cast<int32_t>(i % 128);
+    reading.value = static_cast<double>(i % 1000) / 8.0;
+    reading.unit = "celsius";
+    reading.flags = {1, 2, 3};
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto text = seria::to_string(log);
+  auto end = std::chrono::steady_clock::now();
+  std::printf("%-28s                   first %8.3f ms, all %9.3f ms, "
+              "%zu bytes, %zu held\n",
+              "json to_string", seconds(end - start).count() * 1e3,
+              seconds(end - start).count() * 1e3, text.size(), text.size());
+  text = std::string();
+
+  for (size_t chunk : {4 << 10, 64 << 10}) {
+    pull<seria::json_chunk_format>("json chunked_writer", log, chunk);
+  }
+
+#ifdef SERIA_BENCH_MPACK
+  start = std::chrono::steady_clock::now();
+  char *data = nullptr;
+  size_t size = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &size);
+  seria::serialize(log, &writer);
+  mpack_writer_destroy(&writer);
+  end = std::chrono::steady_clock::now();
+  std::printf("%-28s                   first %8.3f ms, all %9.3f ms, "
+              "%zu bytes, %zu held\n",
+              "msgpack serialize", seconds(end - start).count() * 1e3,
+              seconds(end - start).count() * 1e3, size, size);
+  free(data);
+
+  for (size_t chunk : {4 << 10, 64 << 10}) {
+    pull<seria::mpack_chunk_format>("msgpack chunked_writer", log, chunk);
+  }
+#endif
+}
@@ -0,0 +1,102 @@
+#include "bench.hpp"
+#include <seria/deserialize/binary.hpp>
+#include <seria/serialize/binary.hpp>
+#ifdef SERIA_BENCH_MPACK
+#include <seria/deserialize/mpack.hpp>
+#include <seria/serialize/mpack.hpp>
+#endif
+
+struct Row {
+  int32_t id = 0;
+  double time = 0;
+  float x = 0;
+  float y = 0;
+  float z = 0;
+  int32_t flags = 0;
+};
+
+// same members, encoded column by column
+struct Column : Row {};
+
+namespace seria {
+
+template <> struct is_columnar<Column> : std::true_type {};
+
+template <> auto register_object<Row>() {
+  return std::make_tuple(member("id", &Row::id), member("time", &Row::time),
+                         member("x", &Row::x), member("y", &Row::y),
+                         member("z", &Row::z), member("flags", &Row::flags));
+}
+
+template <> auto register_object<Column>() {
+  return std::make_tuple(member("id", &Column::id),
+                         member("time", &Column::time),
+                         member("x", &Column::x), member("y", &Column::y),
+                         member("z", &Column::z),
+                         member("flags", &Column::flags));
+}
+
+} // namespace seria
+
+template <typename T> void run_binary(const char *name, size_t rows) {
+  std::vector<T> data(rows);
+  for (size_t i = 0; i < rows; i++) {
+    data[i].id = static_cast<int32_t>(i);
+    data[i].time = static_cast<double>(i) * 0.001;
+    data[i].x = static_cast<float>(i % 1000);
+    data[i].flags = static_cast<int32_t>(i & 0xF);
+  }
+
+  auto encoded = seria::to_binary(data);
+  std::printf("%s: %zu bytes\n", name, encoded.size());
+
+  measure("  binary encode", 10, encoded.size(), [&] {
+    seria::binary_writer writer;
+    seria::serialize(data, &writer);
+    do_not_optimize(writer.size());
+  });
+
+  measure("  binary decode", 10, encoded.size(), [&] {
+    std::vector<T> result;
+    seria::from_binary(result, encoded.data(), encoded.size());
+    do_not_optimize(result.data());
+  });
+
+#ifdef SERIA_BENCH_MPACK
+  char *buffer = nullptr;
+  size_t size = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &buffer, &size);
+  seria::serialize(data, &writer);
+  mpack_writer_destroy(&writer);
+  std::printf("%s: %zu bytes msgpack\n", name, size);
+
+  measure("  msgpack encode", 10, size, [&] {
+    char *output = nullptr;
+    size_t total = 0;
+    mpack_writer_t w;
+    mpack_writer_init_growable(&w, &output, &total);
+    seria::serialize(data, &w);
+    mpack_writer_destroy(&w);
+    free(output);
+  });
+
+  measure("  msgpack decode", 10, size, [&] {
+    std::vector<T> result;
+    mpack_tree_t tree;
+    mpack_tree_init_data(&tree, buffer, size);
+    mpack_tree_parse(&tree);
+    seria::deserialize(result, mpack_tree_root(&tree));
+    mpack_tree_destroy(&tree);
+    do_not_optimize(result.data());
+  });
+  free(buffer);
+#endif
+}
+
+int main() {
+  constexpr size_t rows = 1000000;
+  run_binary<Row>("rows", rows);
+  run_binary<Column>("columns", rows);
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "bench.hpp"
+#include <seria/deserialize/csv.hpp>
+#include <seria/serialize/csv.hpp>
+
+struct Position {
+  double latitude = 0;
+  double longitude = 0;
+};
+
+struct Trip {
+  int64_t id = 0;
+  int32_t passengers = 1;
+  float fare = 0;
+  bool paid = true;
+  std::string vendor = "seria";
+  Position pickup{};
+};
+
+namespace seria {
+
+template <> auto register_object<Position>() {
+  return std::make_tuple(member("latitude", &Position::latitude),
+                         member("longitude", &Position::longitude));
+}
+
+template <> auto register_object<Trip>() {
+  return std::make_tuple(member("id", &Trip::id),
+                         member("passengers", &Trip::passengers),
+                         member("fare", &Trip::fare),
+                         member("paid", &Trip::paid),
+                         member("vendor", &Trip::vendor),
+                         member("pickup", &Trip::pickup));
+}
+
+} // namespace seria
+
+int main() {
+  std::vector<Trip> data(500000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i].id = static_cast<int64_t>(i);
+    data[i].passengers = static_cast<int32_t>(i % 6);
+    data[i].fare = static_cast<float>(i % 1000) * 0.25f;
+    data[i].pickup = {40.0 + static_cast<double>(i % 997) * 1e-4,
+                      -73.0 - static_cast<double>(i % 991) * 1e-4};
+  }
+
+  auto text = seria::to_csv(data);
+  std::printf("trips: %zu bytes\n", text.size());
+
+  measure("  csv write", 10, text.size(), [&] {
+    seria::csv_writer writer;
+    seria::write_csv(data, &writer);
+    do_not_optimize(writer.size());
+  });
+
+  for (unsigned threads : {1u, 2u, 4u, 8u}) {
+    seria::csv_options options;
+    options.threads = threads;
+    auto name = "  csv read (" + std::to_string(threads) + " threads)";
+    measure(name.c_str(), 10, text.size(), [&] {
+      std::vector<Trip> result;
+      seria::from_csv(result, text.data(), text.size(), options);
+      do_not_optimize(result.data());
+    });
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "bench.hpp"
+#include <fstream>
+#include <seria/deserialize/binary.hpp>
+#include <seria/serialize/binary.hpp>
+
+// Built twice: with SERIA_BENCH_TABLE the 200 message types go through the
+// table-driven binary encoder, otherwise through the templates.
+
+#define SERIA_BENCH_MESSAGE(N)                                                 \
+  struct Message##N {                                                          \
+    int32_t id = N;                                                            \
+    double value = 0.5;                                                        \
+    bool flag = true;                                                          \
+    std::string name = "message";                                              \
+    std::vector<int32_t> values = {1, 2, 3, 4};                                \
+    std::array<float, 3> position{};                                           \
+  };                                                                           \
+  namespace seria {                                                            \
+  template <> auto register_object<Message##N>() {                             \
+    return std::make_tuple(member("id", &Message##N::id),                      \
+                           member("value", &Message##N::value),                \
+                           member("flag", &Message##N::flag),                  \
+                           member("name", &Message##N::name),                  \
+                           member("values", &Message##N::values),              \
+                           member("position", &Message##N::position));         \
+  }                                                                            \
+  }
+
+#ifdef SERIA_BENCH_TABLE
+#define SERIA_BENCH_ROUND_TRIP(N)                                              \
+  {                                                                            \
+    Message##N message{};                                                      \
+    auto data = seria::to_binary_table(message);                               \
+    seria::from_binary_table(message, data.data(), data.size());               \
+    bytes += data.size();                                                      \
+  }
+#else
+#define SERIA_BENCH_ROUND_TRIP(N)                                              \
+  {                                                                            \
+    Message##N message{};                                                      \
+    auto data = seria::to_binary(message);                                     \
+    seria::from_binary(message, data.data(), data.size());                     \
+    bytes += data.size();                                                      \
+  }
+#endif
+
+SERIA_BENCH_REPEAT100(SERIA_BENCH_MESSAGE, 1)
+SERIA_BENCH_REPEAT100(SERIA_BENCH_MESSAGE, 2)
+
+static size_t round_trip_all() {
+  size_t bytes = 0;
+  SERIA_BENCH_REPEAT100(SERIA_BENCH_ROUND_TRIP, 1)
+  SERIA_BENCH_REPEAT100(SERIA_BENCH_ROUND_TRIP, 2)
+  return bytes;
+}
+
+int main(int /*argc*/, char **argv) {
+  std::ifstream self(argv[0], std::ios::binary | std::ios::ate);
+#ifdef SERIA_BENCH_TABLE
+  std::printf("table-driven, executable: %lld bytes\n",
+              static_cast<long long>(self.tellg()));
+#else
+  std::printf("templated, executable: %lld bytes\n",
+              static_cast<long long>(self.tellg()));
+#endif
+
+  size_t bytes = round_trip_all();
+  measure("  round trip 200 message types", 2000, bytes,
+          [] { do_not_optimize(round_trip_all()); });
+}
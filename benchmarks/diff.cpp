@@ -0,0 +1,157 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/diff/rapidjson.hpp>
+#include <string>
+#ifdef SERIA_BENCH_MPACK
+#include <seria/diff/mpack.hpp>
+#endif
+
+struct Gauge {
+  double value = 0;
+  double minimum = 0;
+  double maximum = 100;
+  int32_t alarms = 0;
+};
+
+struct Panel {
+  uint32_t id = 0;
+  std::string label;
+  Gauge pressure;
+  Gauge temperature;
+  Gauge flow;
+  std::vector<float> history;
+};
+
+struct Snapshot {
+  uint32_t tick = 0;
+  std::string site;
+  std::vector<Panel> panels;
+  Panel main;
+  Panel backup;
+};
+
+namespace seria {
+
+template <> auto register_object<Gauge>() {
+  return std::make_tuple(member("value", &Gauge::value),
+                         member("minimum", &Gauge::minimum),
+                         member("maximum", &Gauge::maximum),
+                         member("alarms", &Gauge::alarms));
+}
+
+template <> auto register_object<Panel>() {
+  return std::make_tuple(member("id", &Panel::id),
+                         member("label", &Panel::label),
+                         member("pressure", &Panel::pressure),
+                         member("temperature", &Panel::temperature),
+                         member("flow", &Panel::flow),
+                         member("history", &Panel::history));
+}
+
+template <> auto register_object<Snapshot>() {
+  return std::make_tuple(member("tick", &Snapshot::tick),
+                         member("site", &Snapshot::site),
+                         member("panels", &Snapshot::panels),
+                         member("main", &Snapshot::main),
+                         member("backup", &Snapshot::backup));
+}
+
+} // namespace seria
+
+Panel make_panel(uint32_t id, size_t history) {
+  Panel panel;
+  panel.id = id;
+  panel.label = "panel " + std::to_string(id);
+  panel.pressure.value = 1.5 * id;
+  panel.temperature.value = 20.25;
+  panel.history.assign(history, static_cast<float>(id));
+  return panel;
+}
+
+std::string to_json(const rapidjson::Document &document) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  document.Accept(writer);
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+// usage: bench_diff [panels, 200 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+
+  // a snapshot every 100 ms where the tick and a few gauges of the main
+  // panels move
+  Snapshot old;
+  old.site = "plant 7";
+  for (size_t i = 0; i < count; i++) {
+    old.panels.push_back(make_panel(static_cast<uint32_t>(i), 32));
+  }
+  old.main = make_panel(10000, 1024);
+  old.backup = make_panel(10001, 1024);
+  Snapshot now = old;
+  now.tick++;
+  now.main.pressure.value += 0.5;
+  now.main.flow.alarms++;
+  now.backup.temperature.value -= 0.25;
+
+  auto full = seria::to_string(now);
+  auto patch = to_json(seria::diff(old, now));
+  std::printf("%-40s %zu bytes, patch %zu bytes\n", "json", full.size(),
+              patch.size());
+  measure("to_string", 20, full.size(),
+          [&] { do_not_optimize(seria::to_string(now).size()); });
+  measure("diff", 20, full.size(),
+          [&] { do_not_optimize(to_json(seria::diff(old, now)).size()); });
+
+  Snapshot decoded = old;
+  measure("parse + deserialize", 20, full.size(), [&] {
+    rapidjson::Document document;
+    document.Parse(full.data(), full.size());
+    seria::deserialize(decoded, document);
+  });
+  measure("parse + apply_patch", 20, patch.size(), [&] {
+    rapidjson::Document document;
+    document.Parse(patch.data(), patch.size());
+    seria::apply_patch(decoded, document);
+  });
+
+#ifdef SERIA_BENCH_MPACK
+  std::string buffer(full.size() * 2, '\0');
+  auto encode = [&](bool delta) {
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, &buffer[0], buffer.size());
+    if (delta) {
+      seria::diff(old, now, &writer);
+    } else {
+      seria::serialize(now, &writer);
+    }
+    auto used = mpack_writer_buffer_used(&writer);
+    mpack_writer_destroy(&writer);
+    return std::string(buffer.data(), used);
+  };
+  auto bytes = encode(false);
+  auto delta = encode(true);
+  std::printf("%-40s %zu bytes, delta %zu bytes\n", "msgpack", bytes.size(),
+              delta.size());
+  measure("msgpack serialize", 20, bytes.size(),
+          [&] { do_not_optimize(encode(false).size()); });
+  measure("msgpack diff", 20, bytes.size(),
+          [&] { do_not_optimize(encode(true).size()); });
+
+  auto decode = [&](const std::string &data, bool delta) {
+    mpack_tree_t tree;
+    mpack_tree_init_data(&tree, data.data(), data.size());
+    mpack_tree_parse(&tree);
+    if (delta) {
+      seria::apply_patch(decoded, mpack_tree_root(&tree));
+    } else {
+      seria::deserialize(decoded, mpack_tree_root(&tree));
+    }
+    mpack_tree_destroy(&tree);
+  };
+  measure("msgpack deserialize", 20, bytes.size(),
+          [&] { decode(bytes, false); });
+  measure("msgpack apply_patch", 20, delta.size(),
+          [&] { decode(delta, true); });
+#endif
+}
@@ -0,0 +1,103 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/frame/mpack.hpp>
+#include <string>
+
+struct Event {
+  uint32_t id = 0;
+  int32_t kind = 0;
+  double latitude = 0;
+  double longitude = 0;
+  std::string source;
+  std::vector<int32_t> values;
+};
+
+namespace seria {
+
+template <> auto register_object<Event>() {
+  return std::make_tuple(member("id", &Event::id), member("kind", &Event::kind),
+                         member("latitude", &Event::latitude),
+                         member("longitude", &Event::longitude),
+                         member("source", &Event::source),
+                         member("values", &Event::values));
+}
+
+} // namespace seria
+
+// usage: bench_frame [messages, 100000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+  std::vector<Event> events(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &event = events[i];
+    event.id = static_cast<uint32_t>(i);
+    event.kind = static_cast<int32_t>(i % 7);
+    event.latitude = 48.85 + static_cast<double>(i % 100) / 1e4;
+    event.longitude = 2.35 - static_cast<double>(i % 100) / 1e4;
+    event.source = "sensor-" + std::to_string(i % 32);
+    event.values.assign(i % 16, static_cast<int32_t>(i));
+  }
+
+  // the same messages without framing, one after the other
+  std::string plain(256 * count + (64 << 10), '\0');
+  size_t plain_size = 0;
+  auto unframed = [&] {
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, &plain[0], plain.size());
+    for (auto &event : events) {
+      seria::serialize(event, &writer);
+    }
+    plain_size = mpack_writer_buffer_used(&writer);
+    mpack_writer_destroy(&writer);
+  };
+  unframed();
+  measure("msgpack serialize, unframed", 10, plain_size, unframed);
+
+  seria::frame_options checked;
+  seria::frame_options bare;
+  bare.checksum = false;
+  seria::frame_options full;
+  full.fingerprint = true;
+  struct {
+    const char *encode;
+    const char *decode;
+    seria::frame_options options;
+  } modes[] = {
+      {"frame_writer", "frame_reader", bare},
+      {"frame_writer, crc32c", "frame_reader, crc32c", checked},
+      {"frame_writer, crc32c + fingerprint",
+       "frame_reader, crc32c + fingerprint", full},
+  };
+
+  for (auto &mode : modes) {
+    seria::frame_writer writer(mode.options);
+    auto encode = [&] {
+      writer.clear();
+      for (auto &event : events) {
+        writer.write(event);
+      }
+    };
+    encode();
+    measure(mode.encode, 10, writer.size(), encode);
+
+    // received in 64 KB reads
+    seria::frame_reader reader(mode.options);
+    Event event;
+    measure(mode.decode, 10, writer.size(), [&] {
+      size_t decoded = 0;
+      for (size_t sent = 0; sent < writer.size(); sent += 64 << 10) {
+        reader.feed(writer.data() + sent,
+                    std::min<size_t>(64 << 10, writer.size() - sent));
+        while (reader.next(event)) {
+          decoded++;
+        }
+      }
+      do_not_optimize(decoded);
+    });
+  }
+
+  measure("crc32c", 10, plain_size, [&] {
+    do_not_optimize(seria::crc32c::compute(plain.data(), plain_size));
+  });
+}
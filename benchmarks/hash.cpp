@@ -0,0 +1,77 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/hash.hpp>
+#include <seria/serialize/binary.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <string>
+
+struct Reading {
+  int64_t timestamp = 0;
+  float value = 0;
+  bool valid = true;
+};
+
+struct Device {
+  uint32_t id = 0;
+  std::string name;
+  std::string location;
+  std::vector<Reading> readings;
+  std::vector<double> calibration;
+};
+
+namespace seria {
+
+template <> auto register_object<Reading>() {
+  return std::make_tuple(member("timestamp", &Reading::timestamp),
+                         member("value", &Reading::value),
+                         member("valid", &Reading::valid));
+}
+
+template <> auto register_object<Device>() {
+  return std::make_tuple(member("id", &Device::id),
+                         member("name", &Device::name),
+                         member("location", &Device::location),
+                         member("readings", &Device::readings),
+                         member("calibration", &Device::calibration));
+}
+
+} // namespace seria
+
+uint64_t hash_bytes(const std::string &bytes) {
+  seria::hash_builder builder;
+  builder.add(bytes.data(), bytes.size());
+  return builder.value();
+}
+
+// usage: bench_hash [devices, 1000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+
+  std::vector<Device> devices(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &device = devices[i];
+    device.id = static_cast<uint32_t>(i);
+    device.name = "device-" + std::to_string(i);
+    device.location = "building " + std::to_string(i % 12);
+    device.readings.resize(16);
+    for (size_t n = 0; n < device.readings.size(); n++) {
+      device.readings[n].timestamp = static_cast<int64_t>(1700000000 + n);
+      device.readings[n].value = static_cast<float>(n) * 0.5f;
+    }
+    device.calibration.assign(64, 1.0 + static_cast<double>(i % 10) / 100);
+  }
+  auto binary = seria::to_binary(devices);
+
+  measure("seria::hash", 20, binary.size(),
+          [&] { do_not_optimize(seria::hash(devices)); });
+  seria::hash_options named;
+  named.names = true;
+  measure("seria::hash, member names", 20, binary.size(),
+          [&] { do_not_optimize(seria::hash(devices, named)); });
+  measure("to_binary + hash", 20, binary.size(),
+          [&] { do_not_optimize(hash_bytes(seria::to_binary(devices))); });
+  measure("to_string + hash", 20, binary.size(),
+          [&] { do_not_optimize(hash_bytes(seria::to_string(devices))); });
+  measure("hash of the binary bytes only", 20, binary.size(),
+          [&] { do_not_optimize(hash_bytes(binary)); });
+}
@@ -0,0 +1,153 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/incremental/rapidjson.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <string>
+#ifdef SERIA_BENCH_MPACK
+#include <seria/deserialize/mpack.hpp>
+#include <seria/incremental/mpack.hpp>
+#include <seria/serialize/mpack.hpp>
+#endif
+
+struct Reading {
+  uint32_t timestamp = 0;
+  int32_t sensor = 0;
+  double value = 0;
+  std::string unit;
+  std::vector<int32_t> flags;
+};
+
+struct Log {
+  std::string source;
+  std::vector<Reading> readings;
+};
+
+namespace seria {
+
+template <> auto register_object<Reading>() {
+  return std::make_tuple(member("timestamp", &Reading::timestamp),
+                         member("sensor", &Reading::sensor),
+                         member("value", &Reading::value),
+                         member("unit", &Reading::unit),
+                         member("flags", &Reading::flags));
+}
+
+template <> auto register_object<Log>() {
+  return std::make_tuple(member("source", &Log::source),
+                         member("readings", &Log::readings));
+}
+
+} // namespace seria
+
+// The input arrives in `chunk` byte pieces, as from a socket. Buffering
+// waits for the whole input before decoding it, the push decoder works on
+// every piece. Prints the total time and the time from the last piece to
+// the decoded value.
+template <typename Buffered, typename Push>
+void compare(const char *format, const std::string &input, size_t chunk,
+             Buffered &&buffered, Push &&push) {
+  using clock = std::chrono::steady_clock;
+  auto ms = [](clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+
+  for (int pass = 0; pass < 2; pass++) {
+    auto start = clock::now();
+    std::string received;
+    for (size_t i = 0; i < input.size(); i += chunk) {
+      received.append(input, i, chunk);
+    }
+    auto last = clock::now();
+    buffered(received);
+    auto end = clock::now();
+    if (pass == 1) {
+      std::printf("%s buffered, %6zu byte pieces   total %9.3f ms, after "
+                  "last piece %9.3f ms\n",
+                  format, chunk, ms(end - start), ms(end - last));
+    }
+
+    start = clock::now();
+    auto decoder = push();
+    for (size_t i = 0; i + chunk < input.size(); i += chunk) {
+      decoder->feed(input.data() + i, chunk);
+    }
+    last = clock::now();
+    auto tail = (input.size() - 1) / chunk * chunk;
+    decoder->feed(input.data() + tail, input.size() - tail);
+    decoder->finish();
+    end = clock::now();
+    if (pass == 1) {
+      std::printf("%s push,     %6zu byte pieces   total %9.3f ms, after "
+                  "last piece %9.3f ms\n",
+                  format, chunk, ms(end - start), ms(end - last));
+    }
+  }
+}
+
+// usage: bench_incremental [readings, 200000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+  Log log;
+  log.source = "station-1";
+  log.readings.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &reading = log.readings[i];
+    reading.timestamp = 1700000000u + static_cast<uint32_t>(i);
+    reading.sensor = static_cast<int32_t>(i % 128);
+    reading.value = static_cast<double>(i % 1000) / 8.0;
+    reading.unit = "celsius";
+    reading.flags = {1, 2, 3};
+  }
+
+  Log result;
+  auto json = seria::to_string(log);
+  std::printf("json: %zu bytes\n", json.size());
+  for (size_t chunk : {1460, 65536}) {
+    compare(
+        "json ", json, chunk,
+        [&](const std::string &text) {
+          rapidjson::Document document;
+          document.Parse(text.data(), text.size());
+          seria::deserialize(result, document);
+          do_not_optimize(result.readings.size());
+        },
+        [&] {
+          return std::make_unique<seria::incremental_decoder<Log>>(result);
+        });
+  }
+
+#ifdef SERIA_BENCH_MPACK
+  char *data = nullptr;
+  size_t size = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &size);
+  seria::serialize(log, &writer);
+  mpack_writer_destroy(&writer);
+  std::string bytes(data, size);
+  free(data);
+
+  std::printf("msgpack: %zu bytes\n", bytes.size());
+  for (size_t chunk : {1460, 65536}) {
+    compare(
+        "mpack", bytes, chunk,
+        [&](const std::string &input) {
+          mpack_tree_t tree;
+          mpack_tree_init_data(&tree, input.data(), input.size());
+          mpack_tree_parse(&tree);
+          seria::deserialize(result, mpack_tree_root(&tree));
+          mpack_tree_destroy(&tree);
+          do_not_optimize(result.readings.size());
+        },
+        [&] {
+          using decoder =
+              seria::incremental_decoder<Log, seria::mpack_push_parser>;
+          return std::make_unique<decoder>(result);
+        });
+  }
+#endif
+}
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+#include <seria/serialize/rapidjson.hpp>
+
+struct Sample {
+  int64_t timestamp = 0;
+  int32_t sensor = 0;
+  bool valid = true;
+  double temperature = 0;
+  double humidity = 0;
+  std::array<float, 3> acceleration{};
+  std::array<uint32_t, 4> counters{};
+};
+
+namespace seria {
+
+template <> struct is_json_template<Sample> : std::true_type {};
+
+template <> auto register_object<Sample>() {
+  return std::make_tuple(member("timestamp", &Sample::timestamp),
+                         member("sensor", &Sample::sensor),
+                         member("valid", &Sample::valid),
+                         member("temperature", &Sample::temperature),
+                         member("humidity", &Sample::humidity),
+                         member("acceleration", &Sample::acceleration),
+                         member("counters", &Sample::counters));
+}
+
+} // namespace seria
+
+int main() {
+  std::vector<Sample> samples(100000);
+  size_t bytes = 0;
+  for (size_t i = 0; i < samples.size(); i++) {
+    auto &sample = samples[i];
+    sample.timestamp = 1700000000000 + static_cast<int64_t>(i);
+    sample.sensor = static_cast<int32_t>(i % 64);
+    sample.temperature = 20.0 + static_cast<double>(i % 100) * 0.1;
+    sample.humidity = static_cast<double>(i % 1000) / 7.0;
+    sample.acceleration = {0.5f, -1.25f, static_cast<float>(i)};
+    sample.counters = {1, 22, 333, static_cast<uint32_t>(i)};
+    bytes += seria::to_string(sample).size();
+  }
+
+  std::printf("%zu fixed shape objects, %zu bytes of json\n", samples.size(),
+              bytes);
+  measure("  to_string (document)", 5, bytes, [&] {
+    for (auto &sample : samples) {
+      do_not_optimize(seria::to_string_document(sample));
+    }
+  });
+  measure("  to_string (template)", 5, bytes, [&] {
+    for (auto &sample : samples) {
+      do_not_optimize(seria::to_string(sample));
+    }
+  });
+}
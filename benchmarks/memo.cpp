@@ -0,0 +1,129 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/memo.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <string>
+#ifdef SERIA_BENCH_MPACK
+#include <seria/serialize/mpack.hpp>
+#endif
+
+struct Attribute {
+  std::string name;
+  std::string value;
+  double weight = 0;
+};
+
+struct Entry {
+  uint64_t version = 0;
+  std::string sku;
+  std::string title;
+  std::string description;
+  std::vector<Attribute> attributes;
+  std::vector<int32_t> related;
+};
+
+struct Page {
+  int32_t number = 0;
+  std::vector<Entry> entries;
+};
+
+namespace seria {
+
+template <> struct is_memoized<Entry> : std::true_type {};
+
+template <> auto register_object<Attribute>() {
+  return std::make_tuple(member("name", &Attribute::name),
+                         member("value", &Attribute::value),
+                         member("weight", &Attribute::weight));
+}
+
+template <> auto register_object<Entry>() {
+  return std::make_tuple(member("version", &Entry::version),
+                         member("sku", &Entry::sku),
+                         member("title", &Entry::title),
+                         member("description", &Entry::description),
+                         member("attributes", &Entry::attributes),
+                         member("related", &Entry::related));
+}
+
+template <> auto register_object<Page>() {
+  return std::make_tuple(member("number", &Page::number),
+                         member("entries", &Page::entries));
+}
+
+} // namespace seria
+
+void report(const seria::memo_cache &cache) {
+  auto stats = cache.stats();
+  std::printf("%-40s %5.1f%% hits, %zu entries, %zu bytes\n", "",
+              stats.hit_rate() * 100, stats.entries, stats.bytes);
+}
+
+// usage: bench_memo [entries, 200 by default] [changed, 1 in 20 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+  size_t changed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+  Page page;
+  page.entries.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &entry = page.entries[i];
+    entry.sku = "SKU-" + std::to_string(100000 + i);
+    entry.title = "Catalog entry number " + std::to_string(i);
+    entry.description = std::string(400, 'd');
+    for (int n = 0; n < 12; n++) {
+      entry.attributes.push_back(
+          {"attribute " + std::to_string(n), "value " + std::to_string(i),
+           0.125 * n});
+    }
+    entry.related.assign(32, static_cast<int32_t>(i));
+  }
+  // the same page sent again and again, with one entry in `changed` updated
+  // before each response
+  size_t next = 0;
+  auto update = [&] {
+    for (size_t i = 0; i < count / changed; i++) {
+      auto &entry = page.entries[next++ % count];
+      entry.version++;
+    }
+  };
+
+  auto json = seria::to_string(page);
+  measure("to_string", 50, json.size(), [&] {
+    update();
+    do_not_optimize(seria::to_string(page).size());
+  });
+
+  seria::memo_cache cache(64 << 20);
+  {
+    seria::memo_scope scope(cache);
+    measure("to_string, memoized", 50, json.size(), [&] {
+      update();
+      do_not_optimize(seria::to_string(page).size());
+    });
+  }
+  report(cache);
+
+#ifdef SERIA_BENCH_MPACK
+  std::string buffer(json.size() * 2, '\0');
+  size_t used = 0;
+  auto encode = [&] {
+    update();
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, &buffer[0], buffer.size());
+    seria::serialize(page, &writer);
+    used = mpack_writer_buffer_used(&writer);
+    mpack_writer_destroy(&writer);
+  };
+  encode();
+  measure("msgpack serialize", 50, used, encode);
+
+  cache.clear();
+  cache.reset_stats();
+  {
+    seria::memo_scope scope(cache);
+    measure("msgpack serialize, memoized", 50, used, encode);
+  }
+  report(cache);
+#endif
+}
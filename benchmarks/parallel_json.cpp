@@ -0,0 +1,71 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <string>
+
+struct Reading {
+  uint32_t timestamp = 0;
+  int32_t sensor = 0;
+  double value = 0;
+  std::string unit;
+  std::vector<int32_t> flags;
+};
+
+struct Log {
+  std::string source;
+  std::vector<Reading> readings;
+};
+
+namespace seria {
+
+template <> auto register_object<Reading>() {
+  return std::make_tuple(member("timestamp", &Reading::timestamp),
+                         member("sensor", &Reading::sensor),
+                         member("value", &Reading::value),
+                         member("unit", &Reading::unit),
+                         member("flags", &Reading::flags));
+}
+
+template <> auto register_object<Log>() {
+  return std::make_tuple(member("source", &Log::source),
+                         member("readings", &Log::readings));
+}
+
+} // namespace seria
+
+// usage: bench_parallel_json [megabytes of json, 1024 by default]
+int main(int argc, char **argv) {
+  size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+
+  // one document with a single huge array member
+  std::string text = R"({"source":"station-1","readings":[)";
+  Reading reading;
+  reading.unit = "celsius";
+  reading.flags = {1, 2, 3};
+  for (size_t i = 0; text.size() < (megabytes << 20); i++) {
+    reading.timestamp = 1700000000u + static_cast<uint32_t>(i);
+    reading.sensor = static_cast<int32_t>(i % 128);
+    reading.value = static_cast<double>(i % 1000) / 8.0;
+    if (i != 0) {
+      text += ',';
+    }
+    text += seria::to_string(reading);
+  }
+  text += "]}";
+  std::printf("document: %zu bytes\n", text.size());
+
+  measure("  structural index", 3, text.size(), [&] {
+    do_not_optimize(
+        seria::json_structural_index(text.data(), text.size(), 2).size());
+  });
+
+  for (unsigned threads : {1u, 2u, 4u, 8u}) {
+    auto name = "  from_string (" + std::to_string(threads) + " threads)";
+    measure(name.c_str(), 3, text.size(), [&] {
+      Log log;
+      seria::from_string(log, text.data(), text.size(), threads);
+      do_not_optimize(log.readings.size());
+    });
+  }
+}
@@ -0,0 +1,89 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <random>
+#include <seria/record_file.hpp>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+struct Event {
+  uint32_t id = 0;
+  int32_t user = 0;
+  double amount = 0;
+  std::string kind;
+  std::vector<int32_t> items;
+};
+
+namespace seria {
+
+template <> auto register_object<Event>() {
+  return std::make_tuple(member("id", &Event::id), member("user", &Event::user),
+                         member("amount", &Event::amount),
+                         member("kind", &Event::kind),
+                         member("items", &Event::items));
+}
+
+} // namespace seria
+
+// usage: bench_record_file [records, 1000000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  std::vector<Event> events(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &event = events[i];
+    event.id = static_cast<uint32_t>(i);
+    event.user = static_cast<int32_t>(i % 10007);
+    event.amount = 0.25 * static_cast<double>(i % 400);
+    event.kind = i % 3 == 0 ? "purchase" : "view";
+    event.items.assign(i % 8, static_cast<int32_t>(i));
+  }
+
+  auto binary = seria::to_binary(events);
+  auto path = "/tmp/seria-bench-records-" + std::to_string(getpid());
+  measure("write_records", 3, binary.size(),
+          [&] { seria::write_records(path.c_str(), events); });
+
+  // the whole vector decoded to read some of its elements
+  measure("from_binary, whole vector", 3, binary.size(), [&] {
+    std::vector<Event> decoded;
+    seria::from_binary(decoded, binary.data(), binary.size());
+    do_not_optimize(decoded[count / 2].amount);
+  });
+
+  seria::record_file<Event> file(path.c_str());
+  std::mt19937_64 random(42);
+  std::vector<size_t> picks(10000);
+  for (auto &pick : picks) {
+    pick = random() % count;
+  }
+  measure("open + 10000 random get", 10, 0, [&] {
+    seria::record_file<Event> opened(path.c_str());
+    Event event;
+    double sum = 0;
+    for (auto pick : picks) {
+      opened.get(pick, event);
+      sum += event.amount;
+    }
+    do_not_optimize(sum);
+  });
+
+  measure("range, every record", 3, binary.size(), [&] {
+    double sum = 0;
+    for (auto &event : file) {
+      sum += event.amount;
+    }
+    do_not_optimize(sum);
+  });
+
+  auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<double> sums(count);
+  measure("parallel_scan, every record", 3, binary.size(), [&] {
+    file.parallel_scan(
+        [&](size_t i, const Event &event) { sums[i] = event.amount; },
+        threads);
+    do_not_optimize(sums[count / 2]);
+  });
+  std::printf("%-40s %10u\n", "threads", threads);
+  std::remove(path.c_str());
+}
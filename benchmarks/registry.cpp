@@ -0,0 +1,76 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <new>
+#include <seria/object.hpp>
+#ifdef __unix__
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+// 500 registered types whose member tables are constant-initialized
+
+#define SERIA_BENCH_TYPE(N)                                                    \
+  struct Type##N {                                                             \
+    int32_t id = 0;                                                            \
+    double value = 0;                                                          \
+    bool flag = false;                                                         \
+    std::array<int32_t, 4> counts{};                                           \
+  };                                                                           \
+  namespace seria {                                                            \
+  template <> constexpr auto register_object<Type##N>() {                      \
+    return std::make_tuple(member("id", &Type##N::id, int32_t(N)),             \
+                           member("value", &Type##N::value, 0.5),              \
+                           member("flag", &Type##N::flag, true),               \
+                           member("counts", &Type##N::counts));                \
+  }                                                                            \
+  }
+
+#define SERIA_BENCH_RECORD(N)                                                  \
+  &seria::KeyValueRecords<Type##N,                                             \
+                          decltype(seria::register_object<Type##N>())>::members,
+
+SERIA_BENCH_REPEAT500(SERIA_BENCH_TYPE)
+
+static const void *records[] = {SERIA_BENCH_REPEAT500(SERIA_BENCH_RECORD)};
+
+// counts the heap allocations made before `main`
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *ptr = std::malloc(size != 0 ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char **argv) {
+  auto startup_allocations = allocations;
+  if (argc > 1) {
+    return 0;
+  }
+
+  std::printf("registered types: %zu\n", sizeof(records) / sizeof(records[0]));
+  std::printf("heap allocations before main: %zu\n", startup_allocations);
+  for (auto *record : records) {
+    do_not_optimize(record);
+  }
+
+#ifdef __unix__
+  // time to start and exit the process, mostly static initialization
+  char exit_flag[] = "--exit";
+  char *args[] = {argv[0], exit_flag, nullptr};
+  measure("  process start", 50, 0, [&] {
+    pid_t pid;
+    if (posix_spawn(&pid, argv[0], nullptr, nullptr, args, environ) == 0) {
+      int status;
+      waitpid(pid, &status, 0);
+    }
+  });
+#endif
+}
@@ -0,0 +1,105 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/reload/rapidjson.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <string>
+
+struct Logging {
+  std::string level;
+  std::string path;
+  uint32_t rotate_mb = 0;
+};
+
+struct Route {
+  std::string prefix;
+  std::string backend;
+  uint32_t timeout_ms = 0;
+  std::vector<std::string> methods;
+};
+
+struct Backend {
+  std::string name;
+  std::vector<std::string> hosts;
+  double weight = 0;
+};
+
+struct Config {
+  Logging logging;
+  std::vector<Route> routes;
+  std::vector<Backend> backends;
+};
+
+namespace seria {
+
+template <> auto register_object<Logging>() {
+  return std::make_tuple(member("level", &Logging::level),
+                         member("path", &Logging::path),
+                         member("rotate_mb", &Logging::rotate_mb));
+}
+
+template <> auto register_object<Route>() {
+  return std::make_tuple(member("prefix", &Route::prefix),
+                         member("backend", &Route::backend),
+                         member("timeout_ms", &Route::timeout_ms),
+                         member("methods", &Route::methods));
+}
+
+template <> auto register_object<Backend>() {
+  return std::make_tuple(member("name", &Backend::name),
+                         member("hosts", &Backend::hosts),
+                         member("weight", &Backend::weight));
+}
+
+template <> auto register_object<Config>() {
+  return std::make_tuple(member("logging", &Config::logging),
+                         member("routes", &Config::routes),
+                         member("backends", &Config::backends));
+}
+
+} // namespace seria
+
+// usage: bench_reload [routes and backends, 20000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+
+  Config config;
+  config.logging = {"info", "/var/log/gateway.log", 64};
+  for (size_t i = 0; i < count; i++) {
+    auto name = "backend-" + std::to_string(i);
+    config.routes.push_back(
+        {"/api/v1/resource/" + std::to_string(i), name, 3000, {"GET", "PUT"}});
+    config.backends.push_back(
+        {name, {"10.0.0.1:8080", "10.0.0.2:8080"}, 1.0});
+  }
+
+  // two edits of the file, applied alternately: the log level, or the
+  // timeout of one route
+  auto base = seria::to_string(config);
+  config.logging.level = "debug";
+  auto level = seria::to_string(config);
+  config.logging.level = "info";
+  config.routes[count / 2].timeout_ms = 5000;
+  auto route = seria::to_string(config);
+
+  Config target;
+  measure("parse + deserialize", 20, base.size(), [&] {
+    rapidjson::Document document;
+    document.Parse(base.data(), base.size());
+    seria::deserialize(target, document);
+  });
+
+  Config reloaded;
+  seria::json_reloader<Config> reloader(reloaded);
+  reloader.reload(base);
+  bool flip = false;
+  measure("reload, log level edited", 20, base.size(), [&] {
+    flip = !flip;
+    do_not_optimize(reloader.reload(flip ? level : base).size());
+  });
+  measure("reload, one route edited", 20, base.size(), [&] {
+    flip = !flip;
+    do_not_optimize(reloader.reload(flip ? route : base).size());
+  });
+  measure("reload, nothing edited", 20, base.size(),
+          [&] { do_not_optimize(reloader.reload(base).size()); });
+}
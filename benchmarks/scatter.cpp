@@ -0,0 +1,81 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/chunked/rapidjson.hpp>
+#include <seria/scatter.hpp>
+#include <string>
+#ifdef SERIA_BENCH_MPACK
+#include <seria/chunked/mpack.hpp>
+#endif
+
+struct Asset {
+  std::string id;
+  std::string description;
+  std::vector<uint8_t> thumbnail;
+  std::vector<int32_t> tags;
+};
+
+namespace seria {
+
+template <> auto register_object<Asset>() {
+  return std::make_tuple(member("id", &Asset::id),
+                         member("description", &Asset::description),
+                         member("thumbnail", &Asset::thumbnail),
+                         member("tags", &Asset::tags));
+}
+
+} // namespace seria
+
+// `write_scatter` into a reused buffer, the segments are only counted as
+// they would be handed to `writev`
+template <typename Format, typename T>
+void scatter(const char *name, const T &value, size_t bytes) {
+  seria::scatter_buffer buffer(4 << 10);
+  measure(name, 20, bytes, [&] {
+    buffer.clear();
+    seria::write_scatter<Format>(value, buffer);
+    do_not_optimize(buffer.segments().size());
+  });
+  std::printf("%-40s %zu bytes in %zu segments, %zu in the arena\n", "",
+              buffer.size(), buffer.segments().size(), buffer.arena().size());
+}
+
+// usage: bench_scatter [assets, 64 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+
+  // media metadata: a few small fields and large blobs
+  std::vector<Asset> assets(count);
+  for (size_t i = 0; i < count; i++) {
+    auto &asset = assets[i];
+    asset.id = "asset-" + std::to_string(i);
+    asset.description.assign(256 << 10, static_cast<char>('a' + i % 26));
+    asset.thumbnail.assign(1 << 20, static_cast<uint8_t>(i));
+    asset.tags = {1, 2, 3, static_cast<int32_t>(i)};
+  }
+
+  std::vector<std::string> descriptions;
+  for (auto &asset : assets) {
+    descriptions.push_back(asset.description);
+  }
+  auto text = seria::to_string(descriptions);
+  measure("json to_string", 20, text.size(),
+          [&] { do_not_optimize(seria::to_string(descriptions).size()); });
+  scatter<seria::json_chunk_format>("json write_scatter", descriptions,
+                                    text.size());
+
+#ifdef SERIA_BENCH_MPACK
+  size_t size = 0;
+  auto encode = [&] {
+    char *data = nullptr;
+    mpack_writer_t writer;
+    mpack_writer_init_growable(&writer, &data, &size);
+    seria::serialize(assets, &writer);
+    mpack_writer_destroy(&writer);
+    do_not_optimize(data);
+    free(data);
+  };
+  encode();
+  measure("msgpack serialize", 20, size, encode);
+  scatter<seria::mpack_chunk_format>("msgpack write_scatter", assets, size);
+#endif
+}
@@ -0,0 +1,166 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/shm_channel.hpp>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct Tick {
+  uint32_t sequence = 0;
+  int32_t instrument = 0;
+  double bid = 0;
+  double ask = 0;
+  std::string venue;
+};
+
+namespace seria {
+
+template <> auto register_object<Tick>() {
+  return std::make_tuple(member("sequence", &Tick::sequence),
+                         member("instrument", &Tick::instrument),
+                         member("bid", &Tick::bid), member("ask", &Tick::ask),
+                         member("venue", &Tick::venue));
+}
+
+} // namespace seria
+
+using channel = seria::shm_channel<Tick>;
+using seconds = std::chrono::duration<double>;
+
+Tick make_tick(uint32_t sequence) {
+  Tick tick;
+  tick.sequence = sequence;
+  tick.instrument = static_cast<int32_t>(sequence % 500);
+  tick.bid = 100.25;
+  tick.ask = 100.5;
+  tick.venue = "XPAR";
+  return tick;
+}
+
+void report(const char *name, size_t count, seconds elapsed) {
+  std::printf("%-40s %10.3f ms %10.2f M msg/s\n", name, elapsed.count() * 1e3,
+              static_cast<double>(count) / elapsed.count() / 1e6);
+}
+
+// the producer writes each message with its own `write`, the consumer reads
+// as much as it can at once
+void socket_throughput(size_t count) {
+  int fds[2];
+  socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+  auto start = std::chrono::steady_clock::now();
+  auto pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    seria::binary_writer writer;
+    for (size_t i = 0; i < count; i++) {
+      writer.clear();
+      writer.write_le<uint32_t>(0);
+      seria::serialize(make_tick(static_cast<uint32_t>(i)), &writer);
+      auto size = static_cast<uint32_t>(writer.size() - 4);
+      std::memcpy(writer.data(), &size, 4);
+      if (write(fds[1], writer.data(), writer.size()) < 0) {
+        _exit(1);
+      }
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+
+  std::string buffer(1 << 16, '\0');
+  size_t used = 0;
+  size_t received = 0;
+  Tick tick;
+  while (received < count) {
+    auto size = read(fds[0], &buffer[used], buffer.size() - used);
+    if (size <= 0) {
+      break;
+    }
+    used += static_cast<size_t>(size);
+    size_t position = 0;
+    uint32_t length = 0;
+    while (used - position >= 4 &&
+           (std::memcpy(&length, &buffer[position], 4),
+            used - position - 4 >= length)) {
+      seria::binary_reader reader(&buffer[position + 4], length);
+      seria::deserialize(tick, &reader);
+      position += 4 + length;
+      received++;
+    }
+    std::memmove(&buffer[0], &buffer[position], used - position);
+    used -= position;
+  }
+  waitpid(pid, nullptr, 0);
+  close(fds[0]);
+  report("unix socket, write per message", received,
+         std::chrono::steady_clock::now() - start);
+}
+
+void shm_throughput(size_t count) {
+  auto name = "/seria-bench-" + std::to_string(getpid());
+  auto consumer = channel::create(name.c_str(), 1 << 20, 256);
+  auto start = std::chrono::steady_clock::now();
+  auto pid = fork();
+  if (pid == 0) {
+    auto producer = channel::open(name.c_str());
+    for (size_t i = 0; i < count; i++) {
+      producer.send(make_tick(static_cast<uint32_t>(i)));
+    }
+    _exit(0);
+  }
+
+  Tick tick;
+  for (size_t i = 0; i < count; i++) {
+    consumer.receive(tick);
+  }
+  waitpid(pid, nullptr, 0);
+  channel::unlink(name.c_str());
+  report("shm_channel", count, std::chrono::steady_clock::now() - start);
+}
+
+// one message there and back, half of the round trip
+void shm_latency(size_t count) {
+  auto name = "/seria-bench-" + std::to_string(getpid());
+  auto ping = channel::create((name + "-ping").c_str(), 1 << 16, 256);
+  auto pong = channel::create((name + "-pong").c_str(), 1 << 16, 256);
+  auto pid = fork();
+  if (pid == 0) {
+    auto in = channel::open((name + "-ping").c_str());
+    auto out = channel::open((name + "-pong").c_str());
+    Tick tick;
+    for (size_t i = 0; i < count; i++) {
+      while (!in.try_receive(tick)) {
+      }
+      while (!out.try_send(tick)) {
+      }
+    }
+    _exit(0);
+  }
+
+  auto tick = make_tick(0);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    while (!ping.try_send(tick)) {
+    }
+    while (!pong.try_receive(tick)) {
+    }
+  }
+  auto elapsed = seconds(std::chrono::steady_clock::now() - start);
+  waitpid(pid, nullptr, 0);
+  channel::unlink((name + "-ping").c_str());
+  channel::unlink((name + "-pong").c_str());
+  std::printf("%-40s %10.3f us one way\n", "shm_channel ping-pong",
+              elapsed.count() * 1e6 / static_cast<double>(count) / 2);
+}
+
+// usage: bench_shm_channel [messages, 5000000 by default]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000000;
+
+  socket_throughput(count);
+  shm_throughput(count);
+  // busy waiting on both sides, needs two cores to mean anything
+  if (sysconf(_SC_NPROCESSORS_ONLN) > 1) {
+    shm_latency(count / 10);
+  }
+}
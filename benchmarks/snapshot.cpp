@@ -0,0 +1,106 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/serialize/rapidjson.hpp>
+#include <seria/snapshot.hpp>
+#include <string>
+
+struct Listener {
+  std::string address;
+  uint32_t port = 0;
+  bool tls = false;
+};
+
+struct Rule {
+  std::string name;
+  std::string match;
+  std::vector<std::string> tags;
+  std::vector<uint32_t> limits;
+  double weight = 0;
+};
+
+struct Config {
+  std::vector<Listener> listeners;
+  std::vector<Rule> rules;
+};
+
+namespace seria {
+
+template <> auto register_object<Listener>() {
+  return std::make_tuple(member("address", &Listener::address),
+                         member("port", &Listener::port),
+                         member("tls", &Listener::tls));
+}
+
+template <> auto register_object<Rule>() {
+  return std::make_tuple(member("name", &Rule::name),
+                         member("match", &Rule::match),
+                         member("tags", &Rule::tags),
+                         member("limits", &Rule::limits),
+                         member("weight", &Rule::weight));
+}
+
+template <> auto register_object<Config>() {
+  return std::make_tuple(member("listeners", &Config::listeners),
+                         member("rules", &Config::rules));
+}
+
+} // namespace seria
+
+// usage: bench_snapshot [rules, 200000 by default, about 50 MB of json]
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+  Config config;
+  config.listeners.push_back({"0.0.0.0", 443, true});
+  for (size_t i = 0; i < count; i++) {
+    auto id = std::to_string(i);
+    config.rules.push_back({"rule-" + id,
+                            "^/api/v2/tenants/" + id + "/objects/.*$",
+                            {"tenant", "storage", "tier-" + id},
+                            {100, 1000, 10000, static_cast<uint32_t>(i)},
+                            0.5});
+  }
+
+  char directory[] = "/tmp/seria-bench-XXXXXX";
+  if (mkdtemp(directory) == nullptr) {
+    return 1;
+  }
+  auto json_path = std::string(directory) + "/config.json";
+  auto cache_dir = std::string(directory) + "/cache";
+  auto json = seria::to_string(config);
+  auto *file = std::fopen(json_path.c_str(), "wb");
+  std::fwrite(json.data(), 1, json.size(), file);
+  std::fclose(file);
+  auto snapshot = seria::snapshot_path<Config>(json_path, cache_dir);
+
+  // every start decodes into a new value
+  measure("from_string", 5, json.size(), [&] {
+    Config loaded;
+    seria::mapped_file mapped(json_path.c_str());
+    seria::from_string(loaded, mapped.data(), mapped.size());
+    do_not_optimize(loaded.rules.size());
+  });
+  measure("load_cached, first start", 5, json.size(), [&] {
+    std::remove(snapshot.c_str());
+    Config loaded;
+    do_not_optimize(seria::load_cached(loaded, json_path, cache_dir).written);
+  });
+  measure("load_cached, from the snapshot", 5, json.size(), [&] {
+    Config loaded;
+    do_not_optimize(
+        seria::load_cached(loaded, json_path, cache_dir).from_snapshot);
+  });
+  seria::snapshot_options options;
+  options.hash_content = false;
+  measure("load_cached, size and mtime only", 5, json.size(), [&] {
+    Config loaded;
+    do_not_optimize(
+        seria::load_cached(loaded, json_path, cache_dir, options)
+            .from_snapshot);
+  });
+
+  std::remove(snapshot.c_str());
+  std::remove(json_path.c_str());
+  std::remove(cache_dir.c_str());
+  std::remove(directory);
+}
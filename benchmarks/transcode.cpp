@@ -0,0 +1,85 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/serialize/mpack.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <seria/transcode.hpp>
+
+struct Order {
+  int32_t id = 0;
+  std::string symbol = "SERIA";
+  double price = 0;
+  uint32_t quantity = 0;
+  bool buy = true;
+  std::vector<int32_t> fills{};
+};
+
+struct Batch {
+  std::vector<Order> orders{};
+};
+
+namespace seria {
+
+template <> auto register_object<Order>() {
+  return std::make_tuple(member("id", &Order::id),
+                         member("symbol", &Order::symbol),
+                         member("price", &Order::price),
+                         member("quantity", &Order::quantity),
+                         member("buy", &Order::buy),
+                         member("fills", &Order::fills));
+}
+
+template <> auto register_object<Batch>() {
+  return std::make_tuple(member("orders", &Batch::orders));
+}
+
+} // namespace seria
+
+int main() {
+  Batch batch;
+  batch.orders.resize(20000);
+  for (size_t i = 0; i < batch.orders.size(); i++) {
+    auto &order = batch.orders[i];
+    order.id = static_cast<int32_t>(i);
+    order.price = 100.0 + static_cast<double>(i % 100) * 0.25;
+    order.quantity = static_cast<uint32_t>(i % 1000);
+    order.fills.assign(4, static_cast<int32_t>(i));
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> json_writer(buffer);
+  seria::serialize(batch).Accept(json_writer);
+  std::string json(buffer.GetString(), buffer.GetSize());
+  std::printf("orders: %zu bytes of json\n", json.size());
+
+  auto encode = [](const char *name, size_t bytes, auto &&fn) {
+    measure(name, 20, bytes, [&] {
+      char *data = nullptr;
+      size_t size = 0;
+      mpack_writer_t writer;
+      mpack_writer_init_growable(&writer, &data, &size);
+      fn(&writer);
+      mpack_writer_destroy(&writer);
+      do_not_optimize(size);
+      free(data);
+    });
+  };
+
+  encode("  decode json, encode msgpack", json.size(),
+         [&](mpack_writer_t *writer) {
+           rapidjson::Document document;
+           document.Parse(json.data(), json.size());
+           Batch result;
+           seria::deserialize(result, document);
+           seria::serialize(result, writer);
+         });
+
+  encode("  transcode", json.size(), [&](mpack_writer_t *writer) {
+    seria::transcode_json_to_mpack(json.data(), json.size(), writer);
+  });
+
+  encode("  transcode (schema)", json.size(), [&](mpack_writer_t *writer) {
+    seria::transcode_json_to_mpack<Batch>(json.data(), json.size(), writer);
+  });
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "bench.hpp"
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <seria/validate/rapidjson.hpp>
+#ifdef SERIA_BENCH_MPACK
+#include <cstdlib>
+#include <seria/deserialize/mpack.hpp>
+#include <seria/serialize/mpack.hpp>
+#include <seria/validate/mpack.hpp>
+#endif
+
+struct Order {
+  int32_t id = 0;
+  std::string symbol = "SERIA";
+  std::string account = "account-0000000000000000";
+  double price = 0;
+  uint32_t quantity = 0;
+  bool buy = true;
+  std::vector<int32_t> fills{};
+};
+
+struct Batch {
+  std::vector<Order> orders{};
+};
+
+namespace seria {
+
+template <> auto register_object<Order>() {
+  return std::make_tuple(member("id", &Order::id),
+                         member("symbol", &Order::symbol),
+                         member("account", &Order::account),
+                         member("price", &Order::price),
+                         member("quantity", &Order::quantity),
+                         member("buy", &Order::buy),
+                         member("fills", &Order::fills));
+}
+
+template <> auto register_object<Batch>() {
+  return std::make_tuple(member("orders", &Batch::orders));
+}
+
+} // namespace seria
+
+int main() {
+  Batch batch;
+  batch.orders.resize(20000);
+  for (size_t i = 0; i < batch.orders.size(); i++) {
+    auto &order = batch.orders[i];
+    order.id = static_cast<int32_t>(i);
+    order.price = 100.0 + static_cast<double>(i % 100) * 0.25;
+    order.quantity = static_cast<uint32_t>(i % 1000);
+    order.fills.assign(4, static_cast<int32_t>(i));
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> json_writer(buffer);
+  seria::serialize(batch).Accept(json_writer);
+  std::string json(buffer.GetString(), buffer.GetSize());
+  std::printf("orders: %zu bytes of json\n", json.size());
+
+  measure("  json deserialize", 20, json.size(), [&] {
+    rapidjson::Document document;
+    document.Parse(json.data(), json.size());
+    Batch result;
+    seria::deserialize(result, document);
+    do_not_optimize(result.orders.data());
+  });
+
+  measure("  json validate", 20, json.size(), [&] {
+    seria::validate<Batch>(json.data(), json.size());
+  });
+
+#ifdef SERIA_BENCH_MPACK
+  char *data = nullptr;
+  size_t size = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &size);
+  seria::serialize(batch, &writer);
+  mpack_writer_destroy(&writer);
+  std::printf("orders: %zu bytes of msgpack\n", size);
+
+  measure("  msgpack deserialize", 20, size, [&] {
+    mpack_tree_t tree;
+    mpack_tree_init_data(&tree, data, size);
+    mpack_tree_parse(&tree);
+    Batch result;
+    seria::deserialize(result, mpack_tree_root(&tree));
+    mpack_tree_destroy(&tree);
+    do_not_optimize(result.orders.data());
+  });
+
+  measure("  msgpack validate", 20, size, [&] {
+    seria::validate_mpack<Batch>(data, size);
+  });
+  free(data);
+#endif
+  return 0;
+}
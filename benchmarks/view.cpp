@@ -0,0 +1,96 @@
+#include "bench.hpp"
+#include <seria/deserialize/binary.hpp>
+#include <seria/serialize/binary.hpp>
+#include <seria/view.hpp>
+
+struct Position {
+  double x = 0;
+  double y = 0;
+  double z = 0;
+};
+
+struct Record {
+  int64_t id = 0;
+  int32_t age = 0;
+  float score = 0;
+  double balance = 0;
+  std::string name;
+  std::string email;
+  std::string city;
+  Position position{};
+  std::array<int32_t, 8> counters{};
+  std::vector<float> history;
+  std::vector<std::string> tags;
+};
+
+namespace seria {
+
+template <> auto register_object<Position>() {
+  return std::make_tuple(member("x", &Position::x), member("y", &Position::y),
+                         member("z", &Position::z));
+}
+
+template <> auto register_object<Record>() {
+  return std::make_tuple(
+      member("id", &Record::id), member("age", &Record::age),
+      member("score", &Record::score), member("balance", &Record::balance),
+      member("name", &Record::name), member("email", &Record::email),
+      member("city", &Record::city), member("position", &Record::position),
+      member("counters", &Record::counters),
+      member("history", &Record::history), member("tags", &Record::tags));
+}
+
+} // namespace seria
+
+int main() {
+  std::vector<Record> records(100000);
+  for (size_t i = 0; i < records.size(); i++) {
+    auto &record = records[i];
+    record.id = static_cast<int64_t>(i);
+    record.age = static_cast<int32_t>(i % 90);
+    record.score = static_cast<float>(i) * 0.5f;
+    record.name = "name-" + std::to_string(i);
+    record.email = "user" + std::to_string(i) + "@example.com";
+    record.city = "city-" + std::to_string(i % 100);
+    record.history.assign(16, static_cast<float>(i));
+    record.tags = {"alpha", "beta", "gamma"};
+  }
+
+  auto binary = seria::to_binary(records);
+  auto zero_copy = seria::to_zero_copy(records);
+  std::printf("binary %zu bytes, zero-copy %zu bytes\n", binary.size(),
+              zero_copy.size());
+
+  measure("deserialize + read 2 fields", 10, binary.size(), [&] {
+    std::vector<Record> result;
+    seria::from_binary(result, binary.data(), binary.size());
+    int64_t sum = 0;
+    for (auto &record : result) {
+      sum += record.age + record.id;
+    }
+    do_not_optimize(sum);
+  });
+
+  measure("view + read 2 fields", 10, zero_copy.size(), [&] {
+    auto view =
+        seria::make_view<std::vector<Record>>(zero_copy.data(), zero_copy.size());
+    int64_t sum = 0;
+    for (auto record : view) {
+      sum += record.get(&Record::age) + record.get(&Record::id);
+    }
+    do_not_optimize(sum);
+  });
+
+  measure("verify + view + read 2 fields", 10, zero_copy.size(), [&] {
+    seria::verify_view<std::vector<Record>>(zero_copy.data(), zero_copy.size());
+    auto view =
+        seria::make_view<std::vector<Record>>(zero_copy.data(), zero_copy.size());
+    int64_t sum = 0;
+    for (auto record : view) {
+      sum += record.get(&Record::age) + record.get(&Record::id);
+    }
+    do_not_optimize(sum);
+  });
+
+  return 0;
+}
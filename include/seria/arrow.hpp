@@ -0,0 +1,1050 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace seria {
+namespace arrow {
+
+// Apache Arrow IPC streaming format, see
+// https://arrow.apache.org/docs/format/Columnar.html#serialization-and-interprocess-communication-ipc
+// Every registered member of `T` becomes a top-level field of the schema and
+// `std::vector<T>` is written as one record batch without null values.
+
+constexpr size_t buffer_alignment = 64;
+constexpr uint32_t continuation = 0xFFFFFFFF;
+constexpr int16_t metadata_version = 4; // V5
+
+enum message_header : uint8_t {
+  header_schema = 1,
+  header_dictionary_batch = 2,
+  header_record_batch = 3,
+};
+
+enum type_id : uint8_t {
+  type_int = 2,
+  type_floating_point = 3,
+  type_binary = 4,
+  type_utf8 = 5,
+  type_bool = 6,
+  type_list = 12,
+  type_struct = 13,
+  type_fixed_size_list = 16,
+};
+
+#ifdef SERIA_BIG_ENDIAN
+constexpr int16_t native_endianness = 1;
+#else
+constexpr int16_t native_endianness = 0;
+#endif
+
+// Minimal flatbuffers builder, built back to front: children are created
+// before the table referring to them. Offsets are distances from the end of
+// the buffer.
+class flatbuffer_builder {
+public:
+  using offset = uint32_t;
+
+  template <typename T> void push(T value) {
+    auto bits = static_cast<uint64_t>(value);
+    auto *dst = grow(sizeof(T));
+    for (size_t i = 0; i < sizeof(T); i++) {
+      dst[i] = static_cast<char>(bits >> (i * 8));
+    }
+  }
+
+  void align(size_t alignment, size_t additional = 0) {
+    if (alignment > m_min_align) {
+      m_min_align = alignment;
+    }
+
+    auto padding = (~(m_size + additional) + 1) & (alignment - 1);
+    std::memset(grow(padding), 0, padding);
+  }
+
+  offset create_string(const char *data, size_t size) {
+    align(4, size + 1);
+    push<uint8_t>(0);
+    std::memcpy(grow(size), data, size);
+    push(static_cast<uint32_t>(size));
+    return static_cast<offset>(m_size);
+  }
+
+  offset create_offsets(const std::vector<offset> &offsets) {
+    align(4, offsets.size() * 4);
+    for (size_t i = offsets.size(); i-- > 0;) {
+      push(static_cast<uint32_t>(m_size + 4 - offsets[i]));
+    }
+    push(static_cast<uint32_t>(offsets.size()));
+    return static_cast<offset>(m_size);
+  }
+
+  // vector of structs made of two longs, `FieldNode` and `Buffer`
+  offset create_pairs(const std::vector<std::pair<int64_t, int64_t>> &pairs) {
+    align(8, pairs.size() * 16);
+    for (size_t i = pairs.size(); i-- > 0;) {
+      push(pairs[i].second);
+      push(pairs[i].first);
+    }
+    push(static_cast<uint32_t>(pairs.size()));
+    return static_cast<offset>(m_size);
+  }
+
+  void start_table() {
+    m_fields.clear();
+    m_table_start = m_size;
+  }
+
+  template <typename T> void add_scalar(uint16_t id, T value) {
+    align(sizeof(T));
+    push(value);
+    m_fields.emplace_back(id, m_size);
+  }
+
+  void add_offset(uint16_t id, offset target) {
+    align(4);
+    push(static_cast<uint32_t>(m_size + 4 - target));
+    m_fields.emplace_back(id, m_size);
+  }
+
+  offset end_table() {
+    align(4);
+    push<int32_t>(0);
+    auto table = m_size;
+
+    uint16_t count = 0;
+    for (auto &field : m_fields) {
+      count = std::max<uint16_t>(count, field.first + 1);
+    }
+
+    std::vector<uint16_t> slots(count, 0);
+    for (auto &field : m_fields) {
+      slots[field.first] = static_cast<uint16_t>(table - field.second);
+    }
+
+    for (size_t i = count; i-- > 0;) {
+      push(slots[i]);
+    }
+    push(static_cast<uint16_t>(table - m_table_start));
+    push(static_cast<uint16_t>(4 + 2 * count));
+
+    // the vtable sits right before the table
+    auto distance = static_cast<uint32_t>(m_size - table);
+    auto *slot = &m_data[m_data.size() - table];
+    for (size_t i = 0; i < 4; i++) {
+      slot[i] = static_cast<char>(distance >> (i * 8));
+    }
+    return static_cast<offset>(table);
+  }
+
+  void finish(offset root) {
+    align(std::max<size_t>(m_min_align, 8), 4);
+    push(static_cast<uint32_t>(m_size + 4 - root));
+  }
+
+  const char *data() const noexcept {
+    return m_data.data() + m_data.size() - m_size;
+  }
+
+  size_t size() const noexcept { return m_size; }
+
+private:
+  char *grow(size_t size) {
+    if (m_data.size() - m_size < size) {
+      auto capacity = std::max<size_t>(m_data.size() * 2, 256);
+      while (capacity - m_size < size) {
+        capacity *= 2;
+      }
+
+      std::string data(capacity, '\0');
+      std::memcpy(&data[capacity - m_size], this->data(), m_size);
+      m_data.swap(data);
+    }
+
+    m_size += size;
+    return &m_data[m_data.size() - m_size];
+  }
+
+  std::string m_data;
+  size_t m_size = 0;
+  size_t m_min_align = 1;
+  size_t m_table_start = 0;
+  std::vector<std::pair<uint16_t, size_t>> m_fields;
+};
+
+// Bounds checked view of a flatbuffers table.
+class flatbuffer_table {
+public:
+  flatbuffer_table(const char *buffer, size_t size, size_t position)
+      : m_buffer(buffer), m_size(size), m_position(position) {
+    auto vtable = static_cast<int64_t>(position) - load<int32_t>(position);
+    if (vtable < 0 || static_cast<size_t>(vtable) + 4 > size) {
+      throw error("malformed arrow metadata");
+    }
+
+    m_vtable = static_cast<size_t>(vtable);
+    m_vtable_size = load<uint16_t>(m_vtable);
+    if (m_vtable + m_vtable_size > size) {
+      throw error("malformed arrow metadata");
+    }
+  }
+
+  static flatbuffer_table root(const char *buffer, size_t size) {
+    flatbuffer_table dummy(buffer, size);
+    return {buffer, size, dummy.load<uint32_t>(0)};
+  }
+
+  bool has(uint16_t id) const { return field(id) != 0; }
+
+  template <typename T> T scalar(uint16_t id, T fallback) const {
+    auto position = field(id);
+    return position == 0 ? fallback : load<T>(position);
+  }
+
+  flatbuffer_table table(uint16_t id) const {
+    return {m_buffer, m_size, target(id)};
+  }
+
+  std::string string(uint16_t id) const {
+    if (!has(id)) {
+      return {};
+    }
+
+    auto position = target(id);
+    auto size = load<uint32_t>(position);
+    check(position + 4, size);
+    return std::string(m_buffer + position + 4, size);
+  }
+
+  // position of the first element and the element count of a vector
+  std::pair<size_t, size_t> vector(uint16_t id, size_t element_size) const {
+    if (!has(id)) {
+      return {0, 0};
+    }
+
+    auto position = target(id);
+    size_t count = load<uint32_t>(position);
+    if (count > m_size / element_size) {
+      throw error("malformed arrow metadata");
+    }
+    check(position + 4, count * element_size);
+    return {position + 4, count};
+  }
+
+  flatbuffer_table table_at(std::pair<size_t, size_t> vector,
+                            size_t index) const {
+    auto position = vector.first + index * 4;
+    return {m_buffer, m_size, position + load<uint32_t>(position)};
+  }
+
+  template <typename T> T load(size_t position) const {
+    check(position, sizeof(T));
+    uint64_t bits = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      bits |= static_cast<uint64_t>(static_cast<uint8_t>(m_buffer[position + i]))
+              << (i * 8);
+    }
+    return static_cast<T>(bits);
+  }
+
+private:
+  flatbuffer_table(const char *buffer, size_t size)
+      : m_buffer(buffer), m_size(size) {}
+
+  size_t field(uint16_t id) const {
+    size_t entry = 4 + 2 * static_cast<size_t>(id);
+    if (entry + 2 > m_vtable_size) {
+      return 0;
+    }
+
+    auto offset = load<uint16_t>(m_vtable + entry);
+    return offset == 0 ? 0 : m_position + offset;
+  }
+
+  size_t target(uint16_t id) const {
+    auto position = field(id);
+    if (position == 0) {
+      throw error("malformed arrow metadata");
+    }
+    return position + load<uint32_t>(position);
+  }
+
+  void check(size_t position, size_t size) const {
+    if (position > m_size || m_size - position < size) {
+      throw error("malformed arrow metadata");
+    }
+  }
+
+  const char *m_buffer;
+  size_t m_size;
+  size_t m_position = 0;
+  size_t m_vtable = 0;
+  size_t m_vtable_size = 0;
+};
+
+// schema
+
+using offset = flatbuffer_builder::offset;
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value, uint8_t>
+write_type(flatbuffer_builder & /*builder*/) {
+  return type_bool;
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value, uint8_t>
+write_type(flatbuffer_builder &builder) {
+  builder.add_scalar<int32_t>(0, sizeof(T) * 8);
+  builder.add_scalar<uint8_t>(1, std::is_signed<T>::value);
+  return type_int;
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value, uint8_t>
+write_type(flatbuffer_builder &builder) {
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8,
+                "no arrow type for this floating point type");
+  builder.add_scalar<int16_t>(0, sizeof(T) == 4 ? 1 : 2);
+  return type_floating_point;
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value, uint8_t>
+write_type(flatbuffer_builder &builder) {
+  return write_type<std::underlying_type_t<T>>(builder);
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value, uint8_t>
+write_type(flatbuffer_builder & /*builder*/) {
+  return type_utf8;
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value, uint8_t>
+write_type(flatbuffer_builder & /*builder*/) {
+  return std::is_same<typename T::value_type, uint8_t>::value ? type_binary
+                                                              : type_list;
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value, uint8_t>
+write_type(flatbuffer_builder &builder) {
+  builder.add_scalar<int32_t>(0, is_array<T>::size);
+  return type_fixed_size_list;
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value, uint8_t>
+write_type(flatbuffer_builder & /*builder*/) {
+  return type_struct;
+}
+
+template <typename T> offset write_field(flatbuffer_builder &builder,
+                                         const char *name);
+
+template <typename T>
+std::enable_if_t<!is_vector<T>::value && !is_array<T>::value &&
+                     !is_object<T>::value,
+                 std::vector<offset>>
+write_children(flatbuffer_builder & /*builder*/) {
+  return {};
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value || is_array<T>::value,
+                 std::vector<offset>>
+write_children(flatbuffer_builder &builder) {
+  using Element = element_type_t<T>;
+  if (std::is_same<T, std::vector<uint8_t>>::value) {
+    return {};
+  }
+  return {write_field<Element>(builder, "item")};
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value, std::vector<offset>>
+write_children(flatbuffer_builder &builder) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  std::vector<offset> children;
+  auto adder = [&builder, &children](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    children.push_back(write_field<Type>(builder, member.m_key));
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+  return children;
+}
+
+template <typename T> offset write_field(flatbuffer_builder &builder,
+                                         const char *name) {
+  auto children = builder.create_offsets(write_children<T>(builder));
+
+  builder.start_table();
+  auto type = write_type<T>(builder);
+  auto type_table = builder.end_table();
+
+  auto key = builder.create_string(name, std::strlen(name));
+
+  builder.start_table();
+  builder.add_offset(0, key);
+  builder.add_scalar<uint8_t>(1, 0); // not nullable
+  builder.add_scalar<uint8_t>(2, type);
+  builder.add_offset(3, type_table);
+  builder.add_offset(5, children);
+  return builder.end_table();
+}
+
+template <typename T> std::string schema_metadata() {
+  flatbuffer_builder builder;
+  auto fields = builder.create_offsets(write_children<T>(builder));
+
+  builder.start_table();
+  builder.add_scalar<int16_t>(0, native_endianness);
+  builder.add_offset(1, fields);
+  auto schema = builder.end_table();
+
+  builder.start_table();
+  builder.add_scalar<int16_t>(0, metadata_version);
+  builder.add_scalar<uint8_t>(1, header_schema);
+  builder.add_offset(2, schema);
+  builder.add_scalar<int64_t>(3, 0);
+  builder.finish(builder.end_table());
+  return std::string(builder.data(), builder.size());
+}
+
+// compares a field of the stream with the field derived from the registered
+// type, list items may carry any name
+inline void check_field(const flatbuffer_table &expected,
+                        const flatbuffer_table &actual, bool check_name) {
+  auto name = expected.string(0);
+  try {
+    if (check_name && actual.string(0) != name) {
+      throw error("arrow field name mismatch, expected `" + name + "`");
+    }
+
+    auto type = expected.scalar<uint8_t>(2, 0);
+    if (actual.scalar<uint8_t>(2, 0) != type) {
+      throw error("arrow type mismatch");
+    }
+
+    auto expected_params = expected.table(3);
+    auto actual_params = actual.table(3);
+    auto same = true;
+    if (type == type_int) {
+      same = expected_params.scalar<int32_t>(0, 0) ==
+                 actual_params.scalar<int32_t>(0, 0) &&
+             expected_params.scalar<uint8_t>(1, 0) ==
+                 actual_params.scalar<uint8_t>(1, 0);
+    } else if (type == type_floating_point) {
+      same = expected_params.scalar<int16_t>(0, 0) ==
+             actual_params.scalar<int16_t>(0, 0);
+    } else if (type == type_fixed_size_list) {
+      same = expected_params.scalar<int32_t>(0, 0) ==
+             actual_params.scalar<int32_t>(0, 0);
+    }
+    if (!same) {
+      throw error("arrow type mismatch");
+    }
+
+    if (actual.has(4)) {
+      throw error("dictionary encoded fields are not supported");
+    }
+
+    auto expected_children = expected.vector(5, 4);
+    auto actual_children = actual.vector(5, 4);
+    if (expected_children.second != actual_children.second) {
+      throw error("arrow field count mismatch");
+    }
+
+    for (size_t i = 0; i < expected_children.second; i++) {
+      check_field(expected.table_at(expected_children, i),
+                  actual.table_at(actual_children, i), type == type_struct);
+    }
+  } catch (error &err) {
+    err.add_prefix(name);
+    throw err;
+  }
+}
+
+template <typename T> void check_schema(const flatbuffer_table &schema) {
+  static const std::string metadata = schema_metadata<T>();
+  auto expected = flatbuffer_table::root(metadata.data(), metadata.size())
+                      .table(2);
+
+  if (schema.scalar<int16_t>(0, 0) != native_endianness) {
+    throw error("arrow stream endianness mismatch");
+  }
+
+  auto expected_fields = expected.vector(1, 4);
+  auto actual_fields = schema.vector(1, 4);
+  if (expected_fields.second != actual_fields.second) {
+    throw error("arrow field count mismatch");
+  }
+
+  for (size_t i = 0; i < expected_fields.second; i++) {
+    check_field(expected.table_at(expected_fields, i),
+                schema.table_at(actual_fields, i), true);
+  }
+}
+
+// record batch
+
+// Collects the field nodes and the 64-byte aligned buffers of a record
+// batch body, in the depth-first order of the schema fields.
+class batch_writer {
+public:
+  void add_node(size_t length) {
+    m_nodes.emplace_back(static_cast<int64_t>(length), 0);
+  }
+
+  // validity bitmaps are omitted since there are no null values
+  void add_empty_buffer() {
+    m_buffers.emplace_back(static_cast<int64_t>(m_body.size()), 0);
+  }
+
+  char *add_buffer(size_t size) {
+    auto padding = (buffer_alignment - size % buffer_alignment) %
+                   buffer_alignment;
+    m_buffers.emplace_back(static_cast<int64_t>(m_body.size()),
+                           static_cast<int64_t>(size));
+
+    auto *data = m_body.reserve(size + padding);
+    std::memset(data + size, 0, padding);
+    return data;
+  }
+
+  const std::vector<std::pair<int64_t, int64_t>> &nodes() const noexcept {
+    return m_nodes;
+  }
+
+  const std::vector<std::pair<int64_t, int64_t>> &buffers() const noexcept {
+    return m_buffers;
+  }
+
+  const binary_writer &body() const noexcept { return m_body; }
+
+private:
+  std::vector<std::pair<int64_t, int64_t>> m_nodes;
+  std::vector<std::pair<int64_t, int64_t>> m_buffers;
+  binary_writer m_body;
+};
+
+inline int32_t checked_offset(size_t offset) {
+  if (offset > static_cast<size_t>(INT32_MAX)) {
+    throw error("arrow column exceeds 2 GiB");
+  }
+  return static_cast<int32_t>(offset);
+}
+
+template <typename T, typename Visit>
+void write_members(size_t length, Visit &&visit, batch_writer &batch);
+
+// `visit(f)` calls `f` on each of the `length` values of the column in order
+
+template <typename T, typename Visit>
+std::enable_if_t<is_boolean<T>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch) {
+  batch.add_node(length);
+  batch.add_empty_buffer();
+
+  auto *bits = batch.add_buffer((length + 7) / 8);
+  std::memset(bits, 0, (length + 7) / 8);
+  size_t index = 0;
+  visit([bits, &index](bool value) {
+    if (value) {
+      bits[index / 8] = static_cast<char>(bits[index / 8] | (1 << (index % 8)));
+    }
+    index++;
+  });
+}
+
+template <typename T, typename Visit>
+std::enable_if_t<(std::is_arithmetic<T>::value || std::is_enum<T>::value) &&
+                 !is_boolean<T>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch) {
+  batch.add_node(length);
+  batch.add_empty_buffer();
+
+  auto *data = batch.add_buffer(length * sizeof(T));
+  visit([&data](const T &value) {
+    std::memcpy(data, &value, sizeof(T));
+    data += sizeof(T);
+  });
+}
+
+template <typename T, typename Visit>
+std::enable_if_t<is_string<T>::value ||
+                 std::is_same<T, std::vector<uint8_t>>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch) {
+  batch.add_node(length);
+  batch.add_empty_buffer();
+
+  auto *offsets = batch.add_buffer((length + 1) * sizeof(int32_t));
+  size_t total = 0;
+  std::memset(offsets, 0, sizeof(int32_t));
+  visit([&offsets, &total](const T &value) {
+    total += value.size();
+    auto offset = checked_offset(total);
+    offsets += sizeof(int32_t);
+    std::memcpy(offsets, &offset, sizeof(offset));
+  });
+
+  auto *data = batch.add_buffer(total);
+  visit([&data](const T &value) {
+    if (!value.empty()) {
+      std::memcpy(data, value.data(), value.size());
+      data += value.size();
+    }
+  });
+}
+
+template <typename T, typename Visit>
+std::enable_if_t<is_vector<T>::value &&
+                 !std::is_same<T, std::vector<uint8_t>>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch);
+
+template <typename T, typename Visit>
+std::enable_if_t<is_array<T>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch);
+
+template <typename T, typename Visit>
+std::enable_if_t<is_object<T>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch);
+
+template <typename T, typename Visit>
+std::enable_if_t<is_vector<T>::value &&
+                 !std::is_same<T, std::vector<uint8_t>>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch) {
+  using Element = typename T::value_type;
+  batch.add_node(length);
+  batch.add_empty_buffer();
+
+  auto *offsets = batch.add_buffer((length + 1) * sizeof(int32_t));
+  size_t total = 0;
+  std::memset(offsets, 0, sizeof(int32_t));
+  visit([&offsets, &total](const T &value) {
+    total += value.size();
+    auto offset = checked_offset(total);
+    offsets += sizeof(int32_t);
+    std::memcpy(offsets, &offset, sizeof(offset));
+  });
+
+  auto items = [&visit](auto &&f) {
+    visit([&f](const T &value) {
+      for (const auto &item : value) {
+        f(item);
+      }
+    });
+  };
+  write_column<Element>(total, items, batch);
+}
+
+template <typename T, typename Visit>
+std::enable_if_t<is_array<T>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch) {
+  using Element = element_type_t<T>;
+  batch.add_node(length);
+  batch.add_empty_buffer();
+
+  auto items = [&visit](auto &&f) {
+    visit([&f](const T &value) {
+      for (const auto &item : value) {
+        f(item);
+      }
+    });
+  };
+  write_column<Element>(length * is_array<T>::size, items, batch);
+}
+
+template <typename T, typename Visit>
+std::enable_if_t<is_object<T>::value>
+write_column(size_t length, Visit &&visit, batch_writer &batch) {
+  batch.add_node(length);
+  batch.add_empty_buffer();
+  write_members<T>(length, visit, batch);
+}
+
+template <typename T, typename Visit>
+void write_members(size_t length, Visit &&visit, batch_writer &batch) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  auto writer = [length, &visit, &batch](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    auto values = [&visit, &member](auto &&f) {
+      visit([&f, &member](const T &value) { f(value.*(member.m_ptr)); });
+    };
+    write_column<Type>(length, values, batch);
+  };
+  for_each(writer, members, std::make_index_sequence<member_size>());
+}
+
+// Walks the field nodes and buffers of a received record batch, checking
+// every buffer against the body bounds.
+class batch_reader {
+public:
+  batch_reader(const flatbuffer_table &batch, const char *body, size_t size)
+      : m_batch(batch), m_body(body), m_body_size(size),
+        m_nodes(batch.vector(1, 16)), m_buffers(batch.vector(2, 16)) {}
+
+  void next_node(size_t length) {
+    if (m_node == m_nodes.second) {
+      throw error("missing arrow field node");
+    }
+
+    auto position = m_nodes.first + 16 * m_node++;
+    auto node_length = m_batch.load<int64_t>(position);
+    auto null_count = m_batch.load<int64_t>(position + 8);
+    if (node_length < 0 || static_cast<uint64_t>(node_length) < length) {
+      throw error("arrow field node is too short");
+    }
+
+    if (null_count != 0) {
+      throw error("null values are not supported");
+    }
+  }
+
+  // returns the buffer, which holds at least `size` bytes
+  const char *next_buffer(size_t size) {
+    if (m_buffer == m_buffers.second) {
+      throw error("missing arrow buffer");
+    }
+
+    auto position = m_buffers.first + 16 * m_buffer++;
+    auto offset = static_cast<uint64_t>(m_batch.load<int64_t>(position));
+    auto length = static_cast<uint64_t>(m_batch.load<int64_t>(position + 8));
+    if (length < size || offset > m_body_size ||
+        m_body_size - offset < length) {
+      throw error("arrow buffer out of bounds");
+    }
+    return m_body + offset;
+  }
+
+  void skip_buffer() { next_buffer(0); }
+
+  // reads and validates `length + 1` offsets, returns them
+  const char *next_offsets(size_t length, size_t *total) {
+    auto *data = next_buffer((length + 1) * sizeof(int32_t));
+    int32_t previous;
+    std::memcpy(&previous, data, sizeof(previous));
+    if (previous != 0) {
+      throw error("arrow offsets must start at zero");
+    }
+
+    for (size_t i = 1; i <= length; i++) {
+      int32_t offset;
+      std::memcpy(&offset, data + i * sizeof(offset), sizeof(offset));
+      if (offset < previous) {
+        throw error("arrow offsets must be non decreasing");
+      }
+      previous = offset;
+    }
+
+    // every value takes at least one bit of the body, which bounds what a
+    // malformed stream can make us allocate
+    *total = static_cast<size_t>(previous);
+    if (*total / 8 > m_body_size) {
+      throw error("arrow offsets out of bounds");
+    }
+    return data;
+  }
+
+private:
+  const flatbuffer_table &m_batch;
+  const char *m_body;
+  size_t m_body_size;
+  std::pair<size_t, size_t> m_nodes;
+  std::pair<size_t, size_t> m_buffers;
+  size_t m_node = 0;
+  size_t m_buffer = 0;
+};
+
+inline int32_t load_offset(const char *offsets, size_t index) {
+  int32_t offset;
+  std::memcpy(&offset, offsets + index * sizeof(offset), sizeof(offset));
+  return offset;
+}
+
+template <typename T, typename Assign>
+void read_members(size_t length, Assign &&assign, batch_reader &batch);
+
+// `assign(f)` calls `f` on each of the `length` targets of the column in
+// order
+
+template <typename T, typename Assign>
+std::enable_if_t<is_boolean<T>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch) {
+  batch.next_node(length);
+  batch.skip_buffer();
+
+  auto *bits = batch.next_buffer((length + 7) / 8);
+  size_t index = 0;
+  assign([bits, &index](auto &&target) {
+    target = ((bits[index / 8] >> (index % 8)) & 1) != 0;
+    index++;
+  });
+}
+
+template <typename T, typename Assign>
+std::enable_if_t<(std::is_arithmetic<T>::value || std::is_enum<T>::value) &&
+                 !is_boolean<T>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch) {
+  batch.next_node(length);
+  batch.skip_buffer();
+
+  auto *data = batch.next_buffer(length * sizeof(T));
+  assign([&data](T &target) {
+    std::memcpy(&target, data, sizeof(T));
+    data += sizeof(T);
+  });
+}
+
+template <typename T, typename Assign>
+std::enable_if_t<is_string<T>::value ||
+                 std::is_same<T, std::vector<uint8_t>>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch) {
+  batch.next_node(length);
+  batch.skip_buffer();
+
+  size_t total = 0;
+  auto *offsets = batch.next_offsets(length, &total);
+  auto *data = batch.next_buffer(total);
+  size_t index = 0;
+  assign([offsets, data, &index](T &target) {
+    auto begin = load_offset(offsets, index);
+    auto end = load_offset(offsets, ++index);
+    target.assign(data + begin, data + end);
+  });
+}
+
+template <typename T, typename Assign>
+std::enable_if_t<is_vector<T>::value &&
+                 !std::is_same<T, std::vector<uint8_t>>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch);
+
+template <typename T, typename Assign>
+std::enable_if_t<is_array<T>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch);
+
+template <typename T, typename Assign>
+std::enable_if_t<is_object<T>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch);
+
+template <typename T, typename Assign>
+std::enable_if_t<is_vector<T>::value &&
+                 !std::is_same<T, std::vector<uint8_t>>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch) {
+  using Element = typename T::value_type;
+  batch.next_node(length);
+  batch.skip_buffer();
+
+  size_t total = 0;
+  auto *offsets = batch.next_offsets(length, &total);
+  size_t index = 0;
+  assign([offsets, &index](T &target) {
+    auto begin = load_offset(offsets, index);
+    auto end = load_offset(offsets, ++index);
+    target.resize(static_cast<size_t>(end - begin));
+  });
+
+  auto items = [&assign](auto &&f) {
+    assign([&f](T &target) {
+      for (auto &&item : target) {
+        f(item);
+      }
+    });
+  };
+  read_column<Element>(total, items, batch);
+}
+
+template <typename T, typename Assign>
+std::enable_if_t<is_array<T>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch) {
+  using Element = element_type_t<T>;
+  batch.next_node(length);
+  batch.skip_buffer();
+
+  auto items = [&assign](auto &&f) {
+    assign([&f](T &target) {
+      for (auto &&item : target) {
+        f(item);
+      }
+    });
+  };
+  read_column<Element>(length * is_array<T>::size, items, batch);
+}
+
+template <typename T, typename Assign>
+std::enable_if_t<is_object<T>::value>
+read_column(size_t length, Assign &&assign, batch_reader &batch) {
+  batch.next_node(length);
+  batch.skip_buffer();
+  read_members<T>(length, assign, batch);
+}
+
+template <typename T, typename Assign>
+void read_members(size_t length, Assign &&assign, batch_reader &batch) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  auto reader = [length, &assign, &batch](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    auto targets = [&assign, &member](auto &&f) {
+      assign([&f, &member](T &target) { f(target.*(member.m_ptr)); });
+    };
+    try {
+      read_column<Type>(length, targets, batch);
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+  for_each(reader, members, std::make_index_sequence<member_size>());
+}
+
+// streams
+
+inline void write_message(const char *metadata, size_t size,
+                          binary_writer *sink) {
+  // pad the metadata so that the body starts 64-byte aligned in the sink
+  auto end = sink->size() + 8 + size;
+  auto padding = (buffer_alignment - end % buffer_alignment) % buffer_alignment;
+  if ((size + padding) % 8 != 0) {
+    padding += 8 - (size + padding) % 8;
+  }
+
+  sink->write_le(continuation);
+  sink->write_le(static_cast<int32_t>(size + padding));
+  sink->write(metadata, size);
+  std::memset(sink->reserve(padding), 0, padding);
+}
+
+template <typename T>
+void write_ipc(const std::vector<T> &rows, binary_writer *sink) {
+  static_assert(is_object<T>::value, "rows must be registered objects");
+
+  auto schema = schema_metadata<T>();
+  write_message(schema.data(), schema.size(), sink);
+
+  batch_writer batch;
+  auto visit = [&rows](auto &&f) {
+    for (auto &row : rows) {
+      f(row);
+    }
+  };
+  write_members<T>(rows.size(), visit, batch);
+
+  flatbuffer_builder builder;
+  auto buffers = builder.create_pairs(batch.buffers());
+  auto nodes = builder.create_pairs(batch.nodes());
+
+  builder.start_table();
+  builder.add_scalar<int64_t>(0, static_cast<int64_t>(rows.size()));
+  builder.add_offset(1, nodes);
+  builder.add_offset(2, buffers);
+  auto record_batch = builder.end_table();
+
+  builder.start_table();
+  builder.add_scalar<int16_t>(0, metadata_version);
+  builder.add_scalar<uint8_t>(1, header_record_batch);
+  builder.add_offset(2, record_batch);
+  builder.add_scalar<int64_t>(3, static_cast<int64_t>(batch.body().size()));
+  builder.finish(builder.end_table());
+
+  write_message(builder.data(), builder.size(), sink);
+  sink->write(batch.body().data(), batch.body().size());
+
+  // end of stream
+  sink->write_le(continuation);
+  sink->write_le<int32_t>(0);
+}
+
+template <typename T> std::string to_ipc(const std::vector<T> &rows) {
+  binary_writer writer;
+  write_ipc(rows, &writer);
+  return writer.str();
+}
+
+// Appends the rows of every record batch of an IPC stream to `rows`. The
+// stream schema must match the one derived from `register_object<T>()`.
+template <typename T>
+void read_ipc(std::vector<T> &rows, const char *data, size_t size) {
+  static_assert(is_object<T>::value, "rows must be registered objects");
+
+  binary_reader reader(data, size);
+  bool has_schema = false;
+  while (reader.remaining() != 0) {
+    auto length = reader.read_le<uint32_t>();
+    if (length == continuation) {
+      length = reader.read_le<uint32_t>();
+    }
+
+    if (length == 0) {
+      break;
+    }
+
+    if (length > reader.remaining()) {
+      throw error("unexpected end of arrow stream");
+    }
+
+    auto *metadata = reader.read(length);
+    auto message = flatbuffer_table::root(metadata, length);
+    auto body_length = message.scalar<int64_t>(3, 0);
+    if (body_length < 0 ||
+        static_cast<uint64_t>(body_length) > reader.remaining()) {
+      throw error("unexpected end of arrow stream");
+    }
+    auto *body = reader.read(static_cast<size_t>(body_length));
+
+    auto header = message.scalar<uint8_t>(1, 0);
+    if (header == header_schema) {
+      check_schema<T>(message.table(2));
+      has_schema = true;
+    } else if (header == header_record_batch) {
+      if (!has_schema) {
+        throw error("arrow record batch before schema");
+      }
+
+      auto batch = message.table(2);
+      if (batch.has(3)) {
+        throw error("compressed arrow record batches are not supported");
+      }
+
+      auto count = batch.scalar<int64_t>(0, 0);
+      if (count < 0 || static_cast<uint64_t>(count) / 8 > size) {
+        throw error("malformed arrow record batch");
+      }
+
+      auto first = rows.size();
+      rows.resize(first + static_cast<size_t>(count));
+
+      batch_reader columns(batch, body, static_cast<size_t>(body_length));
+      auto assign = [&rows, first](auto &&f) {
+        for (size_t i = first; i < rows.size(); i++) {
+          f(rows[i]);
+        }
+      };
+      read_members<T>(static_cast<size_t>(count), assign, columns);
+    } else {
+      throw error("unsupported arrow message");
+    }
+  }
+}
+
+} // namespace arrow
+} // namespace seria
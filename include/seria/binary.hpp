@@ -0,0 +1,237 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) &&               \
+    __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SERIA_BIG_ENDIAN 1
+#endif
+
+namespace seria {
+
+// header of a native binary document: magic, format version, then the 64-bit
+// schema fingerprint of the root type in little-endian order
+constexpr char binary_magic[3] = {'S', 'R', 'B'};
+constexpr uint8_t binary_version = 1;
+constexpr size_t binary_header_size = sizeof(binary_magic) + 1 + 8;
+
+// types whose binary encoding is exactly their little-endian object
+// representation, so that they can be copied with a single `memcpy`
+template <typename T, typename _ = void>
+struct is_binary_pod : std::false_type {};
+
+template <typename T>
+struct is_binary_pod<T, std::enable_if_t<std::is_arithmetic<T>::value &&
+                                         !is_boolean<T>::value>>
+    : std::true_type {};
+
+template <typename T, size_t N>
+struct is_binary_pod<T[N]> : is_binary_pod<T> {};
+
+template <typename T, size_t N>
+struct is_binary_pod<std::array<T, N>>
+    : std::integral_constant<bool, is_binary_pod<T>::value &&
+                                       sizeof(std::array<T, N>) ==
+                                           sizeof(T) * N> {};
+
+template <typename T> T byte_swap(T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  for (size_t i = 0; i < sizeof(T) / 2; i++) {
+    std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+  }
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+class binary_writer {
+public:
+  binary_writer() = default;
+
+  // write into a caller provided buffer, throws `seria::error` on overflow
+  binary_writer(char *buffer, size_t capacity)
+      : m_data(buffer), m_capacity(capacity), m_fixed(true) {}
+
+  char *reserve(size_t size) {
+    if (m_capacity - m_size < size) {
+      grow(size);
+    }
+
+    auto *position = m_data + m_size;
+    m_size += size;
+    return position;
+  }
+
+  void write(const void *data, size_t size) {
+    if (size != 0) {
+      std::memcpy(reserve(size), data, size);
+    }
+  }
+
+  template <typename T> void write_le(T value) {
+#ifdef SERIA_BIG_ENDIAN
+    value = byte_swap(value);
+#endif
+    std::memcpy(reserve(sizeof(T)), &value, sizeof(T));
+  }
+
+  void write_varint(uint64_t value) {
+    char buffer[10];
+    size_t size = 0;
+    while (value >= 0x80) {
+      buffer[size++] = static_cast<char>((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    buffer[size++] = static_cast<char>(value);
+    write(buffer, size);
+  }
+
+  char *data() noexcept { return m_data; }
+
+  const char *data() const noexcept { return m_data; }
+
+  size_t size() const noexcept { return m_size; }
+
+  void clear() noexcept { m_size = 0; }
+
+  std::string str() const { return std::string(m_data, m_size); }
+
+private:
+  void grow(size_t size) {
+    if (m_fixed) {
+      throw error("binary buffer overflow");
+    }
+
+    auto capacity = m_capacity == 0 ? 256 : m_capacity * 2;
+    while (capacity - m_size < size) {
+      capacity *= 2;
+    }
+
+    m_storage.resize(capacity);
+    m_data = &m_storage[0];
+    m_capacity = capacity;
+  }
+
+  std::string m_storage;
+  char *m_data = nullptr;
+  size_t m_size = 0;
+  size_t m_capacity = 0;
+  bool m_fixed = false;
+};
+
+class binary_reader {
+public:
+  binary_reader(const char *data, size_t size)
+      : m_cur(data), m_end(data + size) {}
+
+  const char *read(size_t size) {
+    if (static_cast<size_t>(m_end - m_cur) < size) {
+      throw error("unexpected end of binary data");
+    }
+
+    auto *position = m_cur;
+    m_cur += size;
+    return position;
+  }
+
+  template <typename T> T read_le() {
+    T value;
+    std::memcpy(&value, read(sizeof(T)), sizeof(T));
+#ifdef SERIA_BIG_ENDIAN
+    value = byte_swap(value);
+#endif
+    return value;
+  }
+
+  uint64_t read_varint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (m_cur == m_end) {
+        throw error("unexpected end of binary data");
+      }
+
+      auto byte = static_cast<uint8_t>(*m_cur++);
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+
+    throw error("malformed varint");
+  }
+
+  const char *position() const noexcept { return m_cur; }
+
+  size_t remaining() const noexcept { return m_end - m_cur; }
+
+private:
+  const char *m_cur;
+  const char *m_end;
+};
+
+template <typename Object, typename T>
+size_t member_offset(const Object &obj, T Object::*ptr) {
+  return reinterpret_cast<const char *>(&(obj.*ptr)) -
+         reinterpret_cast<const char *>(&obj);
+}
+
+// Adjacent registered members that are binary pods and also adjacent in
+// memory (no padding between them) are coalesced into runs which are copied
+// with one `memcpy`. `runs[i]` is the byte size of the run starting at member
+// `i`, `covered` if member `i` belongs to an earlier run, or `single` if the
+// member is encoded on its own.
+template <typename T> struct binary_plan {
+  constexpr static uint32_t covered = 0;
+  constexpr static uint32_t single = UINT32_MAX;
+
+  using Members = decltype(register_object<T>());
+  constexpr static size_t member_size = std::tuple_size<Members>::value;
+
+  std::array<size_t, member_size> offsets{};
+  std::array<uint32_t, member_size> runs{};
+
+  static const binary_plan &get(const T &obj) {
+    static const binary_plan plan(obj);
+    return plan;
+  }
+
+private:
+  explicit binary_plan(const T &obj) {
+    auto &members = KeyValueRecords<T, Members>::members;
+    size_t index = 0;
+    size_t run_start = single;
+    size_t run_end = 0;
+
+    auto planner = [&](auto &member) {
+      using Type = typename std::decay_t<decltype(member)>::Type;
+      auto offset = member_offset(obj, member.m_ptr);
+      offsets[index] = offset;
+      runs[index] = single;
+
+#ifndef SERIA_BIG_ENDIAN
+      if (is_binary_pod<Type>::value) {
+        if (run_start != single && run_end == offset) {
+          runs[run_start] += sizeof(Type);
+          runs[index] = covered;
+        } else {
+          run_start = index;
+          runs[index] = sizeof(Type);
+        }
+        run_end = offset + sizeof(Type);
+      } else {
+        run_start = single;
+      }
+#endif
+      index++;
+    };
+
+    for_each(planner, members, std::make_index_sequence<member_size>());
+  }
+};
+
+} // namespace seria
@@ -0,0 +1,276 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+enum cbor_major : uint8_t {
+  cbor_unsigned = 0,
+  cbor_negative = 1,
+  cbor_bytes = 2,
+  cbor_text = 3,
+  cbor_array = 4,
+  cbor_map = 5,
+  cbor_tag = 6,
+  cbor_simple = 7,
+};
+
+constexpr uint8_t cbor_false = 0xF4;
+constexpr uint8_t cbor_true = 0xF5;
+constexpr uint8_t cbor_null = 0xF6;
+constexpr uint8_t cbor_break = 0xFF;
+constexpr unsigned cbor_max_depth = 128;
+
+// RFC 8746 typed array tag of a little-endian packed `T`
+template <typename T> constexpr uint64_t cbor_typed_array_tag() {
+  static_assert(sizeof(T) <= 8, "no typed array tag for this type");
+  return std::is_floating_point<T>::value
+             ? (sizeof(T) == 4 ? 85 : 86)
+             : 64 | (std::is_signed<T>::value ? 0x08 : 0) |
+                   (sizeof(T) > 1 ? 0x04 : 0) |
+                   (sizeof(T) == 1   ? 0
+                    : sizeof(T) == 2 ? 1
+                    : sizeof(T) == 4 ? 2
+                                     : 3);
+}
+
+// Encodes into a caller provided buffer, or a growable one when constructed
+// without arguments. Throws `seria::error` when a fixed buffer overflows.
+class cbor_writer {
+public:
+  cbor_writer() = default;
+
+  cbor_writer(char *buffer, size_t size) : m_buffer(buffer, size) {}
+
+  void write_head(uint8_t major, uint64_t value) {
+    char head[9];
+    auto initial = static_cast<char>(major << 5);
+    if (value < 24) {
+      head[0] = static_cast<char>(initial | value);
+      m_buffer.write(head, 1);
+    } else if (value <= UINT8_MAX) {
+      head[0] = static_cast<char>(initial | 24);
+      head[1] = static_cast<char>(value);
+      m_buffer.write(head, 2);
+    } else if (value <= UINT16_MAX) {
+      head[0] = static_cast<char>(initial | 25);
+      store_big_endian(head + 1, value, 2);
+      m_buffer.write(head, 3);
+    } else if (value <= UINT32_MAX) {
+      head[0] = static_cast<char>(initial | 26);
+      store_big_endian(head + 1, value, 4);
+      m_buffer.write(head, 5);
+    } else {
+      head[0] = static_cast<char>(initial | 27);
+      store_big_endian(head + 1, value, 8);
+      m_buffer.write(head, 9);
+    }
+  }
+
+  void write_uint(uint64_t value) { write_head(cbor_unsigned, value); }
+
+  void write_int(int64_t value) {
+    if (value >= 0) {
+      write_head(cbor_unsigned, static_cast<uint64_t>(value));
+    } else {
+      write_head(cbor_negative, static_cast<uint64_t>(-(value + 1)));
+    }
+  }
+
+  void write_bool(bool value) {
+    write_byte(value ? cbor_true : cbor_false);
+  }
+
+  void write_null() { write_byte(cbor_null); }
+
+  void write_float(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char head[5] = {static_cast<char>(0xFA)};
+    store_big_endian(head + 1, bits, 4);
+    m_buffer.write(head, sizeof(head));
+  }
+
+  void write_double(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char head[9] = {static_cast<char>(0xFB)};
+    store_big_endian(head + 1, bits, 8);
+    m_buffer.write(head, sizeof(head));
+  }
+
+  void write_text(const char *data, size_t size) {
+    write_head(cbor_text, size);
+    m_buffer.write(data, size);
+  }
+
+  void write_bytes(const void *data, size_t size) {
+    write_head(cbor_bytes, size);
+    m_buffer.write(data, size);
+  }
+
+  void start_array(size_t size) { write_head(cbor_array, size); }
+
+  void start_map(size_t size) { write_head(cbor_map, size); }
+
+  void write_tag(uint64_t tag) { write_head(cbor_tag, tag); }
+
+  // appends `size` uninitialized bytes, e.g. for the payload of a byte string
+  char *reserve(size_t size) { return m_buffer.reserve(size); }
+
+  const char *data() const noexcept { return m_buffer.data(); }
+
+  size_t size() const noexcept { return m_buffer.size(); }
+
+  std::string str() const { return m_buffer.str(); }
+
+private:
+  static void store_big_endian(char *dst, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      dst[i] = static_cast<char>(value >> ((size - 1 - i) * 8));
+    }
+  }
+
+  void write_byte(uint8_t byte) {
+    auto value = static_cast<char>(byte);
+    m_buffer.write(&value, 1);
+  }
+
+  binary_writer m_buffer;
+};
+
+struct cbor_head {
+  uint8_t major;
+  uint8_t info;
+  // argument of the head, or the length for strings, arrays and maps
+  uint64_t value;
+  bool indefinite;
+};
+
+// Pull reader over a complete CBOR item, no tree is built.
+class cbor_reader {
+public:
+  cbor_reader(const char *data, size_t size)
+      : m_cur(data), m_end(data + size) {}
+
+  uint8_t peek() const {
+    if (m_cur == m_end) {
+      throw error("unexpected end of cbor data");
+    }
+
+    return static_cast<uint8_t>(*m_cur);
+  }
+
+  bool at_break() const { return peek() == cbor_break; }
+
+  cbor_head read_head() {
+    auto initial = peek();
+    m_cur++;
+
+    cbor_head head{static_cast<uint8_t>(initial >> 5),
+                   static_cast<uint8_t>(initial & 0x1F), 0, false};
+    if (head.info < 24) {
+      head.value = head.info;
+    } else if (head.info <= 27) {
+      size_t size = size_t(1) << (head.info - 24);
+      auto *bytes = reinterpret_cast<const uint8_t *>(read(size));
+      for (size_t i = 0; i < size; i++) {
+        head.value = (head.value << 8) | bytes[i];
+      }
+    } else if (head.info == 31 &&
+               (head.major >= cbor_bytes && head.major <= cbor_map)) {
+      head.indefinite = true;
+    } else if (!(head.info == 31 && head.major == cbor_simple)) {
+      throw error("malformed cbor head");
+    }
+
+    return head;
+  }
+
+  const char *read(size_t size) {
+    if (static_cast<size_t>(m_end - m_cur) < size) {
+      throw error("unexpected end of cbor data");
+    }
+
+    auto *position = m_cur;
+    m_cur += size;
+    return position;
+  }
+
+  // skips one complete data item
+  void skip(unsigned depth = 0) {
+    if (depth > cbor_max_depth) {
+      throw error("nesting too deep");
+    }
+
+    auto head = read_head();
+    switch (head.major) {
+    case cbor_bytes:
+    case cbor_text:
+      if (head.indefinite) {
+        while (!at_break()) {
+          skip(depth + 1);
+        }
+        m_cur++;
+      } else {
+        read(head.value);
+      }
+      break;
+    case cbor_array:
+    case cbor_map: {
+      auto items = head.major == cbor_map ? 2 : 1;
+      if (head.indefinite) {
+        while (!at_break()) {
+          skip(depth + 1);
+        }
+        m_cur++;
+      } else {
+        if (head.value > remaining()) {
+          throw error("unexpected end of cbor data");
+        }
+
+        for (uint64_t i = 0; i < head.value * items; i++) {
+          skip(depth + 1);
+        }
+      }
+      break;
+    }
+    case cbor_tag:
+      skip(depth + 1);
+      break;
+    case cbor_simple:
+      if (head.info == 31) {
+        throw error("unexpected cbor break");
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  size_t remaining() const noexcept { return m_end - m_cur; }
+
+private:
+  const char *m_cur;
+  const char *m_end;
+};
+
+inline double cbor_half_to_double(uint16_t half) {
+  auto exponent = (half >> 10) & 0x1F;
+  auto mantissa = half & 0x3FF;
+  double value;
+  if (exponent == 0) {
+    value = std::ldexp(mantissa, -24);
+  } else if (exponent != 31) {
+    value = std::ldexp(mantissa + 1024, exponent - 25);
+  } else {
+    value = mantissa == 0 ? INFINITY : NAN;
+  }
+  return (half & 0x8000) != 0 ? -value : value;
+}
+
+} // namespace seria
@@ -0,0 +1,380 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <string_view>
+#define SERIA_HAS_COROUTINES
+#endif
+#endif
+
+namespace seria {
+
+enum class chunked_kind : uint8_t {
+  // written at once by the format, with the `serialize` of the backend
+  leaf,
+  object,
+  sequence,
+};
+
+// How `chunked_writer` walks a value of a given type, so that its position
+// in the objects and arrays can be kept between chunks.
+struct chunked_ops {
+  chunked_kind kind = chunked_kind::leaf;
+
+  // objects, the keys are encoded once by the format
+  size_t member_count = 0;
+  const std::string *keys = nullptr;
+  const void *(*member)(const void *object, size_t index,
+                        const chunked_ops **ops) = nullptr;
+
+  // vectors and fixed size arrays
+  size_t (*size)(const void *sequence) = nullptr;
+  const void *(*element)(const void *sequence, size_t index,
+                         const chunked_ops **ops) = nullptr;
+
+  // leaves, appended to `out`
+  void (*leaf)(const void *value, std::string &out) = nullptr;
+  // leaves whose bytes can be referenced in place (strings, binary data):
+  // when there are at least `threshold` of them, appends what precedes them
+  // to `out` and returns them, nullptr otherwise
+  const char *(*blob)(const void *value, size_t threshold, std::string &out,
+                      size_t *size) = nullptr;
+};
+
+template <typename T, typename Format> const chunked_ops &chunked_ops_of();
+
+// Columnar vectors, `std::vector<bool>`, objects with their own `serialize`
+// instead of registered members and whatever the format writes at once are
+// leaves.
+template <typename T, typename Format, typename _ = void>
+struct chunked_type {
+  static chunked_ops make() {
+    chunked_ops ops;
+    ops.leaf = &Format::template write_leaf<T>;
+    set_blob(ops, typename Format::template is_blob<T>{});
+    return ops;
+  }
+
+private:
+  static void set_blob(chunked_ops &ops, std::true_type) {
+    ops.blob = &Format::template write_blob<T>;
+  }
+
+  static void set_blob(chunked_ops & /*ops*/, std::false_type) {}
+};
+
+template <typename T, typename Format>
+struct chunked_type<
+    T, Format,
+    std::enable_if_t<is_object<T>::value &&
+                     std::tuple_size<decltype(register_object<T>())>::value !=
+                         0>> {
+  using Members = decltype(register_object<T>());
+  constexpr static size_t member_size = std::tuple_size<Members>::value;
+
+  static const std::array<std::string, member_size> &keys() {
+    static const auto keys = [] {
+      std::array<std::string, member_size> result{};
+      size_t index = 0;
+      auto encoder = [&](auto &member) {
+        result[index] = Format::encode_key(member.m_key,
+                                           std::strlen(member.m_key), index);
+        index++;
+      };
+      for_each(encoder, KeyValueRecords<T, Members>::members,
+               std::make_index_sequence<member_size>());
+      return result;
+    }();
+    return keys;
+  }
+
+  template <size_t I>
+  static const void *member_at(const void *object, const chunked_ops **ops) {
+    auto &member = std::get<I>(KeyValueRecords<T, Members>::members);
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    *ops = &chunked_ops_of<Type, Format>();
+    return &(static_cast<const T *>(object)->*(member.m_ptr));
+  }
+
+  template <size_t... I>
+  static const void *member(const void *object, size_t index,
+                            const chunked_ops **ops,
+                            std::index_sequence<I...>) {
+    using getter = const void *(*)(const void *, const chunked_ops **);
+    static const getter getters[] = {&member_at<I>...};
+    return getters[index](object, ops);
+  }
+
+  static const void *member(const void *object, size_t index,
+                            const chunked_ops **ops) {
+    return member(object, index, ops, std::make_index_sequence<member_size>());
+  }
+
+  static chunked_ops make() {
+    chunked_ops ops;
+    ops.kind = chunked_kind::object;
+    ops.member_count = member_size;
+    ops.keys = keys().data();
+    ops.member = &member;
+    return ops;
+  }
+};
+
+template <typename T, typename Format>
+struct chunked_type<
+    T, Format,
+    std::enable_if_t<(is_vector<T>::value || is_array<T>::value) &&
+                     !is_columnar_vector<T>::value &&
+                     !is_boolean<element_type_t<T>>::value &&
+                     !Format::template is_leaf<T>::value>> {
+  using Element = element_type_t<T>;
+
+  static size_t size(const void *sequence) {
+    auto &data = *static_cast<const T *>(sequence);
+    return static_cast<size_t>(std::end(data) - std::begin(data));
+  }
+
+  static const void *element(const void *sequence, size_t index,
+                             const chunked_ops **ops) {
+    *ops = &chunked_ops_of<Element, Format>();
+    return &(*static_cast<const T *>(sequence))[index];
+  }
+
+  static chunked_ops make() {
+    chunked_ops ops;
+    ops.kind = chunked_kind::sequence;
+    ops.size = &size;
+    ops.element = &element;
+    return ops;
+  }
+};
+
+template <typename T, typename Format> const chunked_ops &chunked_ops_of() {
+  static const chunked_ops ops = chunked_type<T, Format>::make();
+  return ops;
+}
+
+class json_chunk_format;
+
+// Serializes `T` a chunk at a time, as the consumer asks for it: the output
+// of a large value is produced while the previous chunks are being sent and
+// is never held in memory as a whole. The position in the nested objects
+// and arrays is kept between calls, so memory is one chunk plus the stack of
+// open containers, plus the largest leaf (a string, a columnar vector, ...)
+// which is encoded at once. The output is the same as the backend's
+// `serialize`, `data` has to outlive the writer.
+//
+//   seria::chunked_writer<Test> writer(data);  // json
+//   seria::chunked_writer<Test, seria::mpack_chunk_format> writer(data);
+//   while (!writer.done()) {
+//     auto &chunk = writer.next();
+//     send(socket, chunk.data(), chunk.size(), 0);
+//   }
+template <typename T, typename Format = json_chunk_format>
+class chunked_writer {
+public:
+  explicit chunked_writer(const T &data, size_t chunk_size = 64 << 10)
+      : m_root(&data), m_chunk_size(chunk_size) {}
+
+  // whether all of the output has been read
+  bool done() const noexcept {
+    return m_started && m_depth == 0 && m_pending_read == m_pending.size();
+  }
+
+  // Writes the next `size` bytes of the output into `out`, fewer only at its
+  // end, and returns how many.
+  size_t read(char *out, size_t size) {
+    size_t written = 0;
+    while (written != size) {
+      if (m_pending_read == m_pending.size()) {
+        m_pending.clear();
+        m_pending_read = 0;
+        while (m_pending.size() < size - written && step()) {
+        }
+        if (m_pending.empty()) {
+          break;
+        }
+      }
+
+      auto count = std::min(size - written, m_pending.size() - m_pending_read);
+      std::memcpy(out + written, m_pending.data() + m_pending_read, count);
+      m_pending_read += count;
+      written += count;
+    }
+    return written;
+  }
+
+  // the next chunk of `chunk_size` bytes, shorter at the end of the output
+  // and empty after it
+  const std::string &next() {
+    m_chunk.resize(m_chunk_size);
+    m_chunk.resize(read(&m_chunk[0], m_chunk_size));
+    return m_chunk;
+  }
+
+private:
+  struct frame {
+    const void *value;
+    const chunked_ops *ops;
+    size_t index;
+    size_t count;
+  };
+
+  // appends the next token to `m_pending`, false at the end
+  bool step() {
+    if (!m_started) {
+      m_started = true;
+      visit(m_root, &chunked_ops_of<T, Format>());
+      return true;
+    }
+
+    if (m_depth == 0) {
+      return false;
+    }
+
+    auto &top = m_frames[m_depth - 1];
+    if (top.index == top.count) {
+      if (top.ops->kind == chunked_kind::object) {
+        Format::end_object(m_pending);
+      } else {
+        Format::end_array(m_pending);
+      }
+      m_depth--;
+      return true;
+    }
+
+    const chunked_ops *ops = nullptr;
+    const void *value = nullptr;
+    if (top.ops->kind == chunked_kind::object) {
+      m_pending += top.ops->keys[top.index];
+      value = top.ops->member(top.value, top.index, &ops);
+    } else {
+      Format::separator(m_pending, top.index);
+      value = top.ops->element(top.value, top.index, &ops);
+    }
+    top.index++;
+    visit(value, ops);
+    return true;
+  }
+
+  void visit(const void *value, const chunked_ops *ops) {
+    if (ops->kind == chunked_kind::leaf) {
+      ops->leaf(value, m_pending);
+      return;
+    }
+
+    size_t count = 0;
+    if (ops->kind == chunked_kind::object) {
+      count = ops->member_count;
+      Format::begin_object(m_pending, count);
+    } else {
+      count = ops->size(value);
+      Format::begin_array(m_pending, count);
+    }
+
+    if (m_depth == m_frames.size()) {
+      m_frames.emplace_back();
+    }
+    m_frames[m_depth++] = {value, ops, 0, count};
+  }
+
+  const T *m_root;
+  size_t m_chunk_size;
+  bool m_started = false;
+  std::vector<frame> m_frames;
+  size_t m_depth = 0;
+  // encoded but not read yet
+  std::string m_pending;
+  size_t m_pending_read = 0;
+  std::string m_chunk;
+};
+
+#ifdef SERIA_HAS_COROUTINES
+// The chunks of a `chunked_writer` as a range, for C++20 coroutines:
+//
+//   for (auto chunk : seria::chunks(data)) { ... }
+class chunk_generator {
+public:
+  struct promise_type {
+    std::string_view current;
+
+    chunk_generator get_return_object() {
+      return chunk_generator(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    std::suspend_always yield_value(std::string_view chunk) noexcept {
+      current = chunk;
+      return {};
+    }
+    void return_void() noexcept {}
+    void unhandled_exception() { throw; }
+  };
+
+  class iterator {
+  public:
+    using handle = std::coroutine_handle<promise_type>;
+
+    explicit iterator(handle coroutine) : m_coroutine(coroutine) {}
+
+    std::string_view operator*() const {
+      return m_coroutine.promise().current;
+    }
+    iterator &operator++() {
+      m_coroutine.resume();
+      return *this;
+    }
+    bool operator==(std::default_sentinel_t) const {
+      return m_coroutine.done();
+    }
+
+  private:
+    handle m_coroutine;
+  };
+
+  chunk_generator(chunk_generator &&other) noexcept
+      : m_coroutine(std::exchange(other.m_coroutine, {})) {}
+  chunk_generator(const chunk_generator &) = delete;
+  ~chunk_generator() {
+    if (m_coroutine) {
+      m_coroutine.destroy();
+    }
+  }
+
+  iterator begin() {
+    m_coroutine.resume();
+    return iterator(m_coroutine);
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  explicit chunk_generator(std::coroutine_handle<promise_type> coroutine)
+      : m_coroutine(coroutine) {}
+
+  std::coroutine_handle<promise_type> m_coroutine;
+};
+
+template <typename Format = json_chunk_format, typename T>
+chunk_generator chunks(const T &data, size_t chunk_size = 64 << 10) {
+  chunked_writer<T, Format> writer(data, chunk_size);
+  while (!writer.done()) {
+    auto &chunk = writer.next();
+    if (!chunk.empty()) {
+      co_yield std::string_view(chunk);
+    }
+  }
+}
+#endif
+
+} // namespace seria
@@ -0,0 +1,161 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <mpack/mpack-writer.h>
+#include <seria/chunked.hpp>
+#include <seria/exception.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+namespace seria {
+
+class mpack_chunk_format {
+public:
+  // `std::vector<uint8_t>` is written as `bin`
+  template <typename T, typename _ = void>
+  struct is_leaf : std::false_type {};
+
+  template <typename T>
+  struct is_leaf<T, std::enable_if_t<is_vector<T>::value &&
+                                     std::is_same<typename T::value_type,
+                                                  uint8_t>::value>>
+      : std::true_type {};
+
+  // strings and `bin`
+  template <typename T>
+  struct is_blob
+      : std::integral_constant<bool, is_string<T>::value || is_leaf<T>::value> {
+  };
+
+  static std::string encode_key(const char *key, size_t length,
+                                size_t /*index*/) {
+    std::string result;
+    header(result, 0xa0, 0xdb, length, 31);
+    result.append(key, length);
+    return result;
+  }
+
+  static void begin_object(std::string &out, size_t count) {
+    header(out, 0x80, 0xdf, count, 15);
+  }
+
+  static void end_object(std::string & /*out*/) {}
+
+  static void begin_array(std::string &out, size_t count) {
+    header(out, 0x90, 0xdd, count, 15);
+  }
+
+  static void separator(std::string & /*out*/, size_t /*index*/) {}
+
+  static void end_array(std::string & /*out*/) {}
+
+  template <typename T>
+  static void write_leaf(const void *value, std::string &out) {
+    auto &data = *static_cast<const T *>(value);
+
+    // most leaves fit on the stack, larger ones are written again into a
+    // growable buffer
+    char buffer[256];
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    serialize(data, &writer);
+    auto used = mpack_writer_buffer_used(&writer);
+    auto err = mpack_writer_destroy(&writer);
+    if (err == mpack_ok) {
+      out.append(buffer, used);
+      return;
+    }
+
+    // frees the buffer when `serialize` throws
+    struct encoder_guard {
+      char *bytes = nullptr;
+      size_t size = 0;
+      mpack_writer_t encoder;
+      bool destroyed = false;
+      ~encoder_guard() {
+        if (!destroyed) {
+          mpack_writer_destroy(&encoder);
+        }
+        std::free(bytes);
+      }
+    } guard;
+
+    mpack_writer_init_growable(&guard.encoder, &guard.bytes, &guard.size);
+    serialize(data, &guard.encoder);
+    guard.destroyed = true;
+    err = mpack_writer_destroy(&guard.encoder);
+    if (err != mpack_ok) {
+      throw error(std::string("msgpack writer error: ") +
+                  mpack_error_to_string(err));
+    }
+    out.append(guard.bytes, guard.size);
+  }
+
+  template <typename T>
+  static const char *write_blob(const void *value, size_t threshold,
+                                std::string &out, size_t *size) {
+    auto &data = *static_cast<const T *>(value);
+    if (data.size() < threshold) {
+      return nullptr;
+    }
+    if (is_string<T>::value) {
+      header(out, 0xa0, 0xdb, data.size(), 31);
+    } else {
+      bin_header(out, data.size());
+    }
+    *size = data.size();
+    return reinterpret_cast<const char *>(data.data());
+  }
+
+  static void end_blob(std::string & /*out*/) {}
+
+private:
+  // `bin` has no fixed form, its 8 bit type comes first
+  static void bin_header(std::string &out, size_t length) {
+    size_t bytes = 4;
+    uint8_t type = 0xc6;
+    if (length <= 0xff) {
+      bytes = 1;
+      type = 0xc4;
+    } else if (length <= 0xffff) {
+      bytes = 2;
+      type = 0xc5;
+    }
+    typed_length(out, type, length, bytes);
+  }
+
+  // The smallest encoding of a length, as mpack writes it: in the type
+  // byte up to `fixed_max`, then with one of the 8 (strings only), 16 or 32
+  // bit types ending at `last`.
+  static void header(std::string &out, uint8_t fixed, uint8_t last,
+                     size_t length, size_t fixed_max) {
+    if (length <= fixed_max) {
+      out += static_cast<char>(fixed | length);
+      return;
+    }
+
+    auto with_8 = fixed == 0xa0;
+    size_t bytes = 4;
+    uint8_t type = last;
+    if (with_8 && length <= 0xff) {
+      bytes = 1;
+      type = static_cast<uint8_t>(last - 2);
+    } else if (length <= 0xffff) {
+      bytes = 2;
+      type = static_cast<uint8_t>(last - 1);
+    }
+
+    typed_length(out, type, length, bytes);
+  }
+
+  // the type byte, then `length` in `bytes` big-endian bytes
+  static void typed_length(std::string &out, uint8_t type, size_t length,
+                           size_t bytes) {
+    out += static_cast<char>(type);
+    for (auto i = bytes; i-- > 0;) {
+      out += static_cast<char>((length >> (8 * i)) & 0xff);
+    }
+  }
+};
+
+} // namespace seria
@@ -0,0 +1,14 @@
+#pragma once
+#include <seria/chunked.hpp>
+#include <seria/serialize/mpack.hpp>
+
+namespace seria {
+
+// Msgpack output of `chunked_writer`, the same bytes as `serialize` into a
+// `mpack_writer_t`. Headers and keys are encoded here, leaves go through
+// their `serialize` overload.
+class mpack_chunk_format;
+
+} // namespace seria
+
+#include <seria/chunked/mpack-inl.hpp>
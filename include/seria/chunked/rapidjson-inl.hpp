@@ -0,0 +1,145 @@
+#pragma once
+#include <seria/chunked.hpp>
+#include <seria/exception.hpp>
+#include <seria/type_traits.hpp>
+#ifdef SERIA_USE_EXTERNAL_RAPIDJSON
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#else
+#include <seria/rapidjson/stringbuffer.h>
+#include <seria/rapidjson/writer.h>
+#endif
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace seria {
+
+class json_chunk_format {
+public:
+  template <typename T> struct is_leaf : std::false_type {};
+
+  template <typename T> struct is_blob : is_string<T> {};
+
+  static std::string encode_key(const char *key, size_t length,
+                                size_t index) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.String(key, static_cast<rapidjson::SizeType>(length));
+    std::string result(index == 0 ? "" : ",");
+    result.append(buffer.GetString(), buffer.GetSize());
+    result += ':';
+    return result;
+  }
+
+  static void begin_object(std::string &out, size_t /*count*/) {
+    out += '{';
+  }
+
+  static void end_object(std::string &out) { out += '}'; }
+
+  static void begin_array(std::string &out, size_t /*count*/) { out += '['; }
+
+  static void separator(std::string &out, size_t index) {
+    if (index != 0) {
+      out += ',';
+    }
+  }
+
+  static void end_array(std::string &out) { out += ']'; }
+
+  template <typename T>
+  static void write_leaf(const void *value, std::string &out) {
+    write(*static_cast<const T *>(value), out, json_fixed<T>{});
+  }
+
+  // strings with nothing to escape, between the quotes
+  template <typename T>
+  static const char *write_blob(const void *value, size_t threshold,
+                                std::string &out, size_t *size) {
+    auto &data = *static_cast<const T *>(value);
+    if (data.size() < threshold) {
+      return nullptr;
+    }
+    if (has_escapes(data.data(), data.size())) {
+      return nullptr;
+    }
+    out += '"';
+    *size = data.size();
+    return data.data();
+  }
+
+  static void end_blob(std::string &out) { out += '"'; }
+
+private:
+  // whether one of the bytes is a control character, a quote or a
+  // backslash, checked 8 bytes at a time: a byte of `x - ones * n` has its
+  // high bit set where the byte of `x` below `n` had not
+  static bool has_escapes(const char *data, size_t size) {
+    const uint64_t ones = 0x0101010101010101u;
+    const uint64_t highs = ones * 0x80;
+    auto below = [&](uint64_t x, uint64_t n) {
+      return (x - ones * n) & ~x & highs;
+    };
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+      uint64_t x;
+      std::memcpy(&x, data + i, sizeof(x));
+      if ((below(x, 0x20) | below(x ^ (ones * '"'), 1) |
+           below(x ^ (ones * '\\'), 1)) != 0) {
+        return true;
+      }
+    }
+    for (; i < size; i++) {
+      auto byte = static_cast<unsigned char>(data[i]);
+      if (byte < 0x20 || byte == '"' || byte == '\\') {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // numbers, booleans and fixed size arrays of them, NaN and infinity are
+  // left to the writer which rejects them
+  template <typename T>
+  static void write(const T &value, std::string &out, std::true_type) {
+    auto size = out.size();
+    out.resize(size + json_fixed<T>::bound);
+    bool finite = true;
+    auto *end = write_json_value(value, &out[size], finite);
+    if (!finite) {
+      out.resize(size);
+      write(value, out, std::false_type{});
+      return;
+    }
+    out.resize(static_cast<size_t>(end - out.data()));
+  }
+
+  template <typename T>
+  static void write(const T &value, std::string &out, std::false_type) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    if (!write_document(value, writer)) {
+      throw error("non-finite numbers have no json representation");
+    }
+    out.append(buffer.GetString(), buffer.GetSize());
+  }
+
+  template <typename T>
+  static std::enable_if_t<is_string<T>::value, bool>
+  write_document(const T &value,
+                 rapidjson::Writer<rapidjson::StringBuffer> &writer) {
+    return writer.String(value.data(),
+                         static_cast<rapidjson::SizeType>(value.size()));
+  }
+
+  template <typename T>
+  static std::enable_if_t<!is_string<T>::value, bool>
+  write_document(const T &value,
+                 rapidjson::Writer<rapidjson::StringBuffer> &writer) {
+    return serialize(value).Accept(writer);
+  }
+};
+
+} // namespace seria
@@ -0,0 +1,14 @@
+#pragma once
+#include <seria/chunked.hpp>
+#include <seria/serialize/rapidjson.hpp>
+
+namespace seria {
+
+// Json output of `chunked_writer`, the same text as `to_string`. Numbers
+// and booleans are formatted straight into the output, other leaves go
+// through their `serialize` overload.
+class json_chunk_format;
+
+} // namespace seria
+
+#include <seria/chunked/rapidjson-inl.hpp>
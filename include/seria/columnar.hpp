@@ -0,0 +1,52 @@
+#pragma once
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value> swap_little_endian(T &value) {
+  value = byte_swap(value);
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> swap_little_endian(T &value) {
+  for (auto &element : value) {
+    swap_little_endian(element);
+  }
+}
+
+// Packs member `ptr` of every row into the little-endian column `dst`. The
+// loop is a fixed-size strided copy which compilers turn into plain
+// load/store sequences without calls.
+template <typename Row, typename Object, typename M>
+void gather_column(const Row *rows, size_t size, M Object::*ptr, char *dst) {
+  static_assert(is_binary_pod<M>::value, "column must be arithmetic");
+
+  for (size_t i = 0; i < size; i++) {
+#ifdef SERIA_BIG_ENDIAN
+    M value;
+    std::memcpy(&value, &(rows[i].*ptr), sizeof(M));
+    swap_little_endian(value);
+    std::memcpy(dst + i * sizeof(M), &value, sizeof(M));
+#else
+    std::memcpy(dst + i * sizeof(M), &(rows[i].*ptr), sizeof(M));
+#endif
+  }
+}
+
+// reverse of `gather_column`
+template <typename Row, typename Object, typename M>
+void scatter_column(const char *src, size_t size, M Object::*ptr, Row *rows) {
+  static_assert(is_binary_pod<M>::value, "column must be arithmetic");
+
+  for (size_t i = 0; i < size; i++) {
+    std::memcpy(&(rows[i].*ptr), src + i * sizeof(M), sizeof(M));
+#ifdef SERIA_BIG_ENDIAN
+    swap_little_endian(rows[i].*ptr);
+#endif
+  }
+}
+
+} // namespace seria
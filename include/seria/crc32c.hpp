@@ -0,0 +1,166 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace seria {
+
+// CRC-32C (Castagnoli), as used by iSCSI, ext4 and most framing formats.
+// With SSE4.2 enabled at compile time (`-msse4.2`, `-march=native`) the
+// `crc32` instruction processes 8 bytes at a time, otherwise 8 tables of 256
+// entries do ("slicing by 8"). Both give the same checksums.
+class crc32c {
+public:
+  // continues `crc`, the checksum of the bytes before `data`
+  static uint32_t update(uint32_t crc, const void *data, size_t size) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+#ifdef __SSE4_2__
+    // the instruction has a latency of 3 cycles but a throughput of 1, so
+    // large inputs are checksummed as 3 interleaved streams, combined by
+    // shifting the first ones over the length of the others
+    static const auto &long_shift = shift_tables<long_block>();
+    static const auto &short_shift = shift_tables<short_block>();
+    crc = interleaved<long_block>(crc, bytes, size, long_shift);
+    crc = interleaved<short_block>(crc, bytes, size, short_shift);
+    for (; size >= 8; size -= 8, bytes += 8) {
+      crc = static_cast<uint32_t>(_mm_crc32_u64(crc, load_u64(bytes)));
+    }
+    for (; size != 0; size--) {
+      crc = _mm_crc32_u8(crc, *bytes++);
+    }
+#else
+    auto &table = tables();
+    for (; size >= 8; size -= 8, bytes += 8) {
+      auto low = crc ^ load_le32(bytes);
+      auto high = load_le32(bytes + 4);
+      crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^
+            table[5][(low >> 16) & 0xff] ^ table[4][low >> 24] ^
+            table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^
+            table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+    }
+    for (; size != 0; size--) {
+      crc = table[0][(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+    }
+#endif
+    return ~crc;
+  }
+
+  static uint32_t compute(const void *data, size_t size) {
+    return update(0, data, size);
+  }
+
+private:
+  using table_type = std::array<std::array<uint32_t, 256>, 8>;
+  using shift_type = std::array<std::array<uint32_t, 256>, 4>;
+
+  constexpr static size_t long_block = 8192;
+  constexpr static size_t short_block = 256;
+  constexpr static uint32_t polynomial = 0x82f63b78u;
+
+#ifdef __SSE4_2__
+  static uint64_t load_u64(const uint8_t *bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  template <size_t Block>
+  static uint32_t interleaved(uint32_t crc, const uint8_t *&bytes,
+                              size_t &size, const shift_type &shift) {
+    for (; size >= 3 * Block; size -= 3 * Block, bytes += 3 * Block) {
+      uint64_t crc0 = crc;
+      uint64_t crc1 = 0;
+      uint64_t crc2 = 0;
+      for (size_t i = 0; i < Block; i += 8) {
+        crc0 = _mm_crc32_u64(crc0, load_u64(bytes + i));
+        crc1 = _mm_crc32_u64(crc1, load_u64(bytes + Block + i));
+        crc2 = _mm_crc32_u64(crc2, load_u64(bytes + 2 * Block + i));
+      }
+      crc = apply(shift, static_cast<uint32_t>(crc0)) ^
+            static_cast<uint32_t>(crc1);
+      crc = apply(shift, crc) ^ static_cast<uint32_t>(crc2);
+    }
+    return crc;
+  }
+#endif
+
+  static uint32_t apply(const shift_type &shift, uint32_t crc) {
+    return shift[0][crc & 0xff] ^ shift[1][(crc >> 8) & 0xff] ^
+           shift[2][(crc >> 16) & 0xff] ^ shift[3][crc >> 24];
+  }
+
+  // the product of a 32x32 matrix over GF(2), one column per bit, and `bits`
+  static uint32_t multiply(const uint32_t *matrix, uint32_t bits) {
+    uint32_t result = 0;
+    for (; bits != 0; bits >>= 1, matrix++) {
+      if ((bits & 1) != 0) {
+        result ^= *matrix;
+      }
+    }
+    return result;
+  }
+
+  // `table[k][b]` is the state after `Length` zero bytes following a state
+  // of `b << 8 * k`, the operator for one zero bit being squared up to it
+  template <size_t Length> static const shift_type &shift_tables() {
+    static const shift_type tables = [] {
+      uint32_t op[32];
+      uint32_t square[32];
+      op[0] = polynomial;
+      for (int n = 1; n < 32; n++) {
+        op[n] = 1u << (n - 1);
+      }
+      for (size_t bits = 1; bits < Length * 8; bits *= 2) {
+        for (int n = 0; n < 32; n++) {
+          square[n] = multiply(op, op[n]);
+        }
+        std::memcpy(op, square, sizeof(op));
+      }
+
+      shift_type result{};
+      for (uint32_t n = 0; n < 256; n++) {
+        for (int k = 0; k < 4; k++) {
+          result[k][n] = multiply(op, n << (8 * k));
+        }
+      }
+      return result;
+    }();
+    return tables;
+  }
+
+  static uint32_t load_le32(const uint8_t *bytes) {
+    return static_cast<uint32_t>(bytes[0]) |
+           static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 |
+           static_cast<uint32_t>(bytes[3]) << 24;
+  }
+
+  // `table[k][b]` is the checksum of byte `b` followed by `k` zero bytes
+  static const table_type &tables() {
+    static const table_type tables = [] {
+      table_type result{};
+      for (uint32_t i = 0; i < 256; i++) {
+        auto crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+          crc = (crc >> 1) ^ (polynomial & (0u - (crc & 1)));
+        }
+        result[0][i] = crc;
+      }
+      for (size_t k = 1; k < 8; k++) {
+        for (size_t i = 0; i < 256; i++) {
+          auto previous = result[k - 1][i];
+          result[k][i] = (previous >> 8) ^ result[0][previous & 0xff];
+        }
+      }
+      return result;
+    }();
+    return tables;
+  }
+};
+
+} // namespace seria
@@ -0,0 +1,520 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <seria/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+#include <vector>
+#ifdef SERIA_USE_EXTERNAL_RAPIDJSON
+#include <rapidjson/internal/dtoa.h>
+#include <rapidjson/internal/itoa.h>
+#else
+#include <seria/rapidjson/internal/dtoa.h>
+#include <seria/rapidjson/internal/itoa.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace seria {
+
+struct csv_options {
+  char delimiter = ',';
+  // write a header line, or map the columns of the input by their header
+  bool header = true;
+  // number of threads `from_csv` splits the input across
+  unsigned threads = 1;
+};
+
+inline csv_options tsv_options() {
+  csv_options options;
+  options.delimiter = '\t';
+  return options;
+}
+
+class csv_writer {
+public:
+  explicit csv_writer(char delimiter = ',') : m_delimiter(delimiter) {}
+
+  // write into a caller provided buffer, throws `seria::error` on overflow
+  csv_writer(char *buffer, size_t size, char delimiter = ',')
+      : m_buffer(buffer, size), m_delimiter(delimiter) {}
+
+  char delimiter() const noexcept { return m_delimiter; }
+
+  void write(const char *data, size_t size) { m_buffer.write(data, size); }
+
+  void put(char c) { *m_buffer.reserve(1) = c; }
+
+  // quotes the field when it contains a delimiter, a quote or a line break
+  void write_string(const char *data, size_t size) {
+    auto *end = data + size;
+    auto delimiter = m_delimiter;
+    auto needs_quotes =
+        std::find_if(data, end, [delimiter](char c) {
+          return c == delimiter || c == '"' || c == '\n' || c == '\r';
+        }) != end;
+
+    if (!needs_quotes) {
+      write(data, size);
+      return;
+    }
+
+    put('"');
+    for (auto *cur = data; cur != end;) {
+      auto *quote = std::find(cur, end, '"');
+      write(cur, quote - cur);
+      if (quote == end) {
+        break;
+      }
+      write("\"\"", 2);
+      cur = quote + 1;
+    }
+    put('"');
+  }
+
+  const char *data() const noexcept { return m_buffer.data(); }
+
+  size_t size() const noexcept { return m_buffer.size(); }
+
+  std::string str() const { return m_buffer.str(); }
+
+private:
+  binary_writer m_buffer;
+  char m_delimiter;
+};
+
+inline unsigned csv_count_trailing_zeros(unsigned mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// first delimiter, quote or line break in [cur, end)
+inline const char *csv_find_special(const char *cur, const char *end,
+                                    char delimiter) {
+#ifdef __SSE2__
+  const auto delimiters = _mm_set1_epi8(delimiter);
+  const auto quotes = _mm_set1_epi8('"');
+  const auto newlines = _mm_set1_epi8('\n');
+  const auto returns = _mm_set1_epi8('\r');
+  while (end - cur >= 16) {
+    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cur));
+    auto found = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, delimiters),
+                     _mm_cmpeq_epi8(chunk, quotes)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, newlines),
+                     _mm_cmpeq_epi8(chunk, returns)));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+    if (mask != 0) {
+      return cur + csv_count_trailing_zeros(mask);
+    }
+    cur += 16;
+  }
+#endif
+  while (cur != end && *cur != delimiter && *cur != '"' && *cur != '\n' &&
+         *cur != '\r') {
+    cur++;
+  }
+  return cur;
+}
+
+// RFC 4180 field tokenizer, quoted fields are unescaped into a scratch
+// buffer, others point into the input.
+class csv_reader {
+public:
+  csv_reader(const char *data, size_t size, char delimiter)
+      : m_cur(data), m_end(data + size), m_delimiter(delimiter) {}
+
+  // skips empty lines, returns false at the end of the input
+  bool next_record() {
+    while (m_cur != m_end && (*m_cur == '\n' || *m_cur == '\r')) {
+      m_cur++;
+    }
+    return m_cur != m_end;
+  }
+
+  // reads one field, returns whether more fields follow in the record
+  bool read_field(const char **value, size_t *size) {
+    if (m_cur != m_end && *m_cur == '"') {
+      read_quoted();
+      *value = m_scratch.data();
+      *size = m_scratch.size();
+    } else {
+      auto *special = csv_find_special(m_cur, m_end, m_delimiter);
+      if (special != m_end && *special == '"') {
+        throw error("unexpected quote in unquoted field");
+      }
+      *value = m_cur;
+      *size = special - m_cur;
+      m_cur = special;
+    }
+
+    if (m_cur == m_end) {
+      return false;
+    }
+
+    if (*m_cur == m_delimiter) {
+      m_cur++;
+      return true;
+    }
+
+    if (*m_cur == '\r') {
+      m_cur++;
+    }
+
+    if (m_cur != m_end && *m_cur == '\n') {
+      m_cur++;
+    }
+    return false;
+  }
+
+  const char *position() const noexcept { return m_cur; }
+
+private:
+  void read_quoted() {
+    m_scratch.clear();
+    m_cur++;
+    while (true) {
+      auto *quote = std::find(m_cur, m_end, '"');
+      if (quote == m_end) {
+        throw error("unterminated quoted field");
+      }
+
+      m_scratch.append(m_cur, quote);
+      m_cur = quote + 1;
+      if (m_cur != m_end && *m_cur == '"') {
+        m_scratch.push_back('"');
+        m_cur++;
+        continue;
+      }
+      break;
+    }
+
+    if (m_cur != m_end && *m_cur != m_delimiter && *m_cur != '\n' &&
+        *m_cur != '\r') {
+      throw error("malformed quoted field");
+    }
+  }
+
+  const char *m_cur;
+  const char *m_end;
+  char m_delimiter;
+  std::string m_scratch;
+};
+
+// formatting of a single value
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> csv_format(const T &value,
+                                                  csv_writer *writer) {
+  if (value) {
+    writer->write("true", 4);
+  } else {
+    writer->write("false", 5);
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value>
+csv_format(const T &value, csv_writer *writer) {
+  char buffer[24];
+  auto *end = std::is_signed<T>::value
+                  ? rapidjson::internal::i64toa(static_cast<int64_t>(value),
+                                                buffer)
+                  : rapidjson::internal::u64toa(static_cast<uint64_t>(value),
+                                                buffer);
+  writer->write(buffer, end - buffer);
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+csv_format(const T &value, csv_writer *writer) {
+  if (value != value) {
+    writer->write("nan", 3);
+  } else if (value == std::numeric_limits<T>::infinity()) {
+    writer->write("inf", 3);
+  } else if (value == -std::numeric_limits<T>::infinity()) {
+    writer->write("-inf", 4);
+  } else {
+    char buffer[32];
+    auto *end = rapidjson::internal::dtoa(static_cast<double>(value), buffer);
+    writer->write(buffer, end - buffer);
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> csv_format(const T &value,
+                                                    csv_writer *writer) {
+  csv_format(static_cast<std::underlying_type_t<T>>(value), writer);
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> csv_format(const T &value,
+                                                 csv_writer *writer) {
+  writer->write_string(value.data(), value.size());
+}
+
+// parsing of a single value, the whole field must be consumed
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> csv_parse(T &value, const char *data,
+                                                 size_t size) {
+  if ((size == 4 && std::memcmp(data, "true", 4) == 0) ||
+      (size == 1 && *data == '1')) {
+    value = true;
+  } else if ((size == 5 && std::memcmp(data, "false", 5) == 0) ||
+             (size == 1 && *data == '0')) {
+    value = false;
+  } else {
+    throw type_error("boolean");
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value>
+csv_parse(T &value, const char *data, size_t size) {
+  auto *cur = data;
+  auto *end = data + size;
+  auto negative = cur != end && *cur == '-';
+  if (negative || (cur != end && *cur == '+')) {
+    cur++;
+  }
+
+  if (cur == end || (negative && !std::is_signed<T>::value)) {
+    throw type_error(std::is_signed<T>::value ? "integer"
+                                              : "unsigned integer");
+  }
+
+  // accumulate the magnitude, -min is one more than max
+  auto limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) +
+               (negative ? 1 : 0);
+  uint64_t magnitude = 0;
+  for (; cur != end; cur++) {
+    auto digit = static_cast<unsigned>(*cur - '0');
+    if (digit > 9 || magnitude > (limit - digit) / 10) {
+      throw type_error(std::is_signed<T>::value ? "integer"
+                                                : "unsigned integer");
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+
+  value = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+}
+
+inline double csv_parse_double(const char *data, size_t size) {
+  static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                  1e18, 1e19, 1e20, 1e21, 1e22};
+
+  auto *cur = data;
+  auto *end = data + size;
+  auto negative = cur != end && *cur == '-';
+  if (negative || (cur != end && *cur == '+')) {
+    cur++;
+  }
+
+  // exact when the decimal significand and the power of ten are both
+  // representable, see Clinger's fast path
+  uint64_t significand = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool any = false;
+  for (; cur != end && static_cast<unsigned>(*cur - '0') <= 9; cur++) {
+    any = true;
+    if (digits < 19) {
+      significand = significand * 10 + static_cast<unsigned>(*cur - '0');
+      digits += significand != 0 ? 1 : 0;
+    } else {
+      exponent++;
+      digits++;
+    }
+  }
+
+  if (cur != end && *cur == '.') {
+    for (cur++; cur != end && static_cast<unsigned>(*cur - '0') <= 9; cur++) {
+      any = true;
+      if (digits < 19) {
+        significand = significand * 10 + static_cast<unsigned>(*cur - '0');
+        digits += significand != 0 ? 1 : 0;
+        exponent--;
+      } else {
+        digits++;
+      }
+    }
+  }
+
+  if (any && cur != end && (*cur == 'e' || *cur == 'E')) {
+    int value = 0;
+    auto *start = ++cur;
+    auto exponent_negative = cur != end && *cur == '-';
+    if (exponent_negative || (cur != end && *cur == '+')) {
+      cur++;
+    }
+    for (; cur != end && static_cast<unsigned>(*cur - '0') <= 9; cur++) {
+      value = std::min(value * 10 + (*cur - '0'), 100000);
+    }
+    if (cur == start || static_cast<unsigned>(cur[-1] - '0') > 9) {
+      throw type_error("float or double");
+    }
+    exponent += exponent_negative ? -value : value;
+  }
+
+  if (any && cur == end && digits <= 19 &&
+      significand <= (uint64_t(1) << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    auto value = static_cast<double>(significand);
+    value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+    return negative ? -value : value;
+  }
+
+  // long significands, large exponents, nan and inf
+  std::string text(data, size);
+  char *parsed = nullptr;
+  auto value = std::strtod(text.c_str(), &parsed);
+  if (size == 0 || parsed != text.c_str() + size) {
+    throw type_error("float or double");
+  }
+  return value;
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+csv_parse(T &value, const char *data, size_t size) {
+  value = static_cast<T>(csv_parse_double(data, size));
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> csv_parse(T &value, const char *data,
+                                                   size_t size) {
+  std::underlying_type_t<T> number;
+  try {
+    csv_parse(number, data, size);
+  } catch (type_error &) {
+    throw type_error("int");
+  }
+  value = static_cast<T>(number);
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> csv_parse(T &value, const char *data,
+                                                size_t size) {
+  value.assign(data, size);
+}
+
+// A flattened column of a registered type: nested objects are expanded into
+// dotted names and fixed size arrays into `name.0`, `name.1`...
+struct csv_column {
+  std::string name;
+  size_t offset;
+  void (*format)(const char *value, csv_writer *writer);
+  void (*parse)(char *value, const char *data, size_t size);
+  void (*assign)(char *value, const void *other);
+  const void *default_value;
+};
+
+template <typename T>
+void csv_format_column(const char *value, csv_writer *writer) {
+  csv_format(*reinterpret_cast<const T *>(value), writer);
+}
+
+template <typename T>
+void csv_parse_column(char *value, const char *data, size_t size) {
+  csv_parse(*reinterpret_cast<T *>(value), data, size);
+}
+
+template <typename T> void csv_assign_column(char *value, const void *other) {
+  *reinterpret_cast<T *>(value) = *static_cast<const T *>(other);
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+                 is_string<T>::value>
+csv_add_columns(std::vector<csv_column> &columns, const char *root,
+                const T &value, const T *default_value, std::string name) {
+  columns.push_back({std::move(name),
+                     static_cast<size_t>(
+                         reinterpret_cast<const char *>(&value) - root),
+                     &csv_format_column<T>, &csv_parse_column<T>,
+                     &csv_assign_column<T>, default_value});
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+csv_add_columns(std::vector<csv_column> &columns, const char *root,
+                const T &value, const T *default_value, std::string name);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+csv_add_columns(std::vector<csv_column> &columns, const char *root,
+                const T &value, const T *default_value, std::string name);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+csv_add_columns(std::vector<csv_column> & /*columns*/,
+                const char * /*root*/, const T & /*value*/,
+                const T * /*default_value*/, std::string /*name*/) {
+  static_assert(!is_vector<T>::value,
+                "csv columns must be scalars, strings, fixed size arrays or "
+                "nested objects");
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+csv_add_columns(std::vector<csv_column> &columns, const char *root,
+                const T &value, const T *default_value, std::string name) {
+  for (size_t i = 0; i < is_array<T>::size; i++) {
+    csv_add_columns(columns, root, value[i],
+                    default_value != nullptr ? &(*default_value)[i] : nullptr,
+                    name + "." + std::to_string(i));
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+csv_add_columns(std::vector<csv_column> &columns, const char *root,
+                const T &value, const T *default_value, std::string name) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto adder = [&](auto &member) {
+    // the member default wins over the default of the enclosing object
+    auto *member_default = member.m_has_default
+                               ? &member.m_default_value
+                           : default_value != nullptr
+                               ? &(default_value->*(member.m_ptr))
+                               : nullptr;
+    csv_add_columns(columns, root, value.*(member.m_ptr), member_default,
+                    name.empty() ? member.m_key : name + "." + member.m_key);
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T> const std::vector<csv_column> &csv_columns() {
+  static const std::vector<csv_column> columns = [] {
+    std::vector<csv_column> result;
+    T sample{};
+    csv_add_columns(result, reinterpret_cast<const char *>(&sample), sample,
+                    static_cast<const T *>(nullptr), std::string());
+    return result;
+  }();
+  return columns;
+}
+
+} // namespace seria
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+#include <seria/binary.hpp>
+#include <seria/object.hpp>
+#include <seria/type_graph.hpp>
+#include <seria/type_traits.hpp>
+#include <vector>
+
+namespace seria {
+
+enum class descriptor_kind : uint8_t {
+  boolean,
+  // arithmetic types and enums, stored as `size` little-endian bytes
+  scalar,
+  string,
+  array,
+  vector,
+  columnar,
+  object,
+};
+
+struct type_descriptor;
+
+// type-erased access to a `std::vector`
+struct vector_ops {
+  size_t (*size)(const void *vector);
+  const char *(*data)(const void *vector);
+  // resizes and returns the new data
+  char *(*resize)(void *vector, size_t size);
+};
+
+struct field_descriptor {
+  // the values of `binary_plan`
+  constexpr static uint32_t covered = 0;
+  constexpr static uint32_t single = UINT32_MAX;
+
+  const char *key;
+  uint32_t offset;
+  // bytes of the run of adjacent binary pods starting at this member as in
+  // `binary_plan`, `covered` or `single`
+  uint32_t run;
+  const type_descriptor *type;
+};
+
+// Runtime description of a registered type walked by the table-driven
+// encoders, a single interpreter per backend instead of templates per type.
+struct type_descriptor {
+  descriptor_kind kind = descriptor_kind::object;
+  // the encoding is the memory image of the value
+  bool pod = false;
+  uint32_t size = 0;
+  // elements of fixed size arrays
+  uint32_t count = 0;
+  // elements of arrays and vectors, rows of columnar vectors
+  const type_descriptor *element = nullptr;
+  vector_ops vector{};
+  std::vector<field_descriptor> fields;
+};
+
+template <typename T> const type_descriptor &descriptor_of();
+
+template <typename T> size_t vector_size(const void *vector) {
+  return static_cast<const T *>(vector)->size();
+}
+
+template <typename T> const char *vector_data(const void *vector) {
+  return reinterpret_cast<const char *>(static_cast<const T *>(vector)->data());
+}
+
+template <typename T> char *vector_resize(void *vector, size_t size) {
+  auto *value = static_cast<T *>(vector);
+  value->resize(size);
+  return reinterpret_cast<char *>(value->data());
+}
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> build_descriptor(type_descriptor &type) {
+  type.kind = descriptor_kind::boolean;
+  type.size = sizeof(T);
+}
+
+template <typename T>
+std::enable_if_t<(std::is_arithmetic<T>::value && !is_boolean<T>::value) ||
+                 std::is_enum<T>::value>
+build_descriptor(type_descriptor &type) {
+  type.kind = descriptor_kind::scalar;
+  type.size = sizeof(T);
+#ifndef SERIA_BIG_ENDIAN
+  type.pod = is_binary_pod<T>::value;
+#endif
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> build_descriptor(type_descriptor &type) {
+  type.kind = descriptor_kind::string;
+  type.size = sizeof(T);
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> build_descriptor(type_descriptor &type) {
+  using Element = std::decay_t<decltype(std::declval<T &>()[0])>;
+  type.kind = descriptor_kind::array;
+  type.size = sizeof(T);
+  type.count = is_array<T>::size;
+  type.element = &descriptor_of<Element>();
+#ifndef SERIA_BIG_ENDIAN
+  type.pod = is_binary_pod<T>::value;
+#endif
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value> build_descriptor(type_descriptor &type) {
+  static_assert(!is_boolean<typename T::value_type>::value,
+                "std::vector<bool> has no contiguous storage");
+  type.kind = is_columnar_vector<T>::value ? descriptor_kind::columnar
+                                           : descriptor_kind::vector;
+  type.size = sizeof(T);
+  type.element = &descriptor_of<typename T::value_type>();
+  type.vector = {vector_size<T>, vector_data<T>, vector_resize<T>};
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> build_descriptor(type_descriptor &type) {
+  using Members = decltype(register_object<T>());
+  auto &members = KeyValueRecords<T, Members>::members;
+  constexpr size_t member_size = std::tuple_size<Members>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  type.kind = descriptor_kind::object;
+  type.size = sizeof(T);
+
+  static_assert(binary_plan<T>::covered == field_descriptor::covered &&
+                    binary_plan<T>::single == field_descriptor::single,
+                "");
+
+  // the runs of `binary_plan`, encodings of both paths are the same
+  T sample{};
+  auto &plan = binary_plan<T>::get(sample);
+  size_t index = 0;
+  auto adder = [&](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    type.fields.push_back({member.m_key,
+                           static_cast<uint32_t>(plan.offsets[index]),
+                           plan.runs[index], &descriptor_of<Type>()});
+    index++;
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T> type_descriptor &descriptor_storage() {
+  static type_descriptor type;
+  return type;
+}
+
+// recursive types refer back to the descriptor under construction
+template <typename T> const type_descriptor &descriptor_of() {
+  return type_graph<type_descriptor>::get<T>(
+      descriptor_storage<T>(),
+      [](type_descriptor &type) { build_descriptor<T>(type); });
+}
+
+} // namespace seria
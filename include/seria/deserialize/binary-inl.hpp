@@ -0,0 +1,396 @@
+#pragma once
+#include <seria/binary.hpp>
+#include <seria/columnar.hpp>
+#include <seria/descriptor.hpp>
+#include <seria/exception.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> deserialize(T &data,
+                                                   binary_reader *reader) {
+  auto value = reader->read_le<uint8_t>();
+
+  if (value > 1) {
+    throw type_error("boolean");
+  }
+
+  data = value != 0;
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+deserialize(T &data, binary_reader *reader) {
+  data = reader->read_le<T>();
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> deserialize(T &data,
+                                                     binary_reader *reader) {
+  data = static_cast<T>(reader->read_le<std::underlying_type_t<T>>());
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> deserialize(T &data,
+                                                  binary_reader *reader) {
+  auto size = reader->read_varint();
+  if (size > reader->remaining()) {
+    throw error("unexpected end of binary data");
+  }
+
+  data.assign(reader->read(size), size);
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value>
+deserialize(T &data, binary_reader *reader) {
+  using Element = typename T::value_type;
+  auto size = reader->read_varint();
+
+#ifndef SERIA_BIG_ENDIAN
+  if (is_binary_pod<Element>::value) {
+    if (size > reader->remaining() / sizeof(Element)) {
+      throw error("unexpected end of binary data");
+    }
+
+    data.resize(size);
+    std::memcpy(static_cast<void *>(data.data()),
+                reader->read(size * sizeof(Element)), size * sizeof(Element));
+    return;
+  }
+#endif
+
+  if (size > reader->remaining()) {
+    throw error("unexpected end of binary data");
+  }
+
+  data.resize(size);
+  for (size_t i = 0; i < size; i++) {
+    try {
+      deserialize(data[i], reader);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> deserialize(T &data,
+                                                 binary_reader *reader) {
+#ifndef SERIA_BIG_ENDIAN
+  if (is_binary_pod<T>::value) {
+    std::memcpy(static_cast<void *>(&data), reader->read(sizeof(T)),
+                sizeof(T));
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < is_array<T>::size; i++) {
+    try {
+      deserialize(data[i], reader);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> deserialize(T &data,
+                                                  binary_reader *reader) {
+  auto &members =
+      KeyValueRecords<T, decltype(register_object<std::decay_t<T>>())>::members;
+
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto &plan = binary_plan<T>::get(data);
+  auto *base = reinterpret_cast<char *>(&data);
+  size_t index = 0;
+
+  auto setter = [&](auto &member) {
+    auto run = plan.runs[index];
+    auto offset = plan.offsets[index];
+    index++;
+
+    try {
+      if (run == binary_plan<T>::single) {
+        deserialize(data.*(member.m_ptr), reader);
+      } else if (run != binary_plan<T>::covered) {
+        std::memcpy(base + offset, reader->read(run), run);
+      }
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T, typename Object, typename M>
+void deserialize_column(std::vector<T> &rows, M Object::*ptr,
+                        binary_reader *reader, std::true_type /*pod*/) {
+  if (rows.size() > reader->remaining() / sizeof(M)) {
+    throw error("unexpected end of binary data");
+  }
+
+  scatter_column(reader->read(rows.size() * sizeof(M)), rows.size(), ptr,
+                 rows.data());
+}
+
+template <typename T, typename Object, typename M>
+void deserialize_column(std::vector<T> &rows, M Object::*ptr,
+                        binary_reader *reader, std::false_type /*pod*/) {
+  for (size_t i = 0; i < rows.size(); i++) {
+    try {
+      deserialize(rows[i].*ptr, reader);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value> deserialize(T &data,
+                                                           binary_reader *reader) {
+  using Row = typename T::value_type;
+  auto &members =
+      KeyValueRecords<Row, decltype(register_object<Row>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto size = reader->read_varint();
+  if (size > reader->remaining()) {
+    throw error("unexpected end of binary data");
+  }
+
+  data.resize(size);
+
+  auto setter = [&data, reader](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    try {
+      deserialize_column(data, member.m_ptr, reader, is_binary_pod<Type>{});
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T> void read_binary_header(binary_reader *reader) {
+  auto *magic = reader->read(sizeof(binary_magic));
+  if (std::memcmp(magic, binary_magic, sizeof(binary_magic)) != 0) {
+    throw error("not a seria binary document");
+  }
+
+  if (reader->read_le<uint8_t>() != binary_version) {
+    throw error("unsupported binary version");
+  }
+
+  if (reader->read_le<uint64_t>() != schema_fingerprint<T>()) {
+    throw error("schema fingerprint mismatch");
+  }
+}
+
+template <typename T>
+void from_binary(T &data, const char *buffer, size_t size) {
+  binary_reader reader(buffer, size);
+  read_binary_header<T>(&reader);
+  deserialize(data, &reader);
+
+  if (reader.remaining() != 0) {
+    throw error("unexpected trailing data");
+  }
+}
+
+inline void deserialize_scalar(char *value, size_t size,
+                               binary_reader *reader) {
+  auto *source = reader->read(size);
+#ifdef SERIA_BIG_ENDIAN
+  for (size_t i = 0; i < size; i++) {
+    value[i] = source[size - 1 - i];
+  }
+#else
+  std::memcpy(value, source, size);
+#endif
+}
+
+inline void deserialize_column(const type_descriptor &row,
+                               const field_descriptor &field, char *rows,
+                               size_t size, binary_reader *reader) {
+  auto &column = *field.type;
+  if (column.pod) {
+    if (size > reader->remaining() / column.size) {
+      throw error("unexpected end of binary data");
+    }
+
+    auto *source = reader->read(size * column.size);
+    for (size_t i = 0; i < size; i++) {
+      std::memcpy(rows + i * row.size + field.offset, source + i * column.size,
+                  column.size);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    try {
+      deserialize(column, rows + i * row.size + field.offset, reader);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+// The table-driven decoder, the inverse of the table-driven `serialize`.
+inline void deserialize(const type_descriptor &type, void *data,
+                        binary_reader *reader) {
+  auto *base = static_cast<char *>(data);
+  switch (type.kind) {
+  case descriptor_kind::boolean: {
+    auto value = reader->read_le<uint8_t>();
+    if (value > 1) {
+      throw type_error("boolean");
+    }
+    *static_cast<bool *>(data) = value != 0;
+    break;
+  }
+  case descriptor_kind::scalar:
+    deserialize_scalar(base, type.size, reader);
+    break;
+  case descriptor_kind::string: {
+    auto size = reader->read_varint();
+    if (size > reader->remaining()) {
+      throw error("unexpected end of binary data");
+    }
+    static_cast<std::string *>(data)->assign(reader->read(size), size);
+    break;
+  }
+  case descriptor_kind::array:
+    if (type.pod) {
+      std::memcpy(base, reader->read(type.size), type.size);
+      break;
+    }
+    for (size_t i = 0; i < type.count; i++) {
+      try {
+        deserialize(*type.element, base + i * type.element->size, reader);
+      } catch (type_error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      }
+    }
+    break;
+  case descriptor_kind::vector: {
+    auto &element = *type.element;
+    auto size = reader->read_varint();
+    if (element.pod) {
+      if (size > reader->remaining() / element.size) {
+        throw error("unexpected end of binary data");
+      }
+      auto *values = type.vector.resize(data, size);
+      std::memcpy(values, reader->read(size * element.size),
+                  size * element.size);
+      break;
+    }
+
+    if (size > reader->remaining()) {
+      throw error("unexpected end of binary data");
+    }
+    auto *values = type.vector.resize(data, size);
+    for (size_t i = 0; i < size; i++) {
+      try {
+        deserialize(element, values + i * element.size, reader);
+      } catch (type_error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      }
+    }
+    break;
+  }
+  case descriptor_kind::columnar: {
+    auto size = reader->read_varint();
+    if (size > reader->remaining()) {
+      throw error("unexpected end of binary data");
+    }
+    auto *rows = type.vector.resize(data, size);
+    for (auto &field : type.element->fields) {
+      try {
+        deserialize_column(*type.element, field, rows, size, reader);
+      } catch (type_error &err) {
+        err.add_prefix(field.key);
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(field.key);
+        throw err;
+      }
+    }
+    break;
+  }
+  case descriptor_kind::object:
+    for (auto &field : type.fields) {
+      try {
+        if (field.run == field_descriptor::single) {
+          deserialize(*field.type, base + field.offset, reader);
+        } else if (field.run != field_descriptor::covered) {
+          std::memcpy(base + field.offset, reader->read(field.run), field.run);
+        }
+      } catch (type_error &err) {
+        err.add_prefix(field.key);
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(field.key);
+        throw err;
+      }
+    }
+    break;
+  }
+}
+
+template <typename T>
+void from_binary_table(T &data, const char *buffer, size_t size) {
+  binary_reader reader(buffer, size);
+  read_binary_header<T>(&reader);
+  deserialize(descriptor_of<T>(), &data, &reader);
+
+  if (reader.remaining() != 0) {
+    throw error("unexpected trailing data");
+  }
+}
+
+} // namespace seria
@@ -0,0 +1,54 @@
+#pragma once
+#include <seria/binary.hpp>
+#include <seria/descriptor.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> deserialize(T &data,
+                                                   binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+deserialize(T &data, binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> deserialize(T &data,
+                                                     binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> deserialize(T &data,
+                                                  binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value>
+deserialize(T &data, binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value> deserialize(T &data,
+                                                           binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> deserialize(T &data,
+                                                 binary_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> deserialize(T &data,
+                                                  binary_reader *reader);
+
+template <typename T> void read_binary_header(binary_reader *reader);
+
+template <typename T>
+void from_binary(T &data, const char *buffer, size_t size);
+
+inline void deserialize(const type_descriptor &type, void *data,
+                        binary_reader *reader);
+
+template <typename T>
+void from_binary_table(T &data, const char *buffer, size_t size);
+
+} // namespace seria
+
+#include <seria/deserialize/binary-inl.hpp>
@@ -0,0 +1,322 @@
+#pragma once
+#include <bitset>
+#include <cstring>
+#include <limits>
+#include <seria/cbor.hpp>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> deserialize(T &data,
+                                                   cbor_reader *reader) {
+  auto byte = reader->peek();
+  if (byte != cbor_true && byte != cbor_false) {
+    throw type_error("boolean");
+  }
+
+  reader->read(1);
+  data = byte == cbor_true;
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value &&
+                 !is_boolean<T>::value>
+deserialize(T &data, cbor_reader *reader) {
+  auto head = reader->read_head();
+  constexpr auto max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+
+  if (head.major == cbor_unsigned && head.value <= max) {
+    data = static_cast<T>(head.value);
+  } else if (head.major == cbor_negative && head.value <= max) {
+    data = static_cast<T>(-1 - static_cast<int64_t>(head.value));
+  } else {
+    throw type_error("integer");
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_signed<T>::value &&
+                 !is_boolean<T>::value>
+deserialize(T &data, cbor_reader *reader) {
+  auto head = reader->read_head();
+  constexpr auto max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+
+  if (head.major != cbor_unsigned || head.value > max) {
+    throw type_error("unsigned integer");
+  }
+
+  data = static_cast<T>(head.value);
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+deserialize(T &data, cbor_reader *reader) {
+  auto head = reader->read_head();
+
+  if (head.major == cbor_unsigned) {
+    data = static_cast<T>(head.value);
+  } else if (head.major == cbor_negative) {
+    data = static_cast<T>(-1.0 - static_cast<double>(head.value));
+  } else if (head.major == cbor_simple && head.info == 25) {
+    data = static_cast<T>(
+        cbor_half_to_double(static_cast<uint16_t>(head.value)));
+  } else if (head.major == cbor_simple && head.info == 26) {
+    auto bits = static_cast<uint32_t>(head.value);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    data = static_cast<T>(value);
+  } else if (head.major == cbor_simple && head.info == 27) {
+    double value;
+    std::memcpy(&value, &head.value, sizeof(value));
+    data = static_cast<T>(value);
+  } else {
+    throw type_error("float or double");
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> deserialize(T &data,
+                                                     cbor_reader *reader) {
+  std::underlying_type_t<T> value;
+  try {
+    deserialize(value, reader);
+  } catch (type_error &) {
+    throw type_error("int");
+  }
+
+  data = static_cast<T>(value);
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> deserialize(T &data,
+                                                  cbor_reader *reader) {
+  auto head = reader->read_head();
+  if (head.major != cbor_text) {
+    throw type_error("string");
+  }
+
+  if (head.indefinite) {
+    data.clear();
+    while (!reader->at_break()) {
+      auto chunk = reader->read_head();
+      if (chunk.major != cbor_text || chunk.indefinite) {
+        throw type_error("string");
+      }
+      data.append(reader->read(chunk.value), chunk.value);
+    }
+    reader->read(1);
+    return;
+  }
+
+  data.assign(reader->read(head.value), head.value);
+}
+
+template <typename T>
+void deserialize_typed_array(T &data, cbor_reader *reader, std::true_type) {
+  using Element = typename T::value_type;
+  auto tag = reader->read_head();
+  auto head = reader->read_head();
+  if (tag.value != cbor_typed_array_tag<Element>() ||
+      head.major != cbor_bytes || head.indefinite ||
+      head.value % sizeof(Element) != 0) {
+    throw type_error("typed array");
+  }
+
+  auto size = head.value / sizeof(Element);
+  auto *bytes = reader->read(head.value);
+  data.resize(size);
+  std::memcpy(data.data(), bytes, head.value);
+#ifdef SERIA_BIG_ENDIAN
+  for (auto &value : data) {
+    value = byte_swap(value);
+  }
+#endif
+}
+
+template <typename T>
+void deserialize_typed_array(T & /*data*/, cbor_reader * /*reader*/,
+                             std::false_type) {
+  throw type_error("array");
+}
+
+template <typename T>
+void deserialize_byte_string(T &data, cbor_reader *reader, std::true_type) {
+  auto head = reader->read_head();
+  if (head.indefinite) {
+    throw type_error("byte string");
+  }
+
+  auto *bytes = reader->read(head.value);
+  data.resize(head.value);
+  std::memcpy(data.data(), bytes, head.value);
+}
+
+template <typename T>
+void deserialize_byte_string(T & /*data*/, cbor_reader * /*reader*/,
+                             std::false_type) {
+  throw type_error("array");
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value> deserialize(T &data,
+                                                  cbor_reader *reader) {
+  using Element = typename T::value_type;
+  constexpr bool typed =
+      is_binary_pod<Element>::value && std::is_arithmetic<Element>::value;
+
+  auto initial = reader->peek();
+  if (initial >> 5 == cbor_tag) {
+    deserialize_typed_array(data, reader,
+                            std::integral_constant<bool, typed>{});
+    return;
+  }
+
+  if (initial >> 5 == cbor_bytes) {
+    deserialize_byte_string(data, reader,
+                            std::is_same<Element, uint8_t>{});
+    return;
+  }
+
+  auto head = reader->read_head();
+  if (head.major != cbor_array) {
+    throw type_error("array");
+  }
+
+  if (!head.indefinite && head.value > reader->remaining()) {
+    throw error("unexpected end of cbor data");
+  }
+
+  data.clear();
+  data.reserve(head.indefinite ? 0 : head.value);
+  for (size_t i = 0; head.indefinite ? !reader->at_break() : i < head.value;
+       i++) {
+    data.emplace_back();
+    try {
+      deserialize(data.back(), reader);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+
+  if (head.indefinite) {
+    reader->read(1);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> deserialize(T &data,
+                                                 cbor_reader *reader) {
+  auto head = reader->read_head();
+  if (head.major != cbor_array || head.indefinite) {
+    throw type_error("array");
+  }
+
+  if (head.value != is_array<T>::size) {
+    throw error("the size of array is not same with target");
+  }
+
+  for (size_t i = 0; i < is_array<T>::size; i++) {
+    try {
+      deserialize(data[i], reader);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> deserialize(T &data,
+                                                  cbor_reader *reader) {
+  auto &members =
+      KeyValueRecords<T, decltype(register_object<std::decay_t<T>>())>::members;
+
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto head = reader->read_head();
+  if (head.major != cbor_map) {
+    throw type_error("object");
+  }
+
+  std::bitset<member_size> seen;
+  for (uint64_t i = 0; head.indefinite ? !reader->at_break() : i < head.value;
+       i++) {
+    auto key = reader->read_head();
+    if (key.major != cbor_text || key.indefinite) {
+      throw type_error("string");
+    }
+
+    auto *name = reader->read(key.value);
+    size_t index = 0;
+    bool found = false;
+
+    auto setter = [&](auto &member) {
+      if (found || member.m_key_length != key.value ||
+          std::memcmp(member.m_key, name, key.value) != 0) {
+        index++;
+        return;
+      }
+
+      found = true;
+      seen.set(index);
+      try {
+        deserialize(data.*(member.m_ptr), reader);
+      } catch (type_error &err) {
+        err.add_prefix(member.m_key);
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(member.m_key);
+        throw err;
+      }
+    };
+
+    for_each(setter, members, std::make_index_sequence<member_size>());
+    if (!found) {
+      reader->skip();
+    }
+  }
+
+  if (head.indefinite) {
+    reader->read(1);
+  }
+
+  size_t index = 0;
+  auto defaulter = [&](auto &member) {
+    if (seen.test(index++)) {
+      return;
+    }
+
+    if (!member.m_has_default) {
+      throw error(member.m_key, "missing value");
+    }
+
+    data.*(member.m_ptr) = member.m_default_value;
+  };
+
+  for_each(defaulter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+void from_cbor(T &data, const char *buffer, size_t size) {
+  cbor_reader reader(buffer, size);
+  deserialize(data, &reader);
+
+  if (reader.remaining() != 0) {
+    throw error("unexpected trailing data");
+  }
+}
+
+} // namespace seria
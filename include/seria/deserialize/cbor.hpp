@@ -0,0 +1,51 @@
+#pragma once
+#include <seria/cbor.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> deserialize(T &data,
+                                                   cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value &&
+                 !is_boolean<T>::value>
+deserialize(T &data, cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_signed<T>::value &&
+                 !is_boolean<T>::value>
+deserialize(T &data, cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+deserialize(T &data, cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> deserialize(T &data,
+                                                     cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> deserialize(T &data,
+                                                  cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value> deserialize(T &data,
+                                                  cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> deserialize(T &data,
+                                                 cbor_reader *reader);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> deserialize(T &data,
+                                                  cbor_reader *reader);
+
+template <typename T>
+void from_cbor(T &data, const char *buffer, size_t size);
+
+} // namespace seria
+
+#include <seria/deserialize/cbor-inl.hpp>
@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <seria/csv.hpp>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace seria {
+
+constexpr size_t csv_skip = static_cast<size_t>(-1);
+
+// smallest share of the input worth a thread of its own
+constexpr size_t csv_min_chunk = 1 << 16;
+
+// Maps the fields of a record to columns of `T`, by header name when there
+// is a header, positionally otherwise. Columns absent from the input need a
+// default value.
+template <typename T>
+std::vector<size_t> csv_mapping(csv_reader &reader, bool header,
+                                std::vector<size_t> *missing) {
+  auto &columns = csv_columns<T>();
+  std::vector<size_t> mapping;
+
+  if (!header) {
+    for (size_t i = 0; i < columns.size(); i++) {
+      mapping.push_back(i);
+    }
+    return mapping;
+  }
+
+  std::vector<bool> seen(columns.size(), false);
+  if (reader.next_record()) {
+    bool more = true;
+    while (more) {
+      const char *value;
+      size_t size;
+      more = reader.read_field(&value, &size);
+
+      auto index = csv_skip;
+      for (size_t i = 0; i < columns.size(); i++) {
+        if (!seen[i] && columns[i].name.size() == size &&
+            std::memcmp(columns[i].name.data(), value, size) == 0) {
+          index = i;
+          seen[i] = true;
+          break;
+        }
+      }
+      mapping.push_back(index);
+    }
+  }
+
+  for (size_t i = 0; i < columns.size(); i++) {
+    if (seen[i]) {
+      continue;
+    }
+
+    if (columns[i].default_value == nullptr) {
+      throw error(columns[i].name, "missing value");
+    }
+    missing->push_back(i);
+  }
+  return mapping;
+}
+
+template <typename T>
+void csv_parse_rows(std::vector<T> &rows, const char *data, size_t size,
+                    char delimiter, const std::vector<size_t> &mapping,
+                    const std::vector<size_t> &missing, size_t first_row) {
+  auto &columns = csv_columns<T>();
+  csv_reader reader(data, size, delimiter);
+
+  while (reader.next_record()) {
+    rows.emplace_back();
+    auto *row = reinterpret_cast<char *>(&rows.back());
+
+    try {
+      size_t field = 0;
+      bool more = true;
+      while (more) {
+        const char *value;
+        size_t length;
+        more = reader.read_field(&value, &length);
+        if (field == mapping.size()) {
+          throw error("expected " + std::to_string(mapping.size()) +
+                      " fields");
+        }
+
+        auto index = mapping[field++];
+        if (index == csv_skip) {
+          continue;
+        }
+
+        auto &column = columns[index];
+        try {
+          column.parse(row + column.offset, value, length);
+        } catch (type_error &err) {
+          err.add_prefix(column.name);
+          throw err;
+        }
+      }
+
+      if (field != mapping.size()) {
+        throw error("expected " + std::to_string(mapping.size()) + " fields");
+      }
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(first_row + rows.size() - 1));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(first_row + rows.size() - 1));
+      throw err;
+    }
+
+    for (auto index : missing) {
+      columns[index].assign(row + columns[index].offset,
+                            columns[index].default_value);
+    }
+  }
+}
+
+// Splits [begin, end) into `parts` ranges at line breaks outside of quoted
+// fields; since quotes inside quoted fields are doubled, a line break is
+// outside of quotes iff an even number of quotes precede it.
+inline std::vector<const char *> csv_split(const char *begin, const char *end,
+                                           size_t parts) {
+  std::vector<const char *> bounds{begin};
+  auto size = static_cast<size_t>(end - begin);
+  auto *cur = begin;
+  size_t quotes = 0;
+
+  for (size_t i = 1; i < parts; i++) {
+    auto *nominal = begin + size / parts * i;
+    if (nominal > cur) {
+      quotes += static_cast<size_t>(std::count(cur, nominal, '"'));
+      cur = nominal;
+    }
+
+    for (; cur != end; cur++) {
+      if (*cur == '"') {
+        quotes++;
+      } else if (*cur == '\n' && quotes % 2 == 0) {
+        cur++;
+        break;
+      }
+    }
+    bounds.push_back(cur);
+  }
+
+  bounds.push_back(end);
+  return bounds;
+}
+
+template <typename T>
+void from_csv(std::vector<T> &rows, const char *data, size_t size,
+              const csv_options &options) {
+  static_assert(is_object<T>::value, "rows must be registered objects");
+
+  csv_reader header(data, size, options.delimiter);
+  std::vector<size_t> missing;
+  auto mapping = csv_mapping<T>(header, options.header, &missing);
+
+  auto *begin = options.header ? header.position() : data;
+  auto *end = data + size;
+  auto threads = std::min<size_t>(
+      std::max(options.threads, 1u),
+      std::max<size_t>(static_cast<size_t>(end - begin) / csv_min_chunk, 1));
+
+  rows.clear();
+  if (threads == 1) {
+    csv_parse_rows(rows, begin, end - begin, options.delimiter, mapping,
+                   missing, 0);
+    return;
+  }
+
+  auto bounds = csv_split(begin, end, threads);
+  std::vector<std::vector<T>> parts(threads);
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < threads; i++) {
+    workers.emplace_back([&, i] {
+      try {
+        csv_parse_rows(parts[i], bounds[i], bounds[i + 1] - bounds[i],
+                       options.delimiter, mapping, missing, 0);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  size_t total = 0;
+  for (size_t i = 0; i < threads; i++) {
+    if (errors[i]) {
+      // parse the failed part again to report the row index of the whole
+      // input
+      parts[i].clear();
+      csv_parse_rows(parts[i], bounds[i], bounds[i + 1] - bounds[i],
+                     options.delimiter, mapping, missing, total);
+      std::rethrow_exception(errors[i]);
+    }
+    total += parts[i].size();
+  }
+
+  rows.reserve(total);
+  for (auto &part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(rows));
+  }
+}
+
+} // namespace seria
@@ -0,0 +1,14 @@
+#pragma once
+#include <seria/csv.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+void from_csv(std::vector<T> &rows, const char *data, size_t size,
+              const csv_options &options = csv_options());
+
+} // namespace seria
+
+#include <seria/deserialize/csv-inl.hpp>
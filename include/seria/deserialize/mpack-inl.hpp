@@ -1,7 +1,9 @@
 #pragma once
 #include <mpack/mpack-node.h>
+#include <seria/columnar.hpp>
 #include <seria/exception.hpp>
 #include <seria/object.hpp>
+#include <seria/shape.hpp>
 #include <seria/type_traits.hpp>
 
 namespace seria {
@@ -80,8 +82,8 @@ std::enable_if_t<is_string<T>::value> deserialize(T &data,
 }
 
 template <typename T>
-std::enable_if_t<is_vector<T>::value> deserialize(T &data,
-                                                  const mpack_node_t &node) {
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value>
+deserialize(T &data, const mpack_node_t &node) {
   auto size = mpack_node_array_length(node);
   if (mpack_ok != mpack_node_error(node)) {
     throw type_error("array");
@@ -143,19 +145,155 @@ std::enable_if_t<is_object<T>::value> deserialize(T &data,
     throw type_error("object");
   }
 
+  auto &shape = shape_of<T, member_size>();
+  auto count = mpack_node_map_count(node);
+  auto key_at = [&node](size_t i, size_t *length) -> const char * {
+    auto key = mpack_node_map_key_at(node, i);
+    if (key.data->type != mpack_type_str) {
+      return nullptr;
+    }
+    *length = mpack_node_strlen(key);
+    return mpack_node_str(key);
+  };
+
+  size_t index = 0;
+  auto setter = [&](auto &member) {
+    auto &position = shape.positions[index++];
+    auto found = find_key(member.m_key, member.m_key_length, count, position,
+                          key_at);
+    if (found == count) {
+      if (!member.m_has_default) {
+        throw error(member.m_key, "missing value");
+      }
+
+      data.*(member.m_ptr) = member.m_default_value;
+      return;
+    }
+
+    position = static_cast<uint32_t>(found);
+    try {
+      auto value_node = mpack_node_map_value_at(node, found);
+      deserialize(data.*(member.m_ptr), value_node);
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename M>
+size_t column_length(const mpack_node_t &node, std::true_type /*pod*/) {
+  if (node.data->type != mpack_type_bin) {
+    throw type_error("binary");
+  }
+
+  auto size = mpack_node_bin_size(node);
+  if (size % sizeof(M) != 0) {
+    throw error("column size is not a multiple of the element size");
+  }
+
+  return size / sizeof(M);
+}
+
+template <typename M>
+size_t column_length(const mpack_node_t &node, std::false_type /*pod*/) {
+  auto size = mpack_node_array_length(node);
+  if (mpack_ok != mpack_node_error(node)) {
+    throw type_error("array");
+  }
+
+  return size;
+}
+
+template <typename T, typename Object, typename M>
+void deserialize_column(std::vector<T> &rows, M Object::*ptr,
+                        const mpack_node_t &node, std::true_type /*pod*/) {
+  scatter_column(mpack_node_bin_data(node), rows.size(), ptr, rows.data());
+}
+
+template <typename T, typename Object, typename M>
+void deserialize_column(std::vector<T> &rows, M Object::*ptr,
+                        const mpack_node_t &node, std::false_type /*pod*/) {
+  for (size_t i = 0; i < rows.size(); i++) {
+    try {
+      auto child_node = mpack_node_array_at(node, i);
+      deserialize(rows[i].*ptr, child_node);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value>
+deserialize(T &data, const mpack_node_t &node) {
+  using Row = typename T::value_type;
+  auto &members =
+      KeyValueRecords<Row, decltype(register_object<Row>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  if (node.data->type != mpack_type_map) {
+    throw type_error("object");
+  }
+
+  // the row count is taken from the first column present, every other
+  // column has to agree with it
+  constexpr size_t unknown = SIZE_MAX;
+  size_t size = unknown;
+  auto measurer = [&size, &node](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    if (!mpack_node_map_contains_cstr(node, member.m_key)) {
+      return;
+    }
+
+    try {
+      auto column = mpack_node_map_cstr(node, member.m_key);
+      auto length = column_length<Type>(column, is_binary_pod<Type>{});
+      if (size == unknown) {
+        size = length;
+      } else if (size != length) {
+        throw error("column length mismatch");
+      }
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(measurer, members, std::make_index_sequence<member_size>());
+  data.resize(size == unknown ? 0 : size);
+
   auto setter = [&data, &node](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
     if (!mpack_node_map_contains_cstr(node, member.m_key)) {
-      if (member.m_default_value == nullptr) {
+      if (!member.m_has_default) {
         throw error(member.m_key, "missing value");
       }
 
-      data.*(member.m_ptr) = *member.m_default_value;
+      for (auto &row : data) {
+        row.*(member.m_ptr) = member.m_default_value;
+      }
       return;
     }
 
     try {
-      auto value_node = mpack_node_map_cstr(node, member.m_key);
-      deserialize(data.*(member.m_ptr), value_node);
+      auto column = mpack_node_map_cstr(node, member.m_key);
+      deserialize_column(data, member.m_ptr, column, is_binary_pod<Type>{});
     } catch (type_error &err) {
       err.add_prefix(member.m_key);
       throw err;
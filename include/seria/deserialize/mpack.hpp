@@ -30,8 +30,12 @@ std::enable_if_t<is_string<T>::value> deserialize(T &data,
                                                   const mpack_node_t &node);
 
 template <typename T>
-std::enable_if_t<is_vector<T>::value> deserialize(T &data,
-                                                  const mpack_node_t &node);
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value>
+deserialize(T &data, const mpack_node_t &node);
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value>
+deserialize(T &data, const mpack_node_t &node);
 
 template <typename T>
 std::enable_if_t<is_array<T>::value> deserialize(T &data,
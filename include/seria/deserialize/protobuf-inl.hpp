@@ -0,0 +1,345 @@
+#pragma once
+#include <array>
+#include <limits>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/protobuf.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding /*encoding*/) {
+  if (wire != pb_varint) {
+    throw type_error("boolean");
+  }
+
+  data = reader->read_varint() != 0;
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding) {
+  if (std::is_signed<T>::value) {
+    if (wire != pb_wire_of<T>(encoding)) {
+      throw type_error("integer");
+    }
+
+    int64_t value;
+    if (wire == pb_fixed32) {
+      value = reader->read_le<int32_t>();
+    } else if (wire == pb_fixed64) {
+      value = reader->read_le<int64_t>();
+    } else if (encoding == pb_sint) {
+      value = pb_unzigzag(reader->read_varint());
+    } else {
+      value = static_cast<int64_t>(reader->read_varint());
+    }
+    if (value < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+        value > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+      throw type_error("integer");
+    }
+    data = static_cast<T>(value);
+  } else {
+    if (wire != pb_wire_of<T>(encoding)) {
+      throw type_error("unsigned integer");
+    }
+
+    uint64_t value;
+    if (wire == pb_fixed32) {
+      value = reader->read_le<uint32_t>();
+    } else if (wire == pb_fixed64) {
+      value = reader->read_le<uint64_t>();
+    } else {
+      value = reader->read_varint();
+    }
+    if (value > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+      throw type_error("unsigned integer");
+    }
+    data = static_cast<T>(value);
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding /*encoding*/) {
+  if (wire == pb_fixed32) {
+    data = static_cast<T>(reader->read_le<float>());
+  } else if (wire == pb_fixed64) {
+    data = static_cast<T>(reader->read_le<double>());
+  } else {
+    throw type_error("float or double");
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding /*encoding*/) {
+  if (wire != pb_varint) {
+    throw type_error("int");
+  }
+
+  auto value = static_cast<int64_t>(reader->read_varint());
+  data = static_cast<T>(static_cast<std::underlying_type_t<T>>(value));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value || is_pb_bytes<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding /*encoding*/) {
+  if (wire != pb_length) {
+    throw type_error(is_string<T>::value ? "string" : "bytes");
+  }
+
+  auto size = reader->read_varint();
+  auto *bytes = reinterpret_cast<const typename T::value_type *>(
+      reader->read(size));
+  data.assign(bytes, bytes + size);
+}
+
+template <typename T>
+void pb_read_embedded(T &data, pb_wire_type wire, pb_reader *reader,
+                      bool merge) {
+  if (wire != pb_length) {
+    throw type_error("object");
+  }
+
+  auto size = reader->read_varint();
+  pb_reader message(reader->read(size), size);
+  pb_read_message(data, &message, merge);
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding /*encoding*/) {
+  pb_read_embedded(data, wire, reader, false);
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value || is_string<T>::value> pb_reset(T &data) {
+  data.clear();
+}
+
+template <typename T>
+std::enable_if_t<!is_vector<T>::value && !is_string<T>::value &&
+                 !is_array<T>::value>
+pb_reset(T &data) {
+  data = T{};
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> pb_reset(T &data) {
+  for (auto &value : data) {
+    pb_reset(value);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> pb_check_size(size_t count) {
+  if (count != 0 && count != is_array<T>::size) {
+    throw error("the size of array is not same with target");
+  }
+}
+
+template <typename T>
+std::enable_if_t<!is_array<T>::value> pb_check_size(size_t /*count*/) {}
+
+template <typename T>
+std::enable_if_t<!is_pb_repeated<T>::value && !is_object<T>::value>
+pb_read_field(T &data, pb_wire_type wire, pb_reader *reader, size_t &count,
+              pb_encoding encoding) {
+  pb_read_value(data, wire, reader, encoding);
+  count++;
+}
+
+// an embedded message given more than once is merged into the first
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+pb_read_field(T &data, pb_wire_type wire, pb_reader *reader, size_t &count,
+              pb_encoding /*encoding*/) {
+  pb_read_embedded(data, wire, reader, count != 0);
+  count++;
+}
+
+// values a field holds already when a message is merged into it: repeated
+// fields are appended to, embedded messages merged recursively
+template <typename T>
+std::enable_if_t<is_vector<T>::value && is_pb_repeated<T>::value, size_t>
+pb_merged_count(const T &data) {
+  return data.size();
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value, size_t>
+pb_merged_count(const T & /*data*/) {
+  return 1;
+}
+
+template <typename T>
+std::enable_if_t<!(is_vector<T>::value && is_pb_repeated<T>::value) &&
+                     !is_object<T>::value,
+                 size_t>
+pb_merged_count(const T & /*data*/) {
+  return 0;
+}
+
+template <typename T>
+void pb_read_element(T &data, pb_wire_type wire, pb_reader *reader,
+                     pb_encoding encoding, size_t index,
+                     std::true_type /*is_vector*/) {
+  using Element = typename T::value_type;
+  if (is_pb_packable<Element>::value) {
+    // no reference into `std::vector<bool>`
+    Element value{};
+    pb_read_value(value, wire, reader, encoding);
+    data.push_back(value);
+  } else {
+    data.emplace_back();
+    pb_read_value(data[index], wire, reader, encoding);
+  }
+}
+
+template <typename T>
+void pb_read_element(T &data, pb_wire_type wire, pb_reader *reader,
+                     pb_encoding encoding, size_t index,
+                     std::false_type /*is_vector*/) {
+  if (index >= is_array<T>::size) {
+    throw error("the size of array is not same with target");
+  }
+
+  pb_read_value(data[index], wire, reader, encoding);
+}
+
+template <typename T>
+std::enable_if_t<is_pb_repeated<T>::value>
+pb_read_field(T &data, pb_wire_type wire, pb_reader *reader, size_t &count,
+              pb_encoding encoding) {
+  using Element = element_type_t<T>;
+  using IsVector = std::integral_constant<bool, is_vector<T>::value>;
+
+  if (count == 0) {
+    pb_reset(data);
+  }
+
+  auto read = [&](pb_wire_type element_wire, pb_reader *element_reader) {
+    try {
+      pb_read_element(data, element_wire, element_reader, encoding, count,
+                      IsVector{});
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(count));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(count));
+      throw err;
+    }
+    count++;
+  };
+
+  // packable elements are accepted both packed and one per field
+  if (is_pb_packable<Element>::value && wire == pb_length) {
+    auto size = reader->read_varint();
+    pb_reader packed(reader->read(size), size);
+    while (packed.remaining() != 0) {
+      read(pb_wire_of<Element>(encoding), &packed);
+    }
+  } else {
+    read(wire, reader);
+  }
+}
+
+template <typename T>
+void pb_read_message(T &data, pb_reader *reader, bool merge) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  std::array<size_t, member_size> counts{};
+  if (merge) {
+    size_t index = 0;
+    auto counter = [&](auto &member) {
+      counts[index++] = pb_merged_count(data.*(member.m_ptr));
+    };
+    for_each(counter, members, std::make_index_sequence<member_size>());
+  }
+
+  while (reader->remaining() != 0) {
+    auto key = reader->read_varint();
+    auto field = key >> 3;
+    auto wire = static_cast<pb_wire_type>(key & 0x7);
+
+    size_t index = 0;
+    bool found = false;
+    auto setter = [&](auto &member) {
+      if (found || pb_field_number(member, index) != field) {
+        index++;
+        return;
+      }
+
+      found = true;
+      try {
+        pb_read_field(data.*(member.m_ptr), wire, reader, counts[index],
+                      member.m_encoding);
+      } catch (type_error &err) {
+        err.add_prefix(member.m_key);
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(member.m_key);
+        throw err;
+      }
+    };
+
+    for_each(setter, members, std::make_index_sequence<member_size>());
+    if (!found) {
+      reader->skip(wire);
+    }
+  }
+
+  // absent fields take the registered default, otherwise the protobuf
+  // default of their type (zero, empty); when merging they keep their value
+  size_t index = 0;
+  auto defaulter = [&](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    auto count = counts[index++];
+
+    try {
+      pb_check_size<Type>(count);
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+
+    if (count != 0 || merge) {
+      return;
+    }
+
+    if (member.m_has_default) {
+      data.*(member.m_ptr) = member.m_default_value;
+    } else {
+      pb_reset(data.*(member.m_ptr));
+    }
+  };
+
+  for_each(defaulter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> deserialize(T &data, pb_reader *reader) {
+  pb_read_message(data, reader, false);
+}
+
+template <typename T>
+void from_protobuf(T &data, const char *buffer, size_t size) {
+  pb_reader reader(buffer, size);
+  deserialize(data, &reader);
+}
+
+} // namespace seria
@@ -0,0 +1,65 @@
+#pragma once
+#include <seria/object.hpp>
+#include <seria/protobuf.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value || is_pb_bytes<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+pb_read_value(T &data, pb_wire_type wire, pb_reader *reader,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<!is_pb_repeated<T>::value && !is_object<T>::value>
+pb_read_field(T &data, pb_wire_type wire, pb_reader *reader, size_t &count,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+pb_read_field(T &data, pb_wire_type wire, pb_reader *reader, size_t &count,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_pb_repeated<T>::value>
+pb_read_field(T &data, pb_wire_type wire, pb_reader *reader, size_t &count,
+              pb_encoding encoding);
+
+// `merge` keeps the values of fields absent from the message
+template <typename T>
+void pb_read_message(T &data, pb_reader *reader, bool merge);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> deserialize(T &data, pb_reader *reader);
+
+template <typename T>
+void from_protobuf(T &data, const char *buffer, size_t size);
+
+} // namespace seria
+
+#include <seria/deserialize/protobuf-inl.hpp>
@@ -1,12 +1,21 @@
 #pragma once
+#include <algorithm>
+#include <exception>
 #include <seria/exception.hpp>
+#include <seria/json_index.hpp>
 #include <seria/object.hpp>
+#include <seria/shape.hpp>
 #include <seria/type_traits.hpp>
 #ifdef SERIA_USE_EXTERNAL_RAPIDJSON
 #include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
 #else
 #include <seria/rapidjson/document.h>
+#include <seria/rapidjson/error/en.h>
 #endif
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace seria {
 
@@ -136,18 +145,31 @@ deserialize(T &data, const rapidjson::Value &value) {
     throw type_error("object");
   }
 
-  auto setter = [&data, &value](auto &member) {
-    if (!value.HasMember(member.m_key)) {
-      if (member.m_default_value == nullptr) {
+  auto &shape = shape_of<T, member_size>();
+  auto first = value.MemberBegin();
+  auto count = static_cast<size_t>(value.MemberCount());
+  auto key_at = [first](size_t i, size_t *length) {
+    *length = first[i].name.GetStringLength();
+    return first[i].name.GetString();
+  };
+
+  size_t index = 0;
+  auto setter = [&](auto &member) {
+    auto &position = shape.positions[index++];
+    auto found = find_key(member.m_key, member.m_key_length, count, position,
+                          key_at);
+    if (found == count) {
+      if (!member.m_has_default) {
         throw error(member.m_key, "missing value");
       }
 
-      data.*(member.m_ptr) = *member.m_default_value;
+      data.*(member.m_ptr) = member.m_default_value;
       return;
     }
 
+    position = static_cast<uint32_t>(found);
     try {
-      deserialize(data.*(member.m_ptr), value[member.m_key]);
+      deserialize(data.*(member.m_ptr), first[found].value);
     } catch (type_error &err) {
       err.add_prefix(member.m_key);
       throw err;
@@ -160,4 +182,346 @@ deserialize(T &data, const rapidjson::Value &value) {
   for_each(setter, members, std::make_index_sequence<member_size>());
 }
 
+// smallest share of an array worth a thread of its own
+constexpr size_t json_min_chunk = 1 << 16;
+
+// vectors whose elements can be decoded into their slots concurrently
+template <typename T, typename _ = void>
+struct is_json_parallel : std::false_type {};
+
+template <typename T>
+struct is_json_parallel<
+    T, std::enable_if_t<is_vector<T>::value &&
+                        !is_boolean<typename T::value_type>::value>>
+    : std::true_type {};
+
+inline const char *json_skip_blank(const char *cur, const char *end) {
+  while (cur != end &&
+         (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r')) {
+    cur++;
+  }
+  return cur;
+}
+
+inline bool json_blank(const char *json, size_t begin, size_t end) {
+  return json_skip_blank(json + begin, json + end) == json + end;
+}
+
+// parses `json[begin, end)`, offsets of syntax errors are within `json`
+inline void json_parse_range(rapidjson::Document &document, const char *json,
+                             size_t begin, size_t end) {
+  document.Parse(json + begin, end - begin);
+  if (document.HasParseError()) {
+    throw error(
+        std::string(rapidjson::GetParseError_En(document.GetParseError())) +
+        " at offset " + std::to_string(begin + document.GetErrorOffset()));
+  }
+}
+
+template <typename T>
+void json_decode_range(T &data, const char *json, size_t begin, size_t end) {
+  rapidjson::Document document;
+  json_parse_range(document, json, begin, end);
+  deserialize(data, document);
+}
+
+// Decodes the array whose brackets are the entries `open` and `close` of a
+// structural index and whose commas are the entries in between. Elements
+// are decoded in place, each thread taking a run of them of about the same
+// number of bytes.
+template <typename T>
+void json_decode_elements(T &data, const char *json,
+                          const std::vector<size_t> &index, size_t open,
+                          size_t close, unsigned threads) {
+  auto count = close - open;
+  if (count == 1 && json_blank(json, index[open] + 1, index[close])) {
+    count = 0;
+  }
+  data.resize(count);
+
+  auto decode = [&](size_t first, size_t last) {
+    rapidjson::Document document;
+    for (auto i = first; i < last; i++) {
+      json_parse_range(document, json, index[open + i] + 1,
+                       index[open + i + 1]);
+      try {
+        deserialize(data[i], document);
+      } catch (type_error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      }
+      // the document is reused, its values are not needed anymore
+      document.GetAllocator().Clear();
+    }
+  };
+
+  auto bytes = index[close] - index[open];
+  threads = static_cast<unsigned>(std::min<size_t>(
+      threads, std::max<size_t>(bytes / json_min_chunk, 1)));
+  if (threads == 1) {
+    decode(0, count);
+    return;
+  }
+
+  auto first = index.begin() + static_cast<std::ptrdiff_t>(open);
+  auto last = index.begin() + static_cast<std::ptrdiff_t>(close);
+  std::vector<size_t> bounds;
+  for (unsigned i = 0; i < threads; i++) {
+    auto target = index[open] + bytes / threads * i;
+    auto entry = std::lower_bound(first, last, target);
+    bounds.push_back(std::min<size_t>(entry - first, count));
+  }
+  bounds.push_back(count);
+
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < threads; i++) {
+    workers.emplace_back([&, i] {
+      try {
+        decode(bounds[i], bounds[i + 1]);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // the runs are in order, so this is the error a single thread would hit
+  for (auto &err : errors) {
+    if (err) {
+      std::rethrow_exception(err);
+    }
+  }
+}
+
+// whether the first and the last entries of the index are the brackets
+// `open` and `close` of the root, with only blanks around them
+inline bool json_root(const char *json, size_t size,
+                      const std::vector<size_t> &index, char open,
+                      char close) {
+  return index.size() >= 2 && json[index.front()] == open &&
+         json[index.back()] == close && json_blank(json, 0, index.front()) &&
+         json_blank(json, index.back() + 1, size);
+}
+
+template <typename T>
+std::enable_if_t<!is_json_parallel<T>::value && !is_object<T>::value>
+json_decode_parallel(T &data, const char *json, size_t size,
+                     unsigned /*threads*/) {
+  json_decode_range(data, json, 0, size);
+}
+
+template <typename T>
+std::enable_if_t<is_json_parallel<T>::value>
+json_decode_parallel(T &data, const char *json, size_t size,
+                     unsigned threads) {
+  auto index = json_structural_index(json, size, 1);
+  if (!json_root(json, size, index, '[', ']') ||
+      !std::all_of(index.begin() + 1, index.end() - 1,
+                   [json](size_t offset) { return json[offset] == ','; })) {
+    // not a single array, the parser reports what is wrong with it
+    json_decode_range(data, json, 0, size);
+    return;
+  }
+
+  json_decode_elements(data, json, index, 0, index.size() - 1, threads);
+}
+
+// A member of the root object: `json[value, end)` is its value, `open` and
+// `close` the entries of the index for the brackets of the value, 0 when it
+// is not a container.
+struct json_member_range {
+  std::string key;
+  size_t value;
+  size_t end;
+  size_t open;
+  size_t close;
+};
+
+// Reads the `"key" :` at `cur`, returns where its value starts, nullptr when
+// it is malformed.
+inline const char *json_member_key(const char *cur, const char *end,
+                                   std::string &key) {
+  if (cur == end || *cur != '"') {
+    return nullptr;
+  }
+
+  auto *first = cur++;
+  bool escaped = false;
+  for (; cur != end && *cur != '"'; cur++) {
+    if (*cur == '\\' && cur + 1 != end) {
+      escaped = true;
+      cur++;
+    }
+  }
+  if (cur == end) {
+    return nullptr;
+  }
+
+  if (escaped) {
+    rapidjson::Document document;
+    document.Parse(first, static_cast<size_t>(cur + 1 - first));
+    if (document.HasParseError()) {
+      return nullptr;
+    }
+    key.assign(document.GetString(), document.GetStringLength());
+  } else {
+    key.assign(first + 1, cur);
+  }
+
+  cur = json_skip_blank(cur + 1, end);
+  if (cur == end || *cur != ':') {
+    return nullptr;
+  }
+  return cur + 1;
+}
+
+// Splits the root object into its members, false when it is malformed.
+inline bool json_members(const char *json, const std::vector<size_t> &index,
+                         std::vector<json_member_range> &members) {
+  size_t begin = index.front() + 1;
+  size_t open = 0;
+  size_t close = 0;
+  for (size_t i = 1; i < index.size(); i++) {
+    auto c = json[index[i]];
+    if (open != 0 && close == 0) {
+      if (c == ']' || c == '}') {
+        close = i;
+      }
+      continue;
+    }
+
+    if (c == '[' || c == '{') {
+      if (open != 0) {
+        return false;
+      }
+      open = i;
+      continue;
+    }
+
+    auto last = i + 1 == index.size();
+    if (c != ',' && !last) {
+      return false;
+    }
+
+    auto *end = json + index[i];
+    if (last && members.empty() && open == 0 && json_blank(json, begin, index[i])) {
+      return true;
+    }
+
+    // "key" : value
+    json_member_range member{std::string(), 0, index[i], open, close};
+    auto *cur = json_member_key(json_skip_blank(json + begin, end), end,
+                                member.key);
+    if (cur == nullptr) {
+      return false;
+    }
+    member.value = static_cast<size_t>(cur - json);
+
+    // the container has to be the whole value
+    if (open != 0 && (!json_blank(json, member.value, index[open]) ||
+                      !json_blank(json, index[close] + 1, index[i]))) {
+      return false;
+    }
+
+    members.push_back(std::move(member));
+    begin = index[i] + 1;
+    open = 0;
+    close = 0;
+  }
+  return true;
+}
+
+template <typename T>
+std::enable_if_t<is_json_parallel<T>::value>
+json_decode_member(T &data, const char *json, const std::vector<size_t> &index,
+                   const json_member_range &member, unsigned threads) {
+  if (member.open != 0 && json[index[member.open]] == '[' &&
+      json[index[member.close]] == ']') {
+    json_decode_elements(data, json, index, member.open, member.close,
+                         threads);
+    return;
+  }
+
+  json_decode_range(data, json, member.value, member.end);
+}
+
+template <typename T>
+std::enable_if_t<!is_json_parallel<T>::value>
+json_decode_member(T &data, const char *json,
+                   const std::vector<size_t> & /*index*/,
+                   const json_member_range &member, unsigned /*threads*/) {
+  json_decode_range(data, json, member.value, member.end);
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+json_decode_parallel(T &data, const char *json, size_t size,
+                     unsigned threads) {
+  auto &members =
+      KeyValueRecords<T, decltype(register_object<std::decay_t<T>>())>::members;
+
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto index = json_structural_index(json, size, 2);
+  std::vector<json_member_range> ranges;
+  if (!json_root(json, size, index, '{', '}') ||
+      !json_members(json, index, ranges)) {
+    // not a single object, the parser reports what is wrong with it
+    json_decode_range(data, json, 0, size);
+    return;
+  }
+
+  auto setter = [&](auto &member) {
+    auto found = std::find_if(ranges.begin(), ranges.end(),
+                              [&member](const json_member_range &range) {
+                                return range.key == member.m_key;
+                              });
+    if (found == ranges.end()) {
+      if (!member.m_has_default) {
+        throw error(member.m_key, "missing value");
+      }
+
+      data.*(member.m_ptr) = member.m_default_value;
+      return;
+    }
+
+    try {
+      json_decode_member(data.*(member.m_ptr), json, index, *found, threads);
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+void from_string(T &data, const char *json, size_t size, unsigned threads) {
+  if (threads > 1 && size >= json_min_chunk) {
+    try {
+      json_decode_parallel(data, json, size, threads);
+      return;
+    } catch (error &) {
+      // decode again to report the error a single thread runs into first,
+      // syntax errors are described from the whole text
+    }
+  }
+
+  json_decode_range(data, json, 0, size);
+}
+
 } // namespace seria
\ No newline at end of file
@@ -45,6 +45,13 @@ template <typename T>
 std::enable_if_t<is_object<T>::value>
 deserialize(T &data, const rapidjson::Value &value);
 
+// Parses and decodes a json text, throws `seria::error` on syntax errors.
+// With more than one thread, the elements of a root array or of arrays that
+// are members of a root object are decoded in parallel, after a structural
+// index of the text has been built.
+template <typename T>
+void from_string(T &data, const char *json, size_t size, unsigned threads = 1);
+
 } // namespace seria
 
 #include <seria/deserialize/rapidjson-inl.hpp>
\ No newline at end of file
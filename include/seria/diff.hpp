@@ -0,0 +1,162 @@
+#pragma once
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <vector>
+
+namespace seria {
+
+template <typename Members> struct dense_members : std::false_type {};
+
+template <> struct dense_members<std::tuple<>> : std::true_type {
+  constexpr static size_t size = 0;
+};
+
+template <typename M, typename... Rest>
+struct dense_members<std::tuple<M, Rest...>>
+    : std::integral_constant<bool,
+                             is_binary_pod<typename M::Type>::value &&
+                                 dense_members<std::tuple<Rest...>>::value> {
+  constexpr static size_t size =
+      sizeof(typename M::Type) + dense_members<std::tuple<Rest...>>::size;
+};
+
+// Registered objects made only of arithmetic members which cover all of
+// their bytes: equal objects have the same representation, no padding.
+template <typename T, typename _ = void>
+struct is_dense_object : std::false_type {};
+
+template <typename T>
+struct is_dense_object<
+    T, std::enable_if_t<is_object<T>::value &&
+                        std::is_trivially_copyable<T>::value &&
+                        dense_members<decltype(register_object<T>())>::value>>
+    : std::integral_constant<
+          bool, std::tuple_size<decltype(register_object<T>())>::value != 0 &&
+                    dense_members<decltype(register_object<T>())>::size ==
+                        sizeof(T)> {};
+
+// values compared as their bytes, floating point numbers included: NaN is
+// the same as itself and -0 differs from 0
+template <typename T>
+struct is_bitwise_comparable
+    : std::integral_constant<bool, is_binary_pod<T>::value ||
+                                       is_dense_object<T>::value> {};
+
+template <typename T>
+std::enable_if_t<is_bitwise_comparable<T>::value, bool>
+same_value(const T &a, const T &b) {
+  return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+template <typename T>
+std::enable_if_t<!is_bitwise_comparable<T>::value &&
+                     (std::is_arithmetic<T>::value ||
+                      std::is_enum<T>::value || is_string<T>::value),
+                 bool>
+same_value(const T &a, const T &b) {
+  return a == b;
+}
+
+template <typename T>
+std::enable_if_t<(is_vector<T>::value || is_array<T>::value) &&
+                     !is_bitwise_comparable<T>::value,
+                 bool>
+same_value(const T &a, const T &b);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value && !is_bitwise_comparable<T>::value,
+                 bool>
+same_value(const T &a, const T &b);
+
+template <typename Allocator>
+bool same_value(const std::vector<bool, Allocator> &a,
+                const std::vector<bool, Allocator> &b) {
+  return a == b;
+}
+
+template <typename T>
+bool same_elements(const T *a, const T *b, size_t size,
+                   std::true_type /*bitwise*/) {
+  return size == 0 || std::memcmp(a, b, size * sizeof(T)) == 0;
+}
+
+template <typename T>
+bool same_elements(const T *a, const T *b, size_t size,
+                   std::false_type /*bitwise*/) {
+  for (size_t i = 0; i < size; i++) {
+    if (!same_value(a[i], b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+std::enable_if_t<(is_vector<T>::value || is_array<T>::value) &&
+                     !is_bitwise_comparable<T>::value,
+                 bool>
+same_value(const T &a, const T &b) {
+  auto size = static_cast<size_t>(std::end(a) - std::begin(a));
+  if (size != static_cast<size_t>(std::end(b) - std::begin(b))) {
+    return false;
+  }
+  return size == 0 ||
+         same_elements(&*std::begin(a), &*std::begin(b), size,
+                       is_bitwise_comparable<element_type_t<T>>{});
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value && !is_bitwise_comparable<T>::value,
+                 bool>
+same_value(const T &a, const T &b) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  bool same = true;
+  auto comparer = [&](auto &member) {
+    same = same && same_value(a.*(member.m_ptr), b.*(member.m_ptr));
+  };
+  for_each(comparer, members, std::make_index_sequence<member_size>());
+  return same;
+}
+
+// Which members of two objects differ, in registration order, and how
+// many. Unchanged members are skipped with a byte comparison when they
+// are arithmetic, arrays or vectors of them, or dense objects.
+template <typename T, size_t Size = std::tuple_size<
+                          decltype(register_object<T>())>::value>
+struct member_changes {
+  bool changed[Size];
+  size_t count = 0;
+
+  member_changes(const T &old, const T &now) {
+    auto &members =
+        KeyValueRecords<T, decltype(register_object<T>())>::members;
+    size_t index = 0;
+    auto comparer = [&](auto &member) {
+      auto differs = !same_value(old.*(member.m_ptr), now.*(member.m_ptr));
+      changed[index++] = differs;
+      count += differs ? 1 : 0;
+    };
+    for_each(comparer, members, std::make_index_sequence<Size>());
+  }
+};
+
+// Members holding registered objects, which patches update member by member
+// instead of replacing.
+template <typename T, typename _ = void>
+struct is_patched_object : std::false_type {};
+
+template <typename T>
+struct is_patched_object<
+    T,
+    std::enable_if_t<is_object<T>::value &&
+                     std::tuple_size<decltype(register_object<T>())>::value !=
+                         0>> : std::true_type {};
+
+} // namespace seria
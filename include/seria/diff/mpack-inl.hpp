@@ -0,0 +1,118 @@
+#pragma once
+#include <array>
+#include <mpack/mpack-node.h>
+#include <mpack/mpack-writer.h>
+#include <seria/deserialize/mpack.hpp>
+#include <seria/diff.hpp>
+#include <seria/exception.hpp>
+#include <seria/serialize/mpack.hpp>
+#include <string>
+
+namespace seria {
+
+template <typename T>
+void write_patch_value(const T &old, const T &now, mpack_writer_t *writer,
+                       std::true_type /*object*/) {
+  diff(old, now, writer);
+}
+
+template <typename T>
+void write_patch_value(const T & /*old*/, const T &now, mpack_writer_t *writer,
+                       std::false_type /*object*/) {
+  serialize(now, writer);
+}
+
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value, bool>
+diff(const T &old, const T &now, mpack_writer_t *writer) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  member_changes<T> changes(old, now);
+  mpack_start_map(writer, static_cast<uint32_t>(changes.count));
+  if (changes.count != 0) {
+    uint32_t index = 0;
+    auto writer_of = [&](auto &member) {
+      using Type = typename std::decay_t<decltype(member)>::Type;
+      if (changes.changed[index]) {
+        mpack_write_uint(writer, index);
+        write_patch_value(old.*(member.m_ptr), now.*(member.m_ptr), writer,
+                          is_patched_object<Type>{});
+      }
+      index++;
+    };
+    for_each(writer_of, members, std::make_index_sequence<member_size>());
+  }
+  mpack_finish_map(writer);
+  return changes.count != 0;
+}
+
+template <typename T>
+void apply_patch_value(T &data, const mpack_node_t &node,
+                       std::true_type /*object*/) {
+  apply_patch(data, node);
+}
+
+template <typename T>
+void apply_patch_value(T &data, const mpack_node_t &node,
+                       std::false_type /*object*/) {
+  deserialize(data, node);
+}
+
+template <typename T, size_t Index>
+void apply_patch_member(T &obj, const mpack_node_t &node) {
+  auto &member = std::get<Index>(
+      KeyValueRecords<T, decltype(register_object<T>())>::members);
+  using Type = typename std::decay_t<decltype(member)>::Type;
+  try {
+    if (node.data->type == mpack_type_nil) {
+      obj.*(member.m_ptr) = member.m_default_value;
+      return;
+    }
+    apply_patch_value(obj.*(member.m_ptr), node, is_patched_object<Type>{});
+  } catch (type_error &err) {
+    err.add_prefix(member.m_key);
+    throw err;
+  } catch (error &err) {
+    err.add_prefix(member.m_key);
+    throw err;
+  }
+}
+
+// the function updating each member, by registration index
+template <typename T, size_t... Index>
+const std::array<void (*)(T &, const mpack_node_t &), sizeof...(Index)> &
+patch_members(std::index_sequence<Index...> /*unused*/) {
+  static const std::array<void (*)(T &, const mpack_node_t &),
+                          sizeof...(Index)>
+      table{{&apply_patch_member<T, Index>...}};
+  return table;
+}
+
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value>
+apply_patch(T &obj, const mpack_node_t &patch) {
+  constexpr size_t member_size =
+      std::tuple_size<decltype(register_object<T>())>::value;
+  auto &table = patch_members<T>(std::make_index_sequence<member_size>());
+
+  if (patch.data->type != mpack_type_map) {
+    throw type_error("object");
+  }
+
+  auto count = mpack_node_map_count(patch);
+  for (size_t i = 0; i < count; i++) {
+    auto key = mpack_node_map_key_at(patch, i);
+    if (key.data->type != mpack_type_uint) {
+      throw type_error("member index");
+    }
+    auto index = mpack_node_u64(key);
+    if (index >= member_size) {
+      throw error("no member at index " + std::to_string(index));
+    }
+    table[index](obj, mpack_node_map_value_at(patch, i));
+  }
+}
+
+} // namespace seria
@@ -0,0 +1,27 @@
+#pragma once
+#include <mpack/mpack-node.h>
+#include <mpack/mpack-writer.h>
+#include <seria/deserialize/mpack.hpp>
+#include <seria/diff.hpp>
+#include <seria/serialize/mpack.hpp>
+
+namespace seria {
+
+// Writes the delta turning `old` into `now`: a map from the registration
+// index of each changed member to its new value, or to the delta of its
+// own for members holding registered objects. An empty map when nothing
+// changed, which is what it returns.
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value, bool>
+diff(const T &old, const T &now, mpack_writer_t *writer);
+
+// Updates the members of `obj` present in the delta and leaves the others
+// as they are, `nil` resets a member to its default value. Throws
+// `seria::error` like `deserialize`, and for indices `T` does not have.
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value>
+apply_patch(T &obj, const mpack_node_t &patch);
+
+} // namespace seria
+
+#include <seria/diff/mpack-inl.hpp>
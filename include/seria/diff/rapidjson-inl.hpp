@@ -0,0 +1,126 @@
+#pragma once
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/diff.hpp>
+#include <seria/exception.hpp>
+#include <seria/serialize/rapidjson.hpp>
+#include <seria/shape.hpp>
+
+namespace seria {
+
+template <typename T>
+void add_patch_value(rapidjson::Value &patch, const char *key, const T &old,
+                     const T &now,
+                     rapidjson::Document::AllocatorType &allocator,
+                     std::true_type /*object*/) {
+  rapidjson::Value name(key, allocator);
+  rapidjson::Value value(diff(old, now).Move(), allocator);
+  patch.AddMember(name, value, allocator);
+}
+
+template <typename T>
+void add_patch_value(rapidjson::Value &patch, const char *key,
+                     const T & /*old*/, const T &now,
+                     rapidjson::Document::AllocatorType &allocator,
+                     std::false_type /*object*/) {
+  rapidjson::Value name(key, allocator);
+  rapidjson::Value value(serialize(now).Move(), allocator);
+  patch.AddMember(name, value, allocator);
+}
+
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value, rapidjson::Document>
+diff(const T &old, const T &now) {
+  rapidjson::Document patch(rapidjson::kObjectType);
+  auto &allocator = patch.GetAllocator();
+
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  member_changes<T> changes(old, now);
+  if (changes.count == 0) {
+    return patch;
+  }
+
+  size_t index = 0;
+  auto adder = [&](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    if (changes.changed[index++]) {
+      add_patch_value(patch, member.m_key, old.*(member.m_ptr),
+                      now.*(member.m_ptr), allocator,
+                      is_patched_object<Type>{});
+    }
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+
+  return patch;
+}
+
+template <typename T>
+void apply_patch_value(T &data, const rapidjson::Value &value,
+                       std::true_type /*object*/) {
+  apply_patch(data, value);
+}
+
+template <typename T>
+void apply_patch_value(T &data, const rapidjson::Value &value,
+                       std::false_type /*object*/) {
+  deserialize(data, value);
+}
+
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value>
+apply_patch(T &obj, const rapidjson::Value &patch) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  if (!patch.IsObject()) {
+    throw type_error("object");
+  }
+
+  auto first = patch.MemberBegin();
+  auto count = static_cast<size_t>(patch.MemberCount());
+  auto key_at = [first](size_t i, size_t *length) {
+    *length = first[i].name.GetStringLength();
+    return first[i].name.GetString();
+  };
+
+  // patches from `diff` have their members in registration order, the
+  // next key is looked at first
+  uint32_t next = 0;
+  size_t applied = 0;
+  auto setter = [&](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    if (applied == count) {
+      return;
+    }
+    auto found =
+        find_key(member.m_key, member.m_key_length, count, next, key_at);
+    if (found == count) {
+      return;
+    }
+    next = static_cast<uint32_t>(found + 1);
+    applied++;
+
+    auto &value = first[found].value;
+    try {
+      if (value.IsNull()) {
+        obj.*(member.m_ptr) = member.m_default_value;
+        return;
+      }
+      apply_patch_value(obj.*(member.m_ptr), value,
+                        is_patched_object<Type>{});
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+} // namespace seria
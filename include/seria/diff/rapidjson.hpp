@@ -0,0 +1,25 @@
+#pragma once
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/diff.hpp>
+#include <seria/serialize/rapidjson.hpp>
+
+namespace seria {
+
+// JSON Merge Patch (RFC 7386) turning `old` into `now`: an object with the
+// members that changed, the members holding registered objects being
+// patches of their own. Empty when nothing changed.
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value, rapidjson::Document>
+diff(const T &old, const T &now);
+
+// Updates the members of `obj` present in `patch` and leaves the others as
+// they are. `null` resets a member to its default value, unknown members
+// are ignored. Throws `seria::error` like `deserialize`, the members before
+// the one in error are updated then.
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value>
+apply_patch(T &obj, const rapidjson::Value &patch);
+
+} // namespace seria
+
+#include <seria/diff/rapidjson-inl.hpp>
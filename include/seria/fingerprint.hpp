@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+// FNV-1a over a structural signature of the registered type: member keys,
+// kinds and sizes in registration order. Two types share a fingerprint iff
+// their encodings are interchangeable.
+class fingerprint_builder {
+public:
+  void add(const void *data, size_t size) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+      m_hash ^= bytes[i];
+      m_hash *= 0x100000001b3ULL;
+    }
+  }
+
+  void add(char tag) { add(&tag, 1); }
+
+  void add_size(uint64_t size) {
+    for (int i = 0; i < 8; i++) {
+      add(static_cast<char>(size >> (i * 8)));
+    }
+  }
+
+  uint64_t value() const noexcept { return m_hash; }
+
+private:
+  uint64_t m_hash = 0xcbf29ce484222325ULL;
+};
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value>
+add_fingerprint(fingerprint_builder &builder) {
+  if (is_boolean<T>::value) {
+    builder.add('b');
+    return;
+  }
+
+  builder.add(std::is_floating_point<T>::value ? 'f'
+              : std::is_signed<T>::value     ? 'i'
+                                             : 'u');
+  builder.add_size(sizeof(T));
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value>
+add_fingerprint(fingerprint_builder &builder) {
+  builder.add('e');
+  builder.add_size(sizeof(T));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value>
+add_fingerprint(fingerprint_builder &builder) {
+  builder.add('s');
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+add_fingerprint(fingerprint_builder &builder);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+add_fingerprint(fingerprint_builder &builder);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+add_fingerprint(fingerprint_builder &builder);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+add_fingerprint(fingerprint_builder &builder) {
+  builder.add(is_columnar_vector<T>::value ? 'c' : 'v');
+  add_fingerprint<typename T::value_type>(builder);
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+add_fingerprint(fingerprint_builder &builder) {
+  builder.add('a');
+  builder.add_size(is_array<T>::size);
+  add_fingerprint<std::decay_t<decltype(std::declval<T &>()[0])>>(builder);
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+add_fingerprint(fingerprint_builder &builder) {
+  // recursive types refer back to the enclosing object instead of expanding
+  static thread_local bool visiting = false;
+  if (visiting) {
+    builder.add('r');
+    return;
+  }
+
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  visiting = true;
+  builder.add('{');
+  auto adder = [&builder](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    builder.add(member.m_key, strlen(member.m_key) + 1);
+    add_fingerprint<Type>(builder);
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+  builder.add('}');
+  visiting = false;
+}
+
+template <typename T> uint64_t schema_fingerprint() {
+  static const uint64_t fingerprint = [] {
+    fingerprint_builder builder;
+    add_fingerprint<T>(builder);
+    return builder.value();
+  }();
+  return fingerprint;
+}
+
+} // namespace seria
@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <seria/crc32c.hpp>
+#include <seria/exception.hpp>
+#include <string>
+
+namespace seria {
+
+// A stream of frames, each one holding one message:
+//
+//   flags       1 byte, `frame_fingerprint` | `frame_checksum`
+//   length      varint, bytes of the payload
+//   fingerprint 8 bytes little-endian, with `frame_fingerprint`: the
+//               `schema_fingerprint` of the type of the message
+//   payload
+//   checksum    4 bytes little-endian, with `frame_checksum`: the CRC-32C of
+//               the frame up to here
+enum frame_flags : uint8_t {
+  frame_fingerprint = 1,
+  frame_checksum = 2,
+};
+
+constexpr size_t frame_max_header_size = 1 + 10 + 8;
+
+struct frame_options {
+  // written into every frame, required in every frame read
+  bool fingerprint = false;
+  bool checksum = true;
+  // larger frames are rejected by readers before they are buffered
+  size_t max_size = 64 << 20;
+};
+
+inline size_t frame_varint_size(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+// Writes the header of a frame holding `length` bytes, which takes
+// `1 + frame_varint_size(length)` bytes plus 8 with a fingerprint.
+inline void write_frame_header(char *out, uint8_t flags, uint64_t length,
+                               uint64_t fingerprint) {
+  *out++ = static_cast<char>(flags);
+  while (length >= 0x80) {
+    *out++ = static_cast<char>((length & 0x7F) | 0x80);
+    length >>= 7;
+  }
+  *out++ = static_cast<char>(length);
+  if ((flags & frame_fingerprint) != 0) {
+    for (int i = 0; i < 8; i++) {
+      *out++ = static_cast<char>(fingerprint >> (8 * i));
+    }
+  }
+}
+
+// a complete frame within a buffer
+struct frame_view {
+  uint8_t flags;
+  uint64_t fingerprint;
+  const char *payload;
+  size_t size;
+  // bytes of the whole frame
+  size_t frame_size;
+};
+
+// Finds the frame at the start of `data`, false when it is not complete yet.
+// Throws `seria::error` when the bytes are not a valid frame, including a
+// checksum mismatch: where the next frame starts is unknown then.
+inline bool parse_frame(const char *data, size_t size,
+                        const frame_options &options, frame_view &frame) {
+  if (size == 0) {
+    return false;
+  }
+
+  frame.flags = static_cast<uint8_t>(data[0]);
+  if ((frame.flags & ~(frame_fingerprint | frame_checksum)) != 0) {
+    throw error("unknown frame flags");
+  }
+
+  uint64_t length = 0;
+  size_t position = 1;
+  for (unsigned shift = 0;; shift += 7) {
+    if (position == size) {
+      return false;
+    }
+    if (shift == 63 + 7) {
+      throw error("malformed frame length");
+    }
+    auto byte = static_cast<uint8_t>(data[position++]);
+    length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  if (length > options.max_size) {
+    throw error("frame of " + std::to_string(length) +
+                " bytes is larger than the maximum of " +
+                std::to_string(options.max_size));
+  }
+
+  auto fingerprinted = (frame.flags & frame_fingerprint) != 0;
+  auto checked = (frame.flags & frame_checksum) != 0;
+  if (options.fingerprint && !fingerprinted) {
+    throw error("frame without schema fingerprint");
+  }
+  if (options.checksum && !checked) {
+    throw error("frame without checksum");
+  }
+
+  auto payload = position + (fingerprinted ? 8 : 0);
+  size_t trailer = checked ? 4 : 0;
+  if (size < payload + trailer || size - payload - trailer < length) {
+    return false;
+  }
+  auto end = payload + static_cast<size_t>(length);
+
+  frame.fingerprint = 0;
+  if (fingerprinted) {
+    for (int i = 0; i < 8; i++) {
+      frame.fingerprint |=
+          static_cast<uint64_t>(static_cast<uint8_t>(data[position + i]))
+          << (8 * i);
+    }
+  }
+  frame.payload = data + payload;
+  frame.size = static_cast<size_t>(length);
+  frame.frame_size = end + trailer;
+
+  if (checked) {
+    uint32_t checksum = 0;
+    for (int i = 0; i < 4; i++) {
+      checksum |= static_cast<uint32_t>(static_cast<uint8_t>(data[end + i]))
+                  << (8 * i);
+    }
+    if (crc32c::compute(data, end) != checksum) {
+      throw error("frame checksum mismatch");
+    }
+  }
+  return true;
+}
+
+// Input of a frame reader. Bytes are received straight into it and frames
+// are decoded where they are; the unread bytes, usually part of one frame,
+// are moved to the front when the space at the end runs out.
+class frame_buffer {
+public:
+  explicit frame_buffer(size_t capacity = 64 << 10) : m_data(capacity, '\0') {}
+
+  // space for at least `size` more bytes, to be committed after writing
+  char *prepare(size_t size) {
+    if (m_data.size() - m_end < size) {
+      auto unread = m_end - m_begin;
+      if (m_begin != 0) {
+        std::memmove(&m_data[0], m_data.data() + m_begin, unread);
+        m_begin = 0;
+        m_end = unread;
+      }
+      if (m_data.size() - m_end < size) {
+        auto capacity = std::max<size_t>(m_data.size() * 2, 256);
+        while (capacity - m_end < size) {
+          capacity *= 2;
+        }
+        m_data.resize(capacity);
+      }
+    }
+    return &m_data[m_end];
+  }
+
+  void commit(size_t size) noexcept { m_end += size; }
+
+  void write(const char *data, size_t size) {
+    if (size != 0) {
+      std::memcpy(prepare(size), data, size);
+      commit(size);
+    }
+  }
+
+  const char *data() const noexcept { return m_data.data() + m_begin; }
+
+  size_t size() const noexcept { return m_end - m_begin; }
+
+  void consume(size_t size) noexcept {
+    m_begin += size;
+    if (m_begin == m_end) {
+      m_begin = 0;
+      m_end = 0;
+    }
+  }
+
+private:
+  std::string m_data;
+  size_t m_begin = 0;
+  size_t m_end = 0;
+};
+
+} // namespace seria
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <mpack/mpack-node.h>
+#include <mpack/mpack-writer.h>
+#include <seria/exception.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/frame.hpp>
+#include <string>
+
+namespace seria {
+
+class frame_writer {
+public:
+  explicit frame_writer(frame_options options = frame_options())
+      : m_options(options) {}
+
+  // Appends a frame holding `value`, throws `seria::error` when it is larger
+  // than `max_size`. Nothing is appended when it throws.
+  template <typename T> void write(const T &value) {
+    uint8_t flags = (m_options.fingerprint ? frame_fingerprint : 0) |
+                    (m_options.checksum ? frame_checksum : 0);
+    size_t fixed = 1 + (m_options.fingerprint ? 8 : 0);
+    size_t trailer = m_options.checksum ? 4 : 0;
+
+    // the header is sized for a length as long as the previous one, the
+    // payload is moved when it is not
+    auto payload = m_size + fixed + m_length_size;
+    auto used = encode(value, payload, trailer);
+    if (used > m_options.max_size) {
+      throw error("frame of " + std::to_string(used) +
+                  " bytes is larger than the maximum of " +
+                  std::to_string(m_options.max_size));
+    }
+
+    auto length_size = frame_varint_size(used);
+    if (length_size != m_length_size) {
+      auto moved = m_size + fixed + length_size;
+      reserve(moved + used + trailer);
+      std::memmove(&m_data[moved], m_data.data() + payload, used);
+      payload = moved;
+      m_length_size = length_size;
+    }
+
+    uint64_t fingerprint = 0;
+    if (m_options.fingerprint) {
+      fingerprint = schema_fingerprint<T>();
+    }
+    write_frame_header(&m_data[m_size], flags, used, fingerprint);
+    auto end = payload + used;
+    if (m_options.checksum) {
+      auto checksum = crc32c::compute(m_data.data() + m_size, end - m_size);
+      for (int i = 0; i < 4; i++) {
+        m_data[end + i] = static_cast<char>(checksum >> (8 * i));
+      }
+    }
+    m_size = end + trailer;
+  }
+
+  const char *data() const noexcept { return m_data.data(); }
+
+  size_t size() const noexcept { return m_size; }
+
+  // drops the frames written, keeping the memory for the next ones
+  void clear() noexcept { m_size = 0; }
+
+private:
+  // encodes `value` at `payload` leaving `trailer` bytes after it, growing
+  // the buffer until it fits
+  template <typename T>
+  size_t encode(const T &value, size_t payload, size_t trailer) {
+    reserve(payload + trailer + 256);
+    while (true) {
+      mpack_writer_t writer;
+      mpack_writer_init(&writer, &m_data[payload],
+                        m_data.size() - payload - trailer);
+      serialize(value, &writer);
+      auto used = mpack_writer_buffer_used(&writer);
+      auto err = mpack_writer_destroy(&writer);
+      if (err == mpack_ok) {
+        return used;
+      }
+      if (err != mpack_error_too_big) {
+        throw error(std::string("msgpack writer error: ") +
+                    mpack_error_to_string(err));
+      }
+      reserve(m_data.size() * 2);
+    }
+  }
+
+  void reserve(size_t size) {
+    if (m_data.size() < size) {
+      m_data.resize(std::max(size, m_data.size() * 2));
+    }
+  }
+
+  frame_options m_options;
+  std::string m_data;
+  size_t m_size = 0;
+  // bytes of the length of the last frame
+  size_t m_length_size = 1;
+};
+
+class frame_reader {
+public:
+  explicit frame_reader(frame_options options = frame_options(),
+                        size_t capacity = 64 << 10)
+      : m_options(options), m_buffer(capacity) {}
+
+  // Space for receiving at least `size` bytes, e.g. with `read`, then
+  // `commit` the bytes received.
+  char *prepare(size_t size) { return m_buffer.prepare(size); }
+
+  void commit(size_t size) noexcept { m_buffer.commit(size); }
+
+  // copies bytes received elsewhere
+  void feed(const char *data, size_t size) { m_buffer.write(data, size); }
+
+  // received bytes not read as frames yet
+  size_t buffered() const noexcept { return m_buffer.size(); }
+
+  // Decodes the next frame into `value`, false when it has not been received
+  // completely. Throws `seria::error` for an invalid frame, which the stream
+  // cannot be read past, and for a frame of another schema or one that
+  // does not decode into `T`, which are skipped.
+  template <typename T> bool next(T &value) {
+    frame_view frame;
+    if (!parse_frame(m_buffer.data(), m_buffer.size(), m_options, frame)) {
+      return false;
+    }
+    // the payload stays where it is until more bytes are prepared
+    m_buffer.consume(frame.frame_size);
+
+    if ((frame.flags & frame_fingerprint) != 0 &&
+        frame.fingerprint != schema_fingerprint<T>()) {
+      throw error("schema fingerprint mismatch");
+    }
+
+    struct tree_guard {
+      mpack_tree_t tree;
+      ~tree_guard() { mpack_tree_destroy(&tree); }
+    } guard;
+
+    mpack_tree_init_data(&guard.tree, frame.payload, frame.size);
+    mpack_tree_parse(&guard.tree);
+    if (mpack_tree_error(&guard.tree) != mpack_ok) {
+      throw error(std::string("msgpack reader error: ") +
+                  mpack_error_to_string(mpack_tree_error(&guard.tree)));
+    }
+    deserialize(value, mpack_tree_root(&guard.tree));
+    return true;
+  }
+
+private:
+  frame_options m_options;
+  frame_buffer m_buffer;
+};
+
+} // namespace seria
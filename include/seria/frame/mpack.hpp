@@ -0,0 +1,19 @@
+#pragma once
+#include <seria/deserialize/mpack.hpp>
+#include <seria/frame.hpp>
+#include <seria/serialize/mpack.hpp>
+
+namespace seria {
+
+// Writes messages as msgpack frames (see `frame.hpp`) into one buffer, to be
+// sent and cleared by the caller. The payload is encoded in place after its
+// header.
+class frame_writer;
+
+// Reads msgpack frames from bytes received into it, decoding each payload
+// where it is in the buffer.
+class frame_reader;
+
+} // namespace seria
+
+#include <seria/frame/mpack-inl.hpp>
@@ -0,0 +1,245 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+struct hash_options {
+  // whether the member keys are hashed along with the values, so that
+  // objects of types with other keys hash differently
+  bool names = false;
+  uint64_t seed = 0;
+};
+
+// Streaming 64-bit hash in the style of wyhash: 48-byte blocks are mixed
+// into 3 independent lanes with 64x64->128 bit multiplications, the rest
+// and the length when the value is taken. Words are read in little-endian
+// order, so the hash of the same bytes is the same on every platform, and
+// does not depend on how they were split between calls to `add`.
+class hash_builder {
+public:
+  explicit hash_builder(hash_options options = hash_options())
+      : m_names(options.names) {
+    auto seed = options.seed ^ mix(options.seed ^ secret0, secret1);
+    m_lanes[0] = seed;
+    m_lanes[1] = seed;
+    m_lanes[2] = seed;
+  }
+
+  bool names() const noexcept { return m_names; }
+
+  void add(const void *data, size_t size) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    m_length += size;
+    if (m_used + size < block) {
+      std::memcpy(m_buffer + m_used, bytes, size);
+      m_used += size;
+      return;
+    }
+    if (m_used != 0) {
+      auto fill = block - m_used;
+      std::memcpy(m_buffer + m_used, bytes, fill);
+      consume(m_buffer);
+      bytes += fill;
+      size -= fill;
+    }
+    for (; size >= block; size -= block, bytes += block) {
+      consume(bytes);
+    }
+    std::memcpy(m_buffer, bytes, size);
+    m_used = size;
+  }
+
+  // the little-endian bytes of `value`
+  template <typename T> void add_value(T value) {
+#ifdef SERIA_BIG_ENDIAN
+    value = byte_swap(value);
+#endif
+    // most values fit in the block being filled, a copy of a known size
+    if (m_used + sizeof(T) > block) {
+      add(&value, sizeof(value));
+      return;
+    }
+    std::memcpy(m_buffer + m_used, &value, sizeof(T));
+    m_used += sizeof(T);
+    m_length += sizeof(T);
+    if (m_used == block) {
+      consume(m_buffer);
+      m_used = 0;
+    }
+  }
+
+  void add_size(uint64_t size) { add_value(size); }
+
+  uint64_t value() const noexcept {
+    auto state = m_lanes[0] ^ m_lanes[1] ^ m_lanes[2];
+    uint8_t tail[block + 16] = {};
+    std::memcpy(tail, m_buffer, m_used);
+    for (size_t i = 0; i < m_used; i += 16) {
+      state = mix(load(tail + i) ^ secret1, load(tail + i + 8) ^ state);
+    }
+    return mix(state ^ secret0 ^ m_length, secret3 ^ state);
+  }
+
+private:
+  constexpr static size_t block = 48;
+  constexpr static uint64_t secret0 = 0xa0761d6478bd642fULL;
+  constexpr static uint64_t secret1 = 0xe7037ed1a0b428dbULL;
+  constexpr static uint64_t secret2 = 0x8ebc6af09c88c6e3ULL;
+  constexpr static uint64_t secret3 = 0x589965cc75374cc3ULL;
+
+  // the high and low halves of the 128-bit product folded together
+  static uint64_t mix(uint64_t a, uint64_t b) noexcept {
+#ifdef __SIZEOF_INT128__
+    auto product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^
+           static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t a_high = a >> 32;
+    uint64_t a_low = static_cast<uint32_t>(a);
+    uint64_t b_high = b >> 32;
+    uint64_t b_low = static_cast<uint32_t>(b);
+    uint64_t high = a_high * b_high;
+    uint64_t middle0 = a_high * b_low;
+    uint64_t middle1 = a_low * b_high;
+    uint64_t low = a_low * b_low;
+    uint64_t carry = ((low >> 32) + static_cast<uint32_t>(middle0) +
+                      static_cast<uint32_t>(middle1)) >>
+                     32;
+    high += (middle0 >> 32) + (middle1 >> 32) + carry;
+    low += (middle0 << 32) + (middle1 << 32);
+    return low ^ high;
+#endif
+  }
+
+  static uint64_t load(const uint8_t *bytes) noexcept {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+#ifdef SERIA_BIG_ENDIAN
+    word = byte_swap(word);
+#endif
+    return word;
+  }
+
+  void consume(const uint8_t *bytes) noexcept {
+    m_lanes[0] = mix(load(bytes) ^ secret1, load(bytes + 8) ^ m_lanes[0]);
+    m_lanes[1] = mix(load(bytes + 16) ^ secret2, load(bytes + 24) ^ m_lanes[1]);
+    m_lanes[2] = mix(load(bytes + 32) ^ secret3, load(bytes + 40) ^ m_lanes[2]);
+  }
+
+  uint64_t m_lanes[3];
+  uint64_t m_length = 0;
+  uint8_t m_buffer[block];
+  size_t m_used = 0;
+  bool m_names;
+};
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value>
+add_hash(const T &value, hash_builder &builder) {
+  if (is_boolean<T>::value) {
+    builder.add_value(static_cast<uint8_t>(value ? 1 : 0));
+    return;
+  }
+  builder.add_value(value);
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> add_hash(const T &value,
+                                                  hash_builder &builder) {
+  builder.add_value(static_cast<std::underlying_type_t<T>>(value));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> add_hash(const T &value,
+                                               hash_builder &builder) {
+  builder.add_size(value.size());
+  builder.add(value.data(), value.size());
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value || is_array<T>::value>
+add_hash(const T &value, hash_builder &builder);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> add_hash(const T &value,
+                                               hash_builder &builder);
+
+template <typename Allocator>
+void add_hash(const std::vector<bool, Allocator> &value,
+              hash_builder &builder) {
+  builder.add_size(value.size());
+  for (bool element : value) {
+    add_hash(element, builder);
+  }
+}
+
+// elements stored as their little-endian bytes are hashed all at once
+template <typename T>
+void add_hash_elements(const T *elements, size_t size, hash_builder &builder,
+                       std::true_type /*pod*/) {
+#ifdef SERIA_BIG_ENDIAN
+  add_hash_elements(elements, size, builder, std::false_type{});
+#else
+  builder.add(elements, size * sizeof(T));
+#endif
+}
+
+template <typename T>
+void add_hash_elements(const T *elements, size_t size, hash_builder &builder,
+                       std::false_type /*pod*/) {
+  for (size_t i = 0; i < size; i++) {
+    add_hash(elements[i], builder);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value || is_array<T>::value>
+add_hash(const T &value, hash_builder &builder) {
+  auto size = static_cast<size_t>(std::end(value) - std::begin(value));
+  if (is_vector<T>::value) {
+    builder.add_size(size);
+  }
+  if (size != 0) {
+    add_hash_elements(&*std::begin(value), size, builder,
+                      is_binary_pod<element_type_t<T>>{});
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> add_hash(const T &value,
+                                               hash_builder &builder) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto adder = [&value, &builder](auto &member) {
+    if (builder.names()) {
+      builder.add_size(member.m_key_length);
+      builder.add(member.m_key, member.m_key_length);
+    }
+    add_hash(value.*(member.m_ptr), builder);
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+}
+
+// Hash of the member values of a registered object, or of any value the
+// serializers take, without encoding it. Integers and floating point
+// numbers are hashed as their bit patterns at their size, strings and
+// vectors with their length, so equal values hash alike across runs and
+// platforms as long as their types have the same sizes.
+//
+//   auto changed = seria::hash(profile) != last_hash;
+template <typename T>
+uint64_t hash(const T &value, hash_options options = hash_options()) {
+  hash_builder builder(options);
+  add_hash(value, builder);
+  return builder.value();
+}
+
+} // namespace seria
@@ -0,0 +1,512 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace seria {
+
+enum class decode_status : uint8_t {
+  // the input so far is decoded, the value is not complete yet
+  need_more,
+  done,
+  error,
+};
+
+enum class incremental_kind : uint8_t {
+  // decoded at once by the `deserialize` of the backend when complete
+  leaf,
+  object,
+  sequence,
+};
+
+// How the decoders walk into a value of a given type, so that the stack of
+// partially decoded objects and arrays can be kept between calls.
+struct incremental_ops {
+  incremental_kind kind = incremental_kind::leaf;
+
+  // objects
+  size_t member_count = 0;
+  // index of the member named `key`, `member_count` when there is none
+  size_t (*find)(const char *key, size_t length, size_t guess) = nullptr;
+  const char *(*key)(size_t index) = nullptr;
+  void *(*member)(void *object, size_t index,
+                  const incremental_ops **ops) = nullptr;
+  // sets the members that were not seen, throws for those without defaults
+  void (*finish)(void *object, const std::vector<bool> &seen) = nullptr;
+
+  // vectors and fixed size arrays, `element` grows vectors as needed
+  void *(*element)(void *sequence, size_t index,
+                   const incremental_ops **ops) = nullptr;
+  void (*resize)(void *sequence, size_t size) = nullptr;
+
+  // leaves, `parsed` is a complete value of the backend
+  void (*leaf)(void *value, const void *parsed) = nullptr;
+};
+
+template <typename T, typename Parser>
+const incremental_ops &incremental_ops_of();
+
+// Columnar vectors, `std::vector<bool>` and objects with their own
+// `deserialize` instead of registered members are leaves as well, they are
+// not decoded element by element.
+template <typename T, typename Parser, typename _ = void>
+struct incremental_type {
+  static incremental_ops make() {
+    incremental_ops ops;
+    ops.leaf = &Parser::template decode_leaf<T>;
+    return ops;
+  }
+};
+
+template <typename T, typename Parser>
+struct incremental_type<
+    T, Parser,
+    std::enable_if_t<is_object<T>::value &&
+                     std::tuple_size<decltype(register_object<T>())>::value !=
+                         0>> {
+  using Members = decltype(register_object<T>());
+  constexpr static size_t member_size = std::tuple_size<Members>::value;
+
+  struct key_entry {
+    const char *key;
+    size_t length;
+  };
+
+  static const std::array<key_entry, member_size> &keys() {
+    static const auto keys = [] {
+      std::array<key_entry, member_size> result{};
+      size_t index = 0;
+      auto adder = [&](auto &member) {
+        result[index++] = {member.m_key, member.m_key_length};
+      };
+      for_each(adder, KeyValueRecords<T, Members>::members,
+               std::make_index_sequence<member_size>());
+      return result;
+    }();
+    return keys;
+  }
+
+  static size_t find(const char *key, size_t length, size_t guess) {
+    auto &entries = keys();
+    auto matches = [&](size_t index) {
+      return entries[index].length == length &&
+             std::memcmp(entries[index].key, key, length) == 0;
+    };
+
+    if (guess < member_size && matches(guess)) {
+      return guess;
+    }
+    for (size_t i = 0; i < member_size; i++) {
+      if (matches(i)) {
+        return i;
+      }
+    }
+    return member_size;
+  }
+
+  static const char *key(size_t index) { return keys()[index].key; }
+
+  template <size_t I>
+  static void *member_at(void *object, const incremental_ops **ops) {
+    auto &member = std::get<I>(KeyValueRecords<T, Members>::members);
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    *ops = &incremental_ops_of<Type, Parser>();
+    return &(static_cast<T *>(object)->*(member.m_ptr));
+  }
+
+  template <size_t... I>
+  static void *member(void *object, size_t index, const incremental_ops **ops,
+                      std::index_sequence<I...>) {
+    using getter = void *(*)(void *, const incremental_ops **);
+    static const getter getters[] = {&member_at<I>...};
+    return getters[index](object, ops);
+  }
+
+  static void *member(void *object, size_t index,
+                      const incremental_ops **ops) {
+    return member(object, index, ops, std::make_index_sequence<member_size>());
+  }
+
+  static void finish(void *object, const std::vector<bool> &seen) {
+    auto &data = *static_cast<T *>(object);
+    size_t index = 0;
+    auto setter = [&](auto &member) {
+      if (seen[index++]) {
+        return;
+      }
+
+      if (!member.m_has_default) {
+        throw error(member.m_key, "missing value");
+      }
+
+      data.*(member.m_ptr) = member.m_default_value;
+    };
+
+    for_each(setter, KeyValueRecords<T, Members>::members,
+             std::make_index_sequence<member_size>());
+  }
+
+  static incremental_ops make() {
+    incremental_ops ops;
+    ops.kind = incremental_kind::object;
+    ops.member_count = member_size;
+    ops.find = &find;
+    ops.key = &key;
+    ops.member = &member;
+    ops.finish = &finish;
+    return ops;
+  }
+};
+
+template <typename T, typename Parser>
+struct incremental_type<
+    T, Parser,
+    std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value &&
+                     !is_boolean<typename T::value_type>::value>> {
+  static void *element(void *sequence, size_t index,
+                       const incremental_ops **ops) {
+    auto &data = *static_cast<T *>(sequence);
+    if (index >= data.size()) {
+      data.resize(index + 1);
+    }
+    *ops = &incremental_ops_of<typename T::value_type, Parser>();
+    return &data[index];
+  }
+
+  static void resize(void *sequence, size_t size) {
+    static_cast<T *>(sequence)->resize(size);
+  }
+
+  static incremental_ops make() {
+    incremental_ops ops;
+    ops.kind = incremental_kind::sequence;
+    ops.element = &element;
+    ops.resize = &resize;
+    return ops;
+  }
+};
+
+template <typename T, typename Parser>
+struct incremental_type<T, Parser, std::enable_if_t<is_array<T>::value>> {
+  using Element = std::decay_t<decltype(std::declval<T &>()[0])>;
+
+  static void *element(void *sequence, size_t index,
+                       const incremental_ops **ops) {
+    if (index >= is_array<T>::size) {
+      throw error("the size of array is not same with target");
+    }
+    *ops = &incremental_ops_of<Element, Parser>();
+    return &(*static_cast<T *>(sequence))[index];
+  }
+
+  static void resize(void * /*sequence*/, size_t size) {
+    if (size != is_array<T>::size) {
+      throw error("the size of array is not same with target");
+    }
+  }
+
+  static incremental_ops make() {
+    incremental_ops ops;
+    ops.kind = incremental_kind::sequence;
+    ops.element = &element;
+    ops.resize = &resize;
+    return ops;
+  }
+};
+
+template <typename T, typename Parser>
+const incremental_ops &incremental_ops_of() {
+  static const incremental_ops ops = incremental_type<T, Parser>::make();
+  return ops;
+}
+
+// An object or array being decoded, `target` is null when the value is
+// skipped: unknown members, or the inside of a leaf that is buffered until
+// it is complete.
+struct incremental_frame {
+  void *target = nullptr;
+  const incremental_ops *ops = nullptr;
+  // the member being decoded, or the number of elements so far
+  size_t index = 0;
+  // items left in the container when its size is known upfront
+  size_t remaining = 0;
+  // an object or a map, whatever `ops` is
+  bool map = false;
+  // grammar state of the parser
+  uint8_t state = 0;
+  std::vector<bool> seen;
+};
+
+// The state shared by the push parsers: the frame stack, the unconsumed
+// input and the error. The input given to `feed` is decoded in place and
+// only a trailing incomplete token, or a leaf being buffered, is copied.
+class incremental_state {
+public:
+  incremental_state(void *root, const incremental_ops *ops)
+      : m_root(root), m_root_ops(ops) {}
+
+  decode_status status() const noexcept { return m_status; }
+
+  // the error when the status is `decode_status::error`
+  const error &last_error() const { return *m_error; }
+
+protected:
+  bool skipping() const noexcept {
+    return m_depth != 0 && top().target == nullptr;
+  }
+
+  incremental_frame &top() { return m_frames[m_depth - 1]; }
+
+  const incremental_frame &top() const { return m_frames[m_depth - 1]; }
+
+  // where the next value goes, null when it is skipped
+  void *next_target(const incremental_ops **ops) {
+    if (m_depth == 0) {
+      *ops = m_root_ops;
+      return m_root;
+    }
+
+    auto &frame = top();
+    if (frame.target == nullptr) {
+      return nullptr;
+    }
+
+    if (frame.ops->kind == incremental_kind::object) {
+      if (frame.index == frame.ops->member_count) {
+        return nullptr;
+      }
+      return frame.ops->member(frame.target, frame.index, ops);
+    }
+
+    try {
+      return frame.ops->element(frame.target, frame.index, ops);
+    } catch (type_error &err) {
+      throw_at(err, m_depth - 1);
+    } catch (error &err) {
+      throw_at(err, m_depth - 1);
+    }
+  }
+
+  incremental_frame &push(void *target, const incremental_ops *ops, bool map) {
+    if (m_depth == m_frames.size()) {
+      m_frames.emplace_back();
+    }
+
+    auto &frame = m_frames[m_depth++];
+    frame.target = target;
+    frame.ops = ops;
+    frame.index = 0;
+    frame.remaining = 0;
+    frame.map = map;
+    frame.state = 0;
+    if (target != nullptr && ops->kind == incremental_kind::object) {
+      frame.seen.assign(ops->member_count, false);
+    }
+    return frame;
+  }
+
+  // finishes the top container, the caller marks its value as complete
+  void pop() {
+    auto &frame = top();
+    if (frame.target != nullptr) {
+      try {
+        if (frame.ops->kind == incremental_kind::object) {
+          frame.ops->finish(frame.target, frame.seen);
+        } else {
+          frame.ops->resize(frame.target, frame.index);
+        }
+      } catch (type_error &err) {
+        throw_at(err, m_depth - 1);
+      } catch (error &err) {
+        throw_at(err, m_depth - 1);
+      }
+    }
+    m_depth--;
+  }
+
+  // selects the member of the top object frame named `key`, later values
+  // of a member that was already seen are skipped
+  void select_member(const char *key, size_t length) {
+    auto &frame = top();
+    if (frame.target == nullptr) {
+      return;
+    }
+
+    auto count = frame.ops->member_count;
+    auto guess = frame.index + 1 < count ? frame.index + 1 : 0;
+    auto index = frame.ops->find(key, length, guess);
+    frame.index = index != count && frame.seen[index] ? count : index;
+  }
+
+  // the value in the top frame is complete
+  void advance() {
+    if (m_depth == 0) {
+      m_status = decode_status::done;
+      return;
+    }
+
+    auto &frame = top();
+    if (frame.target != nullptr &&
+        frame.ops->kind == incremental_kind::object) {
+      if (frame.index != frame.ops->member_count) {
+        frame.seen[frame.index] = true;
+      }
+    } else {
+      frame.index++;
+    }
+  }
+
+  void decode_into(void *target, const incremental_ops *ops,
+                   const void *parsed) {
+    try {
+      ops->leaf(target, parsed);
+    } catch (type_error &err) {
+      throw_at(err, m_depth);
+    } catch (error &err) {
+      throw_at(err, m_depth);
+    }
+  }
+
+  // throws `err` with the keys and indices of the frames below `depth`
+  template <typename Error>
+  [[noreturn]] void throw_at(Error &err, size_t depth) {
+    for (auto i = depth; i-- > 0;) {
+      auto &frame = m_frames[i];
+      if (frame.ops->kind == incremental_kind::object) {
+        err.add_prefix(frame.ops->key(frame.index));
+      } else {
+        err.add_prefix(std::to_string(frame.index));
+      }
+    }
+    throw err;
+  }
+
+  [[noreturn]] void wrong_type(const char *desired_type) {
+    type_error err(desired_type);
+    throw_at(err, m_depth);
+  }
+
+  [[noreturn]] void syntax_error(const std::string &message,
+                                 size_t position) {
+    throw error(message + " at offset " + std::to_string(m_offset + position));
+  }
+
+  // A container decoded into a leaf is skipped over and decoded as a whole
+  // once its end is found, the input is kept from its start till then.
+  void start_capture(size_t position, void *target,
+                     const incremental_ops *ops) {
+    m_capturing = true;
+    m_capture_start = position;
+    m_capture_depth = m_depth;
+    m_capture_target = target;
+    m_capture_ops = ops;
+  }
+
+  // Runs `parse(data, size, begin, last)` over the unconsumed input followed
+  // by `data`. It returns how far the input is decoded, what follows, or the
+  // container being captured, is kept for the next call.
+  template <typename Parse>
+  decode_status run(const char *data, size_t size, bool last, Parse &&parse) {
+    if (m_status == decode_status::error) {
+      return m_status;
+    }
+
+    const char *input = data;
+    if (!m_buffer.empty()) {
+      m_buffer.append(data, size);
+      input = m_buffer.data();
+      size = m_buffer.size();
+    }
+
+    auto position = m_resume;
+    try {
+      position = parse(input, size, m_resume, last);
+    } catch (type_error &err) {
+      m_error = std::make_shared<type_error>(err);
+      m_status = decode_status::error;
+    } catch (error &err) {
+      m_error = std::make_shared<error>(err);
+      m_status = decode_status::error;
+    }
+
+    if (m_status == decode_status::error) {
+      m_buffer.clear();
+      m_buffer.shrink_to_fit();
+      return m_status;
+    }
+
+    auto consumed = m_capturing ? m_capture_start : position;
+    if (input == data) {
+      m_buffer.assign(data + consumed, size - consumed);
+    } else {
+      m_buffer.erase(0, consumed);
+    }
+    m_offset += consumed;
+    m_capture_start -= m_capturing ? consumed : 0;
+    m_resume = position - consumed;
+    return m_status;
+  }
+
+  void *m_root;
+  const incremental_ops *m_root_ops;
+  std::vector<incremental_frame> m_frames;
+  size_t m_depth = 0;
+  decode_status m_status = decode_status::need_more;
+  std::shared_ptr<error> m_error;
+  std::string m_buffer;
+  // offset of the start of `m_buffer` in the whole input
+  size_t m_offset = 0;
+  // where to go on within `m_buffer`
+  size_t m_resume = 0;
+  // bytes of the token at `m_resume` the parser has scanned already, so a
+  // long string is not scanned again on every call; one past the input
+  // when it ends inside an escape sequence
+  size_t m_token_scanned = 0;
+
+  bool m_capturing = false;
+  size_t m_capture_start = 0;
+  size_t m_capture_depth = 0;
+  void *m_capture_target = nullptr;
+  const incremental_ops *m_capture_ops = nullptr;
+};
+
+class json_push_parser;
+
+// Decodes `T` from input received in pieces, e.g. from a socket. Every call
+// to `feed` decodes as much as is available and keeps the position in the
+// nested objects and arrays for the next one, so decoding overlaps with
+// receiving and only incomplete tokens are buffered. Scalars, strings and
+// columnar vectors are decoded by the `deserialize` of the backend once
+// complete, objects and arrays are decoded as they arrive.
+//
+//   seria::incremental_decoder<Test> decoder(data);  // json
+//   seria::incremental_decoder<Test, seria::mpack_push_parser> decoder(data);
+template <typename T, typename Parser = json_push_parser>
+class incremental_decoder {
+public:
+  explicit incremental_decoder(T &data)
+      : m_parser(&data, &incremental_ops_of<T, Parser>()) {}
+
+  decode_status feed(const char *data, size_t size) {
+    return m_parser.feed(data, size);
+  }
+
+  // the input is complete, fails when the value is not
+  decode_status finish() { return m_parser.finish(); }
+
+  decode_status status() const noexcept { return m_parser.status(); }
+
+  const error &last_error() const { return m_parser.last_error(); }
+
+private:
+  Parser m_parser;
+};
+
+} // namespace seria
@@ -0,0 +1,284 @@
+#pragma once
+#include <cstdint>
+#include <mpack/mpack-node.h>
+#include <seria/exception.hpp>
+#include <seria/incremental.hpp>
+#include <string>
+
+namespace seria {
+
+class mpack_push_parser : public incremental_state {
+public:
+  using incremental_state::incremental_state;
+
+  template <typename T>
+  static void decode_leaf(void *value, const void *parsed) {
+    deserialize(*static_cast<T *>(value),
+                *static_cast<const mpack_node_t *>(parsed));
+  }
+
+  decode_status feed(const char *data, size_t size) {
+    return run(data, size, false,
+               [this](const char *input, size_t size, size_t begin,
+                      bool last) { return parse(input, size, begin, last); });
+  }
+
+  decode_status finish() {
+    return run(nullptr, 0, true,
+               [this](const char *input, size_t size, size_t begin,
+                      bool last) { return parse(input, size, begin, last); });
+  }
+
+private:
+  // states of map frames
+  enum : uint8_t { key, value };
+
+  enum class header_kind : uint8_t { scalar, string, map, array };
+
+  // a type byte and the length that follows it
+  struct header {
+    header_kind kind;
+    size_t size;
+    // bytes of the payload, or items of a container
+    uint64_t length;
+  };
+
+  static uint64_t big_endian(const char *data, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+      value = value << 8 | static_cast<uint8_t>(data[i]);
+    }
+    return value;
+  }
+
+  // false when the header is not complete yet
+  bool read_header(const char *input, size_t size, size_t position,
+                   header *result) {
+    auto type = static_cast<uint8_t>(input[position]);
+    auto fixed = [result](header_kind kind, size_t size, uint64_t length) {
+      *result = {kind, size, length};
+    };
+
+    // the length of the length, then the kind of value it is for
+    size_t length_size = 0;
+    if (type <= 0x7f || type >= 0xe0) {
+      fixed(header_kind::scalar, 1, 0);
+    } else if (type <= 0x8f) {
+      fixed(header_kind::map, 1, type & 0x0f);
+    } else if (type <= 0x9f) {
+      fixed(header_kind::array, 1, type & 0x0f);
+    } else if (type <= 0xbf) {
+      fixed(header_kind::string, 1, type & 0x1f);
+    } else {
+      switch (type) {
+      case 0xc0: // nil
+      case 0xc2: // false
+      case 0xc3: // true
+        fixed(header_kind::scalar, 1, 0);
+        break;
+      case 0xc4: // bin 8, 16, 32
+      case 0xc5:
+      case 0xc6:
+        length_size = size_t(1) << (type - 0xc4);
+        result->kind = header_kind::scalar;
+        break;
+      case 0xc7: // ext 8, 16, 32, the length is followed by the ext type
+      case 0xc8:
+      case 0xc9:
+        length_size = size_t(1) << (type - 0xc7);
+        result->kind = header_kind::scalar;
+        break;
+      case 0xca: // float 32, 64
+        fixed(header_kind::scalar, 1, 4);
+        break;
+      case 0xcb:
+        fixed(header_kind::scalar, 1, 8);
+        break;
+      case 0xcc: // uint 8, 16, 32, 64
+      case 0xcd:
+      case 0xce:
+      case 0xcf:
+        fixed(header_kind::scalar, 1, uint64_t(1) << (type - 0xcc));
+        break;
+      case 0xd0: // int 8, 16, 32, 64
+      case 0xd1:
+      case 0xd2:
+      case 0xd3:
+        fixed(header_kind::scalar, 1, uint64_t(1) << (type - 0xd0));
+        break;
+      case 0xd4: // fixext 1, 2, 4, 8, 16
+      case 0xd5:
+      case 0xd6:
+      case 0xd7:
+      case 0xd8:
+        fixed(header_kind::scalar, 2, uint64_t(1) << (type - 0xd4));
+        break;
+      case 0xd9: // str 8, 16, 32
+      case 0xda:
+      case 0xdb:
+        length_size = size_t(1) << (type - 0xd9);
+        result->kind = header_kind::string;
+        break;
+      case 0xdc: // array 16, 32
+      case 0xdd:
+        length_size = size_t(2) << (type - 0xdc);
+        result->kind = header_kind::array;
+        break;
+      case 0xde: // map 16, 32
+      case 0xdf:
+        length_size = size_t(2) << (type - 0xde);
+        result->kind = header_kind::map;
+        break;
+      default: // 0xc1 is never used
+        syntax_error("msgpack reader error: invalid type byte", position);
+      }
+    }
+
+    if (length_size == 0) {
+      return position + result->size <= size;
+    }
+
+    auto ext = type >= 0xc7 && type <= 0xc9 ? 1 : 0;
+    result->size = 1 + length_size + ext;
+    if (position + result->size > size) {
+      return false;
+    }
+    result->length = big_endian(input + position + 1, length_size);
+    return true;
+  }
+
+  size_t parse(const char *input, size_t size, size_t position, bool last) {
+    m_input = input;
+    while (true) {
+      while (m_depth != 0 && top().remaining == 0) {
+        close(input, position);
+      }
+
+      // same as a tree, what follows the root value is not read
+      if (m_status == decode_status::done) {
+        return size;
+      }
+
+      header item{};
+      if (position == size || !read_header(input, size, position, &item)) {
+        if (last) {
+          syntax_error("msgpack reader error: unexpected end of data", size);
+        }
+        return position;
+      }
+
+      auto container =
+          item.kind == header_kind::map || item.kind == header_kind::array;
+      auto end = position + item.size + (container ? 0 : item.length);
+      if (!container && end > size) {
+        if (last) {
+          syntax_error("msgpack reader error: unexpected end of data", size);
+        }
+        return position;
+      }
+
+      if (m_depth != 0 && top().map && top().state == key) {
+        auto &frame = top();
+        if (item.kind != header_kind::string) {
+          // matches no member, the key is skipped like a value and so is
+          // the value after it
+          if (frame.target != nullptr) {
+            frame.index = frame.ops->member_count;
+          }
+        } else {
+          select_member(input + position + item.size,
+                        static_cast<size_t>(item.length));
+          frame.state = value;
+          frame.remaining--;
+          position = end;
+          continue;
+        }
+      }
+
+      if (container) {
+        open(item, position);
+      } else {
+        leaf(input + position, end - position);
+      }
+      position = end;
+    }
+  }
+
+  void open(const header &item, size_t position) {
+    const incremental_ops *ops = nullptr;
+    auto *target = m_capturing || skipping() ? nullptr : next_target(&ops);
+    value_started();
+    auto map = item.kind == header_kind::map;
+    if (target != nullptr && ops->kind == incremental_kind::leaf) {
+      start_capture(position, target, ops);
+      target = nullptr;
+    } else if (target != nullptr &&
+               (ops->kind == incremental_kind::object) != map) {
+      wrong_type(map ? "array" : "object");
+    }
+    // keys and values of maps are counted apart
+    auto &frame = push(target, ops, map);
+    frame.remaining = static_cast<size_t>(map ? item.length * 2 : item.length);
+  }
+
+  void leaf(const char *data, size_t size) {
+    if (!m_capturing && !skipping()) {
+      const incremental_ops *ops = nullptr;
+      auto *target = next_target(&ops);
+      if (target != nullptr) {
+        if (ops->kind != incremental_kind::leaf) {
+          wrong_type(ops->kind == incremental_kind::object ? "object"
+                                                           : "array");
+        }
+        decode(data, size, target, ops);
+      }
+    }
+    value_started();
+    advance();
+  }
+
+  void decode(const char *data, size_t size, void *target,
+              const incremental_ops *ops) {
+    struct tree_guard {
+      mpack_tree_t tree;
+      ~tree_guard() { mpack_tree_destroy(&tree); }
+    } guard;
+
+    mpack_tree_init_data(&guard.tree, data, size);
+    mpack_tree_parse(&guard.tree);
+    if (mpack_tree_error(&guard.tree) != mpack_ok) {
+      syntax_error(std::string("msgpack reader error: ") +
+                       mpack_error_to_string(mpack_tree_error(&guard.tree)),
+                   static_cast<size_t>(data - m_input));
+    }
+    auto root = mpack_tree_root(&guard.tree);
+    decode_into(target, ops, &root);
+  }
+
+  // the parent expects the next key, value or item after this one
+  void value_started() {
+    if (m_depth == 0) {
+      return;
+    }
+
+    auto &frame = top();
+    frame.remaining--;
+    frame.state = frame.state == key ? value : key;
+  }
+
+  void close(const char *input, size_t position) {
+    if (!m_capturing) {
+      pop();
+    } else if (--m_depth == m_capture_depth) {
+      m_capturing = false;
+      decode(input + m_capture_start, position - m_capture_start,
+             m_capture_target, m_capture_ops);
+    }
+    advance();
+  }
+
+  // the input of the current call, for the offsets of errors
+  const char *m_input = nullptr;
+};
+
+} // namespace seria
@@ -0,0 +1,14 @@
+#pragma once
+#include <seria/deserialize/mpack.hpp>
+#include <seria/incremental.hpp>
+
+namespace seria {
+
+// Push parser of msgpack for `incremental_decoder`. Leaves are decoded with
+// the `deserialize` overloads taking a `mpack_node_t`, map keys that are not
+// strings match no member.
+class mpack_push_parser;
+
+} // namespace seria
+
+#include <seria/incremental/mpack-inl.hpp>
@@ -0,0 +1,338 @@
+#pragma once
+#include <seria/exception.hpp>
+#include <seria/incremental.hpp>
+#ifdef SERIA_USE_EXTERNAL_RAPIDJSON
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+#else
+#include <seria/rapidjson/document.h>
+#include <seria/rapidjson/error/en.h>
+#endif
+#include <cstring>
+#include <string>
+
+namespace seria {
+
+class json_push_parser : public incremental_state {
+public:
+  using incremental_state::incremental_state;
+
+  template <typename T>
+  static void decode_leaf(void *value, const void *parsed) {
+    deserialize(*static_cast<T *>(value),
+                *static_cast<const rapidjson::Value *>(parsed));
+  }
+
+  decode_status feed(const char *data, size_t size) {
+    return run(data, size, false,
+               [this](const char *input, size_t size, size_t begin,
+                      bool last) { return parse(input, size, begin, last); });
+  }
+
+  decode_status finish() {
+    return run(nullptr, 0, true,
+               [this](const char *input, size_t size, size_t begin,
+                      bool last) { return parse(input, size, begin, last); });
+  }
+
+private:
+  // states of object frames
+  enum : uint8_t { key_or_end, key, colon, member_value, member_end };
+  // states of array frames
+  enum : uint8_t { element_or_end, element, element_end };
+
+  static constexpr size_t incomplete = static_cast<size_t>(-1);
+
+  static bool blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+  size_t parse(const char *input, size_t size, size_t position, bool last) {
+    while (true) {
+      while (position != size && blank(input[position])) {
+        position++;
+      }
+
+      if (m_status == decode_status::done) {
+        if (position != size) {
+          syntax_error(
+              "The document root must not be followed by other values.",
+              position);
+        }
+        return position;
+      }
+
+      if (position == size) {
+        if (last) {
+          unexpected_end(position);
+        }
+        return position;
+      }
+
+      auto c = input[position];
+      if (m_depth == 0) {
+        if (!value(input, size, position, last)) {
+          return position;
+        }
+        continue;
+      }
+
+      auto &frame = top();
+      if (frame.map) {
+        switch (frame.state) {
+        case key_or_end:
+          if (c == '}') {
+            close(input, position);
+            continue;
+          }
+          // fallthrough
+        case key: {
+          if (c != '"') {
+            syntax_error("Missing a name for object member.", position);
+          }
+          auto end = string_end(input, size, position);
+          if (end == incomplete) {
+            if (last) {
+              // the parser reports what is wrong with it
+              parse_range(input, position, size);
+            }
+            return position;
+          }
+          member_key(input, position, end);
+          frame.state = colon;
+          position = end;
+          break;
+        }
+        case colon:
+          if (c != ':') {
+            syntax_error("Missing a colon after a name of object member.",
+                         position);
+          }
+          frame.state = member_value;
+          position++;
+          break;
+        case member_value:
+          if (!value(input, size, position, last)) {
+            return position;
+          }
+          break;
+        default: // member_end
+          if (c == ',') {
+            frame.state = key;
+            position++;
+          } else if (c == '}') {
+            close(input, position);
+          } else {
+            syntax_error("Missing a comma or '}' after an object member.",
+                         position);
+          }
+        }
+        continue;
+      }
+
+      switch (frame.state) {
+      case element_or_end:
+        if (c == ']') {
+          close(input, position);
+          continue;
+        }
+        // fallthrough
+      case element:
+        if (!value(input, size, position, last)) {
+          return position;
+        }
+        break;
+      default: // element_end
+        if (c == ',') {
+          frame.state = element;
+          position++;
+        } else if (c == ']') {
+          close(input, position);
+        } else {
+          syntax_error("Missing a comma or ']' after an array element.",
+                       position);
+        }
+      }
+    }
+  }
+
+  // offset after the string starting at `position`, `incomplete` when its
+  // closing quote is not there yet. The scan goes on where it stopped, the
+  // string is where the parse resumes then.
+  size_t string_end(const char *input, size_t size, size_t position) {
+    auto i = position + 1 + m_token_scanned;
+    while (i < size) {
+      if (input[i] == '\\') {
+        i += 2;
+      } else if (input[i] == '"') {
+        m_token_scanned = 0;
+        return i + 1;
+      } else {
+        i++;
+      }
+    }
+    m_token_scanned = i - position - 1;
+    return incomplete;
+  }
+
+  // offset after the number or literal starting at `position`
+  static size_t scalar_end(const char *input, size_t size, size_t position) {
+    auto i = position;
+    while (i != size && !blank(input[i]) && input[i] != ',' &&
+           input[i] != ']' && input[i] != '}' && input[i] != ':') {
+      i++;
+    }
+    return i;
+  }
+
+  void parse_range(const char *input, size_t begin, size_t end) {
+    m_document.Parse(input + begin, end - begin);
+    if (m_document.HasParseError()) {
+      syntax_error(rapidjson::GetParseError_En(m_document.GetParseError()),
+                   begin + m_document.GetErrorOffset());
+    }
+  }
+
+  // numbers and literals are parsed alone, what follows them belongs to the
+  // enclosing container
+  void parse_scalar(const char *input, size_t begin, size_t end) {
+    if (begin == end) {
+      syntax_error("Invalid value.", begin);
+    }
+
+    m_document.Parse(input + begin, end - begin);
+    auto code = m_document.GetParseError();
+    if (code == rapidjson::kParseErrorDocumentRootNotSingular &&
+        m_depth != 0) {
+      syntax_error(top().map
+                       ? "Missing a comma or '}' after an object member."
+                       : "Missing a comma or ']' after an array element.",
+                   begin + m_document.GetErrorOffset());
+    }
+    if (code != rapidjson::kParseErrorNone) {
+      syntax_error(rapidjson::GetParseError_En(code),
+                   begin + m_document.GetErrorOffset());
+    }
+  }
+
+  void member_key(const char *input, size_t begin, size_t end) {
+    auto *key = input + begin + 1;
+    auto length = end - begin - 2;
+    if (std::memchr(key, '\\', length) == nullptr) {
+      select_member(key, length);
+      return;
+    }
+
+    // escapes are checked even in skipped values
+    parse_range(input, begin, end);
+    select_member(m_document.GetString(), m_document.GetStringLength());
+    m_document.GetAllocator().Clear();
+  }
+
+  // decodes or opens the value at `position`, false when it is incomplete
+  bool value(const char *input, size_t size, size_t &position, bool last) {
+    auto c = input[position];
+    if (c == '{' || c == '[') {
+      const incremental_ops *ops = nullptr;
+      auto *target = skipping() ? nullptr : next_target(&ops);
+      value_started();
+      auto map = c == '{';
+      if (target != nullptr && ops->kind == incremental_kind::leaf) {
+        start_capture(position, target, ops);
+        target = nullptr;
+      } else if (target != nullptr &&
+                 (ops->kind == incremental_kind::object) != map) {
+        wrong_type(map ? "array" : "object");
+      }
+      push(target, ops, map);
+      position++;
+      return true;
+    }
+
+    auto end = c == '"' ? string_end(input, size, position)
+                        : scalar_end(input, size, position);
+    if ((end == incomplete || (end == size && c != '"')) && !last) {
+      return false;
+    }
+    // the parser reports what is missing
+    end = end == incomplete ? size : end;
+
+    parse_scalar(input, position, end);
+    if (m_capturing) {
+      m_document.GetAllocator().Clear();
+      value_started();
+      advance();
+      position = end;
+      return true;
+    }
+
+    const incremental_ops *ops = nullptr;
+    auto *target = skipping() ? nullptr : next_target(&ops);
+    if (target != nullptr) {
+      if (ops->kind != incremental_kind::leaf) {
+        wrong_type(ops->kind == incremental_kind::object ? "object"
+                                                         : "array");
+      }
+      decode_into(target, ops, &m_document);
+    }
+    m_document.GetAllocator().Clear();
+    value_started();
+    advance();
+    position = end;
+    return true;
+  }
+
+  // the parent expects a separator or its end after this value
+  void value_started() {
+    if (m_depth == 0) {
+      return;
+    }
+
+    auto &frame = top();
+    if (frame.map) {
+      frame.state = member_end;
+    } else {
+      frame.state = element_end;
+    }
+  }
+
+  void close(const char *input, size_t &position) {
+    position++;
+    if (!m_capturing) {
+      pop();
+    } else if (--m_depth == m_capture_depth) {
+      m_capturing = false;
+      parse_range(input, m_capture_start, position);
+      decode_into(m_capture_target, m_capture_ops, &m_document);
+      m_document.GetAllocator().Clear();
+    }
+    advance();
+  }
+
+  [[noreturn]] void unexpected_end(size_t position) {
+    if (m_depth == 0) {
+      syntax_error("The document is empty.", position);
+    }
+
+    auto &frame = top();
+    if (frame.map && frame.state == member_end) {
+      syntax_error("Missing a comma or '}' after an object member.", position);
+    }
+    if (frame.map && frame.state == colon) {
+      syntax_error("Missing a colon after a name of object member.",
+                   position);
+    }
+    if (frame.map && frame.state != member_value) {
+      syntax_error("Missing a name for object member.", position);
+    }
+    if (!frame.map && frame.state == element_end) {
+      syntax_error("Missing a comma or ']' after an array element.",
+                   position);
+    }
+    syntax_error("Invalid value.", position);
+  }
+
+  rapidjson::Document m_document;
+};
+
+} // namespace seria
@@ -0,0 +1,14 @@
+#pragma once
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/incremental.hpp>
+
+namespace seria {
+
+// Push parser of json text for `incremental_decoder`, accepting the same
+// documents as `rapidjson::Reader` with the default flags. Leaves are
+// decoded with the `deserialize` overloads taking a `rapidjson::Value`.
+class json_push_parser;
+
+} // namespace seria
+
+#include <seria/incremental/rapidjson-inl.hpp>
@@ -0,0 +1,176 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <seria/exception.hpp>
+#include <string>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace seria {
+
+inline unsigned json_count_trailing_zeros(uint64_t mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return index;
+#else
+  return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+// one bit per byte of a 64 byte block
+struct json_block {
+  uint64_t quotes;
+  uint64_t backslashes;
+  // brackets, braces and commas
+  uint64_t structurals;
+};
+
+inline json_block json_classify(const char *data) {
+  json_block block{0, 0, 0};
+#ifdef __SSE2__
+  const auto quotes = _mm_set1_epi8('"');
+  const auto backslashes = _mm_set1_epi8('\\');
+  const auto commas = _mm_set1_epi8(',');
+  // '[' and ']' are '{' and '}' with the 0x20 bit cleared
+  const auto case_bit = _mm_set1_epi8(0x20);
+  const auto opening = _mm_set1_epi8('{');
+  const auto closing = _mm_set1_epi8('}');
+  for (int i = 0; i < 4; i++) {
+    auto chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i));
+    auto folded = _mm_or_si128(chunk, case_bit);
+    auto structurals = _mm_or_si128(
+        _mm_cmpeq_epi8(chunk, commas),
+        _mm_or_si128(_mm_cmpeq_epi8(folded, opening),
+                     _mm_cmpeq_epi8(folded, closing)));
+    auto shift = 16 * i;
+    block.quotes |= static_cast<uint64_t>(static_cast<unsigned>(
+                        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quotes))))
+                    << shift;
+    block.backslashes |=
+        static_cast<uint64_t>(static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslashes))))
+        << shift;
+    block.structurals |= static_cast<uint64_t>(static_cast<unsigned>(
+                             _mm_movemask_epi8(structurals)))
+                         << shift;
+  }
+#else
+  for (int i = 0; i < 64; i++) {
+    auto c = data[i];
+    auto bit = uint64_t(1) << i;
+    block.quotes |= c == '"' ? bit : 0;
+    block.backslashes |= c == '\\' ? bit : 0;
+    block.structurals |=
+        c == ',' || (c | 0x20) == '{' || (c | 0x20) == '}' ? bit : 0;
+  }
+#endif
+  return block;
+}
+
+// bit i is the parity of the bits 0..i
+inline uint64_t json_prefix_xor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// Offsets of the brackets, braces and commas outside of strings that are
+// at most `max_depth` containers deep, the root container being at depth 1.
+// The text is classified 64 bytes at a time, the bytes within strings are
+// masked out with a prefix xor of the unescaped quotes. Deeper containers
+// are only counted, so the index stays small when the elements of a large
+// array are themselves containers. Only the nesting is checked here, the
+// values are left to the parser.
+inline std::vector<size_t> json_structural_index(const char *data,
+                                                 size_t size,
+                                                 size_t max_depth) {
+  std::vector<size_t> index;
+  size_t depth = 0;
+  // whether the first byte of the block is escaped or within a string
+  uint64_t escaped = 0;
+  uint64_t in_string = 0;
+
+  auto fail = [](const char *message, size_t offset) {
+    throw error(std::string(message) + " at offset " + std::to_string(offset));
+  };
+
+  char tail[64];
+  for (size_t start = 0; start < size; start += 64) {
+    auto *block_data = data + start;
+    if (size - start < 64) {
+      std::memset(tail, ' ', sizeof(tail));
+      std::memcpy(tail, block_data, size - start);
+      block_data = tail;
+    }
+    auto block = json_classify(block_data);
+
+    // a backslash escapes the next byte unless it is escaped itself,
+    // backslashes are rare enough to be walked one by one
+    auto escapes = block.backslashes & ~escaped;
+    uint64_t carry = 0;
+    while (escapes != 0) {
+      auto bit = escapes & (0 - escapes);
+      escaped |= bit << 1;
+      carry |= bit >> 63;
+      escapes &= ~(bit | bit << 1);
+    }
+    auto quotes = block.quotes & ~escaped;
+    auto structurals = block.structurals & ~escaped;
+    escaped = carry;
+
+    auto strings = json_prefix_xor(quotes) ^ in_string;
+    in_string = 0 - (strings >> 63);
+    structurals &= ~strings;
+    while (structurals != 0) {
+      auto offset = start + json_count_trailing_zeros(structurals);
+      structurals &= structurals - 1;
+      switch (data[offset]) {
+      case ',':
+        if (depth == 0) {
+          fail("The document root must not be followed by other values.",
+               offset);
+        }
+        if (depth <= max_depth) {
+          index.push_back(offset);
+        }
+        break;
+      case '[':
+      case '{':
+        if (++depth <= max_depth) {
+          index.push_back(offset);
+        }
+        break;
+      default: // ']' or '}'
+        if (depth == 0) {
+          fail("Invalid value.", offset);
+        }
+        if (depth-- <= max_depth) {
+          index.push_back(offset);
+        }
+        break;
+      }
+    }
+  }
+
+  if (in_string != 0) {
+    fail("Missing a closing quotation mark in string.", size);
+  }
+  if (depth != 0) {
+    fail("Missing a closing bracket or brace.", size);
+  }
+  return index;
+}
+
+} // namespace seria
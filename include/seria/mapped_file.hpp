@@ -0,0 +1,85 @@
+#pragma once
+#include <cerrno>
+#include <cstring>
+#include <seria/exception.hpp>
+#include <string>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SERIA_HAS_MAPPED_FILE
+#endif
+
+#ifdef SERIA_HAS_MAPPED_FILE
+namespace seria {
+
+// A whole file mapped read-only, unmapped when destroyed.
+class mapped_file {
+public:
+  mapped_file() = default;
+
+  // throws `seria::error` when `path` cannot be opened or mapped
+  explicit mapped_file(const char *path) {
+    auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      fail("open", path);
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+      auto code = errno;
+      ::close(fd);
+      fail("fstat", path, code);
+    }
+    m_size = static_cast<size_t>(status.st_size);
+    // empty files cannot be mapped
+    if (m_size != 0) {
+      auto *address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address == MAP_FAILED) {
+        auto code = errno;
+        ::close(fd);
+        fail("mmap", path, code);
+      }
+      m_data = static_cast<const char *>(address);
+    }
+    ::close(fd);
+  }
+
+  mapped_file(mapped_file &&other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)) {}
+
+  mapped_file &operator=(mapped_file &&other) noexcept {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    return *this;
+  }
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  ~mapped_file() {
+    if (m_data != nullptr) {
+      ::munmap(const_cast<char *>(m_data), m_size);
+    }
+  }
+
+  const char *data() const noexcept { return m_data; }
+
+  size_t size() const noexcept { return m_size; }
+
+private:
+  // `code` is the errno of `call`, saved before the file is closed
+  [[noreturn]] static void fail(const char *call, const char *path,
+                                int code = errno) {
+    throw error(std::string(call) + " " + path +
+                " failed: " + std::strerror(code));
+  }
+
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+};
+
+} // namespace seria
+#endif
@@ -0,0 +1,237 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+namespace seria {
+
+// Specialize to cache the encoded bytes of a registered object by its
+// address and version in the `memo_cache` of the enclosing `memo_scope`.
+// The version is `is_memoized<T>::version(obj)` when the specialization
+// has one, the integral data member `version` otherwise, and must change
+// whenever the object does or another object takes its address.
+//
+//   template <> struct is_memoized<Profile> : std::true_type {
+//     static uint64_t version(const Profile &obj) { return obj.revision; }
+//   };
+template <typename T> struct is_memoized : std::false_type {};
+
+template <typename T, typename _ = void>
+struct has_memo_version : std::false_type {};
+
+template <typename T>
+struct has_memo_version<T, decltype((void)is_memoized<T>::version(
+                               std::declval<const T &>()))> : std::true_type {};
+
+template <typename T, typename _ = void>
+struct has_version_member : std::false_type {};
+
+template <typename T>
+struct has_version_member<
+    T, std::enable_if_t<std::is_integral<decltype(T::version)>::value>>
+    : std::true_type {};
+
+template <typename T>
+uint64_t memo_version(const T &obj, std::true_type /*custom*/) {
+  return static_cast<uint64_t>(is_memoized<T>::version(obj));
+}
+
+template <typename T>
+uint64_t memo_version(const T &obj, std::false_type /*custom*/) {
+  return static_cast<uint64_t>(obj.version);
+}
+
+template <typename T> uint64_t memo_version(const T &obj) {
+  static_assert(has_memo_version<T>::value || has_version_member<T>::value,
+                "memoized objects need is_memoized<T>::version or an "
+                "integral version member");
+  return memo_version(obj, has_memo_version<T>{});
+}
+
+// identifies `T` in the cache keys without RTTI: an object and its first
+// member share their address
+template <typename T> struct memo_type {
+  static const char tag;
+};
+
+template <typename T> const char memo_type<T>::tag = 0;
+
+// Encoded objects by address, type and backend, the least recently used
+// ones evicted once their bytes exceed the capacity. Shared by threads.
+class memo_cache {
+public:
+  using bytes = std::shared_ptr<const std::string>;
+
+  struct statistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    double hit_rate() const noexcept {
+      auto lookups = hits + misses;
+      return lookups == 0 ? 0.0
+                          : static_cast<double>(hits) /
+                                static_cast<double>(lookups);
+    }
+  };
+
+  // `capacity` is in encoded bytes, larger objects are never cached
+  explicit memo_cache(size_t capacity = 16 << 20) : m_capacity(capacity) {}
+
+  memo_cache(const memo_cache &) = delete;
+  memo_cache &operator=(const memo_cache &) = delete;
+
+  // the bytes of `obj` at `version` encoded by backend `format`, nullptr
+  // when they are not cached
+  template <typename T>
+  bytes find(const T &obj, uint64_t version, char format) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_index.find(key_of(obj, format));
+    if (found == m_index.end() || found->second->version != version) {
+      m_statistics.misses++;
+      return nullptr;
+    }
+    m_statistics.hits++;
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return found->second->data;
+  }
+
+  // caches `data`, replacing the bytes of another version of `obj`
+  template <typename T>
+  void insert(const T &obj, uint64_t version, char format, std::string data) {
+    if (data.size() > m_capacity) {
+      return;
+    }
+    auto value = std::make_shared<const std::string>(std::move(data));
+    auto key = key_of(obj, format);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_index.find(key);
+    if (found != m_index.end()) {
+      m_statistics.bytes -= found->second->data->size();
+      m_entries.erase(found->second);
+      m_index.erase(found);
+    }
+    m_statistics.bytes += value->size();
+    m_entries.push_front(entry{key, version, std::move(value)});
+    m_index.emplace(key, m_entries.begin());
+    while (m_statistics.bytes > m_capacity) {
+      auto &last = m_entries.back();
+      m_statistics.bytes -= last.data->size();
+      m_statistics.evictions++;
+      m_index.erase(last.key);
+      m_entries.pop_back();
+    }
+    m_statistics.entries = m_entries.size();
+  }
+
+  // drops the cached bytes of `obj`, e.g. before it is destroyed
+  template <typename T> void erase(const T &obj) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto format : {'j', 'm'}) {
+      auto found = m_index.find(key_of(obj, format));
+      if (found != m_index.end()) {
+        m_statistics.bytes -= found->second->data->size();
+        m_entries.erase(found->second);
+        m_index.erase(found);
+      }
+    }
+    m_statistics.entries = m_entries.size();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    m_entries.clear();
+    m_statistics.entries = 0;
+    m_statistics.bytes = 0;
+  }
+
+  statistics stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+  }
+
+  void reset_stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.hits = 0;
+    m_statistics.misses = 0;
+    m_statistics.evictions = 0;
+  }
+
+private:
+  struct key_type {
+    const void *address;
+    const char *type;
+    char format;
+
+    bool operator==(const key_type &other) const noexcept {
+      return address == other.address && type == other.type &&
+             format == other.format;
+    }
+  };
+
+  struct key_hash {
+    size_t operator()(const key_type &key) const noexcept {
+      auto hash = std::hash<const void *>()(key.address);
+      hash ^= std::hash<const void *>()(key.type) + 0x9e3779b9 + (hash << 6) +
+              (hash >> 2);
+      return hash ^ static_cast<size_t>(key.format);
+    }
+  };
+
+  struct entry {
+    key_type key;
+    uint64_t version;
+    bytes data;
+  };
+
+  template <typename T> static key_type key_of(const T &obj, char format) {
+    return key_type{&obj, &memo_type<T>::tag, format};
+  }
+
+  size_t m_capacity;
+  mutable std::mutex m_mutex;
+  // most recently used first
+  std::list<entry> m_entries;
+  std::unordered_map<key_type, std::list<entry>::iterator, key_hash> m_index;
+  statistics m_statistics;
+};
+
+inline memo_cache *&active_memo_cache() {
+  static thread_local memo_cache *cache = nullptr;
+  return cache;
+}
+
+// Makes `serialize` into a msgpack writer and `to_string` on this thread
+// use `cache` for memoized objects until the scope ends.
+//
+//   seria::memo_cache cache(64 << 20);
+//   {
+//     seria::memo_scope scope(cache);
+//     auto json = seria::to_string(response);
+//   }
+//   auto hit_rate = cache.stats().hit_rate();
+class memo_scope {
+public:
+  explicit memo_scope(memo_cache &cache) : m_previous(active_memo_cache()) {
+    active_memo_cache() = &cache;
+  }
+
+  memo_scope(const memo_scope &) = delete;
+  memo_scope &operator=(const memo_scope &) = delete;
+
+  ~memo_scope() { active_memo_cache() = m_previous; }
+
+private:
+  memo_cache *m_previous;
+};
+
+} // namespace seria
@@ -1,7 +1,7 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <functional>
-#include <memory>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -10,32 +10,73 @@
 
 namespace seria {
 
+constexpr size_t key_length(const char *key) {
+  size_t length = 0;
+  while (key[length] != '\0') {
+    length++;
+  }
+  return length;
+}
+
+// protobuf encoding of integer members: `int32`/`int64` varints with
+// negative values sign extended, `sint32`/`sint64` zigzag varints or
+// `(s)fixed32`/`(s)fixed64`
+enum pb_encoding : uint8_t {
+  pb_int = 0,
+  pb_sint = 1,
+  pb_fixed = 2,
+};
+
+// Members are literal types when `T` is, so a `constexpr register_object`
+// puts the whole member table in constant-initialized storage.
 template <typename Object, typename T> struct Member {
   const char *m_key = "";
   T Object::*m_ptr = nullptr;
-  std::unique_ptr<T> m_default_value;
+  // used for missing keys when `m_has_default` is set
+  T m_default_value{};
+  bool m_has_default = false;
+  // protobuf field number, 0 for the 1-based registration position
+  uint32_t m_field = 0;
+  size_t m_key_length = 0;
+  pb_encoding m_encoding = pb_int;
   using Type = T;
 };
 
 template <typename Object, typename T>
 constexpr auto member(const char *key, T Object::*ptr) {
-  return Member<Object, T>{key, ptr, nullptr};
+  return Member<Object, T>{key, ptr, T{}, false, 0, key_length(key)};
 }
 
 template <typename Object, typename T>
 constexpr auto member(const char *key, T Object::*ptr, T &&default_value) {
-  return Member<Object, T>{key, ptr,
-                           std::make_unique<T>(std::forward<T>(default_value))};
+  return Member<Object, T>{key, ptr, std::forward<T>(default_value), true, 0,
+                           key_length(key)};
+}
+
+template <typename Object, typename T>
+constexpr auto pb_member(uint32_t field, const char *key, T Object::*ptr,
+                         pb_encoding encoding = pb_int) {
+  return Member<Object, T>{key, ptr, T{}, false, field, key_length(key),
+                           encoding};
+}
+
+template <typename Object, typename T>
+constexpr auto pb_member(uint32_t field, const char *key, T Object::*ptr,
+                         T &&default_value, pb_encoding encoding = pb_int) {
+  return Member<Object, T>{key, ptr, std::forward<T>(default_value), true,
+                           field, key_length(key), encoding};
 }
 
 template <typename T, typename TupleType> struct KeyValueRecords {
-  static TupleType members;
+  static const TupleType members;
 };
 
-template <typename T> auto register_object() { return std::make_tuple(); }
+template <typename T> constexpr auto register_object() {
+  return std::make_tuple();
+}
 
 template <typename T, typename TupleType>
-TupleType KeyValueRecords<T, TupleType>::members = register_object<T>();
+const TupleType KeyValueRecords<T, TupleType>::members = register_object<T>();
 
 template <typename F, typename Tuple, size_t... I>
 void for_each(F &&f, Tuple &&t, std::index_sequence<I...> /*unused*/) {
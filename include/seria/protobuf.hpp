@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <seria/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <vector>
+
+namespace seria {
+
+enum pb_wire_type : uint8_t {
+  pb_varint = 0,
+  pb_fixed64 = 1,
+  pb_length = 2,
+  pb_fixed32 = 5,
+};
+
+// `std::vector<uint8_t>` is a `bytes` field, other vectors and arrays are
+// repeated fields
+template <typename T, typename _ = void> struct is_pb_bytes : std::false_type {};
+
+template <typename T>
+struct is_pb_bytes<T, std::enable_if_t<is_vector<T>::value &&
+                                       std::is_same<typename T::value_type,
+                                                    uint8_t>::value>>
+    : std::true_type {};
+
+template <typename T>
+struct is_pb_repeated
+    : std::integral_constant<bool, (is_vector<T>::value &&
+                                    !is_pb_bytes<T>::value) ||
+                                       is_array<T>::value> {};
+
+// scalar types whose repeated fields are written packed
+template <typename T>
+struct is_pb_packable
+    : std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                       std::is_enum<T>::value> {};
+
+// integers registered as `pb_fixed` are `fixed32`/`sfixed32` up to 32 bits
+template <typename T>
+constexpr pb_wire_type pb_wire_of(pb_encoding encoding = pb_int) {
+  return std::is_floating_point<T>::value
+             ? (sizeof(T) == sizeof(float) ? pb_fixed32 : pb_fixed64)
+         : std::is_integral<T>::value && !is_boolean<T>::value &&
+                 encoding == pb_fixed
+             ? (sizeof(T) <= sizeof(uint32_t) ? pb_fixed32 : pb_fixed64)
+         : is_pb_packable<T>::value ? pb_varint
+                                    : pb_length;
+}
+
+inline uint64_t pb_zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t pb_unzigzag(uint64_t value) {
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+inline size_t pb_varint_size(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+inline uint64_t pb_key(uint32_t field, pb_wire_type wire) {
+  return (static_cast<uint64_t>(field) << 3) | wire;
+}
+
+template <typename M> uint32_t pb_field_number(const M &member, size_t index) {
+  return member.m_field != 0 ? member.m_field
+                             : static_cast<uint32_t>(index + 1);
+}
+
+// Encodes in two passes: the sizes of nested messages and packed fields are
+// measured first and recorded in pre-order, the second pass consumes them in
+// the same order so every length prefix is written before its payload.
+class pb_writer : public binary_writer {
+public:
+  using binary_writer::binary_writer;
+
+  size_t push_size() {
+    m_sizes.push_back(0);
+    return m_sizes.size() - 1;
+  }
+
+  void set_size(size_t slot, size_t size) { m_sizes[slot] = size; }
+
+  size_t next_size() { return m_sizes[m_next++]; }
+
+  void reset_sizes() noexcept {
+    m_sizes.clear();
+    m_next = 0;
+  }
+
+private:
+  std::vector<size_t> m_sizes;
+  size_t m_next = 0;
+};
+
+class pb_reader : public binary_reader {
+public:
+  using binary_reader::binary_reader;
+
+  // skips the payload of an unknown field
+  void skip(pb_wire_type wire) {
+    switch (wire) {
+    case pb_varint:
+      read_varint();
+      break;
+    case pb_fixed64:
+      read(8);
+      break;
+    case pb_length:
+      read(read_varint());
+      break;
+    case pb_fixed32:
+      read(4);
+      break;
+    default:
+      throw error("unsupported wire type");
+    }
+  }
+};
+
+} // namespace seria
@@ -0,0 +1,469 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <seria/binary.hpp>
+#include <seria/crc32c.hpp>
+#include <seria/deserialize/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/frame.hpp>
+#include <seria/mapped_file.hpp>
+#include <seria/serialize/binary.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef SERIA_HAS_MAPPED_FILE
+namespace seria {
+
+// Records in the native binary format, see `to_binary`, without its header:
+// the schema fingerprint is checked once for the file.
+struct record_binary_codec {
+  constexpr static char id = 'b';
+
+  template <typename T>
+  static void encode(const T &value, binary_writer *writer) {
+    serialize(value, writer);
+  }
+
+  template <typename T>
+  static void decode(T &value, const char *data, size_t size) {
+    binary_reader reader(data, size);
+    deserialize(value, &reader);
+    if (reader.remaining() != 0) {
+      throw error("unexpected trailing data");
+    }
+  }
+};
+
+constexpr char record_magic[4] = {'S', 'R', 'R', 'F'};
+constexpr char record_index_magic[4] = {'S', 'R', 'R', 'X'};
+constexpr uint32_t record_version = 1;
+// magic, version, schema fingerprint, codec and 7 reserved bytes
+constexpr size_t record_header_size = 4 + 4 + 8 + 8;
+// offset of the index, number of records, CRC-32C of the index, magic
+constexpr size_t record_footer_size = 8 + 8 + 4 + 4;
+
+// A file of `T` records:
+//
+//   header   `record_header_size` bytes
+//   records  frames with a checksum (see `frame.hpp`), one per record
+//   index    8 bytes little-endian per record, the offset of its frame
+//   footer   `record_footer_size` bytes
+//
+// The index and the footer are written when the writer is closed, and
+// replaced by the next ones when records are appended later.
+template <typename T, typename Codec = record_binary_codec>
+class record_writer {
+public:
+  // Creates the file, or appends to the records of a complete one. Throws
+  // `seria::error` when it cannot be opened, or when the file appended to
+  // holds other records.
+  explicit record_writer(const char *path, bool append = false)
+      : m_path(path) {
+    if (append && ::access(path, F_OK) == 0) {
+      open_existing();
+      return;
+    }
+
+    m_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+      fail("open");
+    }
+    binary_writer header;
+    header.write(record_magic, sizeof(record_magic));
+    header.write_le<uint32_t>(record_version);
+    header.write_le<uint64_t>(schema_fingerprint<T>());
+    header.write_le<uint64_t>(static_cast<uint8_t>(Codec::id));
+    write_file(header.data(), header.size());
+    m_end = record_header_size;
+  }
+
+  record_writer(const record_writer &) = delete;
+  record_writer &operator=(const record_writer &) = delete;
+
+  // closes the file when `close` was not called, errors are lost then
+  ~record_writer() {
+    if (m_fd >= 0) {
+      try {
+        close();
+      } catch (...) {
+        ::close(m_fd);
+      }
+    }
+  }
+
+  // Appends a record, buffered until enough of them are written.
+  void write(const T &value) {
+    m_payload.clear();
+    Codec::encode(value, &m_payload);
+
+    char header[frame_max_header_size];
+    auto header_size = 1 + frame_varint_size(m_payload.size());
+    write_frame_header(header, frame_checksum, m_payload.size(), 0);
+    auto checksum = crc32c::update(crc32c::compute(header, header_size),
+                                   m_payload.data(), m_payload.size());
+
+    m_offsets.push_back(m_end);
+    m_pending.write(header, header_size);
+    m_pending.write(m_payload.data(), m_payload.size());
+    m_pending.write_le<uint32_t>(checksum);
+    m_end += header_size + m_payload.size() + 4;
+    if (m_pending.size() >= (1 << 20)) {
+      flush();
+    }
+  }
+
+  // records in the file, the ones appended included
+  size_t size() const noexcept { return m_offsets.size(); }
+
+  // Writes the pending records, the index and the footer, then closes the
+  // file. Throws `seria::error` when they cannot be written.
+  void close() {
+    if (m_fd < 0) {
+      return;
+    }
+
+    auto index = m_end;
+    for (auto offset : m_offsets) {
+      m_pending.write_le<uint64_t>(offset);
+    }
+    auto checksum = crc32c::compute(
+        m_pending.data() + m_pending.size() - m_offsets.size() * 8,
+        m_offsets.size() * 8);
+    m_pending.write_le<uint64_t>(index);
+    m_pending.write_le<uint64_t>(m_offsets.size());
+    m_pending.write_le<uint32_t>(checksum);
+    m_pending.write(record_index_magic, sizeof(record_index_magic));
+    flush();
+
+    auto fd = m_fd;
+    m_fd = -1;
+    if (::close(fd) != 0) {
+      fail("close");
+    }
+  }
+
+private:
+  // `code` is the errno of `call`, saved before the file is closed
+  [[noreturn]] void fail(const char *call, int code = errno) const {
+    throw error(std::string(call) + " " + m_path +
+                " failed: " + std::strerror(code));
+  }
+
+  void write_file(const char *data, size_t size) {
+    while (size != 0) {
+      auto written = ::write(m_fd, data, size);
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+      if (written < 0) {
+        fail("write");
+      }
+      data += written;
+      size -= static_cast<size_t>(written);
+    }
+  }
+
+  void flush() {
+    write_file(m_pending.data(), m_pending.size());
+    m_pending.clear();
+  }
+
+  // keeps the records of the file and drops its index, rewritten on close
+  void open_existing();
+
+  std::string m_path;
+  int m_fd = -1;
+  // where the next record goes
+  uint64_t m_end = 0;
+  std::vector<uint64_t> m_offsets;
+  binary_writer m_payload;
+  binary_writer m_pending;
+};
+
+// Records of a file written by `record_writer`, mapped read-only. The index
+// gives the frame of any record, which is decoded on its own: `get` reads
+// only the bytes of the record it returns. Reading is thread safe.
+//
+//   seria::write_records("points.bin", points);
+//   seria::record_file<Point> file("points.bin");
+//   auto point = file.get(12345);
+//   for (auto &point : file.range(100, 200)) { ... }
+//   file.parallel_scan([](size_t i, const Point &point) { ... }, 8);
+template <typename T, typename Codec = record_binary_codec>
+class record_file {
+public:
+  // Throws `seria::error` when the file cannot be mapped, is not a complete
+  // record file, or holds other records.
+  explicit record_file(const char *path) : m_file(path) {
+    auto *data = m_file.data();
+    auto size = m_file.size();
+    if (size < record_header_size + record_footer_size ||
+        std::memcmp(data, record_magic, sizeof(record_magic)) != 0) {
+      throw error("not a seria record file");
+    }
+    binary_reader header(data + sizeof(record_magic),
+                         record_header_size - sizeof(record_magic));
+    if (header.read_le<uint32_t>() != record_version) {
+      throw error("unsupported record file version");
+    }
+    if (header.read_le<uint64_t>() != schema_fingerprint<T>()) {
+      throw error("schema fingerprint mismatch");
+    }
+    if (header.read_le<uint64_t>() != static_cast<uint8_t>(Codec::id)) {
+      throw error("record file of another codec");
+    }
+
+    auto *footer_data = data + size - record_footer_size;
+    if (std::memcmp(footer_data + record_footer_size -
+                        sizeof(record_index_magic),
+                    record_index_magic, sizeof(record_index_magic)) != 0) {
+      throw error("record file without index");
+    }
+    binary_reader footer(footer_data, record_footer_size);
+    auto index = footer.read_le<uint64_t>();
+    auto count = footer.read_le<uint64_t>();
+    auto checksum = footer.read_le<uint32_t>();
+    if (index < record_header_size || index > size - record_footer_size ||
+        (size - record_footer_size - index) / 8 != count ||
+        (size - record_footer_size - index) % 8 != 0 ||
+        crc32c::compute(data + index, count * 8) != checksum) {
+      throw error("corrupted record index");
+    }
+    m_index = data + index;
+    m_end = static_cast<size_t>(index);
+    m_size = static_cast<size_t>(count);
+  }
+
+  size_t size() const noexcept { return m_size; }
+
+  bool empty() const noexcept { return m_size == 0; }
+
+  // Decodes record `i`, throws `seria::error` when it is out of range or
+  // damaged.
+  void get(size_t i, T &value) const {
+    if (i >= m_size) {
+      throw error("record " + std::to_string(i) + " out of range");
+    }
+    try {
+      auto frame = record(i);
+      Codec::decode(value, frame.payload, frame.size);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+
+  T get(size_t i) const {
+    T value{};
+    get(i, value);
+    return value;
+  }
+
+  // the frame of record `i`, its checksum verified
+  frame_view record(size_t i) const {
+    if (i >= m_size) {
+      throw error("record " + std::to_string(i) + " out of range");
+    }
+    auto offset = offset_of(i);
+    frame_options options;
+    options.max_size = m_end;
+    frame_view frame;
+    if (offset < record_header_size || offset >= m_end ||
+        !parse_frame(m_file.data() + offset, m_end - offset, options,
+                     frame)) {
+      throw error("record " + std::to_string(i) + " out of bounds");
+    }
+    return frame;
+  }
+
+  // Decodes the records in order as it is advanced, each one into the value
+  // it holds.
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    iterator(const record_file *file, size_t i) : m_file(file), m_i(i) {}
+
+    const T &operator*() const {
+      if (!m_decoded) {
+        m_file->get(m_i, m_value);
+        m_decoded = true;
+      }
+      return m_value;
+    }
+
+    const T *operator->() const { return &**this; }
+
+    iterator &operator++() {
+      m_i++;
+      m_decoded = false;
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const noexcept {
+      return m_i == other.m_i;
+    }
+
+    bool operator!=(const iterator &other) const noexcept {
+      return m_i != other.m_i;
+    }
+
+  private:
+    const record_file *m_file;
+    size_t m_i;
+    mutable T m_value{};
+    mutable bool m_decoded = false;
+  };
+
+  struct record_range {
+    iterator first;
+    iterator last;
+
+    iterator begin() const { return first; }
+    iterator end() const { return last; }
+  };
+
+  iterator begin() const { return iterator(this, 0); }
+
+  iterator end() const { return iterator(this, m_size); }
+
+  // the records `[first, last)`, clamped to the file
+  record_range range(size_t first, size_t last) const {
+    last = std::min(last, m_size);
+    first = std::min(first, last);
+    return record_range{iterator(this, first), iterator(this, last)};
+  }
+
+  // Calls `fn(i, record)` for every record from `threads` threads, each one
+  // taking a run of records of about the same number of bytes. The error a
+  // single thread would hit first is rethrown once all of them are done.
+  template <typename F> void parallel_scan(F &&fn, unsigned threads) const {
+    auto scan = [&](size_t first, size_t last) {
+      T value{};
+      for (auto i = first; i < last; i++) {
+        get(i, value);
+        fn(i, static_cast<const T &>(value));
+      }
+    };
+
+    threads = std::max(threads, 1u);
+    threads = static_cast<unsigned>(std::min<size_t>(threads, m_size));
+    if (threads <= 1) {
+      scan(0, m_size);
+      return;
+    }
+
+    std::vector<size_t> bounds{0};
+    auto bytes = m_end - record_header_size;
+    for (unsigned t = 1; t < threads; t++) {
+      auto target = record_header_size + bytes / threads * t;
+      size_t low = bounds.back();
+      size_t high = m_size;
+      // the first record starting after `target`
+      while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (offset_of(middle) < target) {
+          low = middle + 1;
+        } else {
+          high = middle;
+        }
+      }
+      bounds.push_back(low);
+    }
+    bounds.push_back(m_size);
+
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+      workers.emplace_back([&, t] {
+        try {
+          scan(bounds[t], bounds[t + 1]);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    for (auto &err : errors) {
+      if (err) {
+        std::rethrow_exception(err);
+      }
+    }
+  }
+
+private:
+  template <typename, typename> friend class record_writer;
+
+  uint64_t offset_of(size_t i) const noexcept {
+    uint64_t offset;
+    std::memcpy(&offset, m_index + i * 8, sizeof(offset));
+#ifdef SERIA_BIG_ENDIAN
+    offset = byte_swap(offset);
+#endif
+    return offset;
+  }
+
+  mapped_file m_file;
+  const char *m_index = nullptr;
+  // where the records end and the index starts
+  size_t m_end = 0;
+  size_t m_size = 0;
+};
+
+template <typename T, typename Codec>
+void record_writer<T, Codec>::open_existing() {
+  {
+    record_file<T, Codec> file(m_path.c_str());
+    m_offsets.resize(file.size());
+    for (size_t i = 0; i < file.size(); i++) {
+      m_offsets[i] = file.offset_of(i);
+    }
+    m_end = file.m_end;
+  }
+
+  // the file has no index until the writer is closed
+  m_fd = ::open(m_path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (m_fd < 0) {
+    fail("open");
+  }
+  if (::ftruncate(m_fd, static_cast<off_t>(m_end)) != 0) {
+    auto code = errno;
+    ::close(m_fd);
+    m_fd = -1;
+    fail("ftruncate", code);
+  }
+  if (::lseek(m_fd, static_cast<off_t>(m_end), SEEK_SET) < 0) {
+    auto code = errno;
+    ::close(m_fd);
+    m_fd = -1;
+    fail("lseek", code);
+  }
+}
+
+// Writes `values` to a new record file at `path`.
+template <typename Codec = record_binary_codec, typename T>
+void write_records(const char *path, const std::vector<T> &values) {
+  record_writer<T, Codec> writer(path);
+  for (auto &value : values) {
+    writer.write(value);
+  }
+  writer.close();
+}
+
+} // namespace seria
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdlib>
+#include <mpack/mpack-node.h>
+#include <mpack/mpack-writer.h>
+#include <seria/deserialize/mpack.hpp>
+#include <seria/exception.hpp>
+#include <seria/record_file.hpp>
+#include <seria/serialize/mpack.hpp>
+#include <string>
+
+#ifdef SERIA_HAS_MAPPED_FILE
+namespace seria {
+
+// Msgpack records for `record_file`, decoded from the mapping with a node
+// tree.
+struct record_mpack_codec {
+  constexpr static char id = 'm';
+
+  template <typename T>
+  static void encode(const T &value, binary_writer *writer) {
+    // frees the buffer when `serialize` throws
+    struct encoder_guard {
+      char *bytes = nullptr;
+      size_t size = 0;
+      mpack_writer_t encoder;
+      bool destroyed = false;
+      ~encoder_guard() {
+        if (!destroyed) {
+          mpack_writer_destroy(&encoder);
+        }
+        std::free(bytes);
+      }
+    } guard;
+
+    mpack_writer_init_growable(&guard.encoder, &guard.bytes, &guard.size);
+    serialize(value, &guard.encoder);
+    guard.destroyed = true;
+    auto err = mpack_writer_destroy(&guard.encoder);
+    if (err == mpack_ok) {
+      writer->write(guard.bytes, guard.size);
+    }
+    if (err != mpack_ok) {
+      throw error(std::string("msgpack writer error: ") +
+                  mpack_error_to_string(err));
+    }
+  }
+
+  template <typename T>
+  static void decode(T &value, const char *data, size_t size) {
+    struct tree_guard {
+      mpack_tree_t tree;
+      ~tree_guard() { mpack_tree_destroy(&tree); }
+    } guard;
+
+    mpack_tree_init_data(&guard.tree, data, size);
+    mpack_tree_parse(&guard.tree);
+    if (mpack_tree_error(&guard.tree) != mpack_ok) {
+      throw error(std::string("msgpack reader error: ") +
+                  mpack_error_to_string(mpack_tree_error(&guard.tree)));
+    }
+    deserialize(value, mpack_tree_root(&guard.tree));
+  }
+};
+
+} // namespace seria
+#endif
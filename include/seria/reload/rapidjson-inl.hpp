@@ -0,0 +1,282 @@
+#pragma once
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/diff.hpp>
+#include <seria/exception.hpp>
+#include <seria/hash.hpp>
+#include <seria/json_index.hpp>
+#include <seria/shape.hpp>
+
+namespace seria {
+
+// Splits the object whose brace is the entry `open` of a structural index
+// into its members, `close` being the entry of its closing brace. False
+// when it is malformed.
+inline bool json_object_members(const char *json,
+                                const std::vector<size_t> &index, size_t open,
+                                size_t &close,
+                                std::vector<json_member_range> &members) {
+  members.clear();
+  auto begin = index[open] + 1;
+  for (auto i = open + 1; i < index.size();) {
+    auto *end = json + index[i];
+    auto *cur = json_skip_blank(json + begin, end);
+    if (members.empty() && cur == end && *end == '}') {
+      close = i;
+      return true;
+    }
+
+    json_member_range member{std::string(), 0, 0, 0, 0};
+    cur = json_member_key(cur, end, member.key);
+    if (cur == nullptr) {
+      return false;
+    }
+    member.value = static_cast<size_t>(cur - json);
+
+    // a container within the index, up to its closing bracket
+    if (*end == '[' || *end == '{') {
+      if (!json_blank(json, member.value, index[i])) {
+        return false;
+      }
+      member.open = i;
+      size_t depth = 0;
+      do {
+        auto c = json[index[i]];
+        depth += c == '[' || c == '{' ? 1 : 0;
+        depth -= c == ']' || c == '}' ? 1 : 0;
+        i++;
+      } while (depth != 0 && i < index.size());
+      if (i == index.size()) {
+        return false;
+      }
+      member.close = i - 1;
+    }
+
+    auto c = json[index[i]];
+    if (c != ',' && c != '}') {
+      return false;
+    }
+    member.end = index[i];
+    members.push_back(std::move(member));
+    if (c == '}') {
+      close = i;
+      return true;
+    }
+    begin = index[i++] + 1;
+  }
+  return false;
+}
+
+// reports what is wrong with `json[begin, end)`, which is not an object
+[[noreturn]] inline void json_reload_fail(const char *json, size_t begin,
+                                          size_t end) {
+  rapidjson::Document document;
+  json_parse_range(document, json, begin, end);
+  if (!document.IsObject()) {
+    throw type_error("object");
+  }
+  throw error("malformed object at offset " + std::to_string(begin));
+}
+
+// number of hashes kept for the members of `T` and of its nested objects
+template <typename T>
+std::enable_if_t<!is_patched_object<T>::value, size_t>
+json_reload_slots(const T & /*obj*/) {
+  return 0;
+}
+
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value, size_t>
+json_reload_slots(const T &obj) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  size_t slots = member_size;
+  auto counter = [&](auto &member) {
+    slots += json_reload_slots(obj.*(member.m_ptr));
+  };
+  for_each(counter, members, std::make_index_sequence<member_size>());
+  return slots;
+}
+
+// how deep the nested objects go, the index has to reach all of them
+template <typename T>
+std::enable_if_t<!is_patched_object<T>::value, size_t>
+json_reload_depth(const T & /*obj*/) {
+  return 0;
+}
+
+template <typename T>
+std::enable_if_t<is_patched_object<T>::value, size_t>
+json_reload_depth(const T &obj) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  size_t depth = 0;
+  auto deepest = [&](auto &member) {
+    depth = std::max(depth, json_reload_depth(obj.*(member.m_ptr)));
+  };
+  for_each(deepest, members, std::make_index_sequence<member_size>());
+  return depth + 1;
+}
+
+// hash of the bytes of a value, without the blanks around it
+inline uint64_t json_reload_hash(const char *value, const char *end) {
+  value = json_skip_blank(value, end);
+  while (end != value && (end[-1] == ' ' || end[-1] == '\t' ||
+                          end[-1] == '\n' || end[-1] == '\r')) {
+    end--;
+  }
+  hash_builder builder;
+  builder.add(value, static_cast<size_t>(end - value));
+  return builder.value();
+}
+
+template <typename T>
+void json_reload_object(T &obj, const char *json,
+                        const std::vector<size_t> &index, size_t open,
+                        size_t close, json_reload_state &state, size_t base,
+                        const std::string &prefix);
+
+// decodes a value whose bytes changed, true when the value did
+template <typename T>
+bool json_reload_value(T &value, const char *json,
+                       const std::vector<size_t> & /*index*/,
+                       const json_member_range &range,
+                       json_reload_state & /*state*/, size_t /*base*/,
+                       const std::string & /*path*/,
+                       std::false_type /*object*/) {
+  T fresh{};
+  json_decode_range(fresh, json, range.value, range.end);
+  if (same_value(fresh, value)) {
+    return false;
+  }
+  value = std::move(fresh);
+  return true;
+}
+
+// nested objects report the members that changed themselves
+template <typename T>
+bool json_reload_value(T &value, const char *json,
+                       const std::vector<size_t> &index,
+                       const json_member_range &range,
+                       json_reload_state &state, size_t base,
+                       const std::string &path, std::true_type /*object*/) {
+  if (range.open == 0 || json[index[range.open]] != '{') {
+    json_reload_fail(json, range.value, range.end);
+  }
+  json_reload_object(value, json, index, range.open, range.close, state,
+                     base, path);
+  return false;
+}
+
+// Reloads the object whose braces are the entries `open` and `close` of
+// the index, its member hashes being the slots from `base`. `prefix` is its
+// path.
+template <typename T>
+void json_reload_object(T &obj, const char *json,
+                        const std::vector<size_t> &index, size_t open,
+                        size_t close, json_reload_state &state, size_t base,
+                        const std::string &prefix) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  std::vector<json_member_range> ranges;
+  size_t end = 0;
+  if (!json_object_members(json, index, open, end, ranges) || end != close) {
+    json_reload_fail(json, index[open], index[close] + 1);
+  }
+
+  auto count = ranges.size();
+  auto key_at = [&ranges](size_t i, size_t *length) {
+    *length = ranges[i].key.size();
+    return ranges[i].key.data();
+  };
+
+  auto slot = base;
+  auto nested = base + member_size;
+  auto reloader = [&](auto &member) {
+    auto &value = obj.*(member.m_ptr);
+    auto current = slot++;
+    auto first = nested;
+    auto slots = json_reload_slots(value);
+    nested += slots;
+    auto path = [&] {
+      return prefix.empty() ? std::string(member.m_key)
+                            : prefix + "." + member.m_key;
+    };
+
+    auto found = find_key(member.m_key, member.m_key_length, count,
+                          static_cast<uint32_t>(current - base), key_at);
+    if (found == count) {
+      if (!member.m_has_default) {
+        throw error(member.m_key, "missing value");
+      }
+      // the nested objects are decoded again when the member is back
+      state.known[current] = 0;
+      std::fill_n(state.known.begin() + static_cast<std::ptrdiff_t>(first),
+                  slots, 0);
+      if (!same_value(value, member.m_default_value)) {
+        value = member.m_default_value;
+        state.changed.push_back(path());
+      }
+      return;
+    }
+
+    auto &range = ranges[found];
+    auto hash = json_reload_hash(json + range.value, json + range.end);
+    if (state.known[current] != 0 && state.hashes[current] == hash) {
+      return;
+    }
+
+    // forgotten until decoded, it may be left half updated
+    state.known[current] = 0;
+    using type = std::decay_t<decltype(value)>;
+    try {
+      if (json_reload_value(value, json, index, range, state, first, path(),
+                            is_patched_object<type>{})) {
+        state.changed.push_back(path());
+      }
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+    state.hashes[current] = hash;
+    state.known[current] = 1;
+  };
+
+  for_each(reloader, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+json_reloader<T>::json_reloader(T &obj)
+    : m_obj(obj), m_depth(json_reload_depth(obj)) {
+  static_assert(is_patched_object<T>::value,
+                "Only registered objects are reloaded!");
+  auto slots = json_reload_slots(obj);
+  m_state.hashes.resize(slots);
+  m_state.known.resize(slots);
+}
+
+template <typename T>
+const std::vector<std::string> &json_reloader<T>::reload(const char *json,
+                                                          size_t size) {
+  m_state.changed.clear();
+  auto index = json_structural_index(json, size, m_depth);
+  if (!json_root(json, size, index, '{', '}')) {
+    json_reload_fail(json, 0, size);
+  }
+
+  json_reload_object(m_obj, json, index, 0, index.size() - 1, m_state, 0,
+                     std::string());
+  return m_state.changed;
+}
+
+} // namespace seria
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/diff.hpp>
+#include <seria/hash.hpp>
+#include <seria/json_index.hpp>
+#include <string>
+#include <vector>
+
+namespace seria {
+
+// hashes of the member values last decoded, in the slots of
+// `json_reload_slots`, and the paths of the members the last reload changed
+struct json_reload_state {
+  std::vector<uint64_t> hashes;
+  std::vector<uint8_t> known;
+  std::vector<std::string> changed;
+};
+
+// Reloads a registered object from new versions of the same JSON document,
+// e.g. a configuration file that is edited while the program runs. The
+// bytes of every member value are hashed, only the members whose bytes
+// differ from the last reload are parsed and decoded again, registered
+// objects member by member. The paths of the members whose values changed
+// are reported, like "inside.i_v", so the program only reacts to those.
+//
+//   seria::json_reloader<Config> reloader(config);
+//   for (auto &path : reloader.reload(text)) {
+//     if (path == "log.level") { ... }
+//   }
+template <typename T> class json_reloader {
+public:
+  explicit json_reloader(T &obj);
+
+  json_reloader(const json_reloader &) = delete;
+  json_reloader &operator=(const json_reloader &) = delete;
+
+  // Decodes the members that changed since the last reload, all of them
+  // the first time, and returns their paths. Missing members are reset to
+  // their defaults. Throws `seria::error` like `deserialize`, the members
+  // before the one in error are updated then.
+  const std::vector<std::string> &reload(const char *json, size_t size);
+
+  const std::vector<std::string> &reload(const std::string &json) {
+    return reload(json.data(), json.size());
+  }
+
+  // the paths of the members the last reload changed
+  const std::vector<std::string> &changed() const noexcept {
+    return m_state.changed;
+  }
+
+  // forgets the hashes, the next reload decodes every member
+  void reset() { std::fill(m_state.known.begin(), m_state.known.end(), 0); }
+
+private:
+  T &m_obj;
+  size_t m_depth;
+  json_reload_state m_state;
+};
+
+} // namespace seria
+
+#include <seria/reload/rapidjson-inl.hpp>
@@ -0,0 +1,174 @@
+#pragma once
+#include <seria/chunked.hpp>
+#include <string>
+#include <vector>
+#if defined(__has_include)
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#define SERIA_HAS_IOVEC
+#endif
+#endif
+
+namespace seria {
+
+struct scatter_segment {
+  const char *data;
+  size_t size;
+};
+
+// Output of `write_scatter`: headers, keys and small leaves are encoded into
+// an arena owned by the buffer, strings and binary data of at least
+// `threshold` bytes are referenced where they are in the serialized value.
+// The segments are valid while both the buffer, unchanged, and the value are
+// alive.
+class scatter_buffer {
+public:
+  explicit scatter_buffer(size_t threshold = 4 << 10)
+      : m_threshold(threshold) {}
+
+  size_t threshold() const noexcept { return m_threshold; }
+
+  // bytes of the whole output
+  size_t size() const noexcept { return m_arena.size() + m_referenced; }
+
+  // the output in order, for `writev`
+  std::vector<scatter_segment> segments() const {
+    std::vector<scatter_segment> result;
+    result.reserve(m_parts.size() + 1);
+    for (auto &part : m_parts) {
+      if (part.data == nullptr) {
+        result.push_back({m_arena.data() + part.begin, part.end - part.begin});
+      } else {
+        result.push_back({part.data, part.end});
+      }
+    }
+    if (m_arena.size() != m_flushed) {
+      result.push_back(
+          {m_arena.data() + m_flushed, m_arena.size() - m_flushed});
+    }
+    return result;
+  }
+
+#ifdef SERIA_HAS_IOVEC
+  std::vector<iovec> iovecs() const {
+    std::vector<iovec> result;
+    for (auto &segment : segments()) {
+      iovec vector;
+      vector.iov_base = const_cast<char *>(segment.data);
+      vector.iov_len = segment.size;
+      result.push_back(vector);
+    }
+    return result;
+  }
+#endif
+
+  // the output copied into one string
+  std::string str() const {
+    std::string result;
+    result.reserve(size());
+    for (auto &segment : segments()) {
+      result.append(segment.data, segment.size);
+    }
+    return result;
+  }
+
+  // drops the output, keeping the memory of the arena for the next value
+  void clear() noexcept {
+    m_arena.clear();
+    m_parts.clear();
+    m_flushed = 0;
+    m_referenced = 0;
+  }
+
+  std::string &arena() noexcept { return m_arena; }
+
+  // appends `size` bytes at `data` without copying them
+  void reference(const char *data, size_t size) {
+    if (m_arena.size() != m_flushed) {
+      m_parts.push_back({nullptr, m_flushed, m_arena.size()});
+      m_flushed = m_arena.size();
+    }
+    m_parts.push_back({data, 0, size});
+    m_referenced += size;
+  }
+
+private:
+  // in the arena from `begin` to `end` when `data` is null, the arena may
+  // still move; `end` bytes at `data` otherwise
+  struct part {
+    const char *data;
+    size_t begin;
+    size_t end;
+  };
+
+  size_t m_threshold;
+  std::string m_arena;
+  std::vector<part> m_parts;
+  // the arena up to here is in `m_parts`
+  size_t m_flushed = 0;
+  size_t m_referenced = 0;
+};
+
+template <typename Format>
+void scatter_value(const void *value, const chunked_ops *ops,
+                   scatter_buffer &out) {
+  auto &arena = out.arena();
+  switch (ops->kind) {
+  case chunked_kind::leaf: {
+    size_t size = 0;
+    auto *data = ops->blob == nullptr
+                     ? nullptr
+                     : ops->blob(value, out.threshold(), arena, &size);
+    if (data == nullptr) {
+      ops->leaf(value, arena);
+      return;
+    }
+    out.reference(data, size);
+    Format::end_blob(arena);
+    return;
+  }
+  case chunked_kind::object:
+    Format::begin_object(arena, ops->member_count);
+    for (size_t i = 0; i < ops->member_count; i++) {
+      const chunked_ops *member_ops = nullptr;
+      arena += ops->keys[i];
+      auto *member = ops->member(value, i, &member_ops);
+      scatter_value<Format>(member, member_ops, out);
+    }
+    Format::end_object(arena);
+    return;
+  default: { // sequence
+    auto count = ops->size(value);
+    Format::begin_array(arena, count);
+    for (size_t i = 0; i < count; i++) {
+      const chunked_ops *element_ops = nullptr;
+      Format::separator(arena, i);
+      auto *element = ops->element(value, i, &element_ops);
+      scatter_value<Format>(element, element_ops, out);
+    }
+    Format::end_array(arena);
+  }
+  }
+}
+
+// Appends the output of `data` to `out` as segments for `writev`/`sendmsg`,
+// the same bytes as the backend's `serialize`: large strings and binary
+// data are not copied, `data` has to outlive the segments.
+//
+//   seria::scatter_buffer buffer(4096);
+//   seria::write_scatter<seria::mpack_chunk_format>(data, buffer);
+//   auto vectors = buffer.iovecs();
+//   writev(socket, vectors.data(), static_cast<int>(vectors.size()));
+template <typename Format = json_chunk_format, typename T>
+void write_scatter(const T &data, scatter_buffer &out) {
+  scatter_value<Format>(&data, &chunked_ops_of<T, Format>(), out);
+}
+
+template <typename Format = json_chunk_format, typename T>
+scatter_buffer to_scatter(const T &data, size_t threshold = 4 << 10) {
+  scatter_buffer out(threshold);
+  write_scatter<Format>(data, out);
+  return out;
+}
+
+} // namespace seria
@@ -0,0 +1,190 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <seria/object.hpp>
+#include <seria/type_graph.hpp>
+#include <seria/type_traits.hpp>
+#include <vector>
+
+namespace seria {
+
+constexpr unsigned schema_max_depth = 128;
+
+enum class schema_kind : uint8_t {
+  boolean,
+  integer,
+  unsigned_integer,
+  floating,
+  enumeration,
+  string,
+  // std::vector<uint8_t>, `bin` in msgpack and an array of numbers in json
+  bytes,
+  array,
+  object,
+};
+
+struct type_schema;
+
+struct schema_member {
+  const char *key;
+  size_t key_length;
+  const type_schema *schema;
+  bool has_default;
+};
+
+// Runtime description of a registered type, for checking streamed values
+// the way `deserialize` would without a `T` to deserialize into.
+struct type_schema {
+  schema_kind kind = schema_kind::object;
+  // floating point members narrower than double
+  bool single = false;
+  // accepted range of integers and enums
+  int64_t min = 0;
+  uint64_t max = 0;
+  // element of arrays and bytes, the size of fixed size arrays or 0
+  const type_schema *element = nullptr;
+  size_t size = 0;
+  std::vector<schema_member> members;
+
+  // index of the member with the given key, or `members.size()`
+  size_t find(const char *key, size_t length) const noexcept {
+    size_t index = 0;
+    while (index < members.size() &&
+           (members[index].key_length != length ||
+            std::memcmp(members[index].key, key, length) != 0)) {
+      index++;
+    }
+    return index;
+  }
+};
+
+inline const char *schema_type_name(schema_kind kind) {
+  switch (kind) {
+  case schema_kind::boolean:
+    return "boolean";
+  case schema_kind::integer:
+    return "integer";
+  case schema_kind::unsigned_integer:
+    return "unsigned integer";
+  case schema_kind::floating:
+    return "float or double";
+  case schema_kind::enumeration:
+    return "int";
+  case schema_kind::string:
+    return "string";
+  case schema_kind::bytes:
+  case schema_kind::array:
+    return "array";
+  default:
+    return "object";
+  }
+}
+
+// Members present in an object being read, without allocating for objects
+// of up to 64 members.
+class member_set {
+public:
+  explicit member_set(size_t size) : m_overflow(size > 64 ? size - 64 : 0) {}
+
+  void insert(size_t index) {
+    if (index < 64) {
+      m_bits |= uint64_t(1) << index;
+    } else {
+      m_overflow[index - 64] = true;
+    }
+  }
+
+  bool contains(size_t index) const {
+    return index < 64 ? (m_bits >> index & 1) != 0 : m_overflow[index - 64];
+  }
+
+private:
+  uint64_t m_bits = 0;
+  std::vector<bool> m_overflow;
+};
+
+template <typename T> const type_schema &schema_of();
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> build_schema(type_schema &schema) {
+  schema.kind = schema_kind::boolean;
+}
+
+template <typename T>
+std::enable_if_t<is_integer<T>::value || std::is_enum<T>::value>
+build_schema(type_schema &schema) {
+  using Type = std::conditional_t<std::is_enum<T>::value, int, T>;
+  schema.kind = std::is_enum<T>::value ? schema_kind::enumeration
+                                       : schema_kind::integer;
+  schema.min = std::numeric_limits<Type>::min();
+  schema.max = static_cast<uint64_t>(std::numeric_limits<Type>::max());
+}
+
+template <typename T>
+std::enable_if_t<is_unsigned_integer<T>::value>
+build_schema(type_schema &schema) {
+  schema.kind = schema_kind::unsigned_integer;
+  schema.max = std::numeric_limits<T>::max();
+}
+
+template <typename T>
+std::enable_if_t<is_float<T>::value> build_schema(type_schema &schema) {
+  schema.kind = schema_kind::floating;
+  schema.single = sizeof(T) < sizeof(double);
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> build_schema(type_schema &schema) {
+  schema.kind = schema_kind::string;
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value> build_schema(type_schema &schema) {
+  static_assert(!is_columnar_vector<T>::value,
+                "columnar vectors have no row-wise equivalent");
+  schema.kind = std::is_same<typename T::value_type, uint8_t>::value
+                    ? schema_kind::bytes
+                    : schema_kind::array;
+  schema.element = &schema_of<typename T::value_type>();
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> build_schema(type_schema &schema) {
+  schema.kind = schema_kind::array;
+  schema.element =
+      &schema_of<std::decay_t<decltype(std::declval<T &>()[0])>>();
+  schema.size = is_array<T>::size;
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> build_schema(type_schema &schema) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  schema.kind = schema_kind::object;
+  auto adder = [&schema](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    schema.members.push_back({member.m_key, member.m_key_length,
+                              &schema_of<Type>(),
+                              member.m_has_default});
+  };
+  for_each(adder, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T> type_schema &schema_storage() {
+  static type_schema schema;
+  return schema;
+}
+
+// recursive types refer back to the schema under construction
+template <typename T> const type_schema &schema_of() {
+  return type_graph<type_schema>::get<T>(
+      schema_storage<T>(),
+      [](type_schema &schema) { build_schema<T>(schema); });
+}
+
+} // namespace seria
@@ -0,0 +1,236 @@
+#pragma once
+#include <seria/binary.hpp>
+#include <seria/columnar.hpp>
+#include <seria/descriptor.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> serialize(const T &obj,
+                                                 binary_writer *writer) {
+  writer->write_le<uint8_t>(obj ? 1 : 0);
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+serialize(const T &obj, binary_writer *writer) {
+  writer->write_le(obj);
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> serialize(const T &obj,
+                                                   binary_writer *writer) {
+  writer->write_le(static_cast<std::underlying_type_t<T>>(obj));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> serialize(const T &obj,
+                                                binary_writer *writer) {
+  writer->write_varint(obj.size());
+  writer->write(obj.data(), obj.size());
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                binary_writer *writer) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto &plan = binary_plan<T>::get(obj);
+  auto *base = reinterpret_cast<const char *>(&obj);
+  size_t index = 0;
+
+  auto setter = [&](auto &member) {
+    auto run = plan.runs[index];
+    auto offset = plan.offsets[index];
+    index++;
+
+    if (run == binary_plan<T>::single) {
+      serialize(obj.*(member.m_ptr), writer);
+    } else if (run != binary_plan<T>::covered) {
+      writer->write(base + offset, run);
+    }
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> serialize(const T &obj,
+                                               binary_writer *writer) {
+#ifndef SERIA_BIG_ENDIAN
+  if (is_binary_pod<T>::value) {
+    writer->write(&obj, sizeof(T));
+    return;
+  }
+#endif
+
+  for (auto &value : obj) {
+    serialize<std::decay_t<decltype(value)>>(value, writer);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value>
+serialize(const T &obj, binary_writer *writer) {
+  using Element = typename T::value_type;
+  writer->write_varint(obj.size());
+
+#ifndef SERIA_BIG_ENDIAN
+  if (is_binary_pod<Element>::value) {
+    writer->write(obj.data(), obj.size() * sizeof(Element));
+    return;
+  }
+#endif
+
+  for (auto &value : obj) {
+    serialize<Element>(value, writer);
+  }
+}
+
+template <typename T, typename Object, typename M>
+void serialize_column(const std::vector<T> &rows, M Object::*ptr,
+                      binary_writer *writer, std::true_type /*pod*/) {
+  gather_column(rows.data(), rows.size(), ptr,
+                writer->reserve(rows.size() * sizeof(M)));
+}
+
+template <typename T, typename Object, typename M>
+void serialize_column(const std::vector<T> &rows, M Object::*ptr,
+                      binary_writer *writer, std::false_type /*pod*/) {
+  for (auto &row : rows) {
+    serialize(row.*ptr, writer);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value> serialize(const T &obj,
+                                                         binary_writer *writer) {
+  using Row = typename T::value_type;
+  auto &members =
+      KeyValueRecords<Row, decltype(register_object<Row>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  writer->write_varint(obj.size());
+
+  auto setter = [&obj, writer](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    serialize_column(obj, member.m_ptr, writer, is_binary_pod<Type>{});
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T> void write_binary_header(binary_writer *writer) {
+  writer->write(binary_magic, sizeof(binary_magic));
+  writer->write_le<uint8_t>(binary_version);
+  writer->write_le<uint64_t>(schema_fingerprint<T>());
+}
+
+template <typename T> std::string to_binary(const T &obj) {
+  binary_writer writer;
+  write_binary_header<T>(&writer);
+  serialize(obj, &writer);
+  return writer.str();
+}
+
+inline void serialize_scalar(const char *value, size_t size,
+                             binary_writer *writer) {
+#ifdef SERIA_BIG_ENDIAN
+  auto *target = writer->reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    target[i] = value[size - 1 - i];
+  }
+#else
+  writer->write(value, size);
+#endif
+}
+
+// The table-driven encoder, producing the same bytes as the templates.
+inline void serialize(const type_descriptor &type, const void *obj,
+                      binary_writer *writer) {
+  auto *base = static_cast<const char *>(obj);
+  switch (type.kind) {
+  case descriptor_kind::boolean:
+    writer->write_le<uint8_t>(*static_cast<const bool *>(obj) ? 1 : 0);
+    break;
+  case descriptor_kind::scalar:
+    serialize_scalar(base, type.size, writer);
+    break;
+  case descriptor_kind::string: {
+    auto &value = *static_cast<const std::string *>(obj);
+    writer->write_varint(value.size());
+    writer->write(value.data(), value.size());
+    break;
+  }
+  case descriptor_kind::array:
+    if (type.pod) {
+      writer->write(base, type.size);
+      break;
+    }
+    for (size_t i = 0; i < type.count; i++) {
+      serialize(*type.element, base + i * type.element->size, writer);
+    }
+    break;
+  case descriptor_kind::vector: {
+    auto size = type.vector.size(obj);
+    auto *data = type.vector.data(obj);
+    auto &element = *type.element;
+    writer->write_varint(size);
+    if (element.pod) {
+      writer->write(data, size * element.size);
+      break;
+    }
+    for (size_t i = 0; i < size; i++) {
+      serialize(element, data + i * element.size, writer);
+    }
+    break;
+  }
+  case descriptor_kind::columnar: {
+    auto size = type.vector.size(obj);
+    auto *rows = type.vector.data(obj);
+    auto stride = type.element->size;
+    writer->write_varint(size);
+    for (auto &field : type.element->fields) {
+      auto &column = *field.type;
+      for (size_t i = 0; i < size; i++) {
+        auto *value = rows + i * stride + field.offset;
+        if (column.pod) {
+          writer->write(value, column.size);
+        } else {
+          serialize(column, value, writer);
+        }
+      }
+    }
+    break;
+  }
+  case descriptor_kind::object:
+    for (auto &field : type.fields) {
+      if (field.run == field_descriptor::single) {
+        serialize(*field.type, base + field.offset, writer);
+      } else if (field.run != field_descriptor::covered) {
+        writer->write(base + field.offset, field.run);
+      }
+    }
+    break;
+  }
+}
+
+template <typename T> std::string to_binary_table(const T &obj) {
+  binary_writer writer;
+  write_binary_header<T>(&writer);
+  serialize(descriptor_of<T>(), &obj, &writer);
+  return writer.str();
+}
+
+} // namespace seria
@@ -0,0 +1,52 @@
+#pragma once
+#include <seria/binary.hpp>
+#include <seria/descriptor.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> serialize(const T &obj,
+                                                 binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+serialize(const T &obj, binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> serialize(const T &obj,
+                                                   binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> serialize(const T &obj,
+                                                binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> serialize(const T &obj,
+                                               binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value>
+serialize(const T &obj, binary_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value> serialize(const T &obj,
+                                                         binary_writer *writer);
+
+template <typename T> void write_binary_header(binary_writer *writer);
+
+template <typename T> std::string to_binary(const T &obj);
+
+inline void serialize(const type_descriptor &type, const void *obj,
+                      binary_writer *writer);
+
+template <typename T> std::string to_binary_table(const T &obj);
+
+} // namespace seria
+
+#include <seria/serialize/binary-inl.hpp>
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstring>
+#include <seria/cbor.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> serialize(const T &obj,
+                                                 cbor_writer *writer) {
+  writer->write_bool(obj);
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value>
+serialize(const T &obj, cbor_writer *writer) {
+  if (std::is_signed<T>::value) {
+    writer->write_int(static_cast<int64_t>(obj));
+  } else {
+    writer->write_uint(static_cast<uint64_t>(obj));
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+serialize(const T &obj, cbor_writer *writer) {
+  if (sizeof(T) == sizeof(float)) {
+    writer->write_float(static_cast<float>(obj));
+  } else {
+    writer->write_double(static_cast<double>(obj));
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> serialize(const T &obj,
+                                                   cbor_writer *writer) {
+  writer->write_int(static_cast<int64_t>(obj));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> serialize(const T &obj,
+                                                cbor_writer *writer) {
+  writer->write_text(obj.data(), obj.size());
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                cbor_writer *writer) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto setter = [&obj, writer](auto &member) {
+    writer->write_text(member.m_key, strlen(member.m_key));
+    serialize(obj.*(member.m_ptr), writer);
+  };
+
+  writer->start_map(member_size);
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> serialize(const T &obj,
+                                               cbor_writer *writer) {
+  writer->start_array(is_array<T>::size);
+  for (auto &value : obj) {
+    serialize<std::decay_t<decltype(value)>>(value, writer);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value &&
+                 std::is_same<typename T::value_type, uint8_t>::value>
+serialize(const T &obj, cbor_writer *writer) {
+  writer->write_bytes(obj.data(), obj.size());
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value &&
+                 !std::is_same<typename T::value_type, uint8_t>::value &&
+                 is_binary_pod<typename T::value_type>::value &&
+                 std::is_arithmetic<typename T::value_type>::value>
+serialize(const T &obj, cbor_writer *writer) {
+  using Element = typename T::value_type;
+  writer->write_tag(cbor_typed_array_tag<Element>());
+  writer->write_head(cbor_bytes, obj.size() * sizeof(Element));
+
+#ifdef SERIA_BIG_ENDIAN
+  auto *dst = writer->reserve(obj.size() * sizeof(Element));
+  for (size_t i = 0; i < obj.size(); i++) {
+    auto value = byte_swap(obj[i]);
+    std::memcpy(dst + i * sizeof(Element), &value, sizeof(Element));
+  }
+#else
+  std::memcpy(writer->reserve(obj.size() * sizeof(Element)), obj.data(),
+              obj.size() * sizeof(Element));
+#endif
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value &&
+                 !(is_binary_pod<typename T::value_type>::value &&
+                   std::is_arithmetic<typename T::value_type>::value)>
+serialize(const T &obj, cbor_writer *writer) {
+  writer->start_array(obj.size());
+  for (auto &value : obj) {
+    serialize<std::decay_t<decltype(value)>>(value, writer);
+  }
+}
+
+template <typename T> std::string to_cbor(const T &obj) {
+  cbor_writer writer;
+  serialize(obj, &writer);
+  return writer.str();
+}
+
+} // namespace seria
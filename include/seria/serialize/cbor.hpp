@@ -0,0 +1,58 @@
+#pragma once
+#include <seria/cbor.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value> serialize(const T &obj,
+                                                 cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !is_boolean<T>::value>
+serialize(const T &obj, cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value>
+serialize(const T &obj, cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value> serialize(const T &obj,
+                                                   cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value> serialize(const T &obj,
+                                                cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value> serialize(const T &obj,
+                                               cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value &&
+                 std::is_same<typename T::value_type, uint8_t>::value>
+serialize(const T &obj, cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value &&
+                 !std::is_same<typename T::value_type, uint8_t>::value &&
+                 is_binary_pod<typename T::value_type>::value &&
+                 std::is_arithmetic<typename T::value_type>::value>
+serialize(const T &obj, cbor_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value &&
+                 !(is_binary_pod<typename T::value_type>::value &&
+                   std::is_arithmetic<typename T::value_type>::value)>
+serialize(const T &obj, cbor_writer *writer);
+
+template <typename T> std::string to_cbor(const T &obj);
+
+} // namespace seria
+
+#include <seria/serialize/cbor-inl.hpp>
@@ -0,0 +1,54 @@
+#pragma once
+#include <seria/csv.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+#include <vector>
+
+namespace seria {
+
+template <typename T>
+void write_csv(const std::vector<T> &rows, csv_writer *writer, bool header) {
+  static_assert(is_object<T>::value, "rows must be registered objects");
+  auto &columns = csv_columns<T>();
+
+  // a record of one empty field would be an empty line, which readers skip
+  auto end_record = [writer, &columns](size_t start) {
+    if (columns.size() == 1 && writer->size() == start) {
+      writer->write("\"\"", 2);
+    }
+    writer->put('\n');
+  };
+
+  if (header) {
+    auto start = writer->size();
+    for (size_t i = 0; i < columns.size(); i++) {
+      if (i != 0) {
+        writer->put(writer->delimiter());
+      }
+      writer->write_string(columns[i].name.data(), columns[i].name.size());
+    }
+    end_record(start);
+  }
+
+  for (auto &row : rows) {
+    auto *base = reinterpret_cast<const char *>(&row);
+    auto start = writer->size();
+    for (size_t i = 0; i < columns.size(); i++) {
+      if (i != 0) {
+        writer->put(writer->delimiter());
+      }
+      columns[i].format(base + columns[i].offset, writer);
+    }
+    end_record(start);
+  }
+}
+
+template <typename T>
+std::string to_csv(const std::vector<T> &rows, const csv_options &options) {
+  csv_writer writer(options.delimiter);
+  write_csv(rows, &writer, options.header);
+  return writer.str();
+}
+
+} // namespace seria
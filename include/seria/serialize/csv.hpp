@@ -0,0 +1,18 @@
+#pragma once
+#include <seria/csv.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+void write_csv(const std::vector<T> &rows, csv_writer *writer,
+               bool header = true);
+
+template <typename T>
+std::string to_csv(const std::vector<T> &rows,
+                   const csv_options &options = csv_options());
+
+} // namespace seria
+
+#include <seria/serialize/csv-inl.hpp>
@@ -1,5 +1,9 @@
 #pragma once
+#include <algorithm>
+#include <cstdlib>
 #include <mpack/mpack-writer.h>
+#include <seria/columnar.hpp>
+#include <seria/memo.hpp>
 #include <seria/object.hpp>
 #include <seria/type_traits.hpp>
 #include <string>
@@ -25,8 +29,7 @@ std::enable_if_t<is_string<T>::value> serialize(const T &obj,
 }
 
 template <typename T>
-std::enable_if_t<is_object<T>::value> serialize(const T &obj,
-                                                mpack_writer_t *writer) {
+void serialize_members(const T &obj, mpack_writer_t *writer) {
   auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
   constexpr size_t member_size =
       std::tuple_size<std::decay_t<decltype(members)>>::value;
@@ -44,6 +47,62 @@ std::enable_if_t<is_object<T>::value> serialize(const T &obj,
   mpack_finish_map(writer);
 }
 
+template <typename T>
+void serialize_object(const T &obj, mpack_writer_t *writer,
+                      std::false_type /*memoized*/) {
+  serialize_members(obj, writer);
+}
+
+// the cached bytes of the object are written as they are, on a miss they
+// are encoded on their own first
+template <typename T>
+void serialize_object(const T &obj, mpack_writer_t *writer,
+                      std::true_type /*memoized*/) {
+  auto *cache = active_memo_cache();
+  if (cache == nullptr) {
+    serialize_members(obj, writer);
+    return;
+  }
+
+  auto version = memo_version(obj);
+  auto cached = cache->find(obj, version, 'm');
+  if (cached == nullptr) {
+    // frees the buffer when a member throws
+    struct encoder_guard {
+      char *bytes = nullptr;
+      size_t size = 0;
+      mpack_writer_t encoder;
+      bool destroyed = false;
+      ~encoder_guard() {
+        if (!destroyed) {
+          mpack_writer_destroy(&encoder);
+        }
+        std::free(bytes);
+      }
+    } guard;
+
+    mpack_writer_init_growable(&guard.encoder, &guard.bytes, &guard.size);
+    serialize_members(obj, &guard.encoder);
+    guard.destroyed = true;
+    auto err = mpack_writer_destroy(&guard.encoder);
+    if (err != mpack_ok) {
+      mpack_writer_flag_error(writer, err);
+      return;
+    }
+    std::string data(guard.bytes, guard.size);
+    mpack_write_object_bytes(writer, data.data(), data.size());
+    cache->insert(obj, version, 'm', std::move(data));
+    return;
+  }
+  mpack_write_object_bytes(writer, cached->data(), cached->size());
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                mpack_writer_t *writer) {
+  serialize_object(obj, writer, is_memoized<T>{});
+}
+
 template <typename T>
 std::enable_if_t<is_array<T>::value> serialize(const T &obj,
                                                mpack_writer_t *writer) {
@@ -56,7 +115,7 @@ std::enable_if_t<is_array<T>::value> serialize(const T &obj,
 }
 
 template <typename T>
-std::enable_if_t<is_vector<T>::value &&
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value &&
                  !std::is_same<typename T::value_type, uint8_t>::value>
 serialize(const T &obj, mpack_writer_t *writer) {
   mpack_start_array(writer, obj.size());
@@ -74,4 +133,53 @@ serialize(const T &obj, mpack_writer_t *writer) {
                   obj.size());
 }
 
-} // namespace seria
\ No newline at end of file
+// arithmetic columns are written as `bin` holding the packed little-endian
+// values, other columns as arrays
+template <typename T, typename Object, typename M>
+void serialize_column(const std::vector<T> &rows, M Object::*ptr,
+                      mpack_writer_t *writer, std::true_type /*pod*/) {
+  constexpr size_t batch = sizeof(M) >= 4096 ? 1 : 4096 / sizeof(M);
+  char buffer[batch * sizeof(M)];
+
+  mpack_start_bin(writer, rows.size() * sizeof(M));
+  for (size_t i = 0; i < rows.size(); i += batch) {
+    auto count = std::min(batch, rows.size() - i);
+    gather_column(rows.data() + i, count, ptr, buffer);
+    mpack_write_bytes(writer, buffer, count * sizeof(M));
+  }
+  mpack_finish_bin(writer);
+}
+
+template <typename T, typename Object, typename M>
+void serialize_column(const std::vector<T> &rows, M Object::*ptr,
+                      mpack_writer_t *writer, std::false_type /*pod*/) {
+  mpack_start_array(writer, rows.size());
+  for (auto &row : rows) {
+    serialize(row.*ptr, writer);
+  }
+  mpack_finish_array(writer);
+}
+
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value>
+serialize(const T &obj, mpack_writer_t *writer) {
+  using Row = typename T::value_type;
+  auto &members =
+      KeyValueRecords<Row, decltype(register_object<Row>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  auto setter = [&obj, writer](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    mpack_write_str(writer, member.m_key, strlen(member.m_key));
+    serialize_column(obj, member.m_ptr, writer, is_binary_pod<Type>{});
+  };
+
+  mpack_start_map(writer, member_size);
+  for_each(setter, members, std::make_index_sequence<member_size>());
+  mpack_finish_map(writer);
+}
+
+} // namespace seria
@@ -31,10 +31,14 @@ std::enable_if_t<is_vector<T>::value &&
 serialize(const T &obj, mpack_writer_t *writer);
 
 template <typename T>
-std::enable_if_t<is_vector<T>::value &&
+std::enable_if_t<is_vector<T>::value && !is_columnar_vector<T>::value &&
                  !std::is_same<typename T::value_type, uint8_t>::value>
 serialize(const T &obj, mpack_writer_t *writer);
 
+template <typename T>
+std::enable_if_t<is_columnar_vector<T>::value>
+serialize(const T &obj, mpack_writer_t *writer);
+
 } // namespace seria
 
 #include <seria/serialize/mpack-inl.hpp>
\ No newline at end of file
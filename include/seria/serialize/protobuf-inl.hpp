@@ -0,0 +1,228 @@
+#pragma once
+#include <cstring>
+#include <iterator>
+#include <seria/object.hpp>
+#include <seria/protobuf.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding /*encoding*/) {
+  writer->write_varint(obj ? 1 : 0);
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding encoding) {
+  if (std::is_floating_point<T>::value) {
+    if (sizeof(T) == sizeof(float)) {
+      writer->write_le(static_cast<float>(obj));
+    } else {
+      writer->write_le(static_cast<double>(obj));
+    }
+  } else if (encoding == pb_fixed) {
+    if (sizeof(T) > sizeof(uint32_t)) {
+      writer->write_le(static_cast<uint64_t>(obj));
+    } else if (std::is_signed<T>::value) {
+      writer->write_le(static_cast<int32_t>(obj));
+    } else {
+      writer->write_le(static_cast<uint32_t>(obj));
+    }
+  } else if (!std::is_signed<T>::value) {
+    writer->write_varint(static_cast<uint64_t>(obj));
+  } else if (encoding == pb_sint) {
+    writer->write_varint(pb_zigzag(static_cast<int64_t>(obj)));
+  } else {
+    // negative values are sign extended to ten bytes
+    writer->write_varint(static_cast<uint64_t>(static_cast<int64_t>(obj)));
+  }
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding /*encoding*/) {
+  // protobuf enums are int32, negative values are sign extended
+  writer->write_varint(static_cast<uint64_t>(static_cast<int64_t>(obj)));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value || is_pb_bytes<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding /*encoding*/) {
+  writer->write_varint(obj.size());
+  writer->write(obj.data(), obj.size());
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding /*encoding*/) {
+  writer->write_varint(writer->next_size());
+  pb_write_message(obj, writer);
+}
+
+// size of the encoded value without its key, nested messages record their
+// size for the writing pass
+template <typename T>
+std::enable_if_t<is_pb_packable<T>::value, size_t>
+pb_value_size(const T &obj, pb_writer * /*writer*/, pb_encoding encoding) {
+  switch (pb_wire_of<T>(encoding)) {
+  case pb_fixed32:
+    return 4;
+  case pb_fixed64:
+    return 8;
+  default:
+    break;
+  }
+
+  if (std::is_unsigned<T>::value) {
+    return pb_varint_size(static_cast<uint64_t>(obj));
+  }
+
+  if (std::is_signed<T>::value && encoding == pb_sint) {
+    return pb_varint_size(pb_zigzag(static_cast<int64_t>(obj)));
+  }
+
+  // enums and `int32`/`int64`, negative values are sign extended
+  return pb_varint_size(static_cast<uint64_t>(static_cast<int64_t>(obj)));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value || is_pb_bytes<T>::value, size_t>
+pb_value_size(const T &obj, pb_writer * /*writer*/,
+              pb_encoding /*encoding*/) {
+  return pb_varint_size(obj.size()) + obj.size();
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value, size_t>
+pb_value_size(const T &obj, pb_writer *writer, pb_encoding /*encoding*/) {
+  auto slot = writer->push_size();
+  auto size = pb_message_size(obj, writer);
+  writer->set_size(slot, size);
+  return pb_varint_size(size) + size;
+}
+
+template <typename T>
+std::enable_if_t<!is_pb_repeated<T>::value, size_t>
+pb_field_size(uint32_t field, const T &obj, pb_writer *writer,
+              pb_encoding encoding) {
+  return pb_varint_size(pb_key(field, pb_wire_of<T>(encoding))) +
+         pb_value_size(obj, writer, encoding);
+}
+
+template <typename T>
+std::enable_if_t<is_pb_repeated<T>::value, size_t>
+pb_field_size(uint32_t field, const T &obj, pb_writer *writer,
+              pb_encoding encoding) {
+  using Element = element_type_t<T>;
+  static_assert(!is_pb_repeated<Element>::value,
+                "nested repeated fields can not be encoded as protobuf");
+
+  if (std::begin(obj) == std::end(obj)) {
+    return 0;
+  }
+
+  if (is_pb_packable<Element>::value) {
+    auto slot = writer->push_size();
+    size_t size = 0;
+    for (const auto &value : obj) {
+      size += pb_value_size(value, writer, encoding);
+    }
+    writer->set_size(slot, size);
+    return pb_varint_size(pb_key(field, pb_length)) + pb_varint_size(size) +
+           size;
+  }
+
+  auto key_size =
+      pb_varint_size(pb_key(field, pb_wire_of<Element>(encoding)));
+  size_t size = 0;
+  for (const auto &value : obj) {
+    size += key_size + pb_value_size(value, writer, encoding);
+  }
+  return size;
+}
+
+template <typename T>
+std::enable_if_t<!is_pb_repeated<T>::value>
+pb_write_field(uint32_t field, const T &obj, pb_writer *writer,
+               pb_encoding encoding) {
+  writer->write_varint(pb_key(field, pb_wire_of<T>(encoding)));
+  pb_write_value(obj, writer, encoding);
+}
+
+template <typename T>
+std::enable_if_t<is_pb_repeated<T>::value>
+pb_write_field(uint32_t field, const T &obj, pb_writer *writer,
+               pb_encoding encoding) {
+  using Element = element_type_t<T>;
+
+  if (std::begin(obj) == std::end(obj)) {
+    return;
+  }
+
+  if (is_pb_packable<Element>::value) {
+    writer->write_varint(pb_key(field, pb_length));
+    writer->write_varint(writer->next_size());
+    for (const auto &value : obj) {
+      pb_write_value(value, writer, encoding);
+    }
+    return;
+  }
+
+  for (const auto &value : obj) {
+    writer->write_varint(pb_key(field, pb_wire_of<Element>(encoding)));
+    pb_write_value<Element>(value, writer, encoding);
+  }
+}
+
+template <typename T>
+size_t pb_message_size(const T &obj, pb_writer *writer) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  size_t size = 0;
+  size_t index = 0;
+  auto measurer = [&obj, writer, &size, &index](auto &member) {
+    size += pb_field_size(pb_field_number(member, index++),
+                          obj.*(member.m_ptr), writer, member.m_encoding);
+  };
+
+  for_each(measurer, members, std::make_index_sequence<member_size>());
+  return size;
+}
+
+template <typename T> void pb_write_message(const T &obj, pb_writer *writer) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  size_t index = 0;
+  auto setter = [&obj, writer, &index](auto &member) {
+    pb_write_field(pb_field_number(member, index++), obj.*(member.m_ptr),
+                   writer, member.m_encoding);
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                pb_writer *writer) {
+  writer->reset_sizes();
+  pb_message_size(obj, writer);
+  pb_write_message(obj, writer);
+  writer->reset_sizes();
+}
+
+template <typename T> std::string to_protobuf(const T &obj) {
+  pb_writer writer;
+  serialize(obj, &writer);
+  return writer.str();
+}
+
+} // namespace seria
@@ -0,0 +1,73 @@
+#pragma once
+#include <seria/object.hpp>
+#include <seria/protobuf.hpp>
+#include <seria/type_traits.hpp>
+
+namespace seria {
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value || is_pb_bytes<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+pb_write_value(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_pb_packable<T>::value, size_t>
+pb_value_size(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_string<T>::value || is_pb_bytes<T>::value, size_t>
+pb_value_size(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value, size_t>
+pb_value_size(const T &obj, pb_writer *writer, pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<!is_pb_repeated<T>::value, size_t>
+pb_field_size(uint32_t field, const T &obj, pb_writer *writer,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_pb_repeated<T>::value, size_t>
+pb_field_size(uint32_t field, const T &obj, pb_writer *writer,
+              pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<!is_pb_repeated<T>::value>
+pb_write_field(uint32_t field, const T &obj, pb_writer *writer,
+               pb_encoding encoding);
+
+template <typename T>
+std::enable_if_t<is_pb_repeated<T>::value>
+pb_write_field(uint32_t field, const T &obj, pb_writer *writer,
+               pb_encoding encoding);
+
+template <typename T>
+size_t pb_message_size(const T &obj, pb_writer *writer);
+
+template <typename T> void pb_write_message(const T &obj, pb_writer *writer);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value> serialize(const T &obj,
+                                                pb_writer *writer);
+
+template <typename T> std::string to_protobuf(const T &obj);
+
+} // namespace seria
+
+#include <seria/serialize/protobuf-inl.hpp>
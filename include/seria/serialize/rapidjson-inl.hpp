@@ -1,12 +1,20 @@
 #pragma once
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <seria/memo.hpp>
 #include <seria/object.hpp>
 #include <seria/type_traits.hpp>
 #ifdef SERIA_USE_EXTERNAL_RAPIDJSON
 #include <rapidjson/document.h>
+#include <rapidjson/internal/dtoa.h>
+#include <rapidjson/internal/itoa.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #else
 #include <seria/rapidjson/document.h>
+#include <seria/rapidjson/internal/dtoa.h>
+#include <seria/rapidjson/internal/itoa.h>
 #include <seria/rapidjson/stringbuffer.h>
 #include <seria/rapidjson/writer.h>
 #endif
@@ -82,7 +90,340 @@ serialize(const T &obj) {
   return document;
 }
 
-template <typename T> std::string to_string(const T &obj) {
+// Values whose text has a bounded length: the numbers and booleans a
+// `rapidjson::Document` holds and fixed size arrays of them. `bound` is the
+// most bytes written for one value.
+template <typename T, typename _ = void>
+struct json_fixed : std::false_type {};
+template <> struct json_fixed<bool> : std::true_type {
+  constexpr static size_t bound = 5;
+};
+template <> struct json_fixed<int32_t> : std::true_type {
+  constexpr static size_t bound = 11;
+};
+template <> struct json_fixed<uint32_t> : std::true_type {
+  constexpr static size_t bound = 10;
+};
+template <> struct json_fixed<int64_t> : std::true_type {
+  constexpr static size_t bound = 20;
+};
+template <> struct json_fixed<uint64_t> : std::true_type {
+  constexpr static size_t bound = 20;
+};
+// as reserved by `rapidjson::Writer::WriteDouble`
+template <> struct json_fixed<float> : std::true_type {
+  constexpr static size_t bound = 25;
+};
+template <> struct json_fixed<double> : std::true_type {
+  constexpr static size_t bound = 25;
+};
+
+template <typename T>
+struct json_fixed<T, std::enable_if_t<is_array<T>::value &&
+                                      json_fixed<element_type_t<T>>::value>>
+    : std::true_type {
+  constexpr static size_t bound =
+      2 + is_array<T>::size * (json_fixed<element_type_t<T>>::bound + 1);
+};
+
+constexpr bool all_of(std::initializer_list<bool> values) {
+  for (auto value : values) {
+    if (!value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr size_t sum_of(std::initializer_list<size_t> values) {
+  size_t sum = 0;
+  for (auto value : values) {
+    sum += value;
+  }
+  return sum;
+}
+
+template <typename Members> struct json_fixed_members : std::false_type {};
+
+template <typename... M>
+struct json_fixed_members<std::tuple<M...>>
+    : std::integral_constant<bool, sizeof...(M) != 0 &&
+                                       all_of({json_fixed<
+                                           typename M::Type>::value...})> {};
+
+// the most bytes the values of fixed length members take
+template <typename Members> struct json_fixed_bound;
+
+template <typename... M> struct json_fixed_bound<std::tuple<M...>> {
+  constexpr static size_t value =
+      sum_of({json_fixed<typename M::Type>::bound...});
+};
+
+// Specialize for a registered object with only fixed length members to
+// have `to_string` splice its values into a constant skeleton, see
+// `json_template`. A `serialize` specialization of the object is not used
+// by `to_string` then.
+//
+//   template <> struct is_json_template<Sample> : std::true_type {};
+template <typename T> struct is_json_template : std::false_type {};
+
+inline char *write_json_value(bool value, char *cursor) {
+  std::memcpy(cursor, value ? "true" : "false", 5);
+  return cursor + (value ? 4 : 5);
+}
+
+inline char *write_json_value(int32_t value, char *cursor) {
+  return rapidjson::internal::i32toa(value, cursor);
+}
+
+inline char *write_json_value(uint32_t value, char *cursor) {
+  return rapidjson::internal::u32toa(value, cursor);
+}
+
+inline char *write_json_value(int64_t value, char *cursor) {
+  return rapidjson::internal::i64toa(value, cursor);
+}
+
+inline char *write_json_value(uint64_t value, char *cursor) {
+  return rapidjson::internal::u64toa(value, cursor);
+}
+
+// `finite` is cleared for NaN and infinity, which the writer rejects
+inline char *write_json_value(double value, char *cursor, bool &finite) {
+  finite = finite && std::isfinite(value);
+  return rapidjson::internal::dtoa(
+      value, cursor,
+      rapidjson::Writer<rapidjson::StringBuffer>::kDefaultMaxDecimalPlaces);
+}
+
+template <typename T>
+std::enable_if_t<!std::is_floating_point<T>::value && !is_array<T>::value,
+                 char *>
+write_json_value(const T &value, char *cursor, bool & /*finite*/) {
+  return write_json_value(value, cursor);
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value, char *>
+write_json_value(const T &value, char *cursor, bool &finite) {
+  *cursor++ = '[';
+  bool first = true;
+  for (auto &element : value) {
+    if (!first) {
+      *cursor++ = ',';
+    }
+    first = false;
+    cursor = write_json_value(element, cursor, finite);
+  }
+  *cursor++ = ']';
+  return cursor;
+}
+
+// The constant text of a fixed shape object: `{"age":`, `,"value":`, ...
+// and the closing `}`, with the keys escaped once by the writer. Fragment
+// `i` is `text[offsets[i], offsets[i + 1])`.
+template <typename T> struct json_template {
+  using Members = decltype(register_object<T>());
+  static_assert(json_fixed_members<Members>::value,
+                "is_json_template needs members that are all numbers, "
+                "booleans or fixed size arrays of them");
+  constexpr static size_t member_size = std::tuple_size<Members>::value;
+  constexpr static size_t value_bound = json_fixed_bound<Members>::value;
+
+  std::string text;
+  std::array<uint32_t, member_size + 2> offsets{};
+
+  static const json_template &get() {
+    static const json_template instance;
+    return instance;
+  }
+
+private:
+  json_template() {
+    auto &members = KeyValueRecords<T, Members>::members;
+    size_t index = 0;
+    auto builder = [&](auto &member) {
+      rapidjson::StringBuffer buffer;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      writer.String(member.m_key,
+                    static_cast<rapidjson::SizeType>(member.m_key_length));
+      text += index == 0 ? '{' : ',';
+      text.append(buffer.GetString(), buffer.GetSize());
+      text += ':';
+      offsets[++index] = static_cast<uint32_t>(text.size());
+    };
+
+    for_each(builder, members, std::make_index_sequence<member_size>());
+    text += '}';
+    offsets[member_size + 1] = static_cast<uint32_t>(text.size());
+  }
+};
+
+// `rapidjson::Writer` into a string buffer which copies raw values at once
+// instead of transcoding them a character at a time
+class json_string_writer
+    : public rapidjson::Writer<rapidjson::StringBuffer> {
+public:
+  explicit json_string_writer(rapidjson::StringBuffer &buffer)
+      : rapidjson::Writer<rapidjson::StringBuffer>(buffer) {}
+
+  bool RawValue(const char *json, size_t length, rapidjson::Type type) {
+    Prefix(type);
+    std::memcpy(os_->Push(length), json, length);
+    return EndValue(true);
+  }
+};
+
+// Memoized objects and the objects, vectors and arrays holding them, which
+// `write_json` walks so the cached text can be inserted. Other values are
+// written through their `serialize`, which may be specialized. Objects
+// nested deeper than `Depth` are not searched, so recursive types end.
+template <typename T, size_t Depth = 8, typename _ = void>
+struct is_json_walked : std::false_type {};
+
+template <bool... Values> struct any_true : std::false_type {};
+
+template <bool... Values>
+struct any_true<true, Values...> : std::true_type {};
+
+template <bool... Values>
+struct any_true<false, Values...> : any_true<Values...> {};
+
+template <size_t Depth, typename Members> struct has_json_walked_member;
+
+template <size_t Depth, typename... M>
+struct has_json_walked_member<Depth, std::tuple<M...>>
+    : any_true<is_json_walked<typename M::Type, Depth - 1>::value...> {};
+
+template <typename T, size_t Depth>
+struct is_json_walked<
+    T, Depth,
+    std::enable_if_t<(Depth > 0) &&
+                     (is_vector<T>::value || is_array<T>::value)>>
+    : is_json_walked<element_type_t<T>, Depth - 1> {};
+
+template <typename T, size_t Depth>
+struct is_json_walked<
+    T, Depth,
+    std::enable_if_t<(Depth > 0) && is_object<T>::value &&
+                     std::tuple_size<decltype(register_object<T>())>::value !=
+                         0>>
+    : std::integral_constant<
+          bool, is_memoized<T>::value ||
+                    has_json_walked_member<
+                        Depth, decltype(register_object<T>())>::value> {};
+
+template <typename T, typename Writer>
+std::enable_if_t<(is_vector<T>::value || is_array<T>::value) &&
+                     is_json_walked<T>::value,
+                 bool>
+write_json(const T &obj, Writer &writer);
+
+template <typename T, typename Writer>
+std::enable_if_t<is_json_walked<T>::value && is_object<T>::value, bool>
+write_json(const T &obj, Writer &writer);
+
+template <typename T, typename Writer>
+std::enable_if_t<std::is_arithmetic<T>::value, bool>
+write_json(const T &obj, Writer &writer) {
+  rapidjson::Value value;
+  value.Set(obj);
+  return value.Accept(writer);
+}
+
+template <typename T, typename Writer>
+std::enable_if_t<is_string<T>::value, bool> write_json(const T &obj,
+                                                       Writer &writer) {
+  return writer.String(obj.data(),
+                       static_cast<rapidjson::SizeType>(obj.size()));
+}
+
+template <typename T, typename Writer>
+std::enable_if_t<!std::is_arithmetic<T>::value && !is_string<T>::value &&
+                     !is_json_walked<T>::value,
+                 bool>
+write_json(const T &obj, Writer &writer) {
+  return serialize(obj).Accept(writer);
+}
+
+template <typename T, typename Writer>
+std::enable_if_t<(is_vector<T>::value || is_array<T>::value) &&
+                     is_json_walked<T>::value,
+                 bool>
+write_json(const T &obj, Writer &writer) {
+  if (!writer.StartArray()) {
+    return false;
+  }
+  rapidjson::SizeType size = 0;
+  for (auto &value : obj) {
+    if (!write_json<std::decay_t<decltype(value)>>(value, writer)) {
+      return false;
+    }
+    size++;
+  }
+  return writer.EndArray(size);
+}
+
+template <typename T, typename Writer>
+bool write_json_members(const T &obj, Writer &writer) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  bool ok = writer.StartObject();
+  auto setter = [&obj, &writer, &ok](auto &member) {
+    ok = ok &&
+         writer.Key(member.m_key,
+                    static_cast<rapidjson::SizeType>(member.m_key_length)) &&
+         write_json(obj.*(member.m_ptr), writer);
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+  return ok &&
+         writer.EndObject(static_cast<rapidjson::SizeType>(member_size));
+}
+
+template <typename T, typename Writer>
+bool write_json_object(const T &obj, Writer &writer,
+                       std::false_type /*memoized*/) {
+  return write_json_members(obj, writer);
+}
+
+// the cached text of the object is inserted as a raw value, on a miss it is
+// written on its own first
+template <typename T, typename Writer>
+bool write_json_object(const T &obj, Writer &writer,
+                       std::true_type /*memoized*/) {
+  auto *cache = active_memo_cache();
+  if (cache == nullptr) {
+    return write_json_members(obj, writer);
+  }
+
+  auto version = memo_version(obj);
+  auto cached = cache->find(obj, version, 'j');
+  if (cached == nullptr) {
+    rapidjson::StringBuffer buffer;
+    json_string_writer encoder(buffer);
+    if (!write_json_members(obj, encoder)) {
+      return false;
+    }
+    std::string text(buffer.GetString(), buffer.GetSize());
+    auto written =
+        writer.RawValue(text.data(), text.size(), rapidjson::kObjectType);
+    cache->insert(obj, version, 'j', std::move(text));
+    return written;
+  }
+  return writer.RawValue(cached->data(), cached->size(),
+                         rapidjson::kObjectType);
+}
+
+template <typename T, typename Writer>
+std::enable_if_t<is_json_walked<T>::value && is_object<T>::value, bool>
+write_json(const T &obj, Writer &writer) {
+  return write_json_object(obj, writer, is_memoized<T>{});
+}
+
+template <typename T> std::string to_string_document(const T &obj) {
   auto serialized = seria::serialize(obj);
   rapidjson::StringBuffer buffer;
   buffer.Clear();
@@ -91,4 +432,62 @@ template <typename T> std::string to_string(const T &obj) {
   return std::string(buffer.GetString());
 }
 
+// values holding memoized objects are written straight to the writer, the
+// same text as `to_string_document`
+template <typename T>
+std::string to_string_walked(const T &obj, std::true_type /*walked*/) {
+  rapidjson::StringBuffer buffer;
+  json_string_writer writer(buffer);
+  write_json(obj, writer);
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+template <typename T>
+std::string to_string_walked(const T &obj, std::false_type /*walked*/) {
+  return to_string_document(obj);
+}
+
+template <typename T>
+std::string to_string(const T &obj, std::false_type /*template*/) {
+  return to_string_walked(obj, is_json_walked<T>{});
+}
+
+template <typename T>
+std::string to_string(const T &obj, std::true_type /*template*/) {
+  auto &json = json_template<T>::get();
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+
+  std::string result(json.text.size() + json_template<T>::value_bound, '\0');
+  auto *begin = &result[0];
+  auto *cursor = begin;
+  const auto *text = json.text.data();
+  const auto *offsets = json.offsets.data();
+  bool finite = true;
+
+  auto writer = [&](auto &member) {
+    std::memcpy(cursor, text + offsets[0], offsets[1] - offsets[0]);
+    cursor += offsets[1] - offsets[0];
+    cursor = write_json_value(obj.*(member.m_ptr), cursor, finite);
+    offsets++;
+  };
+
+  for_each(writer, members,
+           std::make_index_sequence<json_template<T>::member_size>());
+  std::memcpy(cursor, text + offsets[0], offsets[1] - offsets[0]);
+  cursor += offsets[1] - offsets[0];
+
+  if (!finite) {
+    return to_string_document(obj);
+  }
+
+  result.resize(static_cast<size_t>(cursor - begin));
+  return result;
+}
+
+template <typename T> std::string to_string(const T &obj) {
+  return to_string(
+      obj, std::integral_constant<bool, is_json_template<T>::value &&
+                                            !is_memoized<T>::value>{});
+}
+
 } // namespace seria
\ No newline at end of file
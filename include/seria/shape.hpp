@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace seria {
+
+// The position each registered member of an object was found at the last
+// time one was decoded on this thread, starting from the registration
+// order. Producers almost always write members in the same order, so the
+// key at the remembered position is compared first and the search is only
+// needed when the order changes.
+template <size_t Size> struct object_shape {
+  uint32_t positions[Size];
+
+  constexpr object_shape() : positions() {
+    for (size_t i = 0; i < Size; i++) {
+      positions[i] = static_cast<uint32_t>(i);
+    }
+  }
+};
+
+template <typename T, size_t Size> object_shape<Size> &shape_of() {
+  static thread_local object_shape<Size> shape;
+  return shape;
+}
+
+// Index of `key` among the `count` keys of an object, `count` when missing.
+// `key_at(i, &length)` returns the i-th key or nullptr when it is not a
+// string, `guess` is tried before the others.
+template <typename KeyAt>
+size_t find_key(const char *key, size_t length, size_t count, uint32_t guess,
+                KeyAt &&key_at) {
+  auto matches = [&](size_t index) {
+    size_t size = 0;
+    auto *name = key_at(index, &size);
+    return name != nullptr && size == length &&
+           std::memcmp(name, key, length) == 0;
+  };
+
+  if (guess < count && matches(guess)) {
+    return guess;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (i != guess && matches(i)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+} // namespace seria
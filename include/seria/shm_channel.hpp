@@ -0,0 +1,356 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <seria/binary.hpp>
+#include <seria/deserialize/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/serialize/binary.hpp>
+#include <seria/view.hpp>
+#include <string>
+#include <thread>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SERIA_HAS_SHM_CHANNEL
+#endif
+
+#ifdef SERIA_HAS_SHM_CHANNEL
+namespace seria {
+
+// Messages in the native binary format, see `to_binary`, without its header:
+// the schema fingerprint is checked once for the channel.
+struct shm_binary_codec {
+  constexpr static char id = 'b';
+
+  template <typename T>
+  static size_t encode(const T &value, char *slot, size_t capacity) {
+    binary_writer writer(slot, capacity);
+    serialize(value, &writer);
+    return writer.size();
+  }
+
+  template <typename T>
+  static void decode(T &value, const char *data, size_t size) {
+    binary_reader reader(data, size);
+    deserialize(value, &reader);
+    if (reader.remaining() != 0) {
+      throw error("unexpected trailing data");
+    }
+  }
+};
+
+// Zero-copy buffers, see `to_zero_copy`: the consumer reads the message
+// where it is in the ring with `make_view` in `try_consume`.
+struct shm_view_codec {
+  constexpr static char id = 'v';
+
+  template <typename T>
+  static size_t encode(const T &value, char *slot, size_t capacity) {
+    binary_writer writer(slot, capacity);
+    serialize_view(value, &writer);
+    return writer.size();
+  }
+};
+
+// Layout of the mapping: this header, then the ring of `capacity` bytes.
+// The positions only grow, the producer and the consumer each write one and
+// keep it on its own cache line.
+struct shm_ring_header {
+  char magic[4];
+  uint32_t version;
+  uint64_t capacity;
+  uint64_t max_message;
+  uint64_t fingerprint;
+  char codec;
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared memory channels need lock-free 64-bit atomics");
+
+constexpr char shm_magic[4] = {'S', 'R', 'S', 'H'};
+constexpr uint32_t shm_version = 1;
+constexpr size_t shm_ring_offset = (sizeof(shm_ring_header) + 63) / 64 * 64;
+
+// Single-producer, single-consumer channel of `T` messages between two
+// processes through a shared memory mapping, without locks or system calls.
+// The producer encodes each message with `Codec` straight into the ring and
+// the consumer decodes it, or reads it through a view, where it is.
+//
+// Records are an 8-byte length and the message, aligned to 8 bytes, and are
+// never split at the end of the ring: the producer needs `max_message`
+// contiguous bytes to encode into and skips to the start when they are not
+// left before the end.
+//
+//   // producer
+//   auto channel = seria::shm_channel<Test>::create("/test", 1 << 20, 4096);
+//   channel.send(data);
+//   // consumer, in another process
+//   auto channel = seria::shm_channel<Test>::open("/test");
+//   channel.receive(data);
+template <typename T, typename Codec = shm_binary_codec> class shm_channel {
+public:
+  // Creates the named shared memory object, which is removed with `unlink`
+  // once both ends have opened it. `capacity` is rounded up to a power of
+  // two at least twice the largest record.
+  static shm_channel create(const char *name, size_t capacity,
+                            size_t max_message) {
+    auto fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      fail("shm_open");
+    }
+    try {
+      return initialize(fd, capacity, max_message);
+    } catch (...) {
+      ::shm_unlink(name);
+      throw;
+    }
+  }
+
+  static shm_channel open(const char *name) {
+    auto fd = ::shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+      fail("shm_open");
+    }
+    return attach(fd);
+  }
+
+#ifdef __linux__
+  // A channel without a name, its file descriptor is inherited by forked
+  // processes or sent over a UNIX socket and passed to `attach`.
+  static shm_channel create_anonymous(size_t capacity, size_t max_message) {
+    auto fd = ::memfd_create("seria-shm-channel", MFD_CLOEXEC);
+    if (fd < 0) {
+      fail("memfd_create");
+    }
+    return initialize(fd, capacity, max_message);
+  }
+#endif
+
+  // maps the channel created on `fd`, taking ownership of it
+  static shm_channel attach(int fd) {
+    shm_channel channel;
+    channel.m_fd = fd;
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      fail("fstat");
+    }
+    auto size = static_cast<size_t>(info.st_size);
+    if (size < shm_ring_offset) {
+      throw error("not a seria shared memory channel");
+    }
+    channel.map(size);
+
+    auto *header = channel.m_header;
+    if (std::memcmp(header->magic, shm_magic, sizeof(shm_magic)) != 0 ||
+        header->codec != Codec::id ||
+        size != shm_ring_offset + header->capacity) {
+      throw error("not a seria shared memory channel");
+    }
+    if (header->version != shm_version) {
+      throw error("unsupported shared memory channel version");
+    }
+    if (header->fingerprint != schema_fingerprint<T>()) {
+      throw error("schema fingerprint mismatch");
+    }
+    channel.m_head = header->head.load(std::memory_order_acquire);
+    channel.m_tail = header->tail.load(std::memory_order_acquire);
+    channel.m_seen_head = channel.m_head;
+    channel.m_seen_tail = channel.m_tail;
+    return channel;
+  }
+
+  static void unlink(const char *name) { ::shm_unlink(name); }
+
+  shm_channel(shm_channel &&other) noexcept { *this = std::move(other); }
+
+  shm_channel &operator=(shm_channel &&other) noexcept {
+    std::swap(m_fd, other.m_fd);
+    std::swap(m_header, other.m_header);
+    std::swap(m_ring, other.m_ring);
+    std::swap(m_size, other.m_size);
+    m_head = other.m_head;
+    m_tail = other.m_tail;
+    m_seen_head = other.m_seen_head;
+    m_seen_tail = other.m_seen_tail;
+    return *this;
+  }
+
+  shm_channel(const shm_channel &) = delete;
+  shm_channel &operator=(const shm_channel &) = delete;
+
+  ~shm_channel() {
+    if (m_header != nullptr) {
+      ::munmap(m_header, m_size);
+    }
+    if (m_fd >= 0) {
+      ::close(m_fd);
+    }
+  }
+
+  int fd() const noexcept { return m_fd; }
+
+  size_t max_message() const noexcept { return m_header->max_message; }
+
+  // Encodes `value` into the ring, false when the consumer has not made room
+  // for it yet. Throws `seria::error` when it does not fit in `max_message`
+  // bytes, nothing is sent then.
+  bool try_send(const T &value) {
+    auto capacity = m_header->capacity;
+    auto max_message = m_header->max_message;
+    auto offset = m_head & (capacity - 1);
+    auto skipped = capacity - offset < record_size(max_message)
+                       ? capacity - offset
+                       : 0;
+    auto needed = skipped + record_size(max_message);
+    if (capacity - (m_head - m_seen_tail) < needed) {
+      m_seen_tail = m_header->tail.load(std::memory_order_acquire);
+      if (capacity - (m_head - m_seen_tail) < needed) {
+        return false;
+      }
+    }
+
+    auto start = skipped != 0 ? 0 : offset;
+    auto size = Codec::encode(value, m_ring + start + 8, max_message);
+
+    if (skipped != 0) {
+      store_length(offset, wrap);
+    }
+    store_length(start, size);
+    m_head += skipped + record_size(size);
+    m_header->head.store(m_head, std::memory_order_release);
+    return true;
+  }
+
+  // waits for room in the ring
+  void send(const T &value) {
+    while (!try_send(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+  // Calls `fn(data, size)` with the next message where it is in the ring,
+  // false when there is none. The message is released after `fn` returns or
+  // throws.
+  template <typename F> bool try_consume(F &&fn) {
+    if (m_tail == m_seen_head) {
+      m_seen_head = m_header->head.load(std::memory_order_acquire);
+      if (m_tail == m_seen_head) {
+        return false;
+      }
+    }
+
+    auto capacity = m_header->capacity;
+    auto offset = m_tail & (capacity - 1);
+    auto size = load_length(offset);
+    if (size == wrap) {
+      m_tail += capacity - offset;
+      offset = 0;
+      size = load_length(0);
+    }
+
+    struct release_guard {
+      shm_channel *channel;
+      uint64_t tail;
+      ~release_guard() {
+        channel->m_tail = tail;
+        channel->m_header->tail.store(tail, std::memory_order_release);
+      }
+    } guard{this, m_tail + record_size(size)};
+    fn(static_cast<const char *>(m_ring + offset + 8),
+       static_cast<size_t>(size));
+    return true;
+  }
+
+  // decodes the next message into `value`, false when there is none
+  bool try_receive(T &value) {
+    return try_consume([&](const char *data, size_t size) {
+      Codec::decode(value, data, size);
+    });
+  }
+
+  // waits for the next message
+  void receive(T &value) {
+    while (!try_receive(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  constexpr static uint64_t wrap = ~uint64_t(0);
+
+  shm_channel() = default;
+
+  [[noreturn]] static void fail(const char *call) {
+    throw error(std::string(call) + " failed: " + std::strerror(errno));
+  }
+
+  static uint64_t record_size(uint64_t size) { return (8 + size + 7) / 8 * 8; }
+
+  static shm_channel initialize(int fd, size_t capacity, size_t max_message) {
+    shm_channel channel;
+    channel.m_fd = fd;
+
+    size_t ring = 64;
+    while (ring < capacity || ring < 2 * record_size(max_message)) {
+      ring *= 2;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(shm_ring_offset + ring)) != 0) {
+      fail("ftruncate");
+    }
+    channel.map(shm_ring_offset + ring);
+
+    auto *header = new (channel.m_header) shm_ring_header();
+    std::memcpy(header->magic, shm_magic, sizeof(shm_magic));
+    header->version = shm_version;
+    header->capacity = ring;
+    header->max_message = max_message;
+    header->fingerprint = schema_fingerprint<T>();
+    header->codec = Codec::id;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_release);
+    return channel;
+  }
+
+  void map(size_t size) {
+    auto *address =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (address == MAP_FAILED) {
+      fail("mmap");
+    }
+    m_header = static_cast<shm_ring_header *>(address);
+    m_ring = static_cast<char *>(address) + shm_ring_offset;
+    m_size = size;
+  }
+
+  void store_length(uint64_t offset, uint64_t length) {
+    std::memcpy(m_ring + offset, &length, sizeof(length));
+  }
+
+  uint64_t load_length(uint64_t offset) const {
+    uint64_t length;
+    std::memcpy(&length, m_ring + offset, sizeof(length));
+    return length;
+  }
+
+  int m_fd = -1;
+  shm_ring_header *m_header = nullptr;
+  char *m_ring = nullptr;
+  size_t m_size = 0;
+  // the position written by this end and the last one seen of the other
+  uint64_t m_head = 0;
+  uint64_t m_tail = 0;
+  uint64_t m_seen_head = 0;
+  uint64_t m_seen_tail = 0;
+};
+
+} // namespace seria
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#include <mpack/mpack-node.h>
+#include <mpack/mpack-writer.h>
+#include <seria/deserialize/mpack.hpp>
+#include <seria/exception.hpp>
+#include <seria/serialize/mpack.hpp>
+#include <seria/shm_channel.hpp>
+#include <string>
+
+#ifdef SERIA_HAS_SHM_CHANNEL
+namespace seria {
+
+// Msgpack messages for `shm_channel`, decoded from the ring with a node tree.
+struct shm_mpack_codec {
+  constexpr static char id = 'm';
+
+  template <typename T>
+  static size_t encode(const T &value, char *slot, size_t capacity) {
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, slot, capacity);
+    serialize(value, &writer);
+    auto used = mpack_writer_buffer_used(&writer);
+    auto err = mpack_writer_destroy(&writer);
+    if (err != mpack_ok) {
+      throw error(std::string("msgpack writer error: ") +
+                  mpack_error_to_string(err));
+    }
+    return used;
+  }
+
+  template <typename T>
+  static void decode(T &value, const char *data, size_t size) {
+    struct tree_guard {
+      mpack_tree_t tree;
+      ~tree_guard() { mpack_tree_destroy(&tree); }
+    } guard;
+
+    mpack_tree_init_data(&guard.tree, data, size);
+    mpack_tree_parse(&guard.tree);
+    if (mpack_tree_error(&guard.tree) != mpack_ok) {
+      throw error(std::string("msgpack reader error: ") +
+                  mpack_error_to_string(mpack_tree_error(&guard.tree)));
+    }
+    deserialize(value, mpack_tree_root(&guard.tree));
+  }
+};
+
+} // namespace seria
+#endif
@@ -0,0 +1,248 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/deserialize/binary.hpp>
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/exception.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/hash.hpp>
+#include <seria/mapped_file.hpp>
+#include <seria/serialize/binary.hpp>
+#include <string>
+
+#ifdef SERIA_HAS_MAPPED_FILE
+namespace seria {
+
+constexpr char snapshot_magic[4] = {'S', 'R', 'S', 'N'};
+constexpr uint32_t snapshot_version = 1;
+// magic, version, then the fingerprint, the size, modification time and
+// hash of the json file and the hash of the payload
+constexpr size_t snapshot_header_size = 8 + 5 * 8;
+
+struct snapshot_options {
+  // whether the json file is read and hashed to check the snapshot, or only
+  // its size and modification time are compared
+  bool hash_content = true;
+  // threads decoding the json file when the snapshot is not used, see
+  // `from_string`
+  unsigned threads = 1;
+};
+
+struct snapshot_result {
+  // whether the value was decoded from the snapshot
+  bool from_snapshot = false;
+  // whether the snapshot was written after decoding the json file
+  bool written = false;
+  // why the snapshot was not used, empty when it was
+  std::string reason;
+  // why the snapshot could not be written, empty when it was
+  std::string write_error;
+};
+
+// the json file the snapshot was made from
+struct snapshot_source {
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  uint64_t hash = 0;
+};
+
+inline uint64_t snapshot_hash(const char *data, size_t size) {
+  hash_builder builder;
+  builder.add(data, size);
+  return builder.value();
+}
+
+// `code` is the errno of `call`, saved before any clean up
+[[noreturn]] inline void snapshot_fail(const char *call,
+                                       const std::string &path,
+                                       int code = errno) {
+  throw error(std::string(call) + " " + path +
+              " failed: " + std::strerror(code));
+}
+
+// size and modification time in nanoseconds of `path`
+inline snapshot_source snapshot_stat(const std::string &path) {
+  struct stat status;
+  if (::stat(path.c_str(), &status) != 0) {
+    snapshot_fail("stat", path);
+  }
+  snapshot_source source;
+  source.size = static_cast<uint64_t>(status.st_size);
+#ifdef __APPLE__
+  auto &time = status.st_mtimespec;
+#else
+  auto &time = status.st_mtim;
+#endif
+  source.mtime = static_cast<int64_t>(time.tv_sec) * 1000000000 +
+                 static_cast<int64_t>(time.tv_nsec);
+  return source;
+}
+
+// The snapshot of `json_path` as a `T` in `cache_dir`: the name of the
+// json file and a hash of its path and of the schema, so that files with
+// the same name elsewhere or read as other types have their own.
+template <typename T>
+std::string snapshot_path(const std::string &json_path,
+                          const std::string &cache_dir) {
+  hash_builder builder;
+  builder.add(json_path.data(), json_path.size());
+  builder.add_value(schema_fingerprint<T>());
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), ".%016llx.snapshot",
+                static_cast<unsigned long long>(builder.value()));
+  auto slash = json_path.find_last_of('/');
+  auto name = slash == std::string::npos ? json_path
+                                         : json_path.substr(slash + 1);
+  return cache_dir + "/" + name + suffix;
+}
+
+// Decodes the snapshot in `file` made from `source`, whose hash is only
+// compared when `hashed`. Throws `seria::error` with what does not match.
+template <typename T>
+void read_snapshot(T &data, const mapped_file &file,
+                   const snapshot_source &source, bool hashed) {
+  binary_reader reader(file.data(), file.size());
+  if (file.size() < snapshot_header_size ||
+      std::memcmp(reader.read(sizeof(snapshot_magic)), snapshot_magic,
+                  sizeof(snapshot_magic)) != 0) {
+    throw error("not a seria snapshot");
+  }
+  if (reader.read_le<uint32_t>() != snapshot_version) {
+    throw error("unsupported snapshot version");
+  }
+  if (reader.read_le<uint64_t>() != schema_fingerprint<T>()) {
+    throw error("schema fingerprint mismatch");
+  }
+  if (reader.read_le<uint64_t>() != source.size ||
+      reader.read_le<int64_t>() != source.mtime) {
+    throw error("json file modified");
+  }
+  auto hash = reader.read_le<uint64_t>();
+  if (hashed && hash != source.hash) {
+    throw error("json content changed");
+  }
+  auto payload = snapshot_hash(file.data() + snapshot_header_size,
+                               file.size() - snapshot_header_size);
+  if (reader.read_le<uint64_t>() != payload) {
+    throw error("snapshot corrupted");
+  }
+
+  deserialize(data, &reader);
+  if (reader.remaining() != 0) {
+    throw error("unexpected trailing data");
+  }
+}
+
+// Writes the snapshot of `data` to a temporary file renamed to `path`, so
+// that readers never see half of it.
+template <typename T>
+void write_snapshot(const T &data, const std::string &path,
+                    const snapshot_source &source) {
+  binary_writer writer;
+  writer.write(snapshot_magic, sizeof(snapshot_magic));
+  writer.write_le<uint32_t>(snapshot_version);
+  writer.write_le<uint64_t>(schema_fingerprint<T>());
+  writer.write_le<uint64_t>(source.size);
+  writer.write_le<int64_t>(source.mtime);
+  writer.write_le<uint64_t>(source.hash);
+  writer.write_le<uint64_t>(0);
+  serialize(data, &writer);
+
+  auto payload = snapshot_hash(writer.data() + snapshot_header_size,
+                               writer.size() - snapshot_header_size);
+#ifdef SERIA_BIG_ENDIAN
+  payload = byte_swap(payload);
+#endif
+  std::memcpy(writer.data() + snapshot_header_size - 8, &payload, 8);
+
+  auto temporary = path + "." + std::to_string(::getpid()) + ".tmp";
+  auto fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644);
+  if (fd < 0) {
+    snapshot_fail("open", temporary);
+  }
+  for (size_t written = 0; written < writer.size();) {
+    auto size = ::write(fd, writer.data() + written, writer.size() - written);
+    if (size < 0 && errno == EINTR) {
+      continue;
+    }
+    if (size < 0) {
+      auto code = errno;
+      ::close(fd);
+      ::unlink(temporary.c_str());
+      snapshot_fail("write", temporary, code);
+    }
+    written += static_cast<size_t>(size);
+  }
+  if (::close(fd) != 0) {
+    auto code = errno;
+    ::unlink(temporary.c_str());
+    snapshot_fail("close", temporary, code);
+  }
+  if (::rename(temporary.c_str(), path.c_str()) != 0) {
+    auto code = errno;
+    ::unlink(temporary.c_str());
+    snapshot_fail("rename", path, code);
+  }
+}
+
+// Decodes the json file at `json_path` from a snapshot in the native binary
+// format kept in `cache_dir`, which is created when missing. The snapshot
+// is used when it was made from a file of the same size, modification time
+// and content hash, for a type with the same schema fingerprint. Otherwise
+// the json file is decoded and a new snapshot written for the next start.
+// Throws `seria::error` when the json file cannot be read or decoded, a
+// snapshot that cannot be used or written is only reported.
+//
+//   Config config;
+//   auto result = seria::load_cached(config, "/etc/app.json", "/var/cache");
+//   if (!result.from_snapshot) {
+//     log("config snapshot not used: " + result.reason);
+//   }
+template <typename T>
+snapshot_result load_cached(T &data, const std::string &json_path,
+                            const std::string &cache_dir,
+                            snapshot_options options = snapshot_options()) {
+  snapshot_result result;
+  auto source = snapshot_stat(json_path);
+  mapped_file json;
+  if (options.hash_content) {
+    json = mapped_file(json_path.c_str());
+    source.hash = snapshot_hash(json.data(), json.size());
+  }
+
+  auto path = snapshot_path<T>(json_path, cache_dir);
+  try {
+    read_snapshot(data, mapped_file(path.c_str()), source,
+                  options.hash_content);
+    result.from_snapshot = true;
+    return result;
+  } catch (error &err) {
+    // whatever the snapshot left in `data` is decoded again
+    result.reason = err.what();
+  }
+
+  if (!options.hash_content) {
+    json = mapped_file(json_path.c_str());
+    source.hash = snapshot_hash(json.data(), json.size());
+  }
+  from_string(data, json.size() != 0 ? json.data() : "", json.size(),
+              options.threads);
+
+  try {
+    if (::mkdir(cache_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      snapshot_fail("mkdir", cache_dir);
+    }
+    write_snapshot(data, path, source);
+    result.written = true;
+  } catch (error &err) {
+    result.write_error = err.what();
+  }
+  return result;
+}
+
+} // namespace seria
+#endif
@@ -0,0 +1,592 @@
+#pragma once
+#include <cstdint>
+#include <mpack/mpack-writer.h>
+#include <seria/exception.hpp>
+#include <seria/schema.hpp>
+#include <seria/validate/mpack.hpp>
+#include <string>
+#include <vector>
+#ifdef SERIA_USE_EXTERNAL_RAPIDJSON
+#include <rapidjson/error/en.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+#else
+#include <seria/rapidjson/error/en.h>
+#include <seria/rapidjson/memorystream.h>
+#include <seria/rapidjson/reader.h>
+#endif
+
+namespace seria {
+
+// SAX handler of `rapidjson::Reader` checking the events against a schema
+// and forwarding them to `Output`. Unknown members are dropped, elements of
+// `bytes` arrays are passed to `Output::byte`. Without a schema everything
+// is forwarded unchecked.
+template <typename Output> class json_schema_handler {
+public:
+  json_schema_handler(Output *output, const type_schema *schema)
+      : m_output(output), m_root(schema) {}
+
+  bool Null() {
+    if (skipped()) {
+      return true;
+    }
+
+    if (auto *schema = next_schema()) {
+      mismatch(schema);
+    }
+    m_output->null();
+    return finish_value();
+  }
+
+  bool Bool(bool value) {
+    if (skipped()) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema != nullptr && schema->kind != schema_kind::boolean) {
+      mismatch(schema);
+    }
+    m_output->boolean(value);
+    return finish_value();
+  }
+
+  bool Int(int value) { return Int64(value); }
+
+  bool Uint(unsigned value) { return Uint64(value); }
+
+  bool Int64(int64_t value) {
+    if (value >= 0) {
+      return Uint64(static_cast<uint64_t>(value));
+    }
+
+    if (skipped()) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema == nullptr) {
+      m_output->integer(value);
+    } else if (schema->kind == schema_kind::floating) {
+      m_output->real(static_cast<double>(value), schema->single);
+    } else if ((schema->kind == schema_kind::integer ||
+                schema->kind == schema_kind::enumeration) &&
+               value >= schema->min) {
+      m_output->integer(value);
+    } else {
+      mismatch(schema);
+    }
+    return finish_value();
+  }
+
+  bool Uint64(uint64_t value) {
+    if (skipped()) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema == nullptr) {
+      m_output->unsigned_integer(value);
+    } else if (schema->kind == schema_kind::floating) {
+      m_output->real(static_cast<double>(value), schema->single);
+    } else if ((schema->kind != schema_kind::integer &&
+                schema->kind != schema_kind::unsigned_integer &&
+                schema->kind != schema_kind::enumeration) ||
+               value > schema->max) {
+      mismatch(schema);
+    } else if (m_depth != 0 &&
+               m_frames[m_depth - 1].schema->kind == schema_kind::bytes) {
+      m_output->byte(static_cast<uint8_t>(value));
+    } else {
+      m_output->unsigned_integer(value);
+    }
+    return finish_value();
+  }
+
+  bool Double(double value) {
+    if (skipped()) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema != nullptr && schema->kind != schema_kind::floating) {
+      mismatch(schema);
+    }
+    m_output->real(value, schema != nullptr && schema->single);
+    return finish_value();
+  }
+
+  bool RawNumber(const char *, rapidjson::SizeType, bool) { return false; }
+
+  bool String(const char *value, rapidjson::SizeType length, bool) {
+    if (skipped()) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema != nullptr && schema->kind != schema_kind::string) {
+      mismatch(schema);
+    }
+    m_output->string(value, length);
+    return finish_value();
+  }
+
+  bool StartObject() {
+    if (skipped(true)) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema != nullptr && schema->kind != schema_kind::object) {
+      mismatch(schema);
+    }
+    push(schema, true);
+    m_output->start_object();
+    return true;
+  }
+
+  bool Key(const char *key, rapidjson::SizeType length, bool) {
+    if (m_skipping) {
+      return true;
+    }
+
+    auto &frame = m_frames[m_depth - 1];
+    if (frame.schema == nullptr) {
+      m_output->key(key, length);
+      return true;
+    }
+
+    auto index = frame.schema->find(key, length);
+    if (index == frame.schema->members.size()) {
+      m_skipping = true;
+      return true;
+    }
+
+    frame.index = index;
+    frame.next = frame.schema->members[index].schema;
+    if (index < 64) {
+      frame.seen |= uint64_t(1) << index;
+    } else {
+      m_overflow[frame.overflow + index - 64] = true;
+    }
+    m_output->key(key, length);
+    return true;
+  }
+
+  bool EndObject(rapidjson::SizeType) {
+    if (skipped(false, true)) {
+      return true;
+    }
+
+    auto &frame = m_frames[m_depth - 1];
+    if (frame.schema != nullptr) {
+      auto &members = frame.schema->members;
+      for (size_t i = 0; i < members.size(); i++) {
+        auto seen = i < 64 ? (frame.seen >> i & 1) != 0
+                           : m_overflow[frame.overflow + i - 64];
+        if (!seen && !members[i].has_default) {
+          auto prefix = path(m_depth - 1);
+          throw error(prefix.empty() ? members[i].key
+                                     : prefix + "." + members[i].key,
+                      "missing value");
+        }
+      }
+    }
+
+    m_output->end_object();
+    pop();
+    return finish_value();
+  }
+
+  bool StartArray() {
+    if (skipped(true)) {
+      return true;
+    }
+
+    auto *schema = next_schema();
+    if (schema != nullptr && schema->kind != schema_kind::array &&
+        schema->kind != schema_kind::bytes) {
+      mismatch(schema);
+    }
+    push(schema, false);
+    m_output->start_array(schema != nullptr &&
+                          schema->kind == schema_kind::bytes);
+    return true;
+  }
+
+  bool EndArray(rapidjson::SizeType) {
+    if (skipped(false, true)) {
+      return true;
+    }
+
+    auto &frame = m_frames[m_depth - 1];
+    if (frame.schema != nullptr && frame.schema->size != 0 &&
+        frame.schema->size != frame.index) {
+      throw error(path(m_depth - 1),
+                  "the size of array is not same with target");
+    }
+
+    m_output->end_array(frame.schema != nullptr &&
+                        frame.schema->kind == schema_kind::bytes);
+    pop();
+    return finish_value();
+  }
+
+  // path of the value at the given depth, empty for untyped input
+  std::string path(size_t depth) const {
+    std::string result;
+    for (size_t i = 0; i < depth; i++) {
+      auto &frame = m_frames[i];
+      if (frame.schema == nullptr) {
+        return std::string();
+      }
+
+      if (i != 0) {
+        result += '.';
+      }
+      if (frame.is_object) {
+        result += frame.schema->members[frame.index].key;
+      } else {
+        result += std::to_string(frame.index);
+      }
+    }
+    return result;
+  }
+
+private:
+  struct frame {
+    const type_schema *schema;
+    bool is_object;
+    // the schema of the next member value
+    const type_schema *next;
+    // the current member of objects, the number of elements of arrays
+    size_t index;
+    // members present, the bits past 64 are in `m_overflow` from `overflow`
+    uint64_t seen;
+    size_t overflow;
+  };
+
+  // consumes the events of a dropped value, `start` and `end` mark the
+  // events opening and closing containers
+  bool skipped(bool start = false, bool end = false) {
+    if (!m_skipping) {
+      return false;
+    }
+
+    if (start && ++m_skip_depth + m_depth > schema_max_depth) {
+      throw error(path(m_depth), "nesting too deep");
+    } else if (end) {
+      m_skip_depth--;
+    }
+    m_skipping = m_skip_depth != 0;
+    return true;
+  }
+
+  const type_schema *next_schema() const {
+    if (m_depth == 0) {
+      return m_root;
+    }
+
+    auto &frame = m_frames[m_depth - 1];
+    if (frame.schema == nullptr) {
+      return nullptr;
+    }
+    return frame.is_object ? frame.next : frame.schema->element;
+  }
+
+  void push(const type_schema *schema, bool is_object) {
+    if (m_depth == schema_max_depth) {
+      throw error(path(m_depth), "nesting too deep");
+    }
+
+    auto &frame = m_frames[m_depth++];
+    frame = {schema, is_object, nullptr, 0, 0, m_overflow.size()};
+    if (schema != nullptr && is_object && schema->members.size() > 64) {
+      m_overflow.resize(m_overflow.size() + schema->members.size() - 64);
+    }
+  }
+
+  void pop() { m_overflow.resize(m_frames[--m_depth].overflow); }
+
+  [[noreturn]] void mismatch(const type_schema *schema) const {
+    throw type_error(path(m_depth), schema_type_name(schema->kind));
+  }
+
+  bool finish_value() {
+    if (m_depth != 0 && !m_frames[m_depth - 1].is_object) {
+      m_frames[m_depth - 1].index++;
+    }
+    return m_output->ok();
+  }
+
+  Output *m_output;
+  const type_schema *m_root;
+  frame m_frames[schema_max_depth];
+  size_t m_depth = 0;
+  std::vector<bool> m_overflow;
+  bool m_skipping = false;
+  size_t m_skip_depth = 0;
+};
+
+// Runs `handler` over a json document, the parser stack lives on the C++
+// stack unless the document has very long strings.
+template <typename Handler>
+rapidjson::ParseResult parse_json_events(const char *data, size_t size,
+                                         Handler &handler) {
+  alignas(16) char buffer[1024];
+  rapidjson::MemoryPoolAllocator<> allocator(buffer, sizeof(buffer));
+  rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>,
+                           rapidjson::MemoryPoolAllocator<>>
+      reader(&allocator, 256);
+  rapidjson::MemoryStream stream(data, size);
+  return reader.Parse(stream, handler);
+}
+
+inline error json_parse_error(const rapidjson::ParseResult &result) {
+  return error(std::string(rapidjson::GetParseError_En(result.Code())) +
+               " at offset " + std::to_string(result.Offset()));
+}
+
+inline void check_mpack_writer(mpack_writer_t *writer) {
+  auto err = mpack_writer_error(writer);
+  if (err != mpack_ok) {
+    throw error(std::string("msgpack writer error: ") +
+                mpack_error_to_string(err));
+  }
+}
+
+// Output of `json_schema_handler` writing msgpack. Json does not tell the
+// sizes of containers upfront, so the outermost one is encoded into a buffer
+// with its elements counted as they come. The headers of the containers are
+// put in front of their elements once they end, and the whole value is
+// written at once when the outermost container does.
+class mpack_json_output {
+public:
+  explicit mpack_json_output(mpack_writer_t *writer) : m_writer(writer) {}
+
+  void null() {
+    scalar([](mpack_writer_t *writer) { mpack_write_nil(writer); });
+  }
+
+  void boolean(bool value) {
+    scalar(
+        [value](mpack_writer_t *writer) { mpack_write_bool(writer, value); });
+  }
+
+  void integer(int64_t value) {
+    scalar([value](mpack_writer_t *writer) { mpack_write_int(writer, value); });
+  }
+
+  void unsigned_integer(uint64_t value) {
+    scalar(
+        [value](mpack_writer_t *writer) { mpack_write_uint(writer, value); });
+  }
+
+  void real(double value, bool single) {
+    scalar([value, single](mpack_writer_t *writer) {
+      if (single) {
+        mpack_write_float(writer, static_cast<float>(value));
+      } else {
+        mpack_write_double(writer, value);
+      }
+    });
+  }
+
+  void byte(uint8_t value) { m_bytes.push_back(static_cast<char>(value)); }
+
+  void string(const char *value, size_t size) {
+    auto length = static_cast<uint32_t>(size);
+    if (m_open.empty()) {
+      mpack_write_str(m_writer, value, length);
+      return;
+    }
+    element();
+    if (length < 32) {
+      header(static_cast<uint8_t>(0xa0 | length), 0, 0);
+    } else if (length <= 0xFF) {
+      header(0xd9, length, 1);
+    } else if (length <= 0xFFFF) {
+      header(0xda, length, 2);
+    } else {
+      header(0xdb, length, 4);
+    }
+    m_body.append(value, size);
+  }
+
+  void key(const char *value, size_t size) { string(value, size); }
+
+  void start_object() { start(true); }
+
+  void end_object() { end(); }
+
+  void start_array(bool bytes) {
+    if (bytes) {
+      m_bytes.clear();
+    } else {
+      start(false);
+    }
+  }
+
+  void end_array(bool bytes) {
+    if (!bytes) {
+      end();
+      return;
+    }
+
+    auto length = static_cast<uint32_t>(m_bytes.size());
+    if (m_open.empty()) {
+      mpack_write_bin(m_writer, m_bytes.data(), length);
+      return;
+    }
+    element();
+    if (length <= 0xFF) {
+      header(0xc4, length, 1);
+    } else if (length <= 0xFFFF) {
+      header(0xc5, length, 2);
+    } else {
+      header(0xc6, length, 4);
+    }
+    m_body.append(m_bytes);
+  }
+
+  bool ok() const { return mpack_writer_error(m_writer) == mpack_ok; }
+
+private:
+  struct container {
+    size_t header;
+    uint32_t count;
+    bool is_map;
+  };
+
+  // the header of a container, to be put at `offset` of the body
+  struct container_header {
+    size_t offset;
+    char bytes[5];
+    size_t size;
+  };
+
+  template <typename F> void scalar(F &&write) {
+    if (m_open.empty()) {
+      write(m_writer);
+      return;
+    }
+    element();
+    char buffer[16];
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    write(&writer);
+    auto used = mpack_writer_buffer_used(&writer);
+    mpack_writer_destroy(&writer);
+    m_body.append(buffer, used);
+  }
+
+  void element() {
+    if (!m_open.empty()) {
+      m_open.back().count++;
+    }
+  }
+
+  // `lead` then the `size` low bytes of `value`, big-endian
+  void header(uint8_t lead, uint32_t value, int size) {
+    m_body.push_back(static_cast<char>(lead));
+    for (int i = size - 1; i >= 0; i--) {
+      m_body.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+
+  // the header is reserved here so the headers stay in the order they are
+  // written in, the body is written once the count is known
+  void start(bool is_map) {
+    element();
+    m_open.push_back(container{m_headers.size(), 0, is_map});
+    m_headers.push_back(container_header{m_body.size(), {}, 0});
+  }
+
+  void end() {
+    auto open = m_open.back();
+    m_open.pop_back();
+
+    auto &head = m_headers[open.header];
+    auto count = open.is_map ? open.count / 2 : open.count;
+    auto put = [&head](uint8_t lead, uint32_t value, int size) {
+      head.bytes[head.size++] = static_cast<char>(lead);
+      for (int i = size - 1; i >= 0; i--) {
+        head.bytes[head.size++] = static_cast<char>(value >> (8 * i));
+      }
+    };
+    if (count < 16) {
+      put(static_cast<uint8_t>((open.is_map ? 0x80 : 0x90) | count), 0, 0);
+    } else if (count <= 0xFFFF) {
+      put(open.is_map ? 0xde : 0xdc, count, 2);
+    } else {
+      put(open.is_map ? 0xdf : 0xdd, count, 4);
+    }
+
+    if (m_open.empty()) {
+      flush();
+    }
+  }
+
+  // Interleaves the headers with the body, they are sorted by offset already
+  void flush() {
+    std::string value;
+    value.reserve(m_body.size() + m_headers.size() * 5);
+    size_t position = 0;
+    for (const auto &head : m_headers) {
+      value.append(m_body, position, head.offset - position);
+      value.append(head.bytes, head.size);
+      position = head.offset;
+    }
+    value.append(m_body, position, std::string::npos);
+    mpack_write_object_bytes(m_writer, value.data(), value.size());
+
+    m_body.clear();
+    m_headers.clear();
+  }
+
+  mpack_writer_t *m_writer;
+  // elements of the current `bytes` array, these never nest
+  std::string m_bytes;
+  // the outermost container without the headers of the containers
+  std::string m_body;
+  std::vector<container> m_open;
+  std::vector<container_header> m_headers;
+};
+
+// Converts a json document into msgpack without building a DOM, given a
+// schema the values are checked against it, unknown members are dropped and
+// `std::vector<uint8_t>` members become `bin`.
+inline void transcode_json_to_mpack(const char *data, size_t size,
+                                    mpack_writer_t *writer,
+                                    const type_schema *schema = nullptr) {
+  mpack_json_output output(writer);
+  json_schema_handler<mpack_json_output> handler(&output, schema);
+  auto result = parse_json_events(data, size, handler);
+
+  check_mpack_writer(writer);
+  if (result.IsError()) {
+    throw json_parse_error(result);
+  }
+}
+
+template <typename T>
+void transcode_json_to_mpack(const char *data, size_t size,
+                             mpack_writer_t *writer) {
+  transcode_json_to_mpack(data, size, writer, &schema_of<T>());
+}
+
+// Converts msgpack into json events of a rapidjson writer, the inverse of
+// `transcode_json_to_mpack`. `bin` becomes an array of numbers.
+template <typename Writer>
+void transcode_mpack_to_json(const char *data, size_t size, Writer *writer,
+                             const type_schema *schema = nullptr) {
+  walk_mpack(data, size, writer, schema);
+}
+
+template <typename T, typename Writer>
+void transcode_mpack_to_json(const char *data, size_t size, Writer *writer) {
+  transcode_mpack_to_json(data, size, writer, &schema_of<T>());
+}
+
+} // namespace seria
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace seria {
+
+template <typename Node, typename T> struct type_graph_state {
+  // set once the node and all the nodes it refers to are complete
+  static std::atomic<bool> published;
+  // set under the lock once the node is being built
+  static bool started;
+};
+
+template <typename Node, typename T>
+std::atomic<bool> type_graph_state<Node, T>::published{false};
+
+template <typename Node, typename T>
+bool type_graph_state<Node, T>::started = false;
+
+// Builds the runtime descriptions of types (`Node`: schemas, descriptors)
+// on first use, all of one kind under one lock. A recursive type builds the
+// nodes it refers to while its own is under construction, so they are only
+// published once the outermost one is complete. With a function-local
+// static per node instead, two threads starting from different types of the
+// same cycle would each hold one initialization and wait for the other.
+template <typename Node> class type_graph {
+public:
+  template <typename T, typename Build>
+  static const Node &get(Node &node, Build &&build) {
+    using State = type_graph_state<Node, T>;
+    if (State::published.load(std::memory_order_acquire)) {
+      return node;
+    }
+
+    auto &graph = instance();
+    std::lock_guard<std::recursive_mutex> lock(graph.m_mutex);
+    // complete, or under construction further up on this thread
+    if (State::started) {
+      return node;
+    }
+    State::started = true;
+    graph.m_depth++;
+    build(node);
+    graph.m_depth--;
+    graph.m_built.push_back(&State::published);
+
+    if (graph.m_depth == 0) {
+      for (auto *published : graph.m_built) {
+        published->store(true, std::memory_order_release);
+      }
+      graph.m_built.clear();
+    }
+    return node;
+  }
+
+private:
+  static type_graph &instance() {
+    static type_graph graph;
+    return graph;
+  }
+
+  std::recursive_mutex m_mutex;
+  // nodes built since the outermost `get` started
+  std::vector<std::atomic<bool> *> m_built;
+  size_t m_depth = 0;
+};
+
+} // namespace seria
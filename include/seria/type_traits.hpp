@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <iterator>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -54,4 +55,22 @@ struct is_object<
                         (!is_vector<T>::value && std::is_class<T>::value)>>
     : public std::true_type {};
 
+// element type of a vector or an array, `bool` for `std::vector<bool>`
+template <typename T>
+using element_type_t = std::remove_cv_t<std::remove_reference_t<decltype(
+    *std::begin(std::declval<const T &>()))>>;
+
+// specialize to encode `std::vector<T>` of a registered object column by
+// column (struct-of-arrays) instead of as an array of objects
+template <typename T> struct is_columnar : std::false_type {};
+
+template <typename T, typename _ = void>
+struct is_columnar_vector : std::false_type {};
+
+template <typename T>
+struct is_columnar_vector<
+    T, std::enable_if_t<is_vector<T>::value &&
+                        is_columnar<typename T::value_type>::value>>
+    : std::true_type {};
+
 } // namespace seria
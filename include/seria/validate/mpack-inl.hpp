@@ -0,0 +1,249 @@
+#pragma once
+#include <cstdint>
+#include <mpack/mpack-reader.h>
+#include <seria/exception.hpp>
+#include <seria/schema.hpp>
+#include <string>
+
+namespace seria {
+
+// sink of `walk_mpack` discarding everything, has the interface of a
+// rapidjson writer
+struct mpack_null_sink {
+  bool Null() { return true; }
+  bool Bool(bool) { return true; }
+  bool Int64(int64_t) { return true; }
+  bool Uint64(uint64_t) { return true; }
+  bool Uint(unsigned) { return true; }
+  bool Double(double) { return true; }
+  bool String(const char *, size_t) { return true; }
+  bool Key(const char *, size_t) { return true; }
+  bool StartObject() { return true; }
+  bool EndObject(size_t) { return true; }
+  bool StartArray() { return true; }
+  bool EndArray(size_t) { return true; }
+};
+
+inline void check_mpack_reader(mpack_reader_t *reader) {
+  auto err = mpack_reader_error(reader);
+  if (err != mpack_ok) {
+    throw error(std::string("msgpack reader error: ") +
+                mpack_error_to_string(err));
+  }
+}
+
+inline const char *read_mpack_bytes(mpack_reader_t *reader, size_t size) {
+  auto *bytes = mpack_read_bytes_inplace(reader, size);
+  check_mpack_reader(reader);
+  return bytes;
+}
+
+template <typename Sink>
+void walk_mpack_value(mpack_reader_t *reader, Sink *sink,
+                      const type_schema *schema, unsigned depth);
+
+template <typename Sink>
+void walk_mpack_map(mpack_reader_t *reader, Sink *sink,
+                    const type_schema *schema, uint32_t count,
+                    unsigned depth) {
+  member_set seen(schema != nullptr ? schema->members.size() : 0);
+  sink->StartObject();
+  for (uint32_t i = 0; i < count; i++) {
+    auto tag = mpack_read_tag(reader);
+    check_mpack_reader(reader);
+    if (mpack_tag_type(&tag) != mpack_type_str) {
+      throw error("map keys must be strings");
+    }
+
+    auto length = mpack_tag_str_length(&tag);
+    auto *key = read_mpack_bytes(reader, length);
+    mpack_done_str(reader);
+
+    const type_schema *value_schema = nullptr;
+    if (schema != nullptr) {
+      // unknown keys are dropped together with their values
+      auto index = schema->find(key, length);
+      if (index == schema->members.size()) {
+        mpack_discard(reader);
+        check_mpack_reader(reader);
+        continue;
+      }
+
+      seen.insert(index);
+      value_schema = schema->members[index].schema;
+    }
+
+    sink->Key(key, length);
+    try {
+      walk_mpack_value(reader, sink, value_schema, depth + 1);
+    } catch (type_error &err) {
+      err.add_prefix(std::string(key, length));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::string(key, length));
+      throw err;
+    }
+  }
+
+  if (schema != nullptr) {
+    for (size_t i = 0; i < schema->members.size(); i++) {
+      if (!seen.contains(i) && !schema->members[i].has_default) {
+        throw error(schema->members[i].key, "missing value");
+      }
+    }
+  }
+  sink->EndObject(count);
+  mpack_done_map(reader);
+}
+
+// Reads one msgpack value checking it against `schema`, when given, and
+// passes it to `sink` as the events of a rapidjson writer. `bin` becomes an
+// array of numbers.
+template <typename Sink>
+void walk_mpack_value(mpack_reader_t *reader, Sink *sink,
+                      const type_schema *schema, unsigned depth) {
+  if (depth > schema_max_depth) {
+    throw error("nesting too deep");
+  }
+
+  auto tag = mpack_read_tag(reader);
+  check_mpack_reader(reader);
+
+  auto kind = schema != nullptr ? schema->kind : schema_kind::object;
+  auto is_integer = kind == schema_kind::integer ||
+                    kind == schema_kind::unsigned_integer ||
+                    kind == schema_kind::enumeration;
+  auto matches = true;
+  switch (mpack_tag_type(&tag)) {
+  case mpack_type_nil:
+    matches = schema == nullptr;
+    sink->Null();
+    break;
+  case mpack_type_bool:
+    matches = schema == nullptr || kind == schema_kind::boolean;
+    sink->Bool(mpack_tag_bool_value(&tag));
+    break;
+  case mpack_type_int: {
+    auto value = mpack_tag_int_value(&tag);
+    matches = schema == nullptr || kind == schema_kind::floating ||
+              (is_integer && value >= schema->min);
+    sink->Int64(value);
+    break;
+  }
+  case mpack_type_uint: {
+    auto value = mpack_tag_uint_value(&tag);
+    matches = schema == nullptr || kind == schema_kind::floating ||
+              (is_integer && value <= schema->max);
+    sink->Uint64(value);
+    break;
+  }
+  case mpack_type_float:
+  case mpack_type_double: {
+    auto value = mpack_tag_type(&tag) == mpack_type_float
+                     ? static_cast<double>(mpack_tag_float_value(&tag))
+                     : mpack_tag_double_value(&tag);
+    matches = schema == nullptr || kind == schema_kind::floating;
+    if (matches && !sink->Double(value)) {
+      throw error("non-finite numbers have no json representation");
+    }
+    break;
+  }
+  case mpack_type_str: {
+    matches = schema == nullptr || kind == schema_kind::string;
+    auto length = mpack_tag_str_length(&tag);
+    sink->String(read_mpack_bytes(reader, length), length);
+    mpack_done_str(reader);
+    break;
+  }
+  case mpack_type_bin: {
+    matches = schema == nullptr || kind == schema_kind::bytes;
+    auto length = mpack_tag_bin_length(&tag);
+    auto *bytes =
+        reinterpret_cast<const uint8_t *>(read_mpack_bytes(reader, length));
+    sink->StartArray();
+    for (uint32_t i = 0; i < length; i++) {
+      sink->Uint(bytes[i]);
+    }
+    sink->EndArray(length);
+    mpack_done_bin(reader);
+    break;
+  }
+  case mpack_type_array: {
+    matches = schema == nullptr || kind == schema_kind::array ||
+              kind == schema_kind::bytes;
+    if (!matches) {
+      break;
+    }
+
+    auto count = mpack_tag_array_count(&tag);
+    if (schema != nullptr && schema->size != 0 && schema->size != count) {
+      throw error("the size of array is not same with target");
+    }
+
+    sink->StartArray();
+    for (uint32_t i = 0; i < count; i++) {
+      try {
+        walk_mpack_value(reader, sink,
+                         schema != nullptr ? schema->element : nullptr,
+                         depth + 1);
+      } catch (type_error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      } catch (error &err) {
+        err.add_prefix(std::to_string(i));
+        throw err;
+      }
+    }
+    sink->EndArray(count);
+    mpack_done_array(reader);
+    break;
+  }
+  case mpack_type_map:
+    matches = schema == nullptr || kind == schema_kind::object;
+    if (matches) {
+      walk_mpack_map(reader, sink, schema, mpack_tag_map_count(&tag), depth);
+    }
+    break;
+  default:
+    throw error("ext types are not supported");
+  }
+
+  if (!matches) {
+    throw type_error(schema_type_name(kind));
+  }
+}
+
+// walks exactly one msgpack value spanning the whole input
+template <typename Sink>
+void walk_mpack(const char *data, size_t size, Sink *sink,
+                const type_schema *schema) {
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, data, size);
+  try {
+    walk_mpack_value(&reader, sink, schema, 0);
+    if (mpack_reader_remaining(&reader, nullptr) != 0) {
+      throw error("unexpected data after the msgpack value");
+    }
+  } catch (...) {
+    mpack_reader_destroy(&reader);
+    throw;
+  }
+
+  auto err = mpack_reader_destroy(&reader);
+  if (err != mpack_ok) {
+    throw error(std::string("msgpack reader error: ") +
+                mpack_error_to_string(err));
+  }
+}
+
+inline void validate_mpack(const char *data, size_t size,
+                           const type_schema &schema) {
+  mpack_null_sink sink;
+  walk_mpack(data, size, &sink, &schema);
+}
+
+template <typename T> void validate_mpack(const char *data, size_t size) {
+  validate_mpack(data, size, schema_of<T>());
+}
+
+} // namespace seria
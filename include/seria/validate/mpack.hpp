@@ -0,0 +1,17 @@
+#pragma once
+#include <mpack/mpack-reader.h>
+#include <seria/schema.hpp>
+
+namespace seria {
+
+// Checks that msgpack data deserializes into `T` without building a node
+// tree or the value, throws `seria::error` with the same path `deserialize`
+// would.
+template <typename T> void validate_mpack(const char *data, size_t size);
+
+inline void validate_mpack(const char *data, size_t size,
+                           const type_schema &schema);
+
+} // namespace seria
+
+#include <seria/validate/mpack-inl.hpp>
@@ -0,0 +1,538 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <seria/exception.hpp>
+#include <seria/schema.hpp>
+#include <string>
+
+namespace seria {
+
+// Scans a json document checking it against a schema, accepting the same
+// documents as `rapidjson::Reader` with the default flags. Strings are not
+// unescaped and numbers are only converted when their range matters.
+class json_validator {
+public:
+  json_validator(const char *data, size_t size)
+      : m_begin(data), m_cur(data), m_end(data + size) {}
+
+  void validate(const type_schema &schema) {
+    skip_whitespace();
+    if (m_cur == m_end) {
+      syntax_error("The document is empty.");
+    }
+    value(&schema, 0);
+    skip_whitespace();
+    if (m_cur != m_end) {
+      syntax_error("The document root must not be followed by other values.");
+    }
+  }
+
+private:
+  // `schema` is null for the values of unknown members
+  void value(const type_schema *schema, unsigned depth) {
+    switch (peek()) {
+    case '{':
+      object(schema, depth);
+      break;
+    case '[':
+      array(schema, depth);
+      break;
+    case '"': {
+      const char *text;
+      size_t length;
+      string(&text, &length);
+      expect_kind(schema, schema_kind::string);
+      break;
+    }
+    case 't':
+      literal("true", 4);
+      expect_kind(schema, schema_kind::boolean);
+      break;
+    case 'f':
+      literal("false", 5);
+      expect_kind(schema, schema_kind::boolean);
+      break;
+    case 'n':
+      literal("null", 4);
+      if (schema != nullptr) {
+        throw type_error(schema_type_name(schema->kind));
+      }
+      break;
+    default:
+      number(schema);
+    }
+  }
+
+  void object(const type_schema *schema, unsigned depth) {
+    expect_kind(schema, schema_kind::object);
+    enter(depth);
+
+    member_set seen(schema != nullptr ? schema->members.size() : 0);
+    // members mostly come in the order they were registered
+    size_t hint = 0;
+    m_cur++;
+    skip_whitespace();
+    if (peek() == '}') {
+      m_cur++;
+    } else {
+      while (true) {
+        if (peek() != '"') {
+          syntax_error("Missing a name for object member.");
+        }
+        const char *key;
+        size_t length;
+        bool escaped = string(&key, &length);
+        skip_whitespace();
+        if (peek() != ':') {
+          syntax_error("Missing a colon after a name of object member.");
+        }
+        m_cur++;
+        skip_whitespace();
+
+        auto index = schema != nullptr ? find(*schema, key, length, escaped, hint)
+                                       : 0;
+        if (schema == nullptr || index == schema->members.size()) {
+          value(nullptr, depth + 1);
+        } else {
+          auto &member = schema->members[index];
+          seen.insert(index);
+          hint = index + 1;
+          try {
+            value(member.schema, depth + 1);
+          } catch (type_error &err) {
+            err.add_prefix(member.key);
+            throw err;
+          } catch (error &err) {
+            err.add_prefix(member.key);
+            throw err;
+          }
+        }
+
+        skip_whitespace();
+        if (peek() == ',') {
+          m_cur++;
+          skip_whitespace();
+        } else if (peek() == '}') {
+          m_cur++;
+          break;
+        } else {
+          syntax_error("Missing a comma or '}' after an object member.");
+        }
+      }
+    }
+
+    if (schema == nullptr) {
+      return;
+    }
+    auto &members = schema->members;
+    for (size_t i = 0; i < members.size(); i++) {
+      if (!seen.contains(i) && !members[i].has_default) {
+        throw error(members[i].key, "missing value");
+      }
+    }
+  }
+
+  void array(const type_schema *schema, unsigned depth) {
+    if (schema != nullptr && schema->kind != schema_kind::bytes) {
+      expect_kind(schema, schema_kind::array);
+    }
+    enter(depth);
+
+    auto *element = schema != nullptr ? schema->element : nullptr;
+    size_t count = 0;
+    m_cur++;
+    skip_whitespace();
+    if (peek() == ']') {
+      m_cur++;
+    } else {
+      while (true) {
+        try {
+          value(element, depth + 1);
+        } catch (type_error &err) {
+          err.add_prefix(std::to_string(count));
+          throw err;
+        } catch (error &err) {
+          err.add_prefix(std::to_string(count));
+          throw err;
+        }
+        count++;
+
+        skip_whitespace();
+        if (peek() == ',') {
+          m_cur++;
+          skip_whitespace();
+        } else if (peek() == ']') {
+          m_cur++;
+          break;
+        } else {
+          syntax_error("Missing a comma or ']' after an array element.");
+        }
+      }
+    }
+
+    if (schema != nullptr && schema->size != 0 && schema->size != count) {
+      throw error("the size of array is not same with target");
+    }
+  }
+
+  // skips a string, its raw text is stored in `text` and `length`, returns
+  // whether it has escapes
+  bool string(const char **text, size_t *length) {
+    m_cur++;
+    auto *begin = m_cur;
+    bool escaped = false;
+    while (true) {
+      skip_plain_characters();
+      if (m_cur == m_end) {
+        syntax_error("Missing a closing quotation mark in string.");
+      }
+
+      auto c = static_cast<unsigned char>(*m_cur);
+      if (c == '"') {
+        *text = begin;
+        *length = static_cast<size_t>(m_cur - begin);
+        m_cur++;
+        return escaped;
+      } else if (c == '\\') {
+        escaped = true;
+        escape();
+      } else {
+        syntax_error("Invalid encoding in string.");
+      }
+    }
+  }
+
+  void skip_plain_characters() {
+    // eight bytes at a time while there is no '"', '\\' or control character
+    constexpr uint64_t ones = 0x0101010101010101;
+    constexpr uint64_t highs = 0x8080808080808080;
+    while (m_end - m_cur >= 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, m_cur, sizeof(chunk));
+      auto quote = chunk ^ (ones * '"');
+      auto backslash = chunk ^ (ones * '\\');
+      auto special = ((quote - ones) & ~quote) |
+                     ((backslash - ones) & ~backslash) |
+                     ((chunk - ones * 0x20) & ~chunk);
+      if ((special & highs) != 0) {
+        break;
+      }
+      m_cur += 8;
+    }
+
+    while (m_cur != m_end) {
+      auto c = static_cast<unsigned char>(*m_cur);
+      if (c < 0x20 || c == '"' || c == '\\') {
+        break;
+      }
+      m_cur++;
+    }
+  }
+
+  void escape() {
+    m_cur++;
+    switch (peek()) {
+    case '"':
+    case '\\':
+    case '/':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+      m_cur++;
+      return;
+    case 'u': {
+      m_cur++;
+      auto codepoint = hex4();
+      if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+        if (m_end - m_cur < 2 || m_cur[0] != '\\' || m_cur[1] != 'u') {
+          syntax_error("The surrogate pair in string is invalid.");
+        }
+        m_cur += 2;
+        auto low = hex4();
+        if (low < 0xDC00 || low > 0xDFFF) {
+          syntax_error("The surrogate pair in string is invalid.");
+        }
+      }
+      return;
+    }
+    default:
+      syntax_error("Invalid escape character in string.");
+    }
+  }
+
+  unsigned hex4() {
+    unsigned codepoint = 0;
+    for (int i = 0; i < 4; i++) {
+      auto c = peek();
+      codepoint <<= 4;
+      if (c >= '0' && c <= '9') {
+        codepoint += static_cast<unsigned>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        codepoint += static_cast<unsigned>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        codepoint += static_cast<unsigned>(c - 'A' + 10);
+      } else {
+        syntax_error("Incorrect hex digit after \\u escape in string.");
+      }
+      m_cur++;
+    }
+    return codepoint;
+  }
+
+  void number(const type_schema *schema) {
+    auto *begin = m_cur;
+    bool negative = peek() == '-';
+    if (negative) {
+      m_cur++;
+    }
+
+    // the integer part, `digits` counts those past leading zeros
+    uint64_t magnitude = 0;
+    int digits = 0;
+    bool overflow = false;
+    if (peek() == '0') {
+      m_cur++;
+    } else if (is_digit(peek())) {
+      while (is_digit(peek())) {
+        unsigned digit = static_cast<unsigned>(*m_cur++ - '0');
+        if (magnitude > (UINT64_MAX - digit) / 10) {
+          overflow = true;
+        }
+        magnitude = magnitude * 10 + digit;
+        digits++;
+      }
+    } else {
+      syntax_error("Invalid value.");
+    }
+
+    bool integral = true;
+    int exponent = digits - 1;
+    if (peek() == '.') {
+      m_cur++;
+      if (!is_digit(peek())) {
+        syntax_error("Missing fraction part in number.");
+      }
+      while (is_digit(peek())) {
+        if (digits == 0 && *m_cur == '0') {
+          exponent--;
+        } else {
+          digits++;
+        }
+        m_cur++;
+      }
+      integral = false;
+    }
+
+    if (peek() == 'e' || peek() == 'E') {
+      m_cur++;
+      bool negative_exponent = peek() == '-';
+      if (peek() == '+' || peek() == '-') {
+        m_cur++;
+      }
+      if (!is_digit(peek())) {
+        syntax_error("Missing exponent in number.");
+      }
+      int value = 0;
+      while (is_digit(peek())) {
+        if (value < 100000) {
+          value = value * 10 + (*m_cur - '0');
+        }
+        m_cur++;
+      }
+      exponent += negative_exponent ? -value : value;
+      integral = false;
+    }
+
+    // what rapidjson does not report as an integer is a double
+    bool is_double = !integral || overflow ||
+                     (negative && magnitude > uint64_t(1) << 63);
+    if (is_double && digits != 0 && exponent >= DBL_MAX_10_EXP &&
+        std::abs(to_double(begin)) > DBL_MAX) {
+      m_cur = begin;
+      syntax_error("Number too big to be stored in double.");
+    }
+
+    if (schema == nullptr) {
+      return;
+    }
+    switch (schema->kind) {
+    case schema_kind::floating:
+      if (!is_double) {
+        // `deserialize` only takes the integers of `int` for floats
+        if (magnitude <= (negative ? uint64_t(1) << 31 : INT32_MAX)) {
+          return;
+        }
+      } else if (!schema->single || digits == 0 ||
+                 exponent < FLT_MAX_10_EXP ||
+                 (exponent == FLT_MAX_10_EXP &&
+                  std::abs(to_double(begin)) <= FLT_MAX)) {
+        return;
+      }
+      break;
+    case schema_kind::integer:
+    case schema_kind::enumeration:
+      if (!is_double &&
+          magnitude <= (negative ? uint64_t(-(schema->min + 1)) + 1
+                                 : schema->max)) {
+        return;
+      }
+      break;
+    case schema_kind::unsigned_integer:
+      if (!is_double && (!negative || magnitude == 0) &&
+          magnitude <= schema->max) {
+        return;
+      }
+      break;
+    default:
+      break;
+    }
+    throw type_error(schema_type_name(schema->kind));
+  }
+
+  // converts the number at `begin` up to the current position
+  double to_double(const char *begin) const {
+    std::string text(begin, m_cur);
+    return std::strtod(text.c_str(), nullptr);
+  }
+
+  void literal(const char *text, size_t size) {
+    if (static_cast<size_t>(m_end - m_cur) < size ||
+        std::memcmp(m_cur, text, size) != 0) {
+      syntax_error("Invalid value.");
+    }
+    m_cur += size;
+  }
+
+  void expect_kind(const type_schema *schema, schema_kind kind) const {
+    if (schema != nullptr && schema->kind != kind) {
+      throw type_error(schema_type_name(schema->kind));
+    }
+  }
+
+  void enter(unsigned depth) const {
+    if (depth == schema_max_depth) {
+      throw error("nesting too deep");
+    }
+  }
+
+  static size_t find(const type_schema &schema, const char *key,
+                     size_t length, bool escaped, size_t hint) {
+    if (escaped) {
+      auto unescaped = unescape(key, length);
+      return schema.find(unescaped.data(), unescaped.size());
+    }
+
+    auto &members = schema.members;
+    if (hint < members.size() && members[hint].key_length == length &&
+        std::memcmp(members[hint].key, key, length) == 0) {
+      return hint;
+    }
+    return schema.find(key, length);
+  }
+
+  // keys of registered members are plain text, escapes only need to be
+  // decoded enough to compare with them
+  static std::string unescape(const char *text, size_t length) {
+    std::string result;
+    for (size_t i = 0; i < length; i++) {
+      if (text[i] != '\\') {
+        result += text[i];
+        continue;
+      }
+
+      auto c = text[++i];
+      switch (c) {
+      case 'b':
+        result += '\b';
+        break;
+      case 'f':
+        result += '\f';
+        break;
+      case 'n':
+        result += '\n';
+        break;
+      case 'r':
+        result += '\r';
+        break;
+      case 't':
+        result += '\t';
+        break;
+      case 'u': {
+        auto codepoint = hex4(text + i + 1);
+        i += 4;
+        if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+          auto low = hex4(text + i + 3);
+          i += 6;
+          codepoint = (((codepoint - 0xD800) << 10) | (low - 0xDC00)) + 0x10000;
+        }
+        append_utf8(result, codepoint);
+        break;
+      }
+      default:
+        result += c;
+      }
+    }
+    return result;
+  }
+
+  // four hex digits already checked by `escape`
+  static unsigned hex4(const char *text) {
+    return static_cast<unsigned>(
+        std::strtoul(std::string(text, 4).c_str(), nullptr, 16));
+  }
+
+  static void append_utf8(std::string &result, unsigned codepoint) {
+    if (codepoint < 0x80) {
+      result += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+      result += static_cast<char>(0xC0 | (codepoint >> 6));
+      result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+      result += static_cast<char>(0xE0 | (codepoint >> 12));
+      result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+      result += static_cast<char>(0xF0 | (codepoint >> 18));
+      result += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+      result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+  }
+
+  static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+  char peek() const { return m_cur != m_end ? *m_cur : '\0'; }
+
+  void skip_whitespace() {
+    while (m_cur != m_end &&
+           (*m_cur == ' ' || *m_cur == '\n' || *m_cur == '\r' ||
+            *m_cur == '\t')) {
+      m_cur++;
+    }
+  }
+
+  [[noreturn]] void syntax_error(const char *message) const {
+    throw error(std::string(message) + " at offset " +
+                std::to_string(m_cur - m_begin));
+  }
+
+  const char *m_begin;
+  const char *m_cur;
+  const char *m_end;
+};
+
+inline void validate(const char *data, size_t size,
+                     const type_schema &schema) {
+  json_validator validator(data, size);
+  validator.validate(schema);
+}
+
+template <typename T> void validate(const char *data, size_t size) {
+  validate(data, size, schema_of<T>());
+}
+
+} // namespace seria
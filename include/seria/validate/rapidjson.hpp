@@ -0,0 +1,14 @@
+#pragma once
+#include <seria/schema.hpp>
+
+namespace seria {
+
+// Checks that a json document deserializes into `T` without building a DOM
+// or the value, throws `seria::error` with the same path `deserialize` would.
+template <typename T> void validate(const char *data, size_t size);
+
+inline void validate(const char *data, size_t size, const type_schema &schema);
+
+} // namespace seria
+
+#include <seria/validate/rapidjson-inl.hpp>
@@ -0,0 +1,583 @@
+#pragma once
+#include <cstring>
+#include <seria/binary.hpp>
+#include <seria/exception.hpp>
+#include <seria/fingerprint.hpp>
+#include <seria/object.hpp>
+#include <seria/type_traits.hpp>
+#include <string>
+
+namespace seria {
+
+// Zero-copy layout: every value has a fixed-size inline slot. Scalars are
+// stored little-endian in their slot, fixed arrays and objects are laid out
+// inline member by member, strings and vectors store a (u32 offset, u32 count)
+// pair pointing forward to out-of-line data. Offsets are relative to the
+// start of the buffer, vector payloads are 8-byte aligned.
+constexpr char view_magic[3] = {'S', 'R', 'Z'};
+constexpr uint8_t view_version = 1;
+constexpr size_t view_root_offset = 16;
+constexpr size_t view_alignment = 8;
+constexpr unsigned view_max_depth = 64;
+
+template <typename T, typename _ = void> struct view_size;
+
+template <typename T>
+struct view_size<T, std::enable_if_t<std::is_arithmetic<T>::value>>
+    : std::integral_constant<size_t, is_boolean<T>::value ? 1 : sizeof(T)> {};
+
+template <typename T>
+struct view_size<T, std::enable_if_t<std::is_enum<T>::value>>
+    : std::integral_constant<size_t, sizeof(T)> {};
+
+template <typename T>
+struct view_size<T,
+                 std::enable_if_t<is_string<T>::value || is_vector<T>::value>>
+    : std::integral_constant<size_t, 8> {};
+
+template <typename T>
+struct view_size<T, std::enable_if_t<is_array<T>::value>>
+    : std::integral_constant<
+          size_t, is_array<T>::size *
+                      view_size<std::decay_t<decltype(
+                          std::declval<T &>()[0])>>::value> {};
+
+template <size_t N> struct view_offsets {
+  size_t values[N];
+
+  constexpr size_t operator[](size_t index) const { return values[index]; }
+
+  constexpr size_t back() const { return values[N - 1]; }
+};
+
+template <typename Tuple, size_t... I>
+constexpr view_offsets<sizeof...(I) + 1>
+view_member_offsets(std::index_sequence<I...> /*unused*/) {
+  constexpr size_t sizes[] = {
+      view_size<typename std::tuple_element_t<I, Tuple>::Type>::value..., 0};
+  view_offsets<sizeof...(I) + 1> offsets{};
+  for (size_t i = 0; i < sizeof...(I); i++) {
+    offsets.values[i + 1] = offsets.values[i] + sizes[i];
+  }
+  return offsets;
+}
+
+// offsets of every registered member inside the slot of `T`, the last entry
+// is the size of the slot
+template <typename T> struct view_layout {
+  using Members = decltype(register_object<T>());
+  constexpr static size_t member_size = std::tuple_size<Members>::value;
+  constexpr static view_offsets<member_size + 1> offsets =
+      view_member_offsets<Members>(std::make_index_sequence<member_size>());
+};
+
+template <typename T>
+constexpr view_offsets<view_layout<T>::member_size + 1>
+    view_layout<T>::offsets;
+
+template <typename T>
+struct view_size<T, std::enable_if_t<is_object<T>::value>>
+    : std::integral_constant<size_t, view_layout<T>::offsets.back()> {};
+
+template <typename T> void view_store(char *dst, T value) {
+#ifdef SERIA_BIG_ENDIAN
+  value = byte_swap(value);
+#endif
+  std::memcpy(dst, &value, sizeof(T));
+}
+
+template <typename T> T view_load(const char *src) {
+  T value;
+  std::memcpy(&value, src, sizeof(T));
+#ifdef SERIA_BIG_ENDIAN
+  value = byte_swap(value);
+#endif
+  return value;
+}
+
+inline size_t view_append(binary_writer *writer, size_t size,
+                          size_t alignment) {
+  auto padding = (alignment - writer->size() % alignment) % alignment;
+  auto offset = writer->size() + padding;
+  if (offset + size > UINT32_MAX) {
+    throw error("zero-copy buffer exceeds 4GiB");
+  }
+
+  std::memset(writer->reserve(padding + size), 0, padding + size);
+  return offset;
+}
+
+inline void view_store_ref(binary_writer *writer, size_t slot, size_t offset,
+                           size_t count) {
+  view_store(writer->data() + slot, static_cast<uint32_t>(offset));
+  view_store(writer->data() + slot + 4, static_cast<uint32_t>(count));
+}
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  writer->data()[slot] = obj ? 1 : 0;
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  view_store(writer->data() + slot, obj);
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  view_store(writer->data() + slot,
+             static_cast<std::underlying_type_t<T>>(obj));
+}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  auto offset = view_append(writer, obj.size(), 1);
+  std::memcpy(writer->data() + offset, obj.data(), obj.size());
+  view_store_ref(writer, slot, offset, obj.size());
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  using Element = typename T::value_type;
+  constexpr size_t stride = view_size<Element>::value;
+
+  auto offset = view_append(writer, obj.size() * stride, view_alignment);
+  view_store_ref(writer, slot, offset, obj.size());
+
+#ifndef SERIA_BIG_ENDIAN
+  if (is_binary_pod<Element>::value) {
+    std::memcpy(writer->data() + offset, obj.data(), obj.size() * stride);
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < obj.size(); i++) {
+    write_view(obj[i], writer, offset + i * stride);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  using Element = std::decay_t<decltype(obj[0])>;
+  constexpr size_t stride = view_size<Element>::value;
+
+#ifndef SERIA_BIG_ENDIAN
+  if (is_binary_pod<T>::value) {
+    std::memcpy(writer->data() + slot, &obj, sizeof(T));
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < is_array<T>::size; i++) {
+    write_view(obj[i], writer, slot + i * stride);
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+write_view(const T &obj, binary_writer *writer, size_t slot) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  static_assert(member_size != 0, "No registered members!");
+
+  size_t index = 0;
+  auto setter = [&](auto &member) {
+    write_view(obj.*(member.m_ptr), writer,
+               slot + view_layout<T>::offsets[index++]);
+  };
+
+  for_each(setter, members, std::make_index_sequence<member_size>());
+}
+
+template <typename T>
+void serialize_view(const T &obj, binary_writer *writer) {
+  if (writer->size() != 0) {
+    throw error("zero-copy buffer must start at the beginning of the writer");
+  }
+
+  auto *header = writer->reserve(view_root_offset + view_size<T>::value);
+  std::memset(header, 0, view_root_offset + view_size<T>::value);
+  std::memcpy(header, view_magic, sizeof(view_magic));
+  header[sizeof(view_magic)] = static_cast<char>(view_version);
+  view_store(header + sizeof(view_magic) + 1, schema_fingerprint<T>());
+
+  write_view(obj, writer, view_root_offset);
+}
+
+template <typename T> std::string to_zero_copy(const T &obj) {
+  binary_writer writer;
+  serialize_view(obj, &writer);
+  return writer.str();
+}
+
+template <typename T> class view;
+
+template <typename T>
+using view_value_t =
+    std::conditional_t<std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                       T, view<T>>;
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value, T> view_at(const char *base,
+                                                  size_t slot) {
+  return base[slot] != 0;
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value && !is_boolean<T>::value, T>
+view_at(const char *base, size_t slot) {
+  return view_load<T>(base + slot);
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum<T>::value, T> view_at(const char *base,
+                                                    size_t slot) {
+  return static_cast<T>(view_load<std::underlying_type_t<T>>(base + slot));
+}
+
+template <typename T>
+std::enable_if_t<!std::is_arithmetic<T>::value && !std::is_enum<T>::value,
+                 view<T>>
+view_at(const char *base, size_t slot) {
+  return view<T>(base, slot);
+}
+
+template <typename Object, typename T>
+bool is_same_member(T Object::*lhs, T Object::*rhs) {
+  return lhs == rhs;
+}
+
+template <typename Object, typename T, typename U>
+bool is_same_member(T Object::* /*unused*/, U Object::* /*unused*/) {
+  return false;
+}
+
+template <typename T> class view {
+public:
+  static_assert(is_object<T>::value || is_string<T>::value ||
+                    is_vector<T>::value || is_array<T>::value,
+                "no view for this type");
+
+  view(const char *base, size_t slot) : m_base(base), m_slot(slot) {}
+
+  template <typename M> view_value_t<M> get(M T::*ptr) const {
+    return view_at<M>(m_base, m_slot + offset_of(ptr));
+  }
+
+#if __cplusplus >= 201703L
+  template <auto Ptr> auto get() const {
+    static const size_t offset = offset_of(Ptr);
+    return view_at<member_type_t<decltype(Ptr)>>(m_base, m_slot + offset);
+  }
+#endif
+
+private:
+#if __cplusplus >= 201703L
+  template <typename P> struct member_type;
+  template <typename M> struct member_type<M T::*> { using type = M; };
+  template <typename P> using member_type_t = typename member_type<P>::type;
+#endif
+
+  template <typename M> static size_t offset_of(M T::*ptr) {
+    auto &members =
+        KeyValueRecords<T, decltype(register_object<T>())>::members;
+    constexpr size_t member_size =
+        std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+    size_t index = 0;
+    size_t found = member_size;
+    auto finder = [&](auto &member) {
+      if (found == member_size && is_same_member(member.m_ptr, ptr)) {
+        found = index;
+      }
+      index++;
+    };
+
+    for_each(finder, members, std::make_index_sequence<member_size>());
+    if (found == member_size) {
+      throw error("member is not registered");
+    }
+
+    return view_layout<T>::offsets[found];
+  }
+
+  const char *m_base;
+  size_t m_slot;
+};
+
+template <> class view<std::string> {
+public:
+  view(const char *base, size_t slot)
+      : m_data(base + view_load<uint32_t>(base + slot)),
+        m_size(view_load<uint32_t>(base + slot + 4)) {}
+
+  const char *data() const noexcept { return m_data; }
+
+  size_t size() const noexcept { return m_size; }
+
+  bool empty() const noexcept { return m_size == 0; }
+
+  std::string str() const { return std::string(m_data, m_size); }
+
+  bool operator==(const char *other) const {
+    return std::strlen(other) == m_size &&
+           std::memcmp(m_data, other, m_size) == 0;
+  }
+
+  bool operator!=(const char *other) const { return !(*this == other); }
+
+private:
+  const char *m_data;
+  size_t m_size;
+};
+
+// span-like view over a vector or a fixed array
+template <typename Element> class sequence_view {
+public:
+  constexpr static size_t stride = view_size<Element>::value;
+
+  class iterator {
+  public:
+    iterator(const sequence_view *sequence, size_t index)
+        : m_sequence(sequence), m_index(index) {}
+
+    view_value_t<Element> operator*() const { return (*m_sequence)[m_index]; }
+
+    iterator &operator++() {
+      m_index++;
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const {
+      return m_index == other.m_index;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return m_index != other.m_index;
+    }
+
+  private:
+    const sequence_view *m_sequence;
+    size_t m_index;
+  };
+
+  sequence_view(const char *base, size_t offset, size_t size)
+      : m_base(base), m_offset(offset), m_size(size) {}
+
+  size_t size() const noexcept { return m_size; }
+
+  bool empty() const noexcept { return m_size == 0; }
+
+  view_value_t<Element> operator[](size_t index) const {
+    return view_at<Element>(m_base, m_offset + index * stride);
+  }
+
+  // direct access for arithmetic elements, requires an 8-byte aligned buffer
+  template <typename E = Element>
+  std::enable_if_t<is_binary_pod<E>::value, const E *> data() const noexcept {
+    return reinterpret_cast<const E *>(m_base + m_offset);
+  }
+
+  iterator begin() const { return iterator(this, 0); }
+
+  iterator end() const { return iterator(this, m_size); }
+
+private:
+  const char *m_base;
+  size_t m_offset;
+  size_t m_size;
+};
+
+template <typename E, typename A>
+class view<std::vector<E, A>> : public sequence_view<E> {
+public:
+  view(const char *base, size_t slot)
+      : sequence_view<E>(base, view_load<uint32_t>(base + slot),
+                         view_load<uint32_t>(base + slot + 4)) {}
+};
+
+template <typename E, size_t N>
+class view<std::array<E, N>> : public sequence_view<E> {
+public:
+  view(const char *base, size_t slot) : sequence_view<E>(base, slot, N) {}
+};
+
+template <typename E, size_t N> class view<E[N]> : public sequence_view<E> {
+public:
+  view(const char *base, size_t slot) : sequence_view<E>(base, slot, N) {}
+};
+
+inline void verify_view_header(const char *data, size_t size,
+                               uint64_t fingerprint, size_t root_size) {
+  if (size < view_root_offset + root_size ||
+      std::memcmp(data, view_magic, sizeof(view_magic)) != 0) {
+    throw error("not a seria zero-copy buffer");
+  }
+
+  if (static_cast<uint8_t>(data[sizeof(view_magic)]) != view_version) {
+    throw error("unsupported zero-copy version");
+  }
+
+  if (view_load<uint64_t>(data + sizeof(view_magic) + 1) != fingerprint) {
+    throw error("schema fingerprint mismatch");
+  }
+}
+
+// checks only the header, use `verify_view` first for untrusted input
+template <typename T> view<T> make_view(const char *data, size_t size) {
+  verify_view_header(data, size, schema_fingerprint<T>(),
+                     view_size<T>::value);
+  return view<T>(data, view_root_offset);
+}
+
+inline void verify_view_ref(const char *data, size_t size, size_t slot,
+                            size_t stride, size_t alignment) {
+  uint64_t offset = view_load<uint32_t>(data + slot);
+  uint64_t count = view_load<uint32_t>(data + slot + 4);
+
+  // references only point forward, which bounds the walk for any input
+  if (offset <= slot || offset > size || offset % alignment != 0 ||
+      (stride != 0 && count > (size - offset) / stride)) {
+    throw error("reference out of bounds");
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_boolean<T>::value>
+verify_view(const char *data, size_t /*size*/, size_t slot,
+            unsigned /*depth*/) {
+  if (static_cast<uint8_t>(data[slot]) > 1) {
+    throw type_error("boolean");
+  }
+}
+
+template <typename T>
+std::enable_if_t<(std::is_arithmetic<T>::value && !is_boolean<T>::value) ||
+                 std::is_enum<T>::value>
+verify_view(const char * /*data*/, size_t /*size*/, size_t /*slot*/,
+            unsigned /*depth*/) {}
+
+template <typename T>
+std::enable_if_t<is_string<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned /*depth*/) {
+  verify_view_ref(data, size, slot, 1, 1);
+}
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned depth);
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned depth);
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned depth);
+
+template <typename T>
+std::enable_if_t<is_vector<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned depth) {
+  using Element = typename T::value_type;
+  constexpr size_t stride = view_size<Element>::value;
+
+  verify_view_ref(data, size, slot, stride, view_alignment);
+  if (is_binary_pod<Element>::value) {
+    return;
+  }
+
+  if (depth >= view_max_depth) {
+    throw error("nesting too deep");
+  }
+
+  auto offset = view_load<uint32_t>(data + slot);
+  auto count = view_load<uint32_t>(data + slot + 4);
+  for (size_t i = 0; i < count; i++) {
+    try {
+      verify_view<Element>(data, size, offset + i * stride, depth + 1);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_array<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned depth) {
+  using Element = std::decay_t<decltype(std::declval<T &>()[0])>;
+  constexpr size_t stride = view_size<Element>::value;
+
+  if (is_binary_pod<Element>::value) {
+    return;
+  }
+
+  for (size_t i = 0; i < is_array<T>::size; i++) {
+    try {
+      verify_view<Element>(data, size, slot + i * stride, depth);
+    } catch (type_error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(std::to_string(i));
+      throw err;
+    }
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_object<T>::value>
+verify_view(const char *data, size_t size, size_t slot, unsigned depth) {
+  auto &members = KeyValueRecords<T, decltype(register_object<T>())>::members;
+  constexpr size_t member_size =
+      std::tuple_size<std::decay_t<decltype(members)>>::value;
+
+  size_t index = 0;
+  auto checker = [&](auto &member) {
+    using Type = typename std::decay_t<decltype(member)>::Type;
+    try {
+      verify_view<Type>(data, size, slot + view_layout<T>::offsets[index++],
+                        depth);
+    } catch (type_error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    } catch (error &err) {
+      err.add_prefix(member.m_key);
+      throw err;
+    }
+  };
+
+  for_each(checker, members, std::make_index_sequence<member_size>());
+}
+
+// full bounds and value check of an untrusted buffer, throws `seria::error`
+template <typename T> void verify_view(const char *data, size_t size) {
+  verify_view_header(data, size, schema_fingerprint<T>(),
+                     view_size<T>::value);
+  verify_view<T>(data, size, view_root_offset, 0);
+}
+
+} // namespace seria
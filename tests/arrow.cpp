@@ -0,0 +1,189 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <seria/arrow.hpp>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int64_t id = 0;
+  double value = 1.0;
+  Gender gender = Gender::Male;
+  bool flag = false;
+  std::string name = "seria";
+  std::array<float, 3> position{};
+  Inside inside{};
+  std::vector<std::string> tags{};
+  std::vector<Inside> children{};
+};
+
+struct Other {
+  int64_t id = 0;
+  float value = 1.0f;
+};
+
+// same field names as `Other`, wider value
+struct Wide {
+  int64_t id = 0;
+  double value = 1.0;
+};
+
+namespace seria {
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("id", &Person::id),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender),
+                         member("flag", &Person::flag),
+                         member("name", &Person::name),
+                         member("position", &Person::position),
+                         member("inside", &Person::inside),
+                         member("tags", &Person::tags),
+                         member("children", &Person::children));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+template <> auto register_object<Other>() {
+  return std::make_tuple(member("id", &Other::id),
+                         member("value", &Other::value));
+}
+
+template <> auto register_object<Wide>() {
+  return std::make_tuple(member("id", &Wide::id),
+                         member("value", &Wide::value));
+}
+
+} // namespace seria
+
+static std::vector<Person> make_people(size_t count) {
+  std::vector<Person> people(count);
+  for (size_t i = 0; i < count; i++) {
+    people[i].id = static_cast<int64_t>(i) << 33;
+    people[i].value = static_cast<double>(i) * 0.5;
+    people[i].gender = i % 2 == 0 ? Gender::Male : Gender::Female;
+    people[i].flag = i % 3 == 0;
+    people[i].name = std::string(i, 'a');
+    people[i].position = {1.0f, 2.0f, static_cast<float>(i)};
+    people[i].inside.i_v.resize(i % 4);
+    people[i].tags.assign(i % 3, std::to_string(i));
+    people[i].children.resize(i % 2);
+  }
+  return people;
+}
+
+static uint32_t load_u32(const std::string &data, size_t position) {
+  uint32_t value;
+  std::memcpy(&value, data.data() + position, sizeof(value));
+  return value;
+}
+
+TEST_CASE("stream framing", "[arrow]") {
+  auto data = seria::arrow::to_ipc(make_people(3));
+
+  REQUIRE(load_u32(data, 0) == seria::arrow::continuation);
+  REQUIRE(load_u32(data, 4) % 8 == 0);
+
+  // end of stream marker
+  REQUIRE(load_u32(data, data.size() - 8) == seria::arrow::continuation);
+  REQUIRE(load_u32(data, data.size() - 4) == 0);
+}
+
+TEST_CASE("buffers are 64-byte aligned", "[arrow]") {
+  auto data = seria::arrow::to_ipc(make_people(5));
+
+  // skip the schema message
+  size_t position = 8 + load_u32(data, 4);
+  REQUIRE(position % 64 == 0);
+
+  auto length = load_u32(data, position + 4);
+  auto message =
+      seria::arrow::flatbuffer_table::root(data.data() + position + 8, length);
+  REQUIRE(message.scalar<uint8_t>(1, 0) == seria::arrow::header_record_batch);
+
+  auto body = position + 8 + length;
+  REQUIRE(body % 64 == 0);
+
+  auto batch = message.table(2);
+  REQUIRE(batch.scalar<int64_t>(0, 0) == 5);
+
+  auto buffers = batch.vector(2, 16);
+  REQUIRE(buffers.second > 0);
+  for (size_t i = 0; i < buffers.second; i++) {
+    REQUIRE(batch.load<int64_t>(buffers.first + 16 * i) % 64 == 0);
+  }
+}
+
+TEST_CASE("round trip nested columns", "[arrow]") {
+  auto people = make_people(10);
+  auto data = seria::arrow::to_ipc(people);
+
+  std::vector<Person> result{};
+  seria::arrow::read_ipc(result, data.data(), data.size());
+
+  REQUIRE(result.size() == 10);
+  for (size_t i = 0; i < result.size(); i++) {
+    REQUIRE(result[i].id == people[i].id);
+    REQUIRE(result[i].value == people[i].value);
+    REQUIRE(result[i].gender == people[i].gender);
+    REQUIRE(result[i].flag == people[i].flag);
+    REQUIRE(result[i].name == people[i].name);
+    REQUIRE(result[i].position == people[i].position);
+    REQUIRE(result[i].inside.i_v == people[i].inside.i_v);
+    REQUIRE(result[i].tags == people[i].tags);
+    REQUIRE(result[i].children.size() == people[i].children.size());
+  }
+}
+
+TEST_CASE("streams are appended", "[arrow]") {
+  auto data = seria::arrow::to_ipc(make_people(2));
+
+  std::vector<Person> result{};
+  seria::arrow::read_ipc(result, data.data(), data.size());
+  seria::arrow::read_ipc(result, data.data(), data.size());
+
+  REQUIRE(result.size() == 4);
+  REQUIRE(result[3].name == "a");
+}
+
+TEST_CASE("schema mismatch", "[arrow]") {
+  std::vector<Other> others(2);
+  auto data = seria::arrow::to_ipc(others);
+
+  std::vector<Person> result{};
+  REQUIRE_THROWS_AS(seria::arrow::read_ipc(result, data.data(), data.size()),
+                    seria::error);
+}
+
+TEST_CASE("field type mismatch", "[arrow]") {
+  std::vector<Other> others(2);
+  auto data = seria::arrow::to_ipc(others);
+
+  std::vector<Wide> result{};
+  try {
+    seria::arrow::read_ipc(result, data.data(), data.size());
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "value") == 0);
+  }
+}
+
+TEST_CASE("truncated stream", "[arrow]") {
+  auto data = seria::arrow::to_ipc(make_people(3));
+  data.resize(data.size() - 40);
+
+  std::vector<Person> result{};
+  REQUIRE_THROWS_AS(seria::arrow::read_ipc(result, data.data(), data.size()),
+                    seria::error);
+}
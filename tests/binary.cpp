@@ -0,0 +1,588 @@
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <seria/deserialize/binary.hpp>
+#include <seria/hash.hpp>
+#include <seria/record_file.hpp>
+#include <seria/serialize/binary.hpp>
+#include <seria/shm_channel.hpp>
+#include <seria/snapshot.hpp>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Sample {
+  int32_t id = 0;
+  double time = 0.0;
+  std::array<float, 3> position{};
+  std::string label;
+};
+
+struct Person {
+  int age = 1;
+  float value = 1.0f;
+  Gender gender = Gender::Male;
+  uint32_t test_uint = 1;
+  Inside inside{};
+  std::string name = "seria";
+  bool flag = false;
+};
+
+struct Particle {
+  float x = 0.0f;
+  float y = 0.0f;
+  float z = 0.0f;
+  std::array<double, 2> weights{};
+  int32_t id = 0;
+};
+
+struct Node {
+  int value = 0;
+  std::vector<Node> kids;
+};
+
+namespace seria {
+
+template <> struct is_columnar<Sample> : std::true_type {};
+
+template <> auto register_object<Sample>() {
+  return std::make_tuple(member("id", &Sample::id),
+                         member("time", &Sample::time),
+                         member("position", &Sample::position),
+                         member("label", &Sample::label, std::string("none")));
+}
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("age", &Person::age, 50),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender, Gender::Male),
+                         member("test_uint", &Person::test_uint),
+                         member("inside", &Person::inside),
+                         member("name", &Person::name),
+                         member("flag", &Person::flag));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age, 100),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+template <> auto register_object<Particle>() {
+  return std::make_tuple(member("x", &Particle::x), member("y", &Particle::y),
+                         member("z", &Particle::z),
+                         member("weights", &Particle::weights),
+                         member("id", &Particle::id));
+}
+
+template <> auto register_object<Node>() {
+  return std::make_tuple(member("value", &Node::value),
+                         member("kids", &Node::kids));
+}
+
+} // namespace seria
+
+TEST_CASE("serialize std::vector", "[serialize]") {
+  vector<int32_t> a = {1, 2, 3, 4, 5};
+
+  seria::binary_writer writer;
+  seria::serialize(a, &writer);
+
+  uint8_t target[] = {0x05, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+                      0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+                      0x00, 0x05, 0x00, 0x00, 0x00};
+  REQUIRE(writer.size() == sizeof(target));
+  REQUIRE(std::memcmp(writer.data(), target, sizeof(target)) == 0);
+}
+
+TEST_CASE("string", "[serialize]") {
+  std::string value = "hello";
+
+  seria::binary_writer writer;
+  seria::serialize(value, &writer);
+
+  uint8_t target[] = {0x05, 0x68, 0x65, 0x6c, 0x6c, 0x6f};
+  REQUIRE(writer.size() == sizeof(target));
+  REQUIRE(std::memcmp(writer.data(), target, sizeof(target)) == 0);
+}
+
+TEST_CASE("varint length", "[serialize]") {
+  std::string value(300, 'a');
+
+  seria::binary_writer writer;
+  seria::serialize(value, &writer);
+
+  REQUIRE(writer.size() == 302);
+  REQUIRE(static_cast<uint8_t>(writer.data()[0]) == 0xAC);
+  REQUIRE(static_cast<uint8_t>(writer.data()[1]) == 0x02);
+}
+
+TEST_CASE("coalesced members keep the member-wise layout", "[serialize]") {
+  Particle particle{1.0f, 2.0f, 3.0f, {4.0, 5.0}, 6};
+
+  seria::binary_writer writer;
+  seria::serialize(particle, &writer);
+
+  seria::binary_writer expected;
+  seria::serialize(particle.x, &expected);
+  seria::serialize(particle.y, &expected);
+  seria::serialize(particle.z, &expected);
+  seria::serialize(particle.weights[0], &expected);
+  seria::serialize(particle.weights[1], &expected);
+  seria::serialize(particle.id, &expected);
+
+  REQUIRE(writer.size() == expected.size());
+  REQUIRE(std::memcmp(writer.data(), expected.data(), writer.size()) == 0);
+}
+
+TEST_CASE("fixed buffer overflow", "[serialize]") {
+  char buffer[4];
+  seria::binary_writer writer(buffer, sizeof(buffer));
+
+  std::string value = "hello";
+  REQUIRE_THROWS_AS(seria::serialize(value, &writer), seria::error);
+}
+
+TEST_CASE("round trip nested object", "[deserialize]") {
+  Person person{};
+  person.age = 33;
+  person.value = 0.5f;
+  person.gender = Gender::Female;
+  person.test_uint = 7;
+  person.inside.i_v = {6, 66, 666};
+  person.name = "binary";
+  person.flag = true;
+
+  auto data = seria::to_binary(person);
+
+  Person result{};
+  seria::from_binary(result, data.data(), data.size());
+
+  REQUIRE(result.age == 33);
+  REQUIRE(result.value == 0.5f);
+  REQUIRE(result.gender == Gender::Female);
+  REQUIRE(result.test_uint == 7);
+  REQUIRE(result.inside.i_v == std::vector<int>{6, 66, 666});
+  REQUIRE(result.name == "binary");
+  REQUIRE(result.flag);
+}
+
+TEST_CASE("recursive type from two threads", "[deserialize]") {
+  Node tree;
+  tree.value = 1;
+  tree.kids.resize(2);
+  tree.kids[1].value = 2;
+  tree.kids[1].kids.resize(1);
+  tree.kids[1].kids[0].value = 3;
+
+  // the two threads start from different types of the same cycle
+  std::string node_data;
+  std::thread thread([&] { node_data = seria::to_binary(tree); });
+  auto kids_data = seria::to_binary(tree.kids);
+  thread.join();
+
+  Node result;
+  seria::from_binary(result, node_data.data(), node_data.size());
+  REQUIRE(result.value == 1);
+  REQUIRE(result.kids.size() == 2);
+  REQUIRE(result.kids[1].kids[0].value == 3);
+
+  std::vector<Node> kids;
+  seria::from_binary(kids, kids_data.data(), kids_data.size());
+  REQUIRE(kids.size() == 2);
+  REQUIRE(kids[1].value == 2);
+}
+
+TEST_CASE("round trip vector of objects", "[deserialize]") {
+  std::vector<Particle> particles(100);
+  for (size_t i = 0; i < particles.size(); i++) {
+    particles[i].x = static_cast<float>(i);
+    particles[i].weights[1] = static_cast<double>(i) / 2;
+    particles[i].id = static_cast<int32_t>(i);
+  }
+
+  auto data = seria::to_binary(particles);
+
+  std::vector<Particle> result{};
+  seria::from_binary(result, data.data(), data.size());
+
+  REQUIRE(result.size() == 100);
+  REQUIRE(result[42].x == 42.0f);
+  REQUIRE(result[42].weights[1] == 21.0);
+  REQUIRE(result[99].id == 99);
+}
+
+TEST_CASE("structural hash", "[hash]") {
+  Person person{};
+  person.inside.i_v.assign(100, 7);
+  auto hash = seria::hash(person);
+  REQUIRE(seria::hash(person) == hash);
+  // the same on every platform and in every run
+  REQUIRE(seria::hash(std::string("seria")) == 0x4d2578fda149a9cfULL);
+
+  auto copy = person;
+  copy.inside.i_v[99] = 8;
+  REQUIRE(seria::hash(copy) != hash);
+  copy.inside.i_v[99] = 7;
+  copy.flag = true;
+  REQUIRE(seria::hash(copy) != hash);
+
+  // lengths keep values apart from their neighbours
+  std::vector<std::string> split{"ab", "c"};
+  std::vector<std::string> moved{"a", "bc"};
+  REQUIRE(seria::hash(split) != seria::hash(moved));
+
+  // the elements hashed at once or one by one give the same bytes
+  std::vector<int32_t> values(1000);
+  seria::hash_builder builder;
+  builder.add_size(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = static_cast<int32_t>(i * 7919);
+    builder.add_value(values[i]);
+  }
+  REQUIRE(seria::hash(values) == builder.value());
+
+  seria::hash_options options;
+  options.names = true;
+  REQUIRE(seria::hash(person, options) != hash);
+  REQUIRE(seria::hash(person, options) == seria::hash(person, options));
+  options.names = false;
+  options.seed = 1;
+  REQUIRE(seria::hash(person, options) != hash);
+}
+
+TEST_CASE("schema fingerprint mismatch", "[deserialize]") {
+  Inside inside{};
+  auto data = seria::to_binary(inside);
+
+  Person person{};
+  REQUIRE_THROWS_AS(seria::from_binary(person, data.data(), data.size()),
+                    seria::error);
+}
+
+TEST_CASE("truncated input", "[deserialize]") {
+  Person person{};
+  auto data = seria::to_binary(person);
+  data.resize(data.size() - 3);
+
+  try {
+    seria::from_binary(person, data.data(), data.size());
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "name") == 0);
+  }
+}
+
+TEST_CASE("invalid boolean", "[deserialize]") {
+  uint8_t data[] = {0x02};
+  bool value = false;
+
+  seria::binary_reader reader(reinterpret_cast<const char *>(data),
+                              sizeof(data));
+  try {
+    seria::deserialize(value, &reader);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.desired_type(), "boolean") == 0);
+  }
+}
+
+TEST_CASE("columnar vector of objects", "[columnar]") {
+  std::vector<Sample> samples(4);
+  for (size_t i = 0; i < samples.size(); i++) {
+    samples[i].id = static_cast<int32_t>(i);
+    samples[i].time = static_cast<double>(i) * 0.5;
+    samples[i].position = {1.0f, 2.0f, static_cast<float>(i)};
+    samples[i].label = std::to_string(i);
+  }
+
+  seria::binary_writer writer;
+  seria::serialize(samples, &writer);
+
+  // count, then the id column
+  REQUIRE(writer.data()[0] == 4);
+  int32_t ids[4];
+  std::memcpy(ids, writer.data() + 1, sizeof(ids));
+  REQUIRE((ids[0] == 0 && ids[1] == 1 && ids[2] == 2 && ids[3] == 3));
+
+  std::vector<Sample> result{};
+  seria::binary_reader reader(writer.data(), writer.size());
+  seria::deserialize(result, &reader);
+
+  REQUIRE(reader.remaining() == 0);
+  REQUIRE(result.size() == 4);
+  REQUIRE(result[3].time == 1.5);
+  REQUIRE(result[3].position[2] == 3.0f);
+  REQUIRE(result[2].label == "2");
+}
+
+TEST_CASE("table-driven encoding matches templates", "[descriptor]") {
+  Person person{};
+  person.gender = Gender::Female;
+  person.inside.i_v = {6, 66, 666};
+  person.name = "table";
+  person.flag = true;
+
+  auto data = seria::to_binary(person);
+  REQUIRE(seria::to_binary_table(person) == data);
+
+  Person result{};
+  seria::from_binary_table(result, data.data(), data.size());
+  REQUIRE(result.gender == Gender::Female);
+  REQUIRE(result.inside.i_v == std::vector<int>{6, 66, 666});
+  REQUIRE(result.name == "table");
+  REQUIRE(result.flag);
+
+  std::vector<Particle> particles(10);
+  particles[3].weights[1] = 1.5;
+  particles[3].id = 3;
+  data = seria::to_binary(particles);
+  REQUIRE(seria::to_binary_table(particles) == data);
+
+  std::vector<Particle> particle_result{};
+  seria::from_binary_table(particle_result, data.data(), data.size());
+  REQUIRE(particle_result.size() == 10);
+  REQUIRE(particle_result[3].weights[1] == 1.5);
+  REQUIRE(particle_result[3].id == 3);
+
+  std::vector<Sample> samples(3);
+  samples[2].position = {1.0f, 2.0f, 3.0f};
+  samples[2].label = "2";
+  data = seria::to_binary(samples);
+  REQUIRE(seria::to_binary_table(samples) == data);
+
+  std::vector<Sample> sample_result{};
+  seria::from_binary_table(sample_result, data.data(), data.size());
+  REQUIRE(sample_result.size() == 3);
+  REQUIRE(sample_result[2].position[2] == 3.0f);
+  REQUIRE(sample_result[2].label == "2");
+}
+
+TEST_CASE("table-driven decoding errors", "[descriptor]") {
+  Person person{};
+  auto data = seria::to_binary(person);
+  data.resize(data.size() - 3);
+
+  try {
+    seria::from_binary_table(person, data.data(), data.size());
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "name") == 0);
+  }
+
+  data = seria::to_binary(person);
+  data.back() = 2;
+  try {
+    seria::from_binary_table(person, data.data(), data.size());
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "flag") == 0);
+  }
+}
+
+TEST_CASE("record file", "[records]") {
+  auto path = "/tmp/seria-records-" + std::to_string(getpid());
+  std::vector<Person> people(1000);
+  for (size_t i = 0; i < people.size(); i++) {
+    people[i].age = static_cast<int>(i);
+    people[i].name = std::string(i % 37, 'n');
+  }
+  seria::write_records(path.c_str(), people);
+
+  seria::record_file<Person> file(path.c_str());
+  REQUIRE(file.size() == 1000);
+  REQUIRE(file.get(0).age == 0);
+  REQUIRE(file.get(999).name == people[999].name);
+  REQUIRE_THROWS_AS(file.get(1000), seria::error);
+  REQUIRE_THROWS_WITH(seria::record_file<Particle>(path.c_str()),
+                      "schema fingerprint mismatch");
+
+  int expected = 100;
+  for (auto &person : file.range(100, 200)) {
+    REQUIRE(person.age == expected++);
+  }
+  REQUIRE(expected == 200);
+
+  std::vector<int> seen(1000, 0);
+  file.parallel_scan([&](size_t i, const Person &person) {
+    seen[i] = person.age == static_cast<int>(i) ? 1 : 2;
+  }, 4);
+  REQUIRE(std::count(seen.begin(), seen.end(), 1) == 1000);
+
+  // appended records get their place in a new index
+  {
+    seria::record_writer<Person> writer(path.c_str(), true);
+    REQUIRE(writer.size() == 1000);
+    people[0].age = 1000;
+    writer.write(people[0]);
+  }
+  seria::record_file<Person> appended(path.c_str());
+  REQUIRE(appended.size() == 1001);
+  REQUIRE(appended.get(1000).age == 1000);
+  REQUIRE(appended.get(500).age == 500);
+
+  // a damaged record is reported, the others are still read
+  {
+    auto *stream = std::fopen(path.c_str(), "r+b");
+    std::fseek(stream, static_cast<long>(seria::record_header_size) + 3,
+               SEEK_SET);
+    std::fputc('!', stream);
+    std::fclose(stream);
+  }
+  seria::record_file<Person> damaged(path.c_str());
+  REQUIRE_THROWS_WITH(damaged.get(0), "0: frame checksum mismatch");
+  REQUIRE(damaged.get(1).age == 1);
+  REQUIRE_THROWS_AS(damaged.parallel_scan([](size_t, const Person &) {}, 3),
+                    seria::error);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("json snapshot cache", "[snapshot]") {
+  char directory[] = "/tmp/seria-snapshot-XXXXXX";
+  REQUIRE(mkdtemp(directory) != nullptr);
+  auto json_path = std::string(directory) + "/config.json";
+  auto cache_dir = std::string(directory) + "/cache";
+  auto write_json = [&](const char *text) {
+    auto *file = std::fopen(json_path.c_str(), "wb");
+    std::fputs(text, file);
+    std::fclose(file);
+  };
+
+  write_json(R"({"age":7,"value":1.5,"test_uint":3,"name":"first",)"
+             R"("flag":true,"inside":{"i_value":2.0,"i_v":[9,8]}})");
+  Person person;
+  auto result = seria::load_cached(person, json_path, cache_dir);
+  REQUIRE(!result.from_snapshot);
+  REQUIRE(result.written);
+  REQUIRE(result.write_error.empty());
+
+  Person cached;
+  result = seria::load_cached(cached, json_path, cache_dir);
+  REQUIRE(result.from_snapshot);
+  REQUIRE(result.reason.empty());
+  REQUIRE(cached.name == "first");
+  REQUIRE(cached.inside.i_v == std::vector<int>{9, 8});
+  REQUIRE(seria::hash(cached) == seria::hash(person));
+
+  // other types have their own snapshots
+  REQUIRE(seria::snapshot_path<Particle>(json_path, cache_dir) !=
+          seria::snapshot_path<Person>(json_path, cache_dir));
+
+  // the same size, maybe the same modification time, other bytes
+  write_json(R"({"age":7,"value":1.5,"test_uint":3,"name":"other",)"
+             R"("flag":true,"inside":{"i_value":2.0,"i_v":[9,8]}})");
+  result = seria::load_cached(cached, json_path, cache_dir);
+  REQUIRE(!result.from_snapshot);
+  REQUIRE(cached.name == "other");
+  REQUIRE(seria::load_cached(cached, json_path, cache_dir).from_snapshot);
+
+  // a damaged snapshot is replaced
+  auto path = seria::snapshot_path<Person>(json_path, cache_dir);
+  auto *file = std::fopen(path.c_str(), "r+b");
+  std::fseek(file, -1, SEEK_END);
+  std::fputc('!', file);
+  std::fclose(file);
+  result = seria::load_cached(cached, json_path, cache_dir);
+  REQUIRE(result.reason == "snapshot corrupted");
+  REQUIRE(result.written);
+  REQUIRE(cached.name == "other");
+
+  seria::snapshot_options options;
+  options.hash_content = false;
+  REQUIRE(seria::load_cached(cached, json_path, cache_dir, options)
+              .from_snapshot);
+
+  write_json("{");
+  REQUIRE_THROWS_AS(seria::load_cached(cached, json_path, cache_dir),
+                    seria::error);
+  REQUIRE_THROWS_AS(
+      seria::load_cached(cached, json_path + ".missing", cache_dir),
+      seria::error);
+
+  std::remove(path.c_str());
+  std::remove(json_path.c_str());
+  std::remove(cache_dir.c_str());
+  std::remove(directory);
+}
+
+TEST_CASE("shared memory channel", "[shm]") {
+  auto name = "/seria-test-" + std::to_string(getpid());
+  auto producer =
+      seria::shm_channel<Person>::create(name.c_str(), 4096, 256);
+  auto consumer = seria::shm_channel<Person>::open(name.c_str());
+  seria::shm_channel<Person>::unlink(name.c_str());
+  REQUIRE_THROWS_WITH(seria::shm_channel<Particle>::attach(dup(producer.fd())),
+                      "schema fingerprint mismatch");
+
+  // filled and drained a few times, records skip the end of the ring
+  Person person;
+  Person received;
+  int sent = 0;
+  for (int round = 0; round < 5; round++) {
+    int count = 0;
+    person.name = std::string(static_cast<size_t>(round * 17), 'n');
+    while (producer.try_send(person)) {
+      person.age = ++sent;
+      count++;
+    }
+    REQUIRE(count >= 4096 / 2 / 256);
+    for (int i = 0; i < count; i++) {
+      REQUIRE(consumer.try_receive(received));
+      REQUIRE(received.name == person.name);
+    }
+    REQUIRE(!consumer.try_receive(received));
+  }
+  REQUIRE(received.age == sent - 1);
+
+  person.name = std::string(300, 'x');
+  REQUIRE_THROWS_AS(producer.try_send(person), seria::error);
+  REQUIRE(!consumer.try_receive(received));
+
+  // from another thread
+  person.name = "seria";
+  std::thread thread([&] {
+    for (int i = 0; i < 20000; i++) {
+      person.age = i;
+      producer.send(person);
+    }
+  });
+  bool ordered = true;
+  for (int i = 0; i < 20000; i++) {
+    consumer.receive(received);
+    ordered = ordered && received.age == i;
+  }
+  thread.join();
+  REQUIRE(ordered);
+}
+
+TEST_CASE("shared memory channel of views", "[shm]") {
+  auto name = "/seria-test-view-" + std::to_string(getpid());
+  using channel = seria::shm_channel<Particle, seria::shm_view_codec>;
+  auto producer = channel::create(name.c_str(), 1 << 12, 128);
+  auto consumer = channel::open(name.c_str());
+  channel::unlink(name.c_str());
+
+  Particle particle;
+  particle.y = 2.5f;
+  particle.id = 7;
+  REQUIRE(producer.try_send(particle));
+  float y = 0;
+  int32_t id = 0;
+  REQUIRE(consumer.try_consume([&](const char *data, size_t size) {
+    auto view = seria::make_view<Particle>(data, size);
+    y = view.get(&Particle::y);
+    id = view.get(&Particle::id);
+  }));
+  REQUIRE((y == 2.5f && id == 7));
+}
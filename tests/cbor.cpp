@@ -0,0 +1,298 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstring>
+#include <seria/deserialize/cbor.hpp>
+#include <seria/serialize/cbor.hpp>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int age = 1;
+  float value = 1.0f;
+  Gender gender = Gender::Male;
+  uint32_t test_uint = 1;
+  Inside inside{};
+};
+
+enum class Child { Boy, Girl };
+
+namespace seria {
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("age", &Person::age, 50),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender, Gender::Male),
+                         member("test_uint", &Person::test_uint),
+                         member("inside", &Person::inside));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age, 100),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+template <> void serialize(const Child &data, cbor_writer *writer) {
+  writer->write_text(data == Child::Boy ? "B" : "G", 1);
+}
+
+template <> void deserialize(Child &data, cbor_reader *reader) {
+  std::string value;
+  deserialize(value, reader);
+  if (value != "B" && value != "G") {
+    throw type_error("", "should be `B` or `G`");
+  }
+
+  data = value == "B" ? Child::Boy : Child::Girl;
+}
+
+} // namespace seria
+
+template <size_t N>
+static bool same_bytes(const std::string &data, const uint8_t (&target)[N]) {
+  return data.size() == N && std::memcmp(data.data(), target, N) == 0;
+}
+
+TEST_CASE("serialize c style array", "[serialize]") {
+  int a[] = {1, 2, 3, 4, 5};
+
+  uint8_t target[] = {0x85, 0x1, 0x2, 0x3, 0x4, 0x5};
+  REQUIRE(same_bytes(seria::to_cbor(a), target));
+}
+
+TEST_CASE("serialize std::vector", "[serialize]") {
+  vector<int> a = {1, 2, 3, 4, 5};
+
+  // tag 78 (sint32 little endian), then a 20 bytes byte string
+  uint8_t target[] = {0xD8, 0x4E, 0x54, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00,
+                      0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+                      0x00, 0x05, 0x00, 0x00, 0x00};
+  REQUIRE(same_bytes(seria::to_cbor(a), target));
+}
+
+TEST_CASE("customize enum serialize rule", "[serialize]") {
+  std::vector<Child> children{Child::Boy, Child::Girl, Child::Girl};
+
+  uint8_t target[] = {0x83, 0x61, 0x42, 0x61, 0x47, 0x61, 0x47};
+  REQUIRE(same_bytes(seria::to_cbor(children), target));
+}
+
+TEST_CASE("binary bytes", "[serialize]") {
+  std::vector<uint8_t> value{8, 7, 6, 5, 4};
+
+  uint8_t target[] = {0x45, 0x08, 0x07, 0x06, 0x05, 0x04};
+  REQUIRE(same_bytes(seria::to_cbor(value), target));
+}
+
+TEST_CASE("string", "[serialize]") {
+  std::string value = "hello";
+
+  uint8_t target[] = {0x65, 0x68, 0x65, 0x6c, 0x6c, 0x6f};
+  REQUIRE(same_bytes(seria::to_cbor(value), target));
+}
+
+TEST_CASE("shortest integer heads", "[serialize]") {
+  std::vector<int64_t> values{23, 24, -1, -500, 100000};
+  seria::cbor_writer writer;
+  for (auto value : values) {
+    seria::serialize(value, &writer);
+  }
+
+  uint8_t target[] = {0x17, 0x18, 0x18, 0x20, 0x39, 0x01,
+                      0xF3, 0x1A, 0x00, 0x01, 0x86, 0xA0};
+  REQUIRE(same_bytes(writer.str(), target));
+}
+
+TEST_CASE("deserialize c style array", "[deserialize]") {
+  uint8_t data[] = {0x83, 0x01, 0x02, 0x03};
+  int a[] = {0, 0, 0};
+
+  seria::from_cbor(a, reinterpret_cast<const char *>(data), sizeof(data));
+  REQUIRE((a[0] == 1 && a[1] == 2 && a[2] == 3));
+}
+
+TEST_CASE("deserialize indefinite length array", "[deserialize]") {
+  uint8_t data[] = {0x9F, 0x01, 0x02, 0x03, 0xFF};
+  std::vector<int> a{};
+
+  seria::from_cbor(a, reinterpret_cast<const char *>(data), sizeof(data));
+  REQUIRE(a == std::vector<int>{1, 2, 3});
+}
+
+TEST_CASE("deserialize nested object", "[deserialize]") {
+  Person source{};
+  source.age = 0;
+  source.value = 233.0f;
+  source.gender = Gender::Female;
+  source.test_uint = 2;
+  source.inside.i_age = 233;
+  source.inside.i_value = 0.233f;
+  source.inside.i_v = {6, 66, 666};
+  auto data = seria::to_cbor(source);
+
+  Person person{100, 2.0f};
+  seria::from_cbor(person, data.data(), data.size());
+
+  REQUIRE(person.age == 0);
+  REQUIRE(person.gender == Gender::Female);
+  REQUIRE(person.value == 233.0f);
+  REQUIRE(person.test_uint == 2);
+  REQUIRE(person.inside.i_age == 233);
+  REQUIRE(person.inside.i_value == 0.233f);
+  REQUIRE(person.inside.i_v == std::vector<int>{6, 66, 666});
+}
+
+TEST_CASE("deserialize a object with default value", "[deserialize]") {
+  seria::cbor_writer writer;
+  writer.start_map(4);
+  writer.write_text("value", 5);
+  writer.write_double(0.2);
+  writer.write_text("unknown", 7);
+  writer.start_array(2);
+  writer.write_uint(1);
+  writer.write_text("x", 1);
+  writer.write_text("test_uint", 9);
+  writer.write_uint(2);
+  writer.write_text("inside", 6);
+  writer.start_map(2);
+  writer.write_text("i_value", 7);
+  writer.write_double(0.233);
+  writer.write_text("i_v", 3);
+  writer.start_array(1);
+  writer.write_uint(6);
+
+  Person person{};
+  seria::from_cbor(person, writer.data(), writer.size());
+
+  REQUIRE(person.age == 50);
+  REQUIRE(person.value == 0.2f);
+  REQUIRE(person.gender == Gender::Male);
+  REQUIRE(person.inside.i_age == 100);
+  REQUIRE(person.inside.i_v == std::vector<int>{6});
+}
+
+TEST_CASE("customize enum deserialize rule", "[deserialize]") {
+  uint8_t data[] = {0x83, 0x61, 0x42, 0x61, 0x47, 0x61, 0x47};
+  std::vector<Child> children{};
+
+  seria::from_cbor(children, reinterpret_cast<const char *>(data),
+                   sizeof(data));
+
+  REQUIRE(children.size() == 3);
+  REQUIRE(children[0] == Child::Boy);
+  REQUIRE(children[1] == Child::Girl);
+  REQUIRE(children[2] == Child::Girl);
+}
+
+TEST_CASE("half precision and integer to float", "[deserialize]") {
+  uint8_t data[] = {0x83, 0xF9, 0x3E, 0x00, 0x38, 0x63, 0xF9, 0xFC, 0x00};
+  std::vector<double> values{};
+
+  seria::from_cbor(values, reinterpret_cast<const char *>(data), sizeof(data));
+
+  REQUIRE(values.size() == 3);
+  REQUIRE(values[0] == 1.5);
+  REQUIRE(values[1] == -100.0);
+  REQUIRE(std::isinf(values[2]));
+}
+
+TEST_CASE("float to int should fail", "[deserialize]") {
+  uint8_t data[] = {0xFB, 0x3F, 0xF3, 0x33, 0x33,
+                    0x33, 0x33, 0x33, 0x33}; // 1.2
+  int value = 0;
+
+  try {
+    seria::from_cbor(value, reinterpret_cast<const char *>(data),
+                     sizeof(data));
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.desired_type(), "integer") == 0);
+  }
+}
+
+TEST_CASE("integer out of range", "[deserialize]") {
+  uint8_t data[] = {0x19, 0x01, 0x00}; // 256
+  uint8_t value = 0;
+
+  REQUIRE_THROWS_AS(seria::from_cbor(value,
+                                     reinterpret_cast<const char *>(data),
+                                     sizeof(data)),
+                    seria::type_error);
+}
+
+TEST_CASE("deserialize type error", "[deserialize]") {
+  seria::cbor_writer writer;
+  writer.start_map(3);
+  writer.write_text("value", 5);
+  writer.write_uint(1);
+  writer.write_text("test_uint", 9);
+  writer.write_uint(2);
+  writer.write_text("inside", 6);
+  writer.start_map(2);
+  writer.write_text("i_value", 7);
+  writer.write_uint(1);
+  writer.write_text("i_v", 3);
+  writer.start_array(2);
+  writer.write_uint(1);
+  writer.write_double(1.2);
+
+  Person person{};
+  try {
+    seria::from_cbor(person, writer.data(), writer.size());
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "inside.i_v.1") == 0);
+    REQUIRE(std::strcmp(err.desired_type(), "integer") == 0);
+  }
+}
+
+TEST_CASE("deserialize missing value", "[deserialize]") {
+  seria::cbor_writer writer;
+  writer.start_map(3);
+  writer.write_text("value", 5);
+  writer.write_uint(1);
+  writer.write_text("test_uint", 9);
+  writer.write_uint(2);
+  writer.write_text("inside", 6);
+  writer.start_map(1);
+  writer.write_text("i_v", 3);
+  writer.start_array(0);
+
+  Person person{};
+  try {
+    seria::from_cbor(person, writer.data(), writer.size());
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "inside.i_value") == 0);
+  }
+}
+
+TEST_CASE("typed array round trip", "[deserialize]") {
+  std::vector<float> values{0.5f, -1.0f, 3.25f};
+  auto data = seria::to_cbor(values);
+
+  std::vector<float> result{};
+  seria::from_cbor(result, data.data(), data.size());
+  REQUIRE(result == values);
+
+  std::vector<int16_t> mismatch{};
+  REQUIRE_THROWS_AS(seria::from_cbor(mismatch, data.data(), data.size()),
+                    seria::type_error);
+}
+
+TEST_CASE("truncated input", "[deserialize]") {
+  auto data = seria::to_cbor(Person{});
+  data.resize(data.size() - 2);
+
+  Person person{};
+  REQUIRE_THROWS_AS(seria::from_cbor(person, data.data(), data.size()),
+                    seria::error);
+}
@@ -0,0 +1,224 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <seria/deserialize/csv.hpp>
+#include <seria/serialize/csv.hpp>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int age = 1;
+  double value = 1.0;
+  Gender gender = Gender::Male;
+  uint32_t test_uint = 1;
+  Inside inside{};
+  std::string name = "seria";
+  bool flag = false;
+};
+
+struct Point {
+  std::array<float, 2> xy{};
+  std::string label;
+};
+
+struct Note {
+  std::string text;
+};
+
+namespace seria {
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("age", &Person::age, 50),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender, Gender::Male),
+                         member("test_uint", &Person::test_uint),
+                         member("inside", &Person::inside),
+                         member("name", &Person::name),
+                         member("flag", &Person::flag));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age, 100),
+                         member("i_value", &Inside::i_value));
+}
+
+template <> auto register_object<Point>() {
+  return std::make_tuple(member("xy", &Point::xy),
+                         member("label", &Point::label));
+}
+
+template <> auto register_object<Note>() {
+  return std::make_tuple(member("text", &Note::text));
+}
+
+} // namespace seria
+
+TEST_CASE("header and rows", "[serialize]") {
+  std::vector<Person> people(2);
+  people[1].age = -3;
+  people[1].value = 0.5;
+  people[1].gender = Gender::Female;
+  people[1].name = "csv";
+  people[1].flag = true;
+
+  auto text = seria::to_csv(people);
+  REQUIRE(text == "age,value,gender,test_uint,inside.i_age,inside.i_value,"
+                  "name,flag\n"
+                  "1,1.0,0,1,1,1.0,seria,false\n"
+                  "-3,0.5,1,1,1,1.0,csv,true\n");
+}
+
+TEST_CASE("quoted fields", "[serialize]") {
+  std::vector<Point> points(1);
+  points[0].label = "a,\"b\"\nc";
+
+  seria::csv_options options;
+  options.header = false;
+  REQUIRE(seria::to_csv(points, options) == "0.0,0.0,\"a,\"\"b\"\"\nc\"\n");
+}
+
+TEST_CASE("tab separated", "[serialize]") {
+  std::vector<Point> points(1);
+  points[0].xy = {1.5f, -2.0f};
+  points[0].label = "a,b";
+
+  auto text = seria::to_csv(points, seria::tsv_options());
+  REQUIRE(text == "xy.0\txy.1\tlabel\n1.5\t-2.0\ta,b\n");
+}
+
+TEST_CASE("round trip", "[deserialize]") {
+  std::vector<Point> points(3);
+  points[0].label = "plain";
+  points[1].xy = {0.25f, 3e10f};
+  points[1].label = "with \"quotes\", commas";
+  points[2].label = "line\r\nbreak";
+
+  auto text = seria::to_csv(points);
+
+  std::vector<Point> result;
+  seria::from_csv(result, text.data(), text.size());
+  REQUIRE(result.size() == 3);
+  REQUIRE(result[1].xy[0] == 0.25f);
+  REQUIRE(result[1].xy[1] == 3e10f);
+  REQUIRE(result[1].label == points[1].label);
+  REQUIRE(result[2].label == points[2].label);
+}
+
+TEST_CASE("empty field in a single column", "[deserialize]") {
+  std::vector<Note> notes{{"a"}, {""}, {"b"}, {""}};
+
+  auto text = seria::to_csv(notes);
+  REQUIRE(text == "text\na\n\"\"\nb\n\"\"\n");
+
+  std::vector<Note> result;
+  seria::from_csv(result, text.data(), text.size());
+  REQUIRE(result.size() == 4);
+  REQUIRE(result[1].text.empty());
+  REQUIRE(result[2].text == "b");
+  REQUIRE(result[3].text.empty());
+}
+
+TEST_CASE("columns by header name", "[deserialize]") {
+  std::string text = "name,extra,value,test_uint,inside.i_value,flag\r\n"
+                     "\"x\",ignored,2.5,7,0.5,1\r\n"
+                     "\r\n"
+                     "y,,1e-3,8,1,false\r\n";
+
+  std::vector<Person> result;
+  seria::from_csv(result, text.data(), text.size());
+
+  REQUIRE(result.size() == 2);
+  REQUIRE(result[0].name == "x");
+  REQUIRE(result[0].value == 2.5);
+  REQUIRE(result[0].test_uint == 7);
+  REQUIRE(result[0].flag);
+  REQUIRE(result[1].value == 1e-3);
+  REQUIRE(!result[1].flag);
+
+  // columns absent from the header take the registered defaults
+  REQUIRE(result[0].age == 50);
+  REQUIRE(result[1].inside.i_age == 100);
+}
+
+TEST_CASE("missing column without default", "[deserialize]") {
+  std::string text = "age,value\n1,2\n";
+
+  std::vector<Person> result;
+  try {
+    seria::from_csv(result, text.data(), text.size());
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "test_uint") == 0);
+  }
+}
+
+TEST_CASE("invalid value", "[deserialize]") {
+  std::string text = "xy.0,xy.1,label\n1,2,a\n3,four,b\n";
+
+  std::vector<Point> result;
+  try {
+    seria::from_csv(result, text.data(), text.size());
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "1.xy.1") == 0);
+    REQUIRE(std::strcmp(err.desired_type(), "float or double") == 0);
+  }
+}
+
+TEST_CASE("malformed records", "[deserialize]") {
+  seria::csv_options options;
+  options.header = false;
+
+  std::vector<Point> result;
+  std::string extra = "1,2,a,b\n";
+  REQUIRE_THROWS_AS(
+      seria::from_csv(result, extra.data(), extra.size(), options),
+      seria::error);
+
+  std::string unterminated = "1,2,\"a\n";
+  REQUIRE_THROWS_AS(seria::from_csv(result, unterminated.data(),
+                                    unterminated.size(), options),
+                    seria::error);
+
+  std::string overflow = "value,test_uint,inside.i_value,name,flag\n"
+                         "1,4294967296,2,a,0\n";
+  std::vector<Person> people;
+  REQUIRE_THROWS_AS(seria::from_csv(people, overflow.data(), overflow.size()),
+                    seria::type_error);
+}
+
+TEST_CASE("multithreaded parse", "[deserialize]") {
+  std::vector<Point> points(50000);
+  for (size_t i = 0; i < points.size(); i++) {
+    points[i].xy = {static_cast<float>(i), 0.5f};
+    points[i].label = i % 7 == 0 ? "multi\nline, \"quoted\"" : to_string(i);
+  }
+  auto text = seria::to_csv(points);
+
+  seria::csv_options options;
+  options.threads = 4;
+  std::vector<Point> result;
+  seria::from_csv(result, text.data(), text.size(), options);
+
+  REQUIRE(result.size() == points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    REQUIRE(result[i].xy[0] == points[i].xy[0]);
+    REQUIRE(result[i].label == points[i].label);
+  }
+
+  // errors report the row index of the whole input
+  auto position = text.find("\n40000.0,");
+  text[position + 1] = 'x';
+  try {
+    seria::from_csv(result, text.data(), text.size(), options);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "40000.xy.0") == 0);
+  }
+}
@@ -1,7 +1,17 @@
 #include <catch2/catch_all.hpp>
+#include <cstring>
 #include <iostream>
+#include <seria/chunked/mpack.hpp>
 #include <seria/deserialize/mpack.hpp>
+#include <seria/diff/mpack.hpp>
+#include <seria/frame/mpack.hpp>
+#include <seria/incremental/mpack.hpp>
+#include <seria/memo.hpp>
+#include <seria/record_file/mpack.hpp>
+#include <seria/scatter.hpp>
 #include <seria/serialize/mpack.hpp>
+#include <seria/shm_channel/mpack.hpp>
+#include <unistd.h>
 
 using namespace std;
 
@@ -13,6 +23,13 @@ struct Inside {
 
 enum class Gender { Male = 0, Female = 1 };
 
+struct Sample {
+  int32_t id = 0;
+  double time = 0.0;
+  std::array<float, 3> position{};
+  std::string label;
+};
+
 struct Person {
   int age = 1;
   float value = 1.0f;
@@ -23,8 +40,42 @@ struct Person {
 
 enum class Child { Boy, Girl };
 
+struct Batch {
+  std::vector<Person> people;
+  std::vector<Sample> samples;
+};
+
+struct Media {
+  std::string title;
+  std::vector<uint8_t> thumbnail;
+  std::vector<std::string> tags;
+};
+
+struct Profile {
+  uint32_t version = 0;
+  std::string name;
+  std::vector<Person> friends;
+};
+
 namespace seria {
 
+template <> struct is_columnar<Sample> : std::true_type {};
+
+template <> struct is_memoized<Profile> : std::true_type {};
+
+template <> auto register_object<Profile>() {
+  return std::make_tuple(member("version", &Profile::version),
+                         member("name", &Profile::name),
+                         member("friends", &Profile::friends));
+}
+
+template <> auto register_object<Sample>() {
+  return std::make_tuple(member("id", &Sample::id),
+                         member("time", &Sample::time),
+                         member("position", &Sample::position),
+                         member("label", &Sample::label, std::string("none")));
+}
+
 template <> auto register_object<Person>() {
   return std::make_tuple(member("age", &Person::age, 50),
                          member("value", &Person::value),
@@ -33,6 +84,17 @@ template <> auto register_object<Person>() {
                          member("inside", &Person::inside));
 }
 
+template <> auto register_object<Batch>() {
+  return std::make_tuple(member("people", &Batch::people),
+                         member("samples", &Batch::samples));
+}
+
+template <> auto register_object<Media>() {
+  return std::make_tuple(member("title", &Media::title),
+                         member("thumbnail", &Media::thumbnail),
+                         member("tags", &Media::tags));
+}
+
 template <> auto register_object<Inside>() {
   return std::make_tuple(member("i_age", &Inside::i_age, 100),
                          member("i_value", &Inside::i_value),
@@ -252,6 +314,56 @@ TEST_CASE("deserialize a object with default value", "[deserialize]") {
   REQUIRE(person.inside.i_age == 100);
 }
 
+TEST_CASE("deserialize objects with changing member order",
+          "[deserialize]") {
+  const char *orders[][3] = {{"i_age", "i_value", "i_v"},
+                             {"i_v", "i_value", "i_age"},
+                             {"i_value", "i_v", nullptr},
+                             {"i_v", "i_age", "i_value"}};
+
+  char *data = nullptr;
+  size_t size = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &size);
+  mpack_start_array(&writer, 4);
+  for (int i = 0; i < 4; i++) {
+    mpack_start_map(&writer, orders[i][2] == nullptr ? 2 : 3);
+    for (auto *key : orders[i]) {
+      if (key == nullptr) {
+        continue;
+      }
+      mpack_write_cstr(&writer, key);
+      if (std::strcmp(key, "i_age") == 0) {
+        mpack_write_int(&writer, i + 1);
+      } else if (std::strcmp(key, "i_value") == 0) {
+        mpack_write_float(&writer, 0.5f + static_cast<float>(i));
+      } else {
+        mpack_start_array(&writer, 1);
+        mpack_write_int(&writer, i + 1);
+        mpack_finish_array(&writer);
+      }
+    }
+    mpack_finish_map(&writer);
+  }
+  mpack_finish_array(&writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, data, size);
+  mpack_tree_parse(&tree);
+  std::vector<Inside> insides;
+  seria::deserialize(insides, mpack_tree_root(&tree));
+  mpack_tree_destroy(&tree);
+  free(data);
+
+  REQUIRE(insides.size() == 4);
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(insides[i].i_age == (i == 2 ? 100 : i + 1));
+    REQUIRE(insides[i].i_value == 0.5f + static_cast<float>(i));
+    REQUIRE(insides[i].i_v == std::vector<int>{i + 1});
+  }
+}
+
 TEST_CASE("customize enum deserialize rule", "[deserialize]") {
   uint8_t data[] = {0x93, 0xA1, 0x42, 0xA1, 0x47, 0xA1, 0x47};
   std::vector<Child> children{};
@@ -343,4 +455,380 @@ TEST_CASE("deserialize missing value", "[deserialize]") {
   } catch (seria::error &err) {
     REQUIRE(std::strcmp(err.path(), "inside.i_value") == 0);
   }
-}
\ No newline at end of file
+}
+TEST_CASE("columnar vector of objects", "[columnar]") {
+  std::vector<Sample> samples(3);
+  for (size_t i = 0; i < samples.size(); i++) {
+    samples[i].id = static_cast<int32_t>(i + 1);
+    samples[i].time = static_cast<double>(i) * 0.5;
+    samples[i].position = {1.0f, 2.0f, static_cast<float>(i)};
+    samples[i].label = std::to_string(i);
+  }
+
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::serialize(samples, &writer);
+  auto result = mpack_writer_destroy(&writer);
+  REQUIRE(result == mpack_ok);
+
+  // {"id": bin[01 00 00 00 02 00 00 00 03 00 00 00], ...
+  uint8_t target[] = {0x84, 0xA2, 0x69, 0x64, 0xC4, 0x0C, 0x01, 0x00,
+                      0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03, 0x00,
+                      0x00, 0x00};
+  REQUIRE(total > sizeof(target));
+  REQUIRE(std::memcmp(data, target, sizeof(target)) == 0);
+
+  std::vector<Sample> decoded{};
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, data, total);
+  mpack_tree_parse(&tree);
+  seria::deserialize(decoded, mpack_tree_root(&tree));
+  mpack_tree_destroy(&tree);
+  free(data);
+
+  REQUIRE(decoded.size() == 3);
+  REQUIRE(decoded[2].id == 3);
+  REQUIRE(decoded[2].time == 1.0);
+  REQUIRE(decoded[1].position[2] == 1.0f);
+  REQUIRE(decoded[1].label == "1");
+}
+
+TEST_CASE("columnar default column", "[columnar]") {
+  // {"id": bin[01 00 00 00], "time": bin[0.0], "position": bin[0, 0, 0]}
+  uint8_t data[] = {0x83, 0xA2, 0x69, 0x64, 0xC4, 0x04, 0x01, 0x00, 0x00,
+                    0x00, 0xA4, 0x74, 0x69, 0x6D, 0x65, 0xC4, 0x08, 0x00,
+                    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA8, 0x70,
+                    0x6F, 0x73, 0x69, 0x74, 0x69, 0x6F, 0x6E, 0xC4, 0x0C,
+                    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                    0x00, 0x00, 0x00};
+  std::vector<Sample> samples{};
+
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, reinterpret_cast<const char *>(data),
+                       sizeof(data));
+  mpack_tree_parse(&tree);
+  seria::deserialize(samples, mpack_tree_root(&tree));
+
+  REQUIRE(samples.size() == 1);
+  REQUIRE(samples[0].id == 1);
+  REQUIRE(samples[0].label == "none");
+}
+
+TEST_CASE("push decoding", "[incremental]") {
+  Batch batch;
+  batch.people.resize(3);
+  batch.people[1].age = 7;
+  batch.people[2].inside.i_v = {8, 9};
+  batch.samples.resize(2);
+  batch.samples[1].label = "second";
+
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::serialize(batch, &writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+
+  // byte by byte, the columnar vector is decoded once complete
+  Batch decoded;
+  seria::incremental_decoder<Batch, seria::mpack_push_parser> decoder(decoded);
+  for (size_t i = 0; i + 1 < total; i++) {
+    REQUIRE(decoder.feed(data + i, 1) == seria::decode_status::need_more);
+  }
+  REQUIRE(decoder.feed(data + total - 1, 1) == seria::decode_status::done);
+  REQUIRE(decoded.people.size() == 3);
+  REQUIRE(decoded.people[1].age == 7);
+  REQUIRE(decoded.people[2].inside.i_v == std::vector<int>{8, 9});
+  REQUIRE(decoded.samples.size() == 2);
+  REQUIRE(decoded.samples[1].label == "second");
+
+  // errors carry the same path as `deserialize`
+  uint8_t wrong[] = {0x91, 0x82, 0xA5, 0x76, 0x61, 0x6C, 0x75, 0x65, 0xA1,
+                     0x78, 0xA3, 0x61, 0x67, 0x65, 0x01};
+  std::vector<Person> people;
+  seria::incremental_decoder<std::vector<Person>, seria::mpack_push_parser>
+      failing(people);
+  failing.feed(reinterpret_cast<const char *>(wrong), 5);
+  REQUIRE(failing.status() == seria::decode_status::need_more);
+  failing.feed(reinterpret_cast<const char *>(wrong) + 5, sizeof(wrong) - 5);
+  REQUIRE(failing.status() == seria::decode_status::error);
+  REQUIRE(std::string(failing.last_error().what()) ==
+          "0.value: wrong type, should be float or double");
+
+  // truncated input
+  seria::incremental_decoder<Batch, seria::mpack_push_parser> truncated(
+      decoded);
+  truncated.feed(data, total / 2);
+  REQUIRE(truncated.finish() == seria::decode_status::error);
+  free(data);
+}
+
+TEST_CASE("chunked output", "[serialize]") {
+  Batch batch;
+  batch.people.resize(20);
+  batch.people[2].inside.i_v.assign(100000, 7);
+  batch.samples.resize(3);
+
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::serialize(batch, &writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+
+  // arrays longer than 16 bits count, the columnar vector written at once
+  seria::chunked_writer<Batch, seria::mpack_chunk_format> chunked(batch, 1000);
+  std::string bytes;
+  while (!chunked.done()) {
+    bytes += chunked.next();
+  }
+  REQUIRE(bytes == std::string(data, total));
+  free(data);
+}
+
+TEST_CASE("scatter output", "[serialize]") {
+  Media media;
+  media.title = std::string(300, 't');
+  media.thumbnail.assign(70000, 0x5a);
+  media.tags = {"short", std::string(40, 'x')};
+
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::serialize(media, &writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+  std::string target(data, total);
+  free(data);
+
+  auto scattered = seria::to_scatter<seria::mpack_chunk_format>(media, 32);
+  REQUIRE(scattered.size() == target.size());
+  REQUIRE(scattered.str() == target);
+
+  // the title, the thumbnail and the long tag are not copied
+  size_t referenced = 0;
+  for (auto &segment : scattered.segments()) {
+    if (segment.data == media.title.data() ||
+        segment.data == media.tags[1].data() ||
+        segment.data == reinterpret_cast<char *>(media.thumbnail.data())) {
+      referenced++;
+    }
+  }
+  REQUIRE(referenced == 3);
+
+  scattered.clear();
+  seria::write_scatter<seria::mpack_chunk_format>(media.tags, scattered);
+  // the array header and the short tag, then the long one
+  REQUIRE(scattered.segments().size() == 2);
+}
+
+TEST_CASE("memoized objects", "[serialize]") {
+  std::vector<Profile> profiles(3);
+  for (size_t i = 0; i < profiles.size(); i++) {
+    profiles[i].version = 1;
+    profiles[i].name = "profile " + std::to_string(i);
+    profiles[i].friends.resize(i + 1);
+  }
+
+  auto encode = [&profiles] {
+    char *data = nullptr;
+    size_t total = 0;
+    mpack_writer_t writer;
+    mpack_writer_init_growable(&writer, &data, &total);
+    seria::serialize(profiles, &writer);
+    REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+    std::string bytes(data, total);
+    free(data);
+    return bytes;
+  };
+  auto expected = encode();
+
+  seria::memo_cache cache;
+  seria::memo_scope scope(cache);
+  REQUIRE(encode() == expected);
+  REQUIRE(encode() == expected);
+  auto stats = cache.stats();
+  REQUIRE(stats.hits == 3);
+  REQUIRE(stats.misses == 3);
+  REQUIRE(stats.bytes + 1 == expected.size());
+
+  // spliced into the map of the array like any other value
+  profiles[0].friends[0].age = 42;
+  profiles[0].version = 2;
+  auto changed = encode();
+  REQUIRE(cache.stats().misses == 4);
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, changed.data(), changed.size());
+  mpack_tree_parse(&tree);
+  std::vector<Profile> decoded;
+  seria::deserialize(decoded, mpack_tree_root(&tree));
+  mpack_tree_destroy(&tree);
+  REQUIRE(decoded.size() == 3);
+  REQUIRE(decoded[0].friends[0].age == 42);
+  REQUIRE(decoded[2].name == "profile 2");
+
+  // dropped before the object goes away
+  cache.erase(profiles[1]);
+  REQUIRE(cache.stats().entries == 2);
+  cache.clear();
+  REQUIRE(cache.stats().bytes == 0);
+}
+
+TEST_CASE("delta patch", "[diff]") {
+  Batch old;
+  old.people.resize(3);
+  old.samples.resize(2);
+  Batch now = old;
+  now.samples[1].time = 4.5;
+
+  auto delta = [](const Batch &from, const Batch &to, bool *changed) {
+    char *data = nullptr;
+    size_t total = 0;
+    mpack_writer_t writer;
+    mpack_writer_init_growable(&writer, &data, &total);
+    *changed = seria::diff(from, to, &writer);
+    REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+    std::string bytes(data, total);
+    free(data);
+    return bytes;
+  };
+
+  bool changed = true;
+  REQUIRE(delta(old, old, &changed) == "\x80");
+  REQUIRE_FALSE(changed);
+
+  // index 1, the samples, as a whole
+  auto bytes = delta(old, now, &changed);
+  REQUIRE(changed);
+  REQUIRE(bytes.substr(0, 2) == "\x81\x01");
+
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, bytes.data(), bytes.size());
+  mpack_tree_parse(&tree);
+  seria::apply_patch(old, mpack_tree_root(&tree));
+  mpack_tree_destroy(&tree);
+  REQUIRE(old.samples[1].time == 4.5);
+  REQUIRE(old.people.size() == 3);
+
+  Person person;
+  Person edited = person;
+  edited.inside.i_age = 9;
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::diff(person, edited, &writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+  // {4: {0: 9}}, only the changed member of the inside object
+  REQUIRE(std::string(data, total) == std::string("\x81\x04\x81\x00\x09", 5));
+  free(data);
+
+  const char unknown[] = "\x81\x09\x01";
+  mpack_tree_init_data(&tree, unknown, sizeof(unknown) - 1);
+  mpack_tree_parse(&tree);
+  REQUIRE_THROWS_AS(seria::apply_patch(person, mpack_tree_root(&tree)),
+                    seria::error);
+  mpack_tree_destroy(&tree);
+}
+
+TEST_CASE("framed stream", "[frame]") {
+  REQUIRE(seria::crc32c::compute("123456789", 9) == 0xe3069283u);
+
+  seria::frame_options options;
+  options.fingerprint = true;
+  seria::frame_writer writer(options);
+  Person first;
+  first.age = 7;
+  Batch batch;
+  batch.people.resize(2);
+  batch.people[1].inside.i_v.assign(20000, 9); // longer length, moved
+  Person last;
+  last.age = 9;
+  writer.write(first);
+  writer.write(batch);
+  writer.write(last);
+
+  // received a few bytes at a time
+  seria::frame_reader reader(options, 16);
+  Person person;
+  Batch decoded;
+  size_t sent = 0;
+  int frames = 0;
+  while (sent != writer.size()) {
+    auto size = std::min<size_t>(7, writer.size() - sent);
+    std::memcpy(reader.prepare(size), writer.data() + sent, size);
+    reader.commit(size);
+    sent += size;
+    if (frames == 1 ? reader.next(decoded) : reader.next(person)) {
+      frames++;
+      REQUIRE(person.age == (frames == 3 ? 9 : 7));
+    }
+  }
+  REQUIRE(frames == 3);
+  REQUIRE(reader.buffered() == 0);
+  REQUIRE(decoded.people[1].inside.i_v.size() == 20000);
+
+  // another schema is skipped, a corrupted frame stops the stream
+  writer.clear();
+  writer.write(first);
+  writer.write(last);
+  reader.feed(writer.data(), writer.size());
+  Inside inside;
+  REQUIRE_THROWS_WITH(reader.next(inside), "schema fingerprint mismatch");
+  REQUIRE(reader.next(person));
+  REQUIRE(person.age == 9);
+
+  writer.clear();
+  writer.write(first);
+  std::string corrupted(writer.data(), writer.size());
+  corrupted[corrupted.size() / 2] ^= 1;
+  reader.feed(corrupted.data(), corrupted.size());
+  REQUIRE_THROWS_WITH(reader.next(person), "frame checksum mismatch");
+
+  seria::frame_options unchecked;
+  unchecked.checksum = false;
+  seria::frame_writer plain(unchecked);
+  plain.write(first);
+  seria::frame_reader strict;
+  strict.feed(plain.data(), plain.size());
+  REQUIRE_THROWS_WITH(strict.next(person), "frame without checksum");
+}
+
+TEST_CASE("shared memory channel", "[shm]") {
+  using channel = seria::shm_channel<Person, seria::shm_mpack_codec>;
+  auto name = "/seria-test-mpack-" + std::to_string(getpid());
+  auto producer = channel::create(name.c_str(), 4096, 128);
+  auto consumer = channel::open(name.c_str());
+  channel::unlink(name.c_str());
+
+  Person person;
+  Person received;
+  for (int i = 0; i < 100; i++) {
+    person.age = i;
+    REQUIRE(producer.try_send(person));
+    REQUIRE(consumer.try_receive(received));
+    REQUIRE(received.age == i);
+  }
+
+  person.inside.i_v.assign(100, 1000);
+  REQUIRE_THROWS_AS(producer.try_send(person), seria::error);
+}
+
+TEST_CASE("record file of msgpack records", "[records]") {
+  using file_type = seria::record_file<Person, seria::record_mpack_codec>;
+  auto path = "/tmp/seria-records-mpack-" + std::to_string(getpid());
+  std::vector<Person> people(50);
+  for (size_t i = 0; i < people.size(); i++) {
+    people[i].age = static_cast<int>(i);
+  }
+  seria::write_records<seria::record_mpack_codec>(path.c_str(), people);
+
+  file_type file(path.c_str());
+  REQUIRE(file.size() == 50);
+  REQUIRE(file.get(42).age == 42);
+  REQUIRE_THROWS_WITH(seria::record_file<Person>(path.c_str()),
+                      "record file of another codec");
+  std::remove(path.c_str());
+}
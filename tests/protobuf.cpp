@@ -0,0 +1,287 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <seria/deserialize/protobuf.hpp>
+#include <seria/serialize/protobuf.hpp>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int age = 1;
+  double value = 1.0;
+  Gender gender = Gender::Male;
+  uint32_t test_uint = 1;
+  Inside inside{};
+  std::vector<std::string> tags{};
+  std::vector<uint8_t> blob{};
+  std::vector<Inside> children{};
+};
+
+struct Scalar {
+  int32_t a = -1;
+  uint32_t b = 300;
+  bool c = true;
+};
+
+struct Encoded {
+  int32_t i32 = -1;
+  int32_t s32 = -1;
+  int32_t f32 = -1;
+  int64_t i64 = -2;
+  int64_t s64 = -2;
+  int64_t f64 = -3;
+  uint32_t u32 = 300;
+  std::vector<int32_t> packed = {1, -1};
+};
+
+namespace seria {
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(pb_member(1, "age", &Person::age, 50),
+                         pb_member(2, "value", &Person::value),
+                         pb_member(3, "gender", &Person::gender, Gender::Male),
+                         pb_member(4, "test_uint", &Person::test_uint),
+                         pb_member(5, "inside", &Person::inside),
+                         pb_member(6, "tags", &Person::tags),
+                         pb_member(7, "blob", &Person::blob),
+                         pb_member(8, "children", &Person::children));
+}
+
+template <> auto register_object<Inside>() {
+  // implicit field numbers 1, 2, 3
+  return std::make_tuple(member("i_age", &Inside::i_age, 100),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+template <> auto register_object<Scalar>() {
+  return std::make_tuple(pb_member(1, "a", &Scalar::a, pb_sint),
+                         pb_member(2, "b", &Scalar::b),
+                         pb_member(15, "c", &Scalar::c));
+}
+
+template <> auto register_object<Encoded>() {
+  return std::make_tuple(pb_member(1, "i32", &Encoded::i32),
+                         pb_member(2, "s32", &Encoded::s32, pb_sint),
+                         pb_member(3, "f32", &Encoded::f32, pb_fixed),
+                         pb_member(4, "i64", &Encoded::i64),
+                         pb_member(5, "s64", &Encoded::s64, pb_sint),
+                         pb_member(6, "f64", &Encoded::f64, pb_fixed),
+                         pb_member(7, "u32", &Encoded::u32, pb_fixed),
+                         pb_member(8, "packed", &Encoded::packed, pb_fixed));
+}
+
+} // namespace seria
+
+template <size_t N>
+static bool same_bytes(const std::string &data, const uint8_t (&target)[N]) {
+  return data.size() == N && std::memcmp(data.data(), target, N) == 0;
+}
+
+TEST_CASE("varint and zigzag scalars", "[serialize]") {
+  uint8_t target[] = {0x08, 0x01, 0x10, 0xAC, 0x02, 0x78, 0x01};
+  REQUIRE(same_bytes(seria::to_protobuf(Scalar{}), target));
+}
+
+TEST_CASE("packed repeated and nested message", "[serialize]") {
+  Inside inside{};
+  inside.i_age = -2;
+  inside.i_value = 0.5f;
+  inside.i_v = {1, -1, 64};
+
+  // i_age: int32 -2 sign extended, i_value: fixed32, i_v: packed varints
+  uint8_t target[] = {0x08, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                      0xFF, 0x01, 0x15, 0x00, 0x00, 0x00, 0x3F, 0x1A, 0x0C,
+                      0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                      0xFF, 0x01, 0x40};
+  REQUIRE(same_bytes(seria::to_protobuf(inside), target));
+}
+
+TEST_CASE("integer encodings match protoc", "[serialize]") {
+  // as written by protoc for the same values and field types
+  uint8_t target[] = {
+      // int32 -1
+      0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01,
+      // sint32 -1
+      0x10, 0x01,
+      // sfixed32 -1
+      0x1D, 0xFF, 0xFF, 0xFF, 0xFF,
+      // int64 -2
+      0x20, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01,
+      // sint64 -2
+      0x28, 0x03,
+      // sfixed64 -3
+      0x31, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      // fixed32 300
+      0x3D, 0x2C, 0x01, 0x00, 0x00,
+      // packed repeated sfixed32 [1, -1]
+      0x42, 0x08, 0x01, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF};
+  REQUIRE(same_bytes(seria::to_protobuf(Encoded{}), target));
+
+  Encoded result{};
+  result.i32 = result.s32 = result.f32 = 0;
+  result.i64 = result.s64 = result.f64 = 0;
+  result.u32 = 0;
+  result.packed.clear();
+  seria::from_protobuf(result, reinterpret_cast<const char *>(target),
+                       sizeof(target));
+
+  REQUIRE(result.i32 == -1);
+  REQUIRE(result.s32 == -1);
+  REQUIRE(result.f32 == -1);
+  REQUIRE(result.i64 == -2);
+  REQUIRE(result.s64 == -2);
+  REQUIRE(result.f64 == -3);
+  REQUIRE(result.u32 == 300);
+  REQUIRE(result.packed == std::vector<int32_t>{1, -1});
+}
+
+TEST_CASE("wire type must match the encoding", "[deserialize]") {
+  uint8_t data[] = {0x18, 0x01}; // f32 as a varint
+  Encoded encoded{};
+
+  try {
+    seria::from_protobuf(encoded, reinterpret_cast<const char *>(data),
+                         sizeof(data));
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "f32") == 0);
+  }
+}
+
+TEST_CASE("length prefix of nested messages", "[serialize]") {
+  Person person{};
+  person.inside.i_v = {};
+  person.children.resize(2);
+  person.children[1].i_v = {};
+
+  auto data = seria::to_protobuf(person);
+
+  // inside: key 0x2A, then 7 bytes (i_age, i_value), no repeated field
+  uint8_t inside[] = {0x2A, 0x07, 0x08, 0x01, 0x15, 0x00, 0x00, 0x80, 0x3F};
+  auto position = data.find(reinterpret_cast<const char *>(inside), 0,
+                            sizeof(inside));
+  REQUIRE(position != std::string::npos);
+
+  // empty tags are omitted, then the empty blob and two child messages
+  REQUIRE(data.size() == position + sizeof(inside) + 2 + (2 + 14) + (2 + 7));
+}
+
+TEST_CASE("round trip nested object", "[deserialize]") {
+  Person person{};
+  person.age = -33;
+  person.value = 0.25;
+  person.gender = Gender::Female;
+  person.test_uint = 7;
+  person.inside.i_v = {6, 66, 666};
+  person.tags = {"a", "bc"};
+  person.blob = {0, 1, 255};
+  person.children.resize(3);
+  person.children[2].i_age = 42;
+
+  auto data = seria::to_protobuf(person);
+
+  Person result{};
+  seria::from_protobuf(result, data.data(), data.size());
+
+  REQUIRE(result.age == -33);
+  REQUIRE(result.value == 0.25);
+  REQUIRE(result.gender == Gender::Female);
+  REQUIRE(result.test_uint == 7);
+  REQUIRE(result.inside.i_v == std::vector<int>{6, 66, 666});
+  REQUIRE(result.tags == std::vector<std::string>{"a", "bc"});
+  REQUIRE(result.blob == std::vector<uint8_t>{0, 1, 255});
+  REQUIRE(result.children.size() == 3);
+  REQUIRE(result.children[2].i_age == 42);
+}
+
+TEST_CASE("unpacked repeated and unknown fields", "[deserialize]") {
+  // i_v as separate fields, then unknown fields 9 (varint) and 10 (bytes)
+  uint8_t data[] = {0x18, 0x01, 0x18, 0x02, 0x48, 0x96, 0x01,
+                    0x52, 0x02, 0x68, 0x69, 0x15, 0x00, 0x00, 0x00, 0x40};
+  Inside inside{};
+
+  seria::from_protobuf(inside, reinterpret_cast<const char *>(data),
+                       sizeof(data));
+
+  REQUIRE(inside.i_v == std::vector<int>{1, 2});
+  REQUIRE(inside.i_value == 2.0f);
+  REQUIRE(inside.i_age == 100);
+}
+
+TEST_CASE("absent fields take defaults", "[deserialize]") {
+  uint8_t data[] = {0x20, 0x02}; // test_uint = 2
+  Person person{};
+  person.value = 3.0;
+  person.tags = {"stale"};
+
+  seria::from_protobuf(person, reinterpret_cast<const char *>(data),
+                       sizeof(data));
+
+  REQUIRE(person.age == 50);
+  REQUIRE(person.value == 0.0);
+  REQUIRE(person.test_uint == 2);
+  REQUIRE(person.tags.empty());
+  REQUIRE(person.inside.i_age == 1);
+}
+
+TEST_CASE("embedded message given twice is merged", "[deserialize]") {
+  // inside { i_age: 7, i_v: [1] }, inside { i_value: 2.0, i_v: [2] }
+  uint8_t data[] = {0x2A, 0x05, 0x08, 0x07, 0x1A, 0x01, 0x01,
+                    0x2A, 0x08, 0x15, 0x00, 0x00, 0x00, 0x40,
+                    0x1A, 0x01, 0x02};
+  Person person{};
+
+  seria::from_protobuf(person, reinterpret_cast<const char *>(data),
+                       sizeof(data));
+
+  REQUIRE(person.inside.i_age == 7);
+  REQUIRE(person.inside.i_value == 2.0f);
+  REQUIRE(person.inside.i_v == std::vector<int>{1, 2});
+  REQUIRE(person.age == 50);
+}
+
+TEST_CASE("deserialize type error", "[deserialize]") {
+  // inside { i_v: 1, i_v: 1.0 as fixed64 }
+  uint8_t data[] = {0x2A, 0x0B, 0x18, 0x01, 0x19, 0x00, 0x00,
+                    0x00, 0x00, 0x00, 0x00, 0xF0, 0x3F};
+  Person person{};
+
+  try {
+    seria::from_protobuf(person, reinterpret_cast<const char *>(data),
+                         sizeof(data));
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "inside.i_v.1") == 0);
+    REQUIRE(std::strcmp(err.desired_type(), "integer") == 0);
+  }
+}
+
+TEST_CASE("integer out of range", "[deserialize]") {
+  uint8_t data[] = {0x10, 0x80, 0x80, 0x80, 0x80, 0x10}; // b = 2^32
+  Scalar scalar{};
+
+  try {
+    seria::from_protobuf(scalar, reinterpret_cast<const char *>(data),
+                         sizeof(data));
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "b") == 0);
+  }
+}
+
+TEST_CASE("truncated input", "[deserialize]") {
+  auto data = seria::to_protobuf(Person{});
+  data.resize(data.size() - 3);
+
+  Person person{};
+  REQUIRE_THROWS_AS(seria::from_protobuf(person, data.data(), data.size()),
+                    seria::error);
+}
@@ -1,5 +1,12 @@
 #include <catch2/catch_all.hpp>
+#include <limits>
+#include <seria/chunked/rapidjson.hpp>
+#include <seria/scatter.hpp>
 #include <seria/deserialize/rapidjson.hpp>
+#include <seria/diff/rapidjson.hpp>
+#include <seria/incremental/rapidjson.hpp>
+#include <seria/memo.hpp>
+#include <seria/reload/rapidjson.hpp>
 #include <seria/serialize/rapidjson.hpp>
 
 using namespace std;
@@ -22,8 +29,69 @@ struct Person {
 
 enum class Child { Boy, Girl };
 
+struct Point {
+  int x = 0;
+  double y = 0.0;
+};
+
+struct Sample {
+  bool flag = true;
+  int64_t id = -9000000000;
+  uint32_t count = 7;
+  float ratio = 0.5f;
+  double weight = 0.0;
+  std::array<std::array<int, 2>, 2> grid{{{1, 2}, {3, 4}}};
+};
+
+struct Profile {
+  uint32_t version = 0;
+  std::string name;
+  std::vector<int> scores;
+};
+
+struct Listing {
+  uint64_t revision = 0;
+  std::string sku;
+  Profile seller;
+};
+
+struct Price {
+  int64_t cents = 0;
+};
+
+struct Offer {
+  Profile seller;
+  Price price;
+};
+
 namespace seria {
 
+template <> struct is_memoized<Profile> : std::true_type {};
+
+template <> struct is_memoized<Listing> : std::true_type {
+  static uint64_t version(const Listing &listing) { return listing.revision; }
+};
+
+template <> auto register_object<Profile>() {
+  return std::make_tuple(member("version", &Profile::version),
+                         member("name", &Profile::name),
+                         member("scores", &Profile::scores));
+}
+
+template <> auto register_object<Listing>() {
+  return std::make_tuple(member("sku", &Listing::sku),
+                         member("seller", &Listing::seller));
+}
+
+template <> auto register_object<Price>() {
+  return std::make_tuple(member("cents", &Price::cents));
+}
+
+template <> auto register_object<Offer>() {
+  return std::make_tuple(member("seller", &Offer::seller),
+                         member("price", &Offer::price));
+}
+
 template <> auto register_object<Person>() {
   return std::make_tuple(member("age", &Person::age, 50),
                          member("value", &Person::value),
@@ -38,6 +106,21 @@ template <> auto register_object<Inside>() {
                          member("i_v", &Inside::i_v));
 }
 
+template <> struct is_json_template<Sample> : std::true_type {};
+
+template <> auto register_object<Sample>() {
+  return std::make_tuple(member("flag", &Sample::flag),
+                         member("id", &Sample::id),
+                         member("count", &Sample::count),
+                         member("ratio", &Sample::ratio),
+                         member("weight \"kg\"", &Sample::weight),
+                         member("grid", &Sample::grid));
+}
+
+template <> constexpr auto register_object<Point>() {
+  return std::make_tuple(member("x", &Point::x, 7), member("y", &Point::y));
+}
+
 template <> rapidjson::Document serialize(const Child &data) {
   rapidjson::Document json(rapidjson::kStringType);
   if (data == Child::Boy) {
@@ -48,6 +131,17 @@ template <> rapidjson::Document serialize(const Child &data) {
   return json;
 }
 
+// written as text instead of its registered members
+template <> rapidjson::Document serialize(const Price &data) {
+  auto text = std::to_string(data.cents / 100) + "." +
+              std::to_string(data.cents % 100 / 10) +
+              std::to_string(data.cents % 10);
+  rapidjson::Document json(rapidjson::kStringType);
+  json.SetString(text.c_str(), static_cast<rapidjson::SizeType>(text.size()),
+                 json.GetAllocator());
+  return json;
+}
+
 template <> void deserialize(Child &data, const rapidjson::Value &json) {
   if (!json.IsString()) {
     throw type_error("", "should be string");
@@ -106,6 +200,217 @@ TEST_CASE("stringify a person object", "[to_string]") {
   REQUIRE(str == target);
 }
 
+TEST_CASE("stringify a fixed shape object", "[to_string]") {
+  Sample sample{};
+  sample.weight = 1.25e-10;
+  auto str = seria::to_string(sample);
+  std::string target =
+      R"({"flag":true,"id":-9000000000,"count":7,"ratio":0.5,"weight \"kg\"":1.25e-10,"grid":[[1,2],[3,4]]})";
+
+  REQUIRE(str == target);
+  REQUIRE(str == seria::to_string_document(sample));
+
+  // NaN is left to the writer, same as for any other object
+  sample.weight = std::numeric_limits<double>::quiet_NaN();
+  REQUIRE(seria::to_string(sample) == seria::to_string_document(sample));
+}
+
+TEST_CASE("chunked output", "[to_string]") {
+  std::vector<Person> people(50);
+  people[3].inside.i_v.assign(1000, 7);
+  std::vector<Child> children{Child::Boy, Child::Girl};
+
+  for (size_t chunk_size : {1, 10, 4096}) {
+    seria::chunked_writer<std::vector<Person>> writer(people, chunk_size);
+    std::string str;
+    while (!writer.done()) {
+      auto &chunk = writer.next();
+      REQUIRE((chunk.size() == chunk_size || writer.done()));
+      str += chunk;
+    }
+    REQUIRE(str == seria::to_string(people));
+  }
+
+  // leaves with their own `serialize`
+  seria::chunked_writer<std::vector<Child>> custom(children, 3);
+  char out[16];
+  auto size = custom.read(out, sizeof(out));
+  REQUIRE(std::string(out, size) == R"(["B","G"])");
+  REQUIRE(custom.done());
+
+  std::vector<double> values{1.0, std::numeric_limits<double>::infinity()};
+  seria::chunked_writer<std::vector<double>> failing(values, 4);
+  REQUIRE_THROWS_AS(failing.read(out, sizeof(out)), seria::error);
+}
+
+TEST_CASE("scatter output", "[to_string]") {
+  std::vector<std::string> values{std::string(100, 'a'), "short",
+                                  std::string(100, '"'),
+                                  std::string(20, 'b') + '\x01'};
+  auto scattered = seria::to_scatter(values, 16);
+  REQUIRE(scattered.str() == seria::to_string(values));
+
+  // strings to escape are copied
+  auto segments = scattered.segments();
+  REQUIRE(segments.size() == 3);
+  REQUIRE(segments[1].data == values[0].data());
+}
+
+TEST_CASE("memoized objects", "[to_string]") {
+  Profile seller{3, "seller \"one\"", {1, 2, 3}};
+  std::vector<Listing> listings(4);
+  for (size_t i = 0; i < listings.size(); i++) {
+    listings[i].sku = "sku-" + std::to_string(i);
+    listings[i].seller = seller;
+  }
+  auto expected = seria::to_string(listings);
+  REQUIRE(expected == seria::to_string_document(listings));
+
+  seria::memo_cache cache;
+  {
+    seria::memo_scope scope(cache);
+    REQUIRE(seria::to_string(listings) == expected);
+    // the listings and the profiles in them, found by their "version"
+    REQUIRE(cache.stats().misses == 8);
+    REQUIRE(seria::to_string(listings) == expected);
+    REQUIRE(cache.stats().hits == 4);
+
+    // a new version is encoded again, in place of the old one
+    listings[1].sku = "changed";
+    listings[1].revision++;
+    auto changed = seria::to_string(listings);
+    REQUIRE(changed.find("changed") != std::string::npos);
+    REQUIRE(changed.size() == expected.size() + 2);
+    REQUIRE(cache.stats().hits == 8);
+    REQUIRE(cache.stats().misses == 9);
+    REQUIRE(cache.stats().entries == 8);
+  }
+
+  // the cache is only used inside a scope
+  listings[2].sku = "stale";
+  REQUIRE(seria::to_string(listings).find("stale") != std::string::npos);
+  REQUIRE(cache.stats().hits == 8);
+  REQUIRE(cache.stats().hit_rate() > 0.45);
+
+  // least recently used objects are evicted over the capacity
+  seria::memo_cache small(100);
+  seria::memo_scope scope(small);
+  seria::to_string(listings);
+  auto stats = small.stats();
+  REQUIRE(stats.bytes <= 100);
+  REQUIRE(stats.evictions > 0);
+  REQUIRE(stats.entries < 8);
+}
+
+TEST_CASE("serialize specializations of registered objects", "[to_string]") {
+  // fixed length members, but only opted in objects use a skeleton
+  REQUIRE(seria::to_string(Price{125}) == R"("1.25")");
+  REQUIRE(seria::to_string(Price{125}) ==
+          seria::to_string_document(Price{125}));
+
+  std::vector<Price> prices{{125}, {5}};
+  REQUIRE(seria::to_string(prices) == R"(["1.25","0.05"])");
+  REQUIRE(seria::to_string(prices) == seria::to_string_document(prices));
+
+  // objects holding memoized ones are walked, their other members still go
+  // through `serialize`
+  Offer offer{{1, "seller", {}}, {1999}};
+  auto expected = seria::to_string_document(offer);
+  REQUIRE(seria::to_string(offer) == expected);
+  REQUIRE(expected.find(R"("price":"19.99")") != std::string::npos);
+
+  seria::memo_cache cache;
+  seria::memo_scope scope(cache);
+  REQUIRE(seria::to_string(offer) == expected);
+  REQUIRE(seria::to_string(offer) == expected);
+  REQUIRE(cache.stats().hits == 1);
+}
+
+TEST_CASE("merge patch", "[diff]") {
+  Person old{};
+  Person now{};
+  REQUIRE(seria::diff(old, now).ObjectEmpty());
+
+  now.value = 2.5f;
+  now.inside.i_v.push_back(6);
+  auto patch = seria::diff(old, now);
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  patch.Accept(writer);
+  REQUIRE(std::string(buffer.GetString()) ==
+          R"({"value":2.5,"inside":{"i_v":[1,2,3,4,5,6]}})");
+
+  seria::apply_patch(old, patch);
+  REQUIRE(old.value == 2.5f);
+  REQUIRE(old.inside.i_v == now.inside.i_v);
+  REQUIRE(seria::diff(old, now).ObjectEmpty());
+
+  // members in any order, null back to the default, unknown keys ignored
+  rapidjson::Document edit;
+  edit.Parse(R"({"inside":{"i_age":null},"extra":1,"age":7})");
+  seria::apply_patch(old, edit);
+  REQUIRE(old.age == 7);
+  REQUIRE(old.inside.i_age == 100);
+  REQUIRE(old.value == 2.5f);
+
+  edit.Parse(R"({"inside":{"i_v":"text"}})");
+  try {
+    seria::apply_patch(old, edit);
+    FAIL("patch of the wrong type applied");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::string(err.what()).find("inside.i_v") != std::string::npos);
+  }
+}
+
+TEST_CASE("incremental reload", "[deserialize]") {
+  Person person{};
+  seria::json_reloader<Person> reloader(person);
+  std::string config =
+      R"({"age":3,"value":1.0,"gender":0,"test_uint":1,)"
+      R"("inside":{"i_age":1,"i_value":1.0,"i_v":[1,2,3,4,5]}})";
+  REQUIRE(reloader.reload(config) == std::vector<std::string>{"age"});
+  REQUIRE(person.age == 3);
+  REQUIRE(reloader.reload(config).empty());
+
+  // only the members whose bytes changed are decoded, the values compared
+  person.test_uint = 9;
+  config = R"({ "age": 3, "value": 1.00, "gender": 1, "test_uint": 1,)"
+           R"( "inside": {"i_v": [1, 2, 3], "i_age": 1, "i_value": 1}})";
+  REQUIRE(reloader.reload(config) ==
+          std::vector<std::string>{"gender", "inside.i_v"});
+  REQUIRE(person.gender == Gender::Female);
+  REQUIRE(person.test_uint == 9);
+  REQUIRE(person.inside.i_v == std::vector<int>{1, 2, 3});
+
+  // missing members are back to their defaults, unknown keys ignored
+  config = R"({"value":1.0,"gender":1,"test_uint":1,"x":[{"y":0}],)"
+           R"("inside":{"i_value":1.0,"i_v":[1,2,3]}})";
+  REQUIRE(reloader.reload(config) ==
+          std::vector<std::string>{"age", "inside.i_age"});
+  REQUIRE(person.age == 50);
+  REQUIRE(person.inside.i_age == 100);
+
+  config = R"({"value":1.0,"gender":1,"test_uint":1,)"
+           R"("inside":{"i_value":1.0,"i_v":{}}})";
+  try {
+    reloader.reload(config);
+    FAIL("vector reloaded from an object");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::string(err.what()).find("inside.i_v") != std::string::npos);
+  }
+  REQUIRE_THROWS_AS(reloader.reload(R"({"value":1.0,)"), seria::error);
+  REQUIRE_THROWS_AS(reloader.reload(R"({"value":2.0} [])"), seria::error);
+  config = R"({"inside":1,"value":1,"gender":1,"test_uint":1})";
+  REQUIRE_THROWS_AS(reloader.reload(config), seria::type_error);
+
+  // the member in error is decoded again once it is fixed
+  person.test_uint = 1;
+  config = R"({"value":1.0,"gender":1,"test_uint":1,)"
+           R"("inside":{"i_value":1.0,"i_v":[4]}})";
+  REQUIRE(reloader.reload(config) == std::vector<std::string>{"inside.i_v"});
+  REQUIRE(person.inside.i_v == std::vector<int>{4});
+}
+
 TEST_CASE("deserialize c style array", "[deserialize]") {
   const char *str = "[1,2,3]";
   int a[] = {0, 0, 0};
@@ -166,6 +471,167 @@ TEST_CASE("deserialize a object with default value", "[deserialize]") {
   REQUIRE(person.inside.i_age == 100);
 }
 
+TEST_CASE("deserialize objects with changing member order",
+          "[deserialize]") {
+  std::vector<Inside> insides;
+
+  const char *str = R"([{"i_age":1,"i_value":0.5,"i_v":[1]},)"
+                    R"({"i_v":[2],"i_value":1.5,"i_age":2},)"
+                    R"({"i_value":2.5,"i_v":[3]},)"
+                    R"({"extra":0,"i_age":4,"i_value":3.5,"i_v":[4]}])";
+
+  rapidjson::Document document;
+  document.Parse(str);
+  seria::deserialize(insides, document);
+
+  REQUIRE(insides.size() == 4);
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(insides[i].i_age == (i == 2 ? 100 : i + 1));
+    REQUIRE(insides[i].i_value == 0.5f + static_cast<float>(i));
+    REQUIRE(insides[i].i_v == std::vector<int>{i + 1});
+  }
+}
+
+TEST_CASE("constexpr registration", "[deserialize]") {
+  constexpr auto members = seria::register_object<Point>();
+  static_assert(std::get<0>(members).m_has_default &&
+                    std::get<0>(members).m_default_value == 7,
+                "defaults are stored inline");
+  static_assert(std::get<1>(members).m_key_length == 1, "");
+
+  Point point{};
+  rapidjson::Document document;
+  document.Parse(R"({"y":2.5})");
+  seria::deserialize(point, document);
+
+  REQUIRE(point.x == 7);
+  REQUIRE(point.y == 2.5);
+}
+
+TEST_CASE("parallel decoding of large arrays", "[deserialize]") {
+  std::vector<Person> people(5000);
+  for (size_t i = 0; i < people.size(); i++) {
+    people[i].age = static_cast<int>(i);
+    people[i].inside.i_v = {static_cast<int>(i), 1, 2};
+  }
+  auto str = seria::to_string(people);
+
+  std::vector<Person> decoded;
+  seria::from_string(decoded, str.data(), str.size(), 4);
+  REQUIRE(seria::to_string(decoded) == str);
+
+  // an array member of the root object
+  Inside inside{};
+  inside.i_v.assign(50000, 7);
+  str = seria::to_string(inside);
+  Inside decoded_inside{};
+  seria::from_string(decoded_inside, str.data(), str.size(), 4);
+  REQUIRE(decoded_inside.i_v == inside.i_v);
+
+  // errors are the ones of a single thread
+  str = seria::to_string(people);
+  std::string field = R"({"age":4000,)";
+  str.replace(str.find(field), field.size(), R"({"age":"x",)");
+  std::string messages[2];
+  for (unsigned threads : {1u, 4u}) {
+    try {
+      seria::from_string(decoded, str.data(), str.size(), threads);
+    } catch (seria::error &err) {
+      messages[threads / 4] = err.what();
+    }
+  }
+  REQUIRE(messages[0] == "4000.age: wrong type, should be integer");
+  REQUIRE(messages[1] == messages[0]);
+
+  str.insert(str.size() / 2, "]");
+  REQUIRE_THROWS_AS(seria::from_string(decoded, str.data(), str.size(), 4),
+                    seria::error);
+}
+
+TEST_CASE("push decoding", "[incremental]") {
+  std::vector<Person> people(3);
+  people[1].age = 7;
+  people[2].inside.i_v = {8, 9};
+  auto str = seria::to_string(people);
+
+  // byte by byte, the state is kept between calls
+  std::vector<Person> decoded;
+  seria::incremental_decoder<std::vector<Person>> decoder(decoded);
+  for (size_t i = 0; i + 1 < str.size(); i++) {
+    REQUIRE(decoder.feed(&str[i], 1) == seria::decode_status::need_more);
+  }
+  REQUIRE(decoder.feed(&str.back(), 1) == seria::decode_status::done);
+  REQUIRE(seria::to_string(decoded) == str);
+
+  // a number is only complete once what follows it is known
+  int number = 0;
+  seria::incremental_decoder<int> scalar(number);
+  REQUIRE(scalar.feed("12", 2) == seria::decode_status::need_more);
+  REQUIRE(scalar.finish() == seria::decode_status::done);
+  REQUIRE(number == 12);
+
+  // leaves given as arrays are decoded once complete
+  std::vector<Child> children;
+  seria::incremental_decoder<std::vector<Child>> custom(children);
+  std::string target = R"(["B",  "G"])";
+  custom.feed(target.data(), 6);
+  custom.feed(target.data() + 6, target.size() - 6);
+  REQUIRE(custom.status() == seria::decode_status::done);
+  REQUIRE(children.size() == 2);
+  REQUIRE(children[1] == Child::Girl);
+
+  // errors carry the same path as `deserialize`
+  Person person{};
+  seria::incremental_decoder<Person> failing(person);
+  std::string wrong =
+      R"({"value":1,"test_uint":2,"inside":{"i_value":1,"i_v":[1,1.0]}})";
+  failing.feed(wrong.data(), wrong.size());
+  REQUIRE(failing.status() == seria::decode_status::error);
+  REQUIRE(std::strcmp(failing.last_error().path(), "inside.i_v.1") == 0);
+
+  seria::incremental_decoder<Person> missing(person);
+  std::string partial = R"({"value":1,"test_uint":2,"inside":{"i_v":[]}})";
+  missing.feed(partial.data(), partial.size());
+  REQUIRE(std::string(missing.last_error().what()) ==
+          "inside.i_value: missing value");
+
+  seria::incremental_decoder<Person> truncated(person);
+  truncated.feed(wrong.data(), 10);
+  REQUIRE(truncated.finish() == seria::decode_status::error);
+  REQUIRE(std::string(truncated.last_error().what()) ==
+          "Missing a comma or '}' after an object member. at offset 10");
+}
+
+TEST_CASE("long string in small chunks", "[incremental]") {
+  Profile profile{};
+  profile.version = 1;
+  // 4 MiB with escaped quotes, the string is not scanned again on each feed
+  for (size_t i = 0; i < (4 << 20) / 64; i++) {
+    profile.name.append(62, 'x');
+    profile.name.append(i % 3 == 0 ? "\"" : "yy");
+  }
+  profile.scores = {1, 2};
+  auto str = seria::to_string(profile);
+
+  Profile decoded{};
+  seria::incremental_decoder<Profile> decoder(decoded);
+  for (size_t i = 0; i < str.size(); i += 4096) {
+    decoder.feed(str.data() + i, std::min<size_t>(4096, str.size() - i));
+  }
+  REQUIRE(decoder.status() == seria::decode_status::done);
+  REQUIRE(decoded.name == profile.name);
+  REQUIRE(decoded.scores == profile.scores);
+
+  // an escape split between two calls
+  std::string split = R"({"version":2,"name":"a\"b","scores":[]})";
+  auto backslash = split.find('\\') + 1;
+  seria::incremental_decoder<Profile> escaped(decoded);
+  escaped.feed(split.data(), backslash);
+  escaped.feed(split.data() + backslash, split.size() - backslash);
+  REQUIRE(escaped.status() == seria::decode_status::done);
+  REQUIRE(decoded.name == "a\"b");
+}
+
 TEST_CASE("customize enum deserialize rule", "[deserialize]") {
   std::vector<Child> children{};
   std::string target = R"(["B","G","G"])";
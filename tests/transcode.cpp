@@ -0,0 +1,211 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <seria/serialize/mpack.hpp>
+#include <seria/transcode.hpp>
+#ifdef SERIA_USE_EXTERNAL_RAPIDJSON
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#else
+#include <seria/rapidjson/stringbuffer.h>
+#include <seria/rapidjson/writer.h>
+#endif
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int age = 1;
+  float value = 1.0f;
+  Gender gender = Gender::Male;
+  uint32_t test_uint = 1;
+  Inside inside{};
+  std::string name = "seria";
+  std::array<double, 2> position{};
+  std::vector<uint8_t> blob{};
+};
+
+namespace seria {
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("age", &Person::age, 50),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender, Gender::Male),
+                         member("test_uint", &Person::test_uint),
+                         member("inside", &Person::inside),
+                         member("name", &Person::name),
+                         member("position", &Person::position),
+                         member("blob", &Person::blob));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age, 100),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+} // namespace seria
+
+static std::string json_to_mpack(const std::string &json,
+                                 const seria::type_schema *schema) {
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  try {
+    seria::transcode_json_to_mpack(json.data(), json.size(), &writer, schema);
+  } catch (...) {
+    mpack_writer_destroy(&writer);
+    free(data);
+    throw;
+  }
+
+  auto result = mpack_writer_destroy(&writer);
+  REQUIRE(result == mpack_ok);
+  std::string bytes(data, total);
+  free(data);
+  return bytes;
+}
+
+static std::string mpack_to_json(const std::string &bytes,
+                                 const seria::type_schema *schema) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  seria::transcode_mpack_to_json(bytes.data(), bytes.size(), &writer, schema);
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+TEST_CASE("untyped json to msgpack", "[transcode]") {
+  std::string json = R"({"a":[1,-2,300,1.5,true,null],"b":{"c":"x"}})";
+  auto bytes = json_to_mpack(json, nullptr);
+
+  uint8_t target[] = {0x82, 0xa1, 'a',  0x96, 0x01, 0xfe, 0xcd, 0x01,
+                      0x2c, 0xcb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00,
+                      0x00, 0x00, 0xc3, 0xc0, 0xa1, 'b',  0x81, 0xa1,
+                      'c',  0xa1, 'x'};
+  REQUIRE(bytes.size() == sizeof(target));
+  REQUIRE(std::memcmp(bytes.data(), target, sizeof(target)) == 0);
+
+  REQUIRE(mpack_to_json(bytes, nullptr) == json);
+}
+
+TEST_CASE("nested containers get their sizes", "[transcode]") {
+  std::string json = R"([[[1,2],{}],[],{"k":[0,1,2,3,4,5,6,7,8,9,10,11,12,)"
+                     R"(13,14,15,16]}])";
+  auto bytes = json_to_mpack(json, nullptr);
+
+  std::string target = "\x93\x92\x92\x01\x02\x80\x90\x81\xa1k\xdc";
+  target += std::string("\x00\x11", 2);
+  for (char i = 0; i <= 16; i++) {
+    target += i;
+  }
+  REQUIRE(bytes == target);
+  REQUIRE(mpack_to_json(bytes, nullptr) == json);
+}
+
+TEST_CASE("typed json matches serialize", "[transcode]") {
+  Person person{};
+  person.value = 0.5f;
+  person.gender = Gender::Female;
+  person.position = {1.5, -2.0};
+  person.blob = {0, 1, 255};
+
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::serialize(person, &writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+  std::string expected(data, total);
+  free(data);
+
+  std::string json = R"({"age":1,"value":0.5,"gender":1,"test_uint":1,)"
+                     R"("inside":{"i_age":1,"i_value":1,"i_v":[1,2,3,4,5]},)"
+                     R"("name":"seria","position":[1.5,-2],)"
+                     R"("blob":[0,1,255]})";
+  auto &schema = seria::schema_of<Person>();
+  REQUIRE(json_to_mpack(json, &schema) == expected);
+
+  // `bin` comes back as an array of numbers
+  auto back = mpack_to_json(expected, &schema);
+  REQUIRE(back.find(R"("blob":[0,1,255])") != std::string::npos);
+  REQUIRE(json_to_mpack(back, &schema) == expected);
+}
+
+TEST_CASE("unknown members are dropped", "[transcode]") {
+  std::string json = R"({"i_value":2,"extra":{"a":[1,{"b":2}]},"i_v":[],)"
+                     R"("more":"x"})";
+  auto &schema = seria::schema_of<Inside>();
+  auto bytes = json_to_mpack(json, &schema);
+
+  REQUIRE(mpack_to_json(bytes, nullptr) == R"({"i_value":2.0,"i_v":[]})");
+
+  auto untyped = json_to_mpack(json, nullptr);
+  REQUIRE(mpack_to_json(untyped, &schema) == R"({"i_value":2,"i_v":[]})");
+}
+
+TEST_CASE("typed json errors", "[transcode]") {
+  auto &schema = seria::schema_of<Person>();
+
+  try {
+    json_to_mpack(R"({"value":1,"test_uint":1,"name":"",)"
+                  R"("inside":{"i_value":1,"i_v":[1,"2"]}})",
+                  &schema);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "inside.i_v.1") == 0);
+    REQUIRE(std::strcmp(err.desired_type(), "integer") == 0);
+  }
+
+  try {
+    json_to_mpack(R"({"value":1,"test_uint":-1})", &schema);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "test_uint") == 0);
+  }
+
+  try {
+    json_to_mpack(R"({"value":1,"inside":{"i_v":[]}})", &schema);
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "inside.i_value") == 0);
+  }
+
+  try {
+    json_to_mpack(R"({"blob":[1,256]})", &schema);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "blob.1") == 0);
+  }
+
+  REQUIRE_THROWS_AS(json_to_mpack(R"({"position":[1,2,3]})", &schema),
+                    seria::error);
+  REQUIRE_THROWS_AS(json_to_mpack(R"({"a":1)", nullptr), seria::error);
+}
+
+TEST_CASE("typed msgpack errors", "[transcode]") {
+  auto &schema = seria::schema_of<Inside>();
+  auto bytes = json_to_mpack(R"({"i_value":1,"i_v":[1,2.5]})", nullptr);
+
+  try {
+    mpack_to_json(bytes, &schema);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "i_v.1") == 0);
+  }
+
+  auto missing = json_to_mpack(R"({"i_v":[]})", nullptr);
+  REQUIRE_THROWS_AS(mpack_to_json(missing, &schema), seria::error);
+
+  auto trailing = json_to_mpack("1", nullptr) + '\x01';
+  REQUIRE_THROWS_AS(mpack_to_json(trailing, nullptr), seria::error);
+
+  auto truncated = bytes.substr(0, bytes.size() - 1);
+  REQUIRE_THROWS_AS(mpack_to_json(truncated, nullptr), seria::error);
+}
@@ -0,0 +1,227 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <seria/deserialize/rapidjson.hpp>
+#include <seria/serialize/mpack.hpp>
+#include <seria/validate/mpack.hpp>
+#include <seria/validate/rapidjson.hpp>
+#include <thread>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int age = 1;
+  float value = 1.0f;
+  Gender gender = Gender::Male;
+  uint32_t test_uint = 1;
+  Inside inside{};
+  std::string name = "seria";
+  std::array<double, 2> position{};
+  bool flag = false;
+};
+
+struct Node {
+  int value = 0;
+  std::vector<Node> kids;
+};
+
+namespace seria {
+
+template <> auto register_object<Node>() {
+  return std::make_tuple(member("value", &Node::value),
+                         member("kids", &Node::kids));
+}
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("age", &Person::age, 50),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender, Gender::Male),
+                         member("test_uint", &Person::test_uint),
+                         member("inside", &Person::inside),
+                         member("name", &Person::name),
+                         member("position", &Person::position),
+                         member("flag", &Person::flag, false));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age, 100),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+} // namespace seria
+
+// the error path of `deserialize`, empty when it succeeds
+static std::string deserialize_error(const std::string &json) {
+  rapidjson::Document document;
+  document.Parse(json.data(), json.size());
+  Person person{};
+  try {
+    seria::deserialize(person, document);
+  } catch (seria::error &err) {
+    return std::string("error at ") + err.path();
+  }
+  return std::string();
+}
+
+static std::string validate_error(const std::string &json) {
+  try {
+    seria::validate<Person>(json.data(), json.size());
+  } catch (seria::error &err) {
+    return std::string("error at ") + err.path();
+  }
+  return std::string();
+}
+
+TEST_CASE("json agrees with deserialize", "[validate]") {
+  std::string inside = R"("inside":{"i_value":0.5,"i_v":[1,2]})";
+  std::string payloads[] = {
+      R"({"value":1,"test_uint":2,"name":"a","position":[1,2],)" + inside +
+          "}",
+      R"({"value":1.5,"test_uint":2,"name":"a","position":[1,2.5],)"
+      R"("unknown":{"a":[1,{"b":null}]},"age":-7,"gender":1,)" +
+          inside + "}",
+      R"({"test_uint":2,"name":"a","position":[1,2],)" + inside + "}",
+      R"({"value":"1","test_uint":2,"name":"a","position":[1,2],)" + inside +
+          "}",
+      R"({"value":1,"test_uint":-2,"name":"a","position":[1,2],)" + inside +
+          "}",
+      R"({"value":1,"test_uint":2,"name":"a","position":[1,2,3],)" + inside +
+          "}",
+      R"({"value":1,"test_uint":2,"name":"a","position":[1,true],)" +
+          inside + "}",
+      R"({"value":1,"test_uint":2,"name":"a","position":[1,2],)"
+      R"("inside":{"i_value":0.5,"i_v":[1,2.5]}})",
+      R"({"value":1,"test_uint":2,"name":"a","position":[1,2],)"
+      R"("inside":{"i_v":[]}})",
+      R"({"value":1,"test_uint":2,"name":"a","position":[1,2],)"
+      R"("inside":[]})",
+      R"([])",
+      R"({"value":1e39,"test_uint":2,"name":"a","position":[1,2],)" +
+          inside + "}",
+      R"({"value":3000000000,"test_uint":2,"name":"a","position":[1,2],)" +
+          inside + "}",
+      R"({"value":1,"age":1.0,"test_uint":2,"name":"a","position":[1,2],)" +
+          inside + "}",
+      R"({"value":1,"test_uint":2,"na\u006de":"\"\ud83d\ude00",)"
+      R"("position":[1,2],)" +
+          inside + "}",
+  };
+
+  for (auto &payload : payloads) {
+    INFO(payload);
+    REQUIRE(validate_error(payload) == deserialize_error(payload));
+  }
+}
+
+TEST_CASE("recursive type from two threads", "[validate]") {
+  // each thread starts from a different type of the cycle
+  const seria::type_schema *node = nullptr;
+  const seria::type_schema *kids = nullptr;
+  std::thread first([&node] { node = &seria::schema_of<Node>(); });
+  std::thread second(
+      [&kids] { kids = &seria::schema_of<std::vector<Node>>(); });
+  first.join();
+  second.join();
+
+  REQUIRE(node->members.size() == 2);
+  REQUIRE(node->members[1].schema == kids);
+  REQUIRE(kids->element == node);
+
+  std::string json = R"({"value":1,"kids":[{"value":2,"kids":[]}]})";
+  REQUIRE_NOTHROW(seria::validate<Node>(json.data(), json.size()));
+  json = R"({"value":1,"kids":[{"value":2,"kids":[{"value":"3"}]}]})";
+  REQUIRE_THROWS_AS(seria::validate<Node>(json.data(), json.size()),
+                    seria::type_error);
+}
+
+TEST_CASE("malformed json", "[validate]") {
+  std::string json = R"({"value":1,"test_uint":2)";
+  REQUIRE_THROWS_AS(seria::validate<Person>(json.data(), json.size()),
+                    seria::error);
+
+  std::string deep = R"({"unknown":)" + std::string(1000, '[') +
+                     std::string(1000, ']') + "}";
+  REQUIRE_THROWS_AS(seria::validate<Inside>(deep.data(), deep.size()),
+                    seria::error);
+
+  // the syntax accepted is the one of rapidjson
+  std::string values[] = {"[1,2]",   "[1,2,]",     "[01]",
+                          "[-]",     "[1.]",       "[1e]",
+                          "[1e400]", "[-0.5e-3]",  R"(["\x"])",
+                          "[nul]",   " [ true ] ", R"({"a" 1})",
+                          "[1] 2",   R"(["\ud800"])",
+                          R"(["\ud800\u0041"])", "[\"a\tb\"]"};
+  for (auto &value : values) {
+    INFO(value);
+    auto text = R"({"i_value":1,"i_v":[],"unknown":)" + value + "}";
+    rapidjson::Document document;
+    document.Parse(text.data(), text.size());
+    bool valid = true;
+    try {
+      seria::validate<Inside>(text.data(), text.size());
+    } catch (seria::error &) {
+      valid = false;
+    }
+    REQUIRE(valid == !document.HasParseError());
+  }
+}
+
+static std::string to_mpack(const Person &person) {
+  char *data = nullptr;
+  size_t total = 0;
+  mpack_writer_t writer;
+  mpack_writer_init_growable(&writer, &data, &total);
+  seria::serialize(person, &writer);
+  REQUIRE(mpack_writer_destroy(&writer) == mpack_ok);
+  std::string bytes(data, total);
+  free(data);
+  return bytes;
+}
+
+TEST_CASE("msgpack", "[validate]") {
+  Person person{};
+  auto bytes = to_mpack(person);
+  seria::validate_mpack<Person>(bytes.data(), bytes.size());
+
+  // an Inside is missing `value`
+  REQUIRE_THROWS_AS(seria::validate_mpack<Inside>(bytes.data(), bytes.size()),
+                    seria::error);
+
+  auto truncated = bytes.substr(0, bytes.size() - 1);
+  REQUIRE_THROWS_AS(
+      seria::validate_mpack<Person>(truncated.data(), truncated.size()),
+      seria::error);
+
+  auto trailing = bytes + '\x01';
+  REQUIRE_THROWS_AS(
+      seria::validate_mpack<Person>(trailing.data(), trailing.size()),
+      seria::error);
+}
+
+TEST_CASE("msgpack error path", "[validate]") {
+  Person person{};
+  person.inside.i_v = {1, -2};
+  auto bytes = to_mpack(person);
+
+  // pretend `i_v` holds unsigned values
+  seria::type_schema schema = seria::schema_of<Person>();
+  seria::type_schema inside = *schema.members[4].schema;
+  inside.members[2].schema = &seria::schema_of<std::vector<uint32_t>>();
+  schema.members[4].schema = &inside;
+
+  try {
+    seria::validate_mpack(bytes.data(), bytes.size(), schema);
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "inside.i_v.1") == 0);
+    REQUIRE(std::strcmp(err.desired_type(), "unsigned integer") == 0);
+  }
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <seria/view.hpp>
+
+using namespace std;
+
+struct Inside {
+  int i_age = 1;
+  float i_value = 1.0f;
+  std::vector<int> i_v = {1, 2, 3, 4, 5};
+};
+
+enum class Gender { Male = 0, Female = 1 };
+
+struct Person {
+  int age = 1;
+  float value = 1.0f;
+  Gender gender = Gender::Male;
+  bool flag = false;
+  std::string name = "seria";
+  std::array<int16_t, 3> triple = {7, 8, 9};
+  Inside inside{};
+  std::vector<Inside> children{};
+  std::vector<std::string> tags{};
+};
+
+namespace seria {
+
+template <> auto register_object<Person>() {
+  return std::make_tuple(member("age", &Person::age),
+                         member("value", &Person::value),
+                         member("gender", &Person::gender),
+                         member("flag", &Person::flag),
+                         member("name", &Person::name),
+                         member("triple", &Person::triple),
+                         member("inside", &Person::inside),
+                         member("children", &Person::children),
+                         member("tags", &Person::tags));
+}
+
+template <> auto register_object<Inside>() {
+  return std::make_tuple(member("i_age", &Inside::i_age),
+                         member("i_value", &Inside::i_value),
+                         member("i_v", &Inside::i_v));
+}
+
+} // namespace seria
+
+static Person make_person() {
+  Person person{};
+  person.age = 42;
+  person.value = 0.5f;
+  person.gender = Gender::Female;
+  person.flag = true;
+  person.name = "zero copy";
+  person.inside.i_v = {6, 66, 666};
+  person.children.resize(2);
+  person.children[1].i_age = 3;
+  person.children[1].i_v = {10, 20};
+  person.tags = {"a", "bc"};
+  return person;
+}
+
+TEST_CASE("read scalar members", "[view]") {
+  auto buffer = seria::to_zero_copy(make_person());
+  auto person = seria::make_view<Person>(buffer.data(), buffer.size());
+
+  REQUIRE(person.get(&Person::age) == 42);
+  REQUIRE(person.get(&Person::value) == 0.5f);
+  REQUIRE(person.get(&Person::gender) == Gender::Female);
+  REQUIRE(person.get(&Person::flag));
+  REQUIRE(person.get(&Person::name) == "zero copy");
+  REQUIRE(person.get(&Person::triple)[2] == 9);
+}
+
+TEST_CASE("nested views", "[view]") {
+  auto buffer = seria::to_zero_copy(make_person());
+  auto person = seria::make_view<Person>(buffer.data(), buffer.size());
+
+  auto inside = person.get(&Person::inside);
+  REQUIRE(inside.get(&Inside::i_age) == 1);
+
+  auto values = inside.get(&Inside::i_v);
+  REQUIRE(values.size() == 3);
+  REQUIRE(values.data()[2] == 666);
+
+  auto children = person.get(&Person::children);
+  REQUIRE(children.size() == 2);
+  REQUIRE(children[1].get(&Inside::i_age) == 3);
+
+  int sum = 0;
+  for (auto value : children[1].get(&Inside::i_v)) {
+    sum += value;
+  }
+  REQUIRE(sum == 30);
+
+  auto tags = person.get(&Person::tags);
+  REQUIRE(tags.size() == 2);
+  REQUIRE(tags[1].str() == "bc");
+}
+
+TEST_CASE("verify a valid buffer", "[verify]") {
+  auto buffer = seria::to_zero_copy(make_person());
+  REQUIRE_NOTHROW(seria::verify_view<Person>(buffer.data(), buffer.size()));
+}
+
+TEST_CASE("verify rejects out of bounds references", "[verify]") {
+  auto buffer = seria::to_zero_copy(make_person());
+  auto slot = seria::view_root_offset +
+              seria::view_layout<Person>::offsets[4]; // name
+  seria::view_store<uint32_t>(&buffer[slot + 4], 1000000);
+
+  try {
+    seria::verify_view<Person>(buffer.data(), buffer.size());
+    FAIL("should throw");
+  } catch (seria::error &err) {
+    REQUIRE(std::strcmp(err.path(), "name") == 0);
+  }
+}
+
+TEST_CASE("verify rejects invalid nested values", "[verify]") {
+  auto buffer = seria::to_zero_copy(make_person());
+  auto slot = seria::view_root_offset +
+              seria::view_layout<Person>::offsets[3]; // flag
+  buffer[slot] = 5;
+
+  try {
+    seria::verify_view<Person>(buffer.data(), buffer.size());
+    FAIL("should throw");
+  } catch (seria::type_error &err) {
+    REQUIRE(std::strcmp(err.path(), "flag") == 0);
+  }
+}
+
+TEST_CASE("verify rejects truncated buffers", "[verify]") {
+  auto buffer = seria::to_zero_copy(make_person());
+  buffer.resize(buffer.size() - 4);
+
+  REQUIRE_THROWS_AS(seria::verify_view<Person>(buffer.data(), buffer.size()),
+                    seria::error);
+}
+
+TEST_CASE("schema fingerprint mismatch", "[verify]") {
+  auto buffer = seria::to_zero_copy(Inside{});
+  REQUIRE_THROWS_AS(seria::make_view<Person>(buffer.data(), buffer.size()),
+                    seria::error);
+}